@@ -18,25 +18,31 @@
 #include <stdlib.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_action {
-    pep_linkedlist_t * attributes;
+    pep_vector_t * attributes;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 xacml_action_t * xacml_action_create() {
-    xacml_action_t * action= calloc(1,sizeof(struct xacml_action));
+    return xacml_action_create_in(NULL);
+}
+
+xacml_action_t * xacml_action_create_in(xacml_arena_t * arena) {
+    xacml_action_t * action= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_action));
     if (action == NULL) {
         pep_log_error("xacml_action_create: can't allocate xacml_action_t.");
         return NULL;
     }
-    action->attributes= pep_llist_create();
+    action->arena= XACML_ARENA(arena);
+    action->attributes= xacml_vector_create(action->arena);
     if (action->attributes == NULL) {
         pep_log_error("xacml_action_create: can't create attributes list.");
-        free(action);
+        xacml_free(action->arena,action);
         return NULL;
     }
     return action;
@@ -47,7 +53,7 @@ int xacml_action_addattribute(xacml_action_t * action, xacml_attribute_t * attr)
         pep_log_error("xacml_action_addattribute: NULL action or attribute.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(action->attributes,attr) != LLIST_OK) {
+    if (pep_vector_add(action->attributes,attr) != VECTOR_OK) {
         pep_log_error("xacml_action_addattribute: can't add attribute to list.");
         return PEP_XACML_ERROR;
     }
@@ -56,8 +62,10 @@ int xacml_action_addattribute(xacml_action_t * action, xacml_attribute_t * attr)
 
 void xacml_action_delete(xacml_action_t * action) {
     if (action == NULL) return;
-    pep_llist_delete_elements(action->attributes,(pep_llist_delete_elt_f)xacml_attribute_delete);
-    pep_llist_delete(action->attributes);
+    pep_vector_delete_elements(action->attributes,(pep_vector_delete_elt_f)xacml_attribute_delete);
+    /* released with the arena */
+    if (action->arena != NULL) return;
+    pep_vector_delete(action->attributes);
     free(action);
     action= NULL;
 }
@@ -67,7 +75,7 @@ size_t xacml_action_attributes_length(const xacml_action_t * action) {
         pep_log_warn("xacml_action_attributes_length: NULL action.");
         return 0;
     }
-    return pep_llist_length(action->attributes);
+    return pep_vector_length(action->attributes);
 }
 
 xacml_attribute_t * xacml_action_getattribute(const xacml_action_t * action, int index) {
@@ -75,6 +83,6 @@ xacml_attribute_t * xacml_action_getattribute(const xacml_action_t * action, int
         pep_log_error("xacml_action_getattribute: NULL action.");
         return NULL;
     }
-    return pep_llist_get(action->attributes, index);
+    return pep_vector_get(action->attributes, index);
 }
 
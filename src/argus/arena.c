@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* from ../util */
+#include "log.h"
+
+#include "i_xacml.h"
+
+/************************************************************
+ * XACML object arena functions
+ */
+
+xacml_arena_t * xacml_arena_create(size_t block_size) {
+    hessian_arena_t * arena= hessian_arena_create(block_size);
+    if (arena == NULL) {
+        pep_log_error("xacml_arena_create: can't create arena.");
+        return NULL;
+    }
+    return (xacml_arena_t *)arena;
+}
+
+void xacml_arena_reset(xacml_arena_t * arena) {
+    hessian_arena_reset(XACML_ARENA(arena));
+}
+
+void xacml_arena_delete(xacml_arena_t * arena) {
+    hessian_arena_delete(XACML_ARENA(arena));
+}
+
+void * xacml_calloc(hessian_arena_t * arena, size_t size) {
+    if (arena == NULL) return calloc(1,size);
+    return hessian_arena_alloc(arena,size);
+}
+
+void xacml_free(hessian_arena_t * arena, void * ptr) {
+    if (arena == NULL) free(ptr);
+}
+
+/* pep_vector_realloc_f allocator */
+static void * xacml_arena_realloc(void * arena, void * ptr, size_t size, size_t new_size) {
+    void * p= hessian_arena_alloc((hessian_arena_t *)arena,new_size);
+    if (p != NULL && ptr != NULL) {
+        memcpy(p,ptr,(size < new_size) ? size : new_size);
+    }
+    return p;
+}
+
+pep_vector_t * xacml_vector_create(hessian_arena_t * arena) {
+    if (arena == NULL) return pep_vector_create(0);
+    return pep_vector_create_in(0,xacml_arena_realloc,arena);
+}
+
+xacml_arena_owner_t * xacml_arena_owner_create(size_t block_size) {
+    xacml_arena_owner_t * owner;
+    hessian_arena_t * arena= hessian_arena_create(block_size);
+    if (arena == NULL) {
+        pep_log_error("xacml_arena_owner_create: can't create arena.");
+        return NULL;
+    }
+    owner= hessian_arena_alloc(arena,sizeof(xacml_arena_owner_t));
+    if (owner == NULL) {
+        pep_log_error("xacml_arena_owner_create: can't allocate xacml_arena_owner_t.");
+        hessian_arena_delete(arena);
+        return NULL;
+    }
+    owner->arena= arena;
+    owner->refs= 1;
+    return owner;
+}
+
+void xacml_arena_owner_acquire(xacml_arena_owner_t * owner) {
+    if (owner == NULL) return;
+    __atomic_add_fetch(&(owner->refs),1,__ATOMIC_RELAXED);
+}
+
+void xacml_arena_owner_release(xacml_arena_owner_t * owner) {
+    if (owner == NULL) return;
+    if (__atomic_sub_fetch(&(owner->refs),1,__ATOMIC_ACQ_REL) == 0) {
+        /* the owner is in the arena */
+        hessian_arena_delete(owner->arena);
+    }
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* from ../util */
+#include "log.h"
+
+#include "i_xacml.h"
+#include "profiles.h"
+
+/************************************************************
+ * XACML identifier atom table
+ */
+
+/*
+ * The table is an open addressing hash of the atoms, indexing the interned
+ * identifiers array. It has a fixed size: the identifiers are never moved,
+ * and the lookups read it without lock while xacml_atom_intern() appends
+ * under the lock, publishing the slot after the identifier.
+ */
+
+/* maximum number of atoms, including the predefined ones */
+#ifndef XACML_ATOM_MAX
+#define XACML_ATOM_MAX 4096
+#endif
+
+/* hash slots, power of 2 and at least twice XACML_ATOM_MAX */
+#define XACML_ATOM_SLOTS (2 * XACML_ATOM_MAX)
+
+/* identifiers defined in xacml.h and profiles.h, indexed by atom */
+static const char * const predefined_ids[XACML_ATOM_PROFILES_LAST]= {
+    [XACML_ATOM_NONE]= NULL,
+    [XACML_ATOM_DATATYPE_X500NAME]= XACML_DATATYPE_X500NAME,
+    [XACML_ATOM_DATATYPE_RFC822NAME]= XACML_DATATYPE_RFC822NAME,
+    [XACML_ATOM_DATATYPE_IPADDRESS]= XACML_DATATYPE_IPADDRESS,
+    [XACML_ATOM_DATATYPE_DNSNAME]= XACML_DATATYPE_DNSNAME,
+    [XACML_ATOM_DATATYPE_STRING]= XACML_DATATYPE_STRING,
+    [XACML_ATOM_DATATYPE_BOOLEAN]= XACML_DATATYPE_BOOLEAN,
+    [XACML_ATOM_DATATYPE_INTEGER]= XACML_DATATYPE_INTEGER,
+    [XACML_ATOM_DATATYPE_DOUBLE]= XACML_DATATYPE_DOUBLE,
+    [XACML_ATOM_DATATYPE_TIME]= XACML_DATATYPE_TIME,
+    [XACML_ATOM_DATATYPE_DATE]= XACML_DATATYPE_DATE,
+    [XACML_ATOM_DATATYPE_DATETIME]= XACML_DATATYPE_DATETIME,
+    [XACML_ATOM_DATATYPE_ANYURI]= XACML_DATATYPE_ANYURI,
+    [XACML_ATOM_DATATYPE_HEXBINARY]= XACML_DATATYPE_HEXBINARY,
+    [XACML_ATOM_DATATYPE_BASE64BINARY]= XACML_DATATYPE_BASE64BINARY,
+    [XACML_ATOM_DATATYPE_DAY_TIME_DURATION]= XACML_DATATYPE_DAY_TIME_DURATION,
+    [XACML_ATOM_DATATYPE_YEAR_MONTH_DURATION]= XACML_DATATYPE_YEAR_MONTH_DURATION,
+    [XACML_ATOM_SUBJECT_ID]= XACML_SUBJECT_ID,
+    [XACML_ATOM_SUBJECT_ID_QUALIFIER]= XACML_SUBJECT_ID_QUALIFIER,
+    [XACML_ATOM_SUBJECT_KEY_INFO]= XACML_SUBJECT_KEY_INFO,
+    [XACML_ATOM_SUBJECT_CATEGORY_ACCESS]= XACML_SUBJECT_CATEGORY_ACCESS,
+    [XACML_ATOM_SUBJECT_CATEGORY_INTERMEDIARY]= XACML_SUBJECT_CATEGORY_INTERMEDIARY,
+    [XACML_ATOM_SUBJECT_CATEGORY_RECIPIENT]= XACML_SUBJECT_CATEGORY_RECIPIENT,
+    [XACML_ATOM_SUBJECT_CATEGORY_CODEBASE]= XACML_SUBJECT_CATEGORY_CODEBASE,
+    [XACML_ATOM_SUBJECT_CATEGORY_REQUESTING_MACHINE]= XACML_SUBJECT_CATEGORY_REQUESTING_MACHINE,
+    [XACML_ATOM_RESOURCE_ID]= XACML_RESOURCE_ID,
+    [XACML_ATOM_ACTION_ID]= XACML_ACTION_ID,
+    [XACML_ATOM_ENVIRONMENT_CURRENT_TIME]= XACML_ENVIRONMENT_CURRENT_TIME,
+    [XACML_ATOM_ENVIRONMENT_CURRENT_DATE]= XACML_ENVIRONMENT_CURRENT_DATE,
+    [XACML_ATOM_ENVIRONMENT_CURRENT_DATETIME]= XACML_ENVIRONMENT_CURRENT_DATETIME,
+    [XACML_ATOM_STATUSCODE_OK]= XACML_STATUSCODE_OK,
+    [XACML_ATOM_STATUSCODE_MISSINGATTRIBUTE]= XACML_STATUSCODE_MISSINGATTRIBUTE,
+    [XACML_ATOM_STATUSCODE_SYNTAXERROR]= XACML_STATUSCODE_SYNTAXERROR,
+    [XACML_ATOM_STATUSCODE_PROCESSINGERROR]= XACML_STATUSCODE_PROCESSINGERROR,
+    [XACML_ATOM_COMMONAUTHZ_PROFILE_1_1]= XACML_COMMONAUTHZ_PROFILE_1_1,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_PROFILE_ID]= XACML_DCISEC_ATTRIBUTE_PROFILE_ID,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_SUBJECT_ISSUER]= XACML_DCISEC_ATTRIBUTE_SUBJECT_ISSUER,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION]= XACML_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_GROUP]= XACML_DCISEC_ATTRIBUTE_GROUP,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_PRIMARY]= XACML_DCISEC_ATTRIBUTE_GROUP_PRIMARY,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_ROLE]= XACML_DCISEC_ATTRIBUTE_ROLE,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_ROLE_PRIMARY]= XACML_DCISEC_ATTRIBUTE_ROLE_PRIMARY,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_RESOURCE_OWNER]= XACML_DCISEC_ATTRIBUTE_RESOURCE_OWNER,
+    [XACML_ATOM_DCISEC_ACTION_NAMESPACE]= XACML_DCISEC_ACTION_NAMESPACE,
+    [XACML_ATOM_DCISEC_ACTION_ANY]= XACML_DCISEC_ACTION_ANY,
+    [XACML_ATOM_DCISEC_OBLIGATION_MAP_LOCAL_USER]= XACML_DCISEC_OBLIGATION_MAP_LOCAL_USER,
+    [XACML_ATOM_DCISEC_OBLIGATION_MAP_POSIX_USER]= XACML_DCISEC_OBLIGATION_MAP_POSIX_USER,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_USER_ID]= XACML_DCISEC_ATTRIBUTE_USER_ID,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID]= XACML_DCISEC_ATTRIBUTE_GROUP_ID,
+    [XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY]= XACML_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY,
+    [XACML_ATOM_GRIDWN_PROFILE_VERSION]= XACML_GRIDWN_PROFILE_VERSION,
+    [XACML_ATOM_GLITE_ATTRIBUTE_PROFILE_ID]= XACML_GLITE_ATTRIBUTE_PROFILE_ID,
+    [XACML_ATOM_GLITE_ATTRIBUTE_SUBJECT_ISSUER]= XACML_GLITE_ATTRIBUTE_SUBJECT_ISSUER,
+    [XACML_ATOM_GLITE_ATTRIBUTE_VOMS_ISSUER]= XACML_GLITE_ATTRIBUTE_VOMS_ISSUER,
+    [XACML_ATOM_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION]= XACML_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION,
+    [XACML_ATOM_GLITE_ATTRIBUTE_FQAN]= XACML_GLITE_ATTRIBUTE_FQAN,
+    [XACML_ATOM_GLITE_ATTRIBUTE_FQAN_PRIMARY]= XACML_GLITE_ATTRIBUTE_FQAN_PRIMARY,
+    [XACML_ATOM_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER]= XACML_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER,
+    [XACML_ATOM_GLITE_ATTRIBUTE_USER_ID]= XACML_GLITE_ATTRIBUTE_USER_ID,
+    [XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID]= XACML_GLITE_ATTRIBUTE_GROUP_ID,
+    [XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY]= XACML_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY,
+    [XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP]= XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP,
+    [XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX]= XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX,
+    [XACML_ATOM_GLITE_DATATYPE_FQAN]= XACML_GLITE_DATATYPE_FQAN,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ID]= XACML_AUTHZINTEROP_SUBJECT_X509_ID,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ISSUER]= XACML_AUTHZINTEROP_SUBJECT_X509_ISSUER,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_VO]= XACML_AUTHZINTEROP_SUBJECT_VO,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_CERTCHAIN]= XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_FQAN]= XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN,
+    [XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN]= XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_UIDGID]= XACML_AUTHZINTEROP_OBLIGATION_UIDGID,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS]= XACML_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_USERNAME]= XACML_AUTHZINTEROP_OBLIGATION_USERNAME,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_AFS_TOKEN]= XACML_AUTHZINTEROP_OBLIGATION_AFS_TOKEN,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID]= XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID]= XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME]= XACML_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME,
+    [XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN]= XACML_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN
+};
+
+static const char * atom_ids[XACML_ATOM_MAX];
+static size_t atom_lengths[XACML_ATOM_MAX];
+static volatile xacml_atom_t atom_slots[XACML_ATOM_SLOTS];
+static volatile xacml_atom_t n_atoms= 0;
+
+static pthread_once_t atom_once= PTHREAD_ONCE_INIT;
+static pthread_mutex_t atom_lock= PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a hash */
+static uint32_t atom_hash(const char * id, size_t id_l) {
+    uint32_t h= 2166136261U;
+    size_t i;
+    for (i= 0; i < id_l; i++) {
+        h^= (unsigned char)id[i];
+        h*= 16777619U;
+    }
+    return h;
+}
+
+/* returns the slot of the identifier, empty if not interned */
+static size_t atom_slot(const char * id, size_t id_l) {
+    size_t slot= atom_hash(id,id_l) & (XACML_ATOM_SLOTS - 1);
+    xacml_atom_t atom;
+    while ((atom= atom_slots[slot]) != XACML_ATOM_NONE) {
+        if (atom_lengths[atom] == id_l && memcmp(atom_ids[atom],id,id_l) == 0) break;
+        slot= (slot + 1) & (XACML_ATOM_SLOTS - 1);
+    }
+    return slot;
+}
+
+/* must be called with the lock held, or from atom_init */
+static xacml_atom_t atom_add(const char * id, size_t id_l, size_t slot) {
+    xacml_atom_t atom= n_atoms;
+    atom_ids[atom]= id;
+    atom_lengths[atom]= id_l;
+    n_atoms= atom + 1;
+    /* the identifier is visible before the slot */
+    __sync_synchronize();
+    atom_slots[slot]= atom;
+    return atom;
+}
+
+static void atom_init(void) {
+    xacml_atom_t atom;
+    /* atom 0 is XACML_ATOM_NONE */
+    n_atoms= 1;
+    for (atom= 1; atom < XACML_ATOM_PROFILES_LAST; atom++) {
+        const char * id= predefined_ids[atom];
+        size_t id_l= strlen(id);
+        atom_add(id,id_l,atom_slot(id,id_l));
+    }
+}
+
+xacml_atom_t xacml_atom_lookup_n(const char * id, size_t id_l) {
+    if (id == NULL) return XACML_ATOM_NONE;
+    pthread_once(&atom_once,atom_init);
+    return atom_slots[atom_slot(id,id_l)];
+}
+
+xacml_atom_t xacml_atom_lookup(const char * id) {
+    if (id == NULL) return XACML_ATOM_NONE;
+    return xacml_atom_lookup_n(id,strlen(id));
+}
+
+xacml_atom_t xacml_atom_intern(const char * id) {
+    xacml_atom_t atom;
+    size_t id_l, slot;
+    char * copy;
+    if (id == NULL) {
+        pep_log_error("xacml_atom_intern: NULL id.");
+        return XACML_ATOM_NONE;
+    }
+    id_l= strlen(id);
+    atom= xacml_atom_lookup_n(id,id_l);
+    if (atom != XACML_ATOM_NONE) return atom;
+    pthread_mutex_lock(&atom_lock);
+    /* interned by another thread meanwhile? */
+    slot= atom_slot(id,id_l);
+    atom= atom_slots[slot];
+    if (atom == XACML_ATOM_NONE) {
+        if (n_atoms >= XACML_ATOM_MAX) {
+            pep_log_error("xacml_atom_intern: atom table full (%d atoms).",XACML_ATOM_MAX);
+        }
+        else if ((copy= malloc(id_l + 1)) == NULL) {
+            pep_log_error("xacml_atom_intern: can't allocate id (%d bytes).",(int)id_l);
+        }
+        else {
+            memcpy(copy,id,id_l + 1);
+            atom= atom_add(copy,id_l,slot);
+        }
+    }
+    pthread_mutex_unlock(&atom_lock);
+    return atom;
+}
+
+const char * xacml_atom_tostring(xacml_atom_t atom) {
+    pthread_once(&atom_once,atom_init);
+    if (atom <= XACML_ATOM_NONE || atom >= n_atoms) return NULL;
+    return atom_ids[atom];
+}
+
+const char * xacml_id_copy(hessian_arena_t * arena, const char * id, size_t id_l, xacml_atom_t * atom) {
+    char * copy;
+    *atom= xacml_atom_lookup_n(id,id_l);
+    /* the interned identifier is shared */
+    if (*atom != XACML_ATOM_NONE) return atom_ids[*atom];
+    copy= xacml_calloc(arena,id_l + 1);
+    if (copy != NULL) memcpy(copy,id,id_l);
+    return copy;
+}
+
+void xacml_id_free(hessian_arena_t * arena, const char * id, xacml_atom_t atom) {
+    if (atom == XACML_ATOM_NONE) xacml_free(arena,(char *)id);
+}
@@ -19,45 +19,45 @@
 #include <string.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_attribute {
-    char * id; /* mandatory */
-    char * datatype; /* optional */
-    char * issuer; /* optional */
-    pep_linkedlist_t * values; /* string list */
+    xacml_string_t id; /* mandatory, shared with the atom table if interned */
+    xacml_atom_t atom;
+    xacml_string_t datatype; /* optional */
+    xacml_string_t issuer; /* optional */
+    pep_vector_t * values; /* xacml_string_t list */
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 /**
  * Creates a PEP attribute with the given id.
  */
 xacml_attribute_t * xacml_attribute_create(const char * id) {
-    xacml_attribute_t * attr= calloc(1,sizeof(struct xacml_attribute));
+    return xacml_attribute_create_in(id,NULL);
+}
+
+xacml_attribute_t * xacml_attribute_create_in(const char * id, xacml_arena_t * arena) {
+    xacml_attribute_t * attr= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_attribute));
     if (attr == NULL) {
         pep_log_error("xacml_attribute_create: can't allocate xacml_attribute_t.");
         return NULL;
     }
-    attr->id= NULL;
-    if (id != NULL) {
-        size_t size= strlen(id);
-        attr->id= calloc(size + 1,sizeof(char));
-        if (attr->id == NULL) {
-            pep_log_error("xacml_attribute_create: can't allocate id (%d bytes).",(int)size);
-            free(attr);
-            return NULL;
-        }
-        strncpy(attr->id,id,size);
+    attr->arena= XACML_ARENA(arena);
+    attr->atom= XACML_ATOM_NONE;
+    if (id != NULL && xacml_attribute_setid(attr,id) != PEP_XACML_OK) {
+        pep_log_error("xacml_attribute_create: can't set id.");
+        xacml_free(attr->arena,attr);
+        return NULL;
     }
-    attr->datatype= NULL;
-    attr->issuer= NULL;
-    attr->values= pep_llist_create();
+    attr->values= xacml_vector_create(attr->arena);
     if (attr->values == NULL) {
         pep_log_error("xacml_attribute_create: can't create values list.");
-        free(attr->id);
-        free(attr);
+        xacml_id_free(attr->arena,attr->id.string,attr->atom);
+        xacml_free(attr->arena,attr);
         return NULL;
     }
     return attr;
@@ -74,29 +74,30 @@ xacml_attribute_t * xacml_attribute_clone(const xacml_attribute_t * attr) {
         pep_log_warn("xacml_attribute_clone: attr is NULL.");
         return NULL;
     }
-    clone= xacml_attribute_create(attr->id);
-    if (clone == NULL) {
-        pep_log_error("xacml_attribute_clone: can't create clone with id: %s", attr->id);
+    clone= xacml_attribute_create(NULL);
+    if (clone == NULL || (attr->id.string != NULL && xacml_attribute_setid_n(clone,attr->id.string,attr->id.length) != PEP_XACML_OK)) {
+        pep_log_error("xacml_attribute_clone: can't create clone with id: %s", attr->id.string);
+        xacml_attribute_delete(clone);
         return NULL;
     }
     /* datatype */
-    if (xacml_attribute_setdatatype(clone,attr->datatype) != PEP_XACML_OK) {
-        pep_log_error("xacml_attribute_clone: can't set datatype: %s",attr->datatype);
+    if (xacml_attribute_setdatatype_n(clone,attr->datatype.string,attr->datatype.length) != PEP_XACML_OK) {
+        pep_log_error("xacml_attribute_clone: can't set datatype: %s",attr->datatype.string);
         xacml_attribute_delete(clone);
         return NULL;
     }
     /* issuer */
-    if (xacml_attribute_setissuer(clone,attr->issuer) != PEP_XACML_OK) {
-        pep_log_error("xacml_attribute_clone: can't set issuer: %s",attr->issuer);
+    if (xacml_attribute_setissuer_n(clone,attr->issuer.string,attr->issuer.length) != PEP_XACML_OK) {
+        pep_log_error("xacml_attribute_clone: can't set issuer: %s",attr->issuer.string);
         xacml_attribute_delete(clone);
         return NULL;
     }
     /* values */
     nvalues= xacml_attribute_values_length(attr);
     for(i= 0; i<nvalues; i++) {
-        const char * value= xacml_attribute_getvalue(attr,i);
-        if (xacml_attribute_addvalue(clone,value) != PEP_XACML_OK) {
-            pep_log_error("xacml_attribute_clone: can't clone value[%d]: %s",i,value);
+        const xacml_string_t * value= pep_vector_get(attr->values,i);
+        if (xacml_attribute_addvalue_n(clone,value->string,value->length) != PEP_XACML_OK) {
+            pep_log_error("xacml_attribute_clone: can't clone value[%d]: %s",i,value->string);
             xacml_attribute_delete(clone);
             return NULL;
         }
@@ -109,7 +110,14 @@ xacml_attribute_t * xacml_attribute_clone(const xacml_attribute_t * attr) {
  * Sets the PEP attribute id. id is mandatory and can't be NULL.
  */
 int xacml_attribute_setid(xacml_attribute_t * attr, const char * id) {
-    size_t size;
+    if (id == NULL) {
+        pep_log_error("xacml_attribute_setid: NULL id.");
+        return PEP_XACML_ERROR;
+    }
+    return xacml_attribute_setid_n(attr,id,strlen(id));
+}
+
+int xacml_attribute_setid_n(xacml_attribute_t * attr, const char * id, size_t id_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_setid: NULL attribute.");
         return PEP_XACML_ERROR;
@@ -118,57 +126,70 @@ int xacml_attribute_setid(xacml_attribute_t * attr, const char * id) {
         pep_log_error("xacml_attribute_setid: NULL id.");
         return PEP_XACML_ERROR;
     }
-    if (attr->id != NULL) {
-        free(attr->id);
+    if (attr->id.string != NULL) {
+        xacml_id_free(attr->arena,attr->id.string,attr->atom);
     }
-    size= strlen(id);
-    attr->id= calloc(size + 1,sizeof(char));
-    if (attr->id == NULL) {
-        pep_log_error("xacml_attribute_setid: can't allocate id (%d bytes).", (int)size);
+    attr->id.string= xacml_id_copy(attr->arena,id,id_l,&attr->atom);
+    attr->id.length= id_l;
+    attr->id.utf8_length= XACML_UTF8_UNKNOWN;
+    if (attr->id.string == NULL) {
+        pep_log_error("xacml_attribute_setid: can't allocate id (%d bytes).", (int)id_l);
         return PEP_XACML_ERROR;
     }
-    strncpy(attr->id,id,size);
     return PEP_XACML_OK;
 }
 
 const char * xacml_attribute_getid(const xacml_attribute_t * attr) {
+    return xacml_attribute_getid_n(attr,NULL);
+}
+
+const char * xacml_attribute_getid_n(const xacml_attribute_t * attr, size_t * id_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_getid: NULL attribute.");
         return NULL;
     }
-    return attr->id;
+    if (id_l != NULL) *id_l= attr->id.length;
+    return attr->id.string;
+}
+
+xacml_atom_t xacml_attribute_getatom(const xacml_attribute_t * attr) {
+    if (attr == NULL) {
+        pep_log_error("xacml_attribute_getatom: NULL attribute.");
+        return XACML_ATOM_NONE;
+    }
+    return attr->atom;
 }
 
 /**
  * Sets the PEP attribute data type. NULL to delete existing datatype.
  */
 int xacml_attribute_setdatatype(xacml_attribute_t * attr, const char * datatype) {
+    return xacml_attribute_setdatatype_n(attr,datatype,(datatype != NULL) ? strlen(datatype) : 0);
+}
+
+int xacml_attribute_setdatatype_n(xacml_attribute_t * attr, const char * datatype, size_t datatype_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_setdatatype: NULL attribute.");
         return PEP_XACML_ERROR;
     }
-    if (attr->datatype != NULL) {
-        free(attr->datatype);
-    }
-    attr->datatype= NULL;
-    if (datatype != NULL) {
-        size_t size= strlen(datatype);
-        attr->datatype= calloc(size + 1,sizeof(char));
-        if (attr->datatype == NULL) {
-            pep_log_error("xacml_attribute_setdatatype: can't allocate datatype (%d bytes).", (int)size);
-            return PEP_XACML_ERROR;
-        }
-        strncpy(attr->datatype,datatype,size);
+    if (xacml_string_set(attr->arena,&(attr->datatype),datatype,datatype_l) != PEP_XACML_OK) {
+        pep_log_error("xacml_attribute_setdatatype: can't allocate datatype (%d bytes).", (int)datatype_l);
+        return PEP_XACML_ERROR;
     }
     return PEP_XACML_OK;
 }
 
 const char * xacml_attribute_getdatatype(const xacml_attribute_t * attr) {
+    return xacml_attribute_getdatatype_n(attr,NULL);
+}
+
+const char * xacml_attribute_getdatatype_n(const xacml_attribute_t * attr, size_t * datatype_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_getdatatype: NULL attribute.");
         return NULL;
     }
-    return attr->datatype;
+    if (datatype_l != NULL) *datatype_l= attr->datatype.length;
+    return attr->datatype.string;
 }
 
 
@@ -176,61 +197,60 @@ const char * xacml_attribute_getdatatype(const xacml_attribute_t * attr) {
  * Sets the PEP attribute issuer. NULL to delete existing id.
  */
 int xacml_attribute_setissuer(xacml_attribute_t * attr, const char * issuer) {
+    return xacml_attribute_setissuer_n(attr,issuer,(issuer != NULL) ? strlen(issuer) : 0);
+}
+
+int xacml_attribute_setissuer_n(xacml_attribute_t * attr, const char * issuer, size_t issuer_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_setissuer: NULL attribute.");
         return PEP_XACML_ERROR;
     }
-    if (attr->issuer != NULL) {
-        free(attr->issuer);
-    }
-    attr->issuer= NULL;
-    if (issuer != NULL) {
-        size_t size= strlen(issuer);
-        attr->issuer= calloc(size + 1,sizeof(char));
-        if (attr->issuer == NULL) {
-            pep_log_error("xacml_attribute_setissuer: can't allocate issuer (%d bytes).", (int)size);
-            return PEP_XACML_ERROR;
-        }
-        strncpy(attr->issuer,issuer,size);
+    if (xacml_string_set(attr->arena,&(attr->issuer),issuer,issuer_l) != PEP_XACML_OK) {
+        pep_log_error("xacml_attribute_setissuer: can't allocate issuer (%d bytes).", (int)issuer_l);
+        return PEP_XACML_ERROR;
     }
     return PEP_XACML_OK;
-
 }
 
 const char * xacml_attribute_getissuer(const xacml_attribute_t * attr) {
+    return xacml_attribute_getissuer_n(attr,NULL);
+}
+
+const char * xacml_attribute_getissuer_n(const xacml_attribute_t * attr, size_t * issuer_l) {
     if (attr == NULL) {
         pep_log_error("xacml_attribute_getissuer: NULL attribute.");
         return NULL;
     }
-    return attr->issuer;
+    if (issuer_l != NULL) *issuer_l= attr->issuer.length;
+    return attr->issuer.string;
 }
 
 /**
  * Adds a value to the PEP attribute.
  */
 int xacml_attribute_addvalue(xacml_attribute_t * attr, const char *value) {
-    size_t size;
-    char * v;
     if (attr == NULL || value == NULL) {
         pep_log_error("xacml_attribute_addvalue: NULL attribute or value.");
         return PEP_XACML_ERROR;
     }
-    /* copy the const value */
-    size= strlen(value);
-/*
-    if (size <= 0) {
-        pep_log_error("xacml_attribute_addvalue: empty value not allowed.");
+    return xacml_attribute_addvalue_n(attr,value,strlen(value));
+}
+
+int xacml_attribute_addvalue_n(xacml_attribute_t * attr, const char * value, size_t value_l) {
+    xacml_string_t * v;
+    if (attr == NULL || value == NULL) {
+        pep_log_error("xacml_attribute_addvalue: NULL attribute or value.");
         return PEP_XACML_ERROR;
     }
-*/
-    v= calloc(size + 1, sizeof(char));
+    /* copy the const value, with its length */
+    v= xacml_string_create(attr->arena,value,value_l);
     if (v == NULL) {
-        pep_log_error("xacml_attribute_addvalue: can't allocate value (%d bytes).", (int)size);
+        pep_log_error("xacml_attribute_addvalue: can't allocate value (%d bytes).", (int)value_l);
         return PEP_XACML_ERROR;
     }
-    strncpy(v,value,size);
-    if (pep_llist_add(attr->values,v) != LLIST_OK) {
+    if (pep_vector_add(attr->values,v) != VECTOR_OK) {
         pep_log_error("xacml_attribute_addvalue: can't add value to list.");
+        xacml_free(attr->arena,v);
         return PEP_XACML_ERROR;
     }
     else return PEP_XACML_OK;
@@ -241,15 +261,42 @@ size_t xacml_attribute_values_length(const xacml_attribute_t * attr) {
         pep_log_warn("xacml_attribute_values_length: NULL attribute.");
         return 0;
     }
-    return pep_llist_length(attr->values);
+    return pep_vector_length(attr->values);
 }
 
 const char * xacml_attribute_getvalue(const xacml_attribute_t * attr,int index) {
+    return xacml_attribute_getvalue_n(attr,index,NULL);
+}
+
+const char * xacml_attribute_getvalue_n(const xacml_attribute_t * attr, int index, size_t * value_l) {
+    const xacml_string_t * value;
     if (attr == NULL) {
         pep_log_error("xacml_attribute_getvalue: NULL attribute.");
         return NULL;
     }
-    return pep_llist_get(attr->values,index);
+    value= xacml_attribute_getvaluestring(attr,index);
+    if (value == NULL) return NULL;
+    if (value_l != NULL) *value_l= value->length;
+    return value->string;
+}
+
+/*
+ * Internal length-carrying strings getters, for the marshaller.
+ */
+const xacml_string_t * xacml_attribute_getidstring(const xacml_attribute_t * attr) {
+    return (attr != NULL && attr->id.string != NULL) ? &(attr->id) : NULL;
+}
+
+const xacml_string_t * xacml_attribute_getdatatypestring(const xacml_attribute_t * attr) {
+    return (attr != NULL && attr->datatype.string != NULL) ? &(attr->datatype) : NULL;
+}
+
+const xacml_string_t * xacml_attribute_getissuerstring(const xacml_attribute_t * attr) {
+    return (attr != NULL && attr->issuer.string != NULL) ? &(attr->issuer) : NULL;
+}
+
+const xacml_string_t * xacml_attribute_getvaluestring(const xacml_attribute_t * attr, int index) {
+    return (attr != NULL) ? pep_vector_get(attr->values,index) : NULL;
 }
 
 /**
@@ -257,12 +304,13 @@ const char * xacml_attribute_getvalue(const xacml_attribute_t * attr,int index)
  */
 void xacml_attribute_delete(xacml_attribute_t * attr) {
     if (attr == NULL) return;
-    if (attr->id != NULL) free(attr->id);
-    if (attr->datatype != NULL) free(attr->datatype);
-    if (attr->issuer != NULL) free(attr->issuer);
-    pep_llist_delete_elements(attr->values,(pep_llist_delete_elt_f)free);
-    pep_llist_delete(attr->values);
+    /* released with the arena */
+    if (attr->arena != NULL) return;
+    if (attr->id.string != NULL) xacml_id_free(NULL,attr->id.string,attr->atom);
+    xacml_string_clear(NULL,&(attr->datatype));
+    xacml_string_clear(NULL,&(attr->issuer));
+    pep_vector_delete_elements(attr->values,(pep_vector_delete_elt_f)free);
+    pep_vector_delete(attr->values);
     free(attr);
     attr= NULL;
 }
-
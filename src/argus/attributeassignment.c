@@ -21,33 +21,39 @@
 /* from ../util */
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_attributeassignment {
-    char * id; /* mandatory */
+    const char * id; /* mandatory, shared with the atom table if interned */
+    xacml_atom_t atom;
     char * datatype;
     char * value;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 /**
  * Creates a PEP attribute assignment with the given id. id can be NULL, but not recommended.
  */
 xacml_attributeassignment_t * xacml_attributeassignment_create(const char * id) {
-    xacml_attributeassignment_t * attr= calloc(1,sizeof(struct xacml_attributeassignment));
+    return xacml_attributeassignment_create_in(id,NULL);
+}
+
+xacml_attributeassignment_t * xacml_attributeassignment_create_in(const char * id, xacml_arena_t * arena) {
+    xacml_attributeassignment_t * attr= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_attributeassignment));
     if (attr == NULL) {
         pep_log_error("xacml_attributeassignment_create: can't allocate xacml_attributeassignment_t.");
         return NULL;
     }
+    attr->arena= XACML_ARENA(arena);
     attr->id= NULL;
+    attr->atom= XACML_ATOM_NONE;
     if (id != NULL) {
-        size_t size= strlen(id);
-        attr->id= calloc(size + 1,sizeof(char));
+        attr->id= xacml_id_copy(attr->arena,id,strlen(id),&attr->atom);
         if (attr->id == NULL) {
-            pep_log_error("xacml_attributeassignment_create: can't allocate id (%d bytes).",(int)size);
-            free(attr);
+            pep_log_error("xacml_attributeassignment_create: can't allocate id (%d bytes).",(int)strlen(id));
+            xacml_free(attr->arena,attr);
             return NULL;
         }
-        strncpy(attr->id,id,size);
     }
     return attr;
 }
@@ -56,7 +62,6 @@ xacml_attributeassignment_t * xacml_attributeassignment_create(const char * id)
  * Sets the PEP attribute id. id is mandatory and can't be NULL.
  */
 int xacml_attributeassignment_setid(xacml_attributeassignment_t * attr, const char * id) {
-    size_t size;
     if (attr == NULL) {
         pep_log_error("xacml_attributeassignment_setid: NULL attribute.");
         return PEP_XACML_ERROR;
@@ -66,15 +71,13 @@ int xacml_attributeassignment_setid(xacml_attributeassignment_t * attr, const ch
         return PEP_XACML_ERROR;
     }
     if (attr->id != NULL) {
-        free(attr->id);
+        xacml_id_free(attr->arena,attr->id,attr->atom);
     }
-    size= strlen(id);
-    attr->id= calloc(size + 1,sizeof(char));
+    attr->id= xacml_id_copy(attr->arena,id,strlen(id),&attr->atom);
     if (attr->id == NULL) {
-        pep_log_error("xacml_attributeassignment_setid: can't allocate id (%d bytes).", (int)size);
+        pep_log_error("xacml_attributeassignment_setid: can't allocate id (%d bytes).", (int)strlen(id));
         return PEP_XACML_ERROR;
     }
-    strncpy(attr->id,id,size);
     return PEP_XACML_OK;
 }
 
@@ -89,6 +92,14 @@ const char * xacml_attributeassignment_getid(const xacml_attributeassignment_t *
     return attr->id;
 }
 
+xacml_atom_t xacml_attributeassignment_getatom(const xacml_attributeassignment_t * attr) {
+    if (attr == NULL) {
+        pep_log_error("xacml_attributeassignment_getatom: NULL attribute.");
+        return XACML_ATOM_NONE;
+    }
+    return attr->atom;
+}
+
 /**
  * Sets the AttributeAssignment Datatype, can be NULL
  */
@@ -99,13 +110,13 @@ int xacml_attributeassignment_setdatatype(xacml_attributeassignment_t * attr, co
     }
 
     if (attr->datatype != NULL) {
-        free(attr->datatype);
+        xacml_free(attr->arena,attr->datatype);
     }
 
     attr->datatype= NULL;
     if (datatype!=NULL) {
         size_t size= strlen(datatype);
-        attr->datatype= calloc(size + 1,sizeof(char));
+        attr->datatype= xacml_calloc(attr->arena,size + 1);
         if (attr->datatype == NULL) {
             pep_log_error("xacml_attributeassignment_setdatatype: can't allocate datatype (%d bytes).", (int)size);
             return PEP_XACML_ERROR;
@@ -145,13 +156,13 @@ int xacml_attributeassignment_setvalue(xacml_attributeassignment_t * attr, const
     }
 
     if (attr->value != NULL) {
-        free(attr->value);
+        xacml_free(attr->arena,attr->value);
     }
 
     attr->value= NULL;
     if (value!=NULL) {
         size_t size= strlen(value);
-        attr->value= calloc(size + 1,sizeof(char));
+        attr->value= xacml_calloc(attr->arena,size + 1);
         if (attr->value == NULL) {
             pep_log_error("xacml_attributeassignment_setvalue: can't allocate value (%d bytes).", (int)size);
             return PEP_XACML_ERROR;
@@ -194,7 +205,9 @@ const char * xacml_attributeassignment_getvalue(const xacml_attributeassignment_
  */
 void xacml_attributeassignment_delete(xacml_attributeassignment_t * attr) {
     if (attr == NULL) return;
-    if (attr->id != NULL) free(attr->id);
+    /* released with the arena */
+    if (attr->arena != NULL) return;
+    if (attr->id != NULL) xacml_id_free(NULL,attr->id,attr->atom);
     if (attr->datatype != NULL) free(attr->datatype);
     if (attr->value != NULL) free(attr->value);
     free(attr);
@@ -18,25 +18,31 @@
 #include <stdlib.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_environment {
-    pep_linkedlist_t * attributes;
+    pep_vector_t * attributes;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 xacml_environment_t * xacml_environment_create() {
-    xacml_environment_t * env= calloc(1,sizeof(struct xacml_environment));
+    return xacml_environment_create_in(NULL);
+}
+
+xacml_environment_t * xacml_environment_create_in(xacml_arena_t * arena) {
+    xacml_environment_t * env= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_environment));
     if (env == NULL) {
         pep_log_error("xacml_environment_create: can't allocate xacml_environment_t.");
         return NULL;
     }
-    env->attributes= pep_llist_create();
+    env->arena= XACML_ARENA(arena);
+    env->attributes= xacml_vector_create(env->arena);
     if (env->attributes == NULL) {
         pep_log_error("xacml_environment_create: can't create attributes list.");
-        free(env);
+        xacml_free(env->arena,env);
         return NULL;
     }
     return env;
@@ -47,7 +53,7 @@ int xacml_environment_addattribute(xacml_environment_t * env, xacml_attribute_t
         pep_log_error("xacml_environment_addattribute: NULL environment or attribute.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(env->attributes,attr) != LLIST_OK) {
+    if (pep_vector_add(env->attributes,attr) != VECTOR_OK) {
         pep_log_error("xacml_environment_addattribute: can't add attribute to list.");
         return PEP_XACML_ERROR;
     }
@@ -59,7 +65,7 @@ size_t xacml_environment_attributes_length(const xacml_environment_t * env) {
         pep_log_warn("xacml_environment_attributes_length: NULL environment.");
         return 0;
     }
-    return pep_llist_length(env->attributes);
+    return pep_vector_length(env->attributes);
 
 }
 
@@ -68,14 +74,16 @@ xacml_attribute_t * xacml_environment_getattribute(const xacml_environment_t * e
         pep_log_error("xacml_environment_getattribute: NULL environment.");
         return NULL;
     }
-    return pep_llist_get(env->attributes, index);
+    return pep_vector_get(env->attributes, index);
 
 }
 
 void xacml_environment_delete(xacml_environment_t * env) {
     if (env == NULL) return;
-    pep_llist_delete_elements(env->attributes,(pep_llist_delete_elt_f)xacml_attribute_delete);
-    pep_llist_delete(env->attributes);
+    pep_vector_delete_elements(env->attributes,(pep_vector_delete_elt_f)xacml_attribute_delete);
+    /* released with the arena */
+    if (env->arena != NULL) return;
+    pep_vector_delete(env->attributes);
     free(env);
     env= NULL;
 }
@@ -38,6 +38,10 @@ typedef enum {
     PEP_ERR_MARSHALLING_IO,
     PEP_ERR_UNMARSHALLING_HESSIAN,
     PEP_ERR_UNMARSHALLING_IO,
+    PEP_ERR_HANDLE_FROZEN,
+    PEP_ERR_ASYNC,
+    PEP_ERR_ASYNC_ABORTED,
+    PEP_ERR_SHARE_IN_USE,
     PEP_ERR_CURL                    = 1024,
 } pep_error_t;
 */
@@ -54,7 +58,7 @@ const char * pep_strerror(pep_error_t pep_errno) {
         return "NULL pointer error";
         
     case PEP_ERR_LLIST:
-        return "linkedlist error";
+        return "list error";
         
     case PEP_ERR_PIP_INIT:
         return "PIP init error";
@@ -86,6 +90,18 @@ const char * pep_strerror(pep_error_t pep_errno) {
     case PEP_ERR_UNMARSHALLING_IO:
         return "Unmarshalling IO error";
         
+    case PEP_ERR_HANDLE_FROZEN:
+        return "PEP handle frozen";
+        
+    case PEP_ERR_ASYNC:
+        return "asynchronous engine error";
+        
+    case PEP_ERR_ASYNC_ABORTED:
+        return "asynchronous authorization aborted";
+        
+    case PEP_ERR_SHARE_IN_USE:
+        return "share still used by a PEP handle";
+        
     default:
         /* should be PEP_ERR_CURL. curl_easy_strerror returns "Unkown error" if no match */
         return curl_easy_strerror(pep_errno - PEP_ERR_CURL);
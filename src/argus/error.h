@@ -60,7 +60,7 @@ typedef enum {
     PEP_OK = 0, /**< OK, No error */
     PEP_ERR_MEMORY, /**< Memory allocation error */
     PEP_ERR_NULL_POINTER, /**< NULL pointer exception */
-    PEP_ERR_LLIST, /**< Linked list allocation error */
+    PEP_ERR_LLIST, /**< List (vector) allocation error */
     PEP_ERR_PIP_INIT, /**< PIP pip_init_func() error in pep_addpip(pep_pip_t *) */
     PEP_ERR_OH_INIT, /**< Obligation Hanlder oh_init_func() error in pep_addobligationhandler(pep_obligationhandler_t *) */
     PEP_ERR_OPTION_INVALID, /**< PEP client option invalid in pep_setoption(pep_option_t,args) */
@@ -71,6 +71,10 @@ typedef enum {
     PEP_ERR_MARSHALLING_IO, /**< IO error in pep_authorize(pep_request_t **,pep_response_t **) */
     PEP_ERR_UNMARSHALLING_HESSIAN, /**< Hessian unmarshalling error in pep_authorize(pep_request_t **,pep_response_t **) */
     PEP_ERR_UNMARSHALLING_IO, /**< IO error in pep_authorize(pep_request_t **,pep_response_t **) */
+    PEP_ERR_HANDLE_FROZEN, /**< PEP handle configuration changed after pep_freeze(pep) */
+    PEP_ERR_ASYNC, /**< Asynchronous engine (libcurl multi handle) error in pep_authorize_async(pep,...) or pep_async_perform(pep,...) */
+    PEP_ERR_ASYNC_ABORTED, /**< Asynchronous authorization aborted by pep_destroy(pep) */
+    PEP_ERR_SHARE_IN_USE, /**< Share still used by a PEP handle in pep_share_delete(share) */
     PEP_ERR_CURL = 1024 /**< Any CURL error (MUST BE LAST OF ENUM)*/
 } pep_error_t;
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _INTERNAL_XACML_H_
+#define _INTERNAL_XACML_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * INTERNAL XACML object model allocation functions
+ */
+#include "hessian.h" /* ../hessian/hessian.h */
+#include "vector.h" /* ../util/vector.h */
+
+#include "xacml.h"
+
+/*
+ * The public XACML arena is a Hessian arena.
+ */
+#define XACML_ARENA(arena) ((hessian_arena_t *)(arena))
+
+/*
+ * Allocates zeroed memory from the arena, or from the heap if the arena is
+ * NULL. xacml_free does nothing for an arena.
+ */
+void * xacml_calloc(hessian_arena_t * arena, size_t size);
+void xacml_free(hessian_arena_t * arena, void * ptr);
+
+/*
+ * Creates an empty vector allocated from the arena, or from the heap if the
+ * arena is NULL.
+ */
+pep_vector_t * xacml_vector_create(hessian_arena_t * arena);
+
+/*
+ * An arena owned by the XACML objects created for it, allocated in the arena
+ * itself: a response and the request relinquished from it. The arena is
+ * deleted with its last owner.
+ */
+typedef struct xacml_arena_owner {
+    hessian_arena_t * arena;
+    int refs;
+} xacml_arena_owner_t;
+
+xacml_arena_owner_t * xacml_arena_owner_create(size_t block_size);
+void xacml_arena_owner_acquire(xacml_arena_owner_t * owner);
+void xacml_arena_owner_release(xacml_arena_owner_t * owner);
+
+/*
+ * Creates an empty response in its own arena, the objects added to it are
+ * created in xacml_response_getarena(response). xacml_response_delete()
+ * deletes the arena.
+ */
+xacml_response_t * xacml_response_create_owned(size_t block_size);
+xacml_arena_t * xacml_response_getarena(const xacml_response_t * response);
+
+/*
+ * Makes the request, created in the arena of the owner, an owner of it too.
+ */
+void xacml_request_setowner(xacml_request_t * request, xacml_arena_owner_t * owner);
+
+/*
+ * Length-carrying string: the bytes length and the UTF-8 chars length of the
+ * null terminated string, the UTF-8 length is counted on first use.
+ */
+#define XACML_UTF8_UNKNOWN ((size_t)-1)
+
+typedef struct xacml_string {
+    const char * string; /* NULL if not set */
+    size_t length; /* bytes */
+    size_t utf8_length; /* UTF-8 chars or XACML_UTF8_UNKNOWN */
+} xacml_string_t;
+
+/*
+ * Sets the string to a copy of the length bytes, allocated from the arena or
+ * from the heap if the arena is NULL. The previous string is released, a NULL
+ * string clears it. Returns PEP_XACML_OK or PEP_XACML_ERROR.
+ */
+int xacml_string_set(hessian_arena_t * arena, xacml_string_t * string, const char * bytes, size_t length);
+void xacml_string_clear(hessian_arena_t * arena, xacml_string_t * string);
+
+/*
+ * Creates a string and its copy of the length bytes in a single allocation,
+ * released with xacml_free().
+ */
+xacml_string_t * xacml_string_create(hessian_arena_t * arena, const char * bytes, size_t length);
+
+/*
+ * Returns the UTF-8 chars length of the string, counted and cached on first use.
+ */
+size_t xacml_string_utf8_length(const xacml_string_t * string);
+
+/*
+ * XACML Attribute length-carrying strings, NULL if not set.
+ */
+const xacml_string_t * xacml_attribute_getidstring(const xacml_attribute_t * attr);
+const xacml_string_t * xacml_attribute_getdatatypestring(const xacml_attribute_t * attr);
+const xacml_string_t * xacml_attribute_getissuerstring(const xacml_attribute_t * attr);
+const xacml_string_t * xacml_attribute_getvaluestring(const xacml_attribute_t * attr, int index);
+
+/*
+ * Returns the atom of the id_l bytes identifier, without registering it.
+ */
+xacml_atom_t xacml_atom_lookup_n(const char * id, size_t id_l);
+
+/*
+ * Copies the id_l bytes identifier in the arena, or in the heap if the arena
+ * is NULL, and sets its atom. An interned identifier is shared with the atom
+ * table and not copied. Returns NULL if the copy can't be allocated.
+ */
+const char * xacml_id_copy(hessian_arena_t * arena, const char * id, size_t id_l, xacml_atom_t * atom);
+
+/*
+ * Frees an identifier copied by xacml_id_copy().
+ */
+void xacml_id_free(hessian_arena_t * arena, const char * id, xacml_atom_t atom);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
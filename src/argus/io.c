@@ -15,15 +15,23 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "io.h"
 #include "hessian.h" /* ../hessian/hessian.h */
 #include "log.h" /* ../util/log.h */
 
+#include "i_xacml.h"
+
 /** functions return codes  */
 #define PEP_IO_OK     0
 #define PEP_IO_ERROR -1
+#define PEP_IO_REF    1 /* Hessian ref read, the object tree is required */
+#define PEP_IO_MORE   2 /* partial input, more bytes are required */
+
+/** the own arena block size of an unmarshalled response */
+#define XACML_RESPONSE_ARENA_SIZE 4096
 
 /**
  * Hessian 1.0 marshalling/unmarshalling prototypes.
@@ -49,6 +57,51 @@ static int xacml_statuscode_unmarshal(xacml_statuscode_t ** statuscode, const he
 static int xacml_obligation_unmarshal(xacml_obligation_t ** obligation, const hessian_object_t * h_obligation);
 static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** attr, const hessian_object_t * h_attribute);
 
+/**
+ * The unmarshallers fetch the known pair<key>s of the Hessian map with
+ * hessian_map_get(), the other pairs are ignored with a warning.
+ */
+static void xacml_unmarshal_unknownkeys(const hessian_object_t * h_map, size_t known_l, const char * func);
+
+/**
+ * Hessian 1.0 direct marshalling prototypes: the XACML objects are written
+ * into the output buffer without building the Hessian objects.
+ *
+ * Returns PEP_IO_OK or PEP_IO_ERROR.
+ */
+static int xacml_attribute_write(const xacml_attribute_t * attr, pep_buffer_t * output);
+static int xacml_subject_write(const xacml_subject_t * subject, pep_buffer_t * output);
+static int xacml_resource_write(const xacml_resource_t * resource, pep_buffer_t * output);
+static int xacml_action_write(const xacml_action_t * action, pep_buffer_t * output);
+static int xacml_environment_write(const xacml_environment_t * env, pep_buffer_t * output);
+static int xacml_request_write(const xacml_request_t * request, pep_buffer_t * output);
+
+/**
+ * Hessian 1.0 pull reader unmarshalling prototypes: the token is the first
+ * token of the object, already read.
+ *
+ * Returns PEP_IO_OK, PEP_IO_ERROR or PEP_IO_REF.
+ */
+static int xacml_attribute_read(hessian_reader_t * reader, hessian_token_t token, xacml_attribute_t ** attr, xacml_arena_t * arena);
+static int xacml_subject_read(hessian_reader_t * reader, hessian_token_t token, xacml_subject_t ** subject, xacml_arena_t * arena);
+static int xacml_resource_read(hessian_reader_t * reader, hessian_token_t token, xacml_resource_t ** resource, xacml_arena_t * arena);
+static int xacml_action_read(hessian_reader_t * reader, hessian_token_t token, xacml_action_t ** action, xacml_arena_t * arena);
+static int xacml_environment_read(hessian_reader_t * reader, hessian_token_t token, xacml_environment_t ** env, xacml_arena_t * arena);
+static int xacml_request_read(hessian_reader_t * reader, hessian_token_t token, xacml_request_t ** request, xacml_arena_t * arena);
+static int xacml_response_read(hessian_reader_t * reader, hessian_token_t token, xacml_response_t ** response, xacml_arena_t * arena);
+static int xacml_result_read(hessian_reader_t * reader, hessian_token_t token, xacml_result_t ** result, xacml_arena_t * arena);
+static int xacml_status_read(hessian_reader_t * reader, hessian_token_t token, xacml_status_t ** status, xacml_arena_t * arena);
+static int xacml_statuscode_read(hessian_reader_t * reader, hessian_token_t token, xacml_statuscode_t ** statuscode, xacml_arena_t * arena);
+static int xacml_obligation_read(hessian_reader_t * reader, hessian_token_t token, xacml_obligation_t ** obligation, xacml_arena_t * arena);
+static int xacml_attributeassignment_read(hessian_reader_t * reader, hessian_token_t token, xacml_attributeassignment_t ** attr, xacml_arena_t * arena);
+
+static void xacml_unmarshal_unknownkeys(const hessian_object_t * h_map, size_t known_l, const char * func) {
+    size_t map_l= hessian_map_length(h_map);
+    if (map_l > known_l) {
+        pep_log_warn("%s: %d unknown Hessian map<key>s ignored.",func,(int)(map_l - known_l));
+    }
+}
+
 /**
  * Returns the Hessian map for this Action or a Hessian null if the Action is null.
  */
@@ -116,8 +169,8 @@ static int xacml_action_marshal(const xacml_action_t * action, hessian_object_t
 static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t * h_action) {
     const char * map_type;
     xacml_action_t * action;
-    size_t map_l;
-    int i;
+    hessian_object_t * h_attributes;
+    size_t known_l;
     if (hessian_gettype(h_action) != HESSIAN_MAP) {
         pep_log_error("xacml_action_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_action), hessian_getclassname(h_action));
         return PEP_IO_ERROR;
@@ -137,53 +190,36 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_action);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_action,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_action_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_action_delete(action);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_action_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+    h_attributes= hessian_map_get(h_action,XACML_HESSIAN_ACTION_ATTRIBUTES);
+    if (h_attributes != NULL) {
+        size_t h_attributes_l;
+        int j;
+        if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
+            pep_log_error("xacml_action_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_ACTION_ATTRIBUTES);
             xacml_action_delete(action);
             return PEP_IO_ERROR;
         }
-        if (strcmp(XACML_HESSIAN_ACTION_ATTRIBUTES,key) == 0) {
-            hessian_object_t * h_attributes= hessian_map_getvalue(h_action,i);
-            size_t h_attributes_l;
-            int j;
-            if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
-                pep_log_error("xacml_action_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+        h_attributes_l= hessian_list_length(h_attributes);
+        for(j= 0; j<h_attributes_l; j++) {
+            hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
+            xacml_attribute_t * attribute= NULL;
+            if (xacml_attribute_unmarshal(&attribute,h_attr)) {
+                pep_log_error("xacml_action_unmarshal: can't unmarshal XACML attribute at: %d.",j);
                 xacml_action_delete(action);
                 return PEP_IO_ERROR;
             }
-            h_attributes_l= hessian_list_length(h_attributes);
-            for(j= 0; j<h_attributes_l; j++) {
-                hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
-                xacml_attribute_t * attribute= NULL;
-                if (xacml_attribute_unmarshal(&attribute,h_attr)) {
-                    pep_log_error("xacml_action_unmarshal: can't unmarshal XACML attribute at: %d.",j);
-                    xacml_action_delete(action);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_action_addattribute(action,attribute) != PEP_XACML_OK) {
-                    pep_log_error("xacml_action_unmarshal: can't add XACML attribute to XACML action at: %d",j);
-                    xacml_action_delete(action);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
+            if (xacml_action_addattribute(action,attribute) != PEP_XACML_OK) {
+                pep_log_error("xacml_action_unmarshal: can't add XACML attribute to XACML action at: %d",j);
+                xacml_action_delete(action);
+                xacml_attribute_delete(attribute);
+                return PEP_IO_ERROR;
             }
         }
-        else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_action_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_action,known_l,"xacml_action_unmarshal");
     *act= action;
     return PEP_IO_OK;
 }
@@ -195,7 +231,7 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
 static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_object_t ** h_attr) {
     hessian_object_t * h_attribute, * h_value, * h_key, * h_values, * h_values_key;
     const char * attr_id, * attr_dt, * attr_issuer;
-    size_t values_l;
+    size_t attr_id_l, attr_dt_l, attr_issuer_l, values_l;
     int i;
     if (attr == NULL) {
         pep_log_error("xacml_attribute_marshal: NULL attribute object.");
@@ -208,8 +244,8 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
     }
 
     /* mandatory attribute */
-    attr_id= xacml_attribute_getid(attr);
-    h_value= hessian_create(HESSIAN_STRING,attr_id);
+    attr_id= xacml_attribute_getid_n(attr,&attr_id_l);
+    h_value= hessian_string_create_n(attr_id,attr_id_l);
     if (h_value== NULL) {
         pep_log_error("xacml_attribute_marshal: can't create Hessian string: %s", attr_id);
         hessian_delete(h_attribute);
@@ -224,10 +260,10 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
         return PEP_IO_ERROR;
     }
     /* optional datatype */
-    attr_dt= xacml_attribute_getdatatype(attr);
+    attr_dt= xacml_attribute_getdatatype_n(attr,&attr_dt_l);
     if (attr_dt != NULL) {
         h_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_DATATYPE);
-        h_value= hessian_create(HESSIAN_STRING,attr_dt);
+        h_value= hessian_string_create_n(attr_dt,attr_dt_l);
         if (hessian_map_add(h_attribute,h_key,h_value) != HESSIAN_OK) {
             pep_log_error("xacml_attribute_marshal: can't add pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_DATATYPE,attr_dt,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
             hessian_delete(h_attribute);
@@ -237,10 +273,10 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
         }
     }
     /* optional issuer */
-    attr_issuer= xacml_attribute_getissuer(attr);
+    attr_issuer= xacml_attribute_getissuer_n(attr,&attr_issuer_l);
     if (attr_issuer != NULL) {
         h_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_ISSUER);
-        h_value= hessian_create(HESSIAN_STRING,attr_issuer);
+        h_value= hessian_string_create_n(attr_issuer,attr_issuer_l);
         if (hessian_map_add(h_attribute,h_key,h_value) != HESSIAN_OK) {
             pep_log_error("xacml_attribute_marshal: can't add pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ISSUER,attr_issuer,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
             hessian_delete(h_attribute);
@@ -258,8 +294,9 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
     }
     values_l= xacml_attribute_values_length(attr);
     for (i= 0; i < values_l; i++) {
-        const char * value= xacml_attribute_getvalue(attr,i);
-        h_value= hessian_create(HESSIAN_STRING,value);
+        size_t value_l;
+        const char * value= xacml_attribute_getvalue_n(attr,i,&value_l);
+        h_value= hessian_string_create_n(value,value_l);
         if (h_value == NULL) {
             pep_log_error("xacml_attribute_marshal: can't create Hessian string: %s at: %d.", value, i);
             hessian_delete(h_attribute);
@@ -289,8 +326,8 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
 static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_object_t * h_attribute) {
     const char * map_type;
     xacml_attribute_t * attribute;
-    size_t map_l;
-    int i;
+    hessian_object_t * h_string, * h_values;
+    size_t known_l;
     if (hessian_gettype(h_attribute) != HESSIAN_MAP) {
         pep_log_error("xacml_attribute_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_attribute), hessian_getclassname(h_attribute));
         return PEP_IO_ERROR;
@@ -311,111 +348,102 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_attribute);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_attribute,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_attribute_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+
+    /* id (mandatory) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTE_ID);
+    if (h_string != NULL) {
+        const char * id;
+        size_t id_l;
+        if (hessian_gettype(h_string) != HESSIAN_STRING) {
+            pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string.",XACML_HESSIAN_ATTRIBUTE_ID);
+            xacml_attribute_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        id= hessian_string_getstring_n(h_string,&id_l);
+        if (xacml_attribute_setid_n(attribute,id,id_l) != PEP_XACML_OK) {
+            pep_log_error("xacml_attribute_unmarshal: can't set id: %s to XACML attribute",id);
+            xacml_attribute_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* datatype (optional) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTE_DATATYPE);
+    if (h_string != NULL) {
+        const char * datatype= NULL;
+        size_t datatype_l= 0;
+        hessian_t h_string_type= hessian_gettype(h_string);
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_ATTRIBUTE_DATATYPE);
             xacml_attribute_delete(attribute);
             return PEP_IO_ERROR;
         }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_attribute_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+        if (h_string_type == HESSIAN_STRING) {
+            datatype= hessian_string_getstring_n(h_string,&datatype_l);
+        }
+        if (xacml_attribute_setdatatype_n(attribute,datatype,datatype_l) != PEP_XACML_OK) {
+            pep_log_error("xacml_attribute_unmarshal: can't set datatype: %s to XACML attribute",datatype);
             xacml_attribute_delete(attribute);
             return PEP_IO_ERROR;
         }
 
-        /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_ATTRIBUTE_ID,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            const char * id;
-            if (hessian_gettype(h_string) != HESSIAN_STRING) {
-                pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                xacml_attribute_delete(attribute);
-                return PEP_IO_ERROR;
-            }
-            id= hessian_string_getstring(h_string);
-            if (xacml_attribute_setid(attribute,id) != PEP_XACML_OK) {
-                pep_log_error("xacml_attribute_unmarshal: can't set id: %s to XACML attribute at: %d",id,i);
-                xacml_attribute_delete(attribute);
-                return PEP_IO_ERROR;
-            }
+        known_l++;
+    }
+    /* issuer (optional) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTE_ISSUER);
+    if (h_string != NULL) {
+        const char * issuer = NULL;
+        size_t issuer_l= 0;
+        hessian_t h_string_type= hessian_gettype(h_string);
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_ATTRIBUTE_ISSUER);
+            xacml_attribute_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        if (h_string_type == HESSIAN_STRING) {
+            issuer= hessian_string_getstring_n(h_string,&issuer_l);
+        }
+        if (xacml_attribute_setissuer_n(attribute,issuer,issuer_l) != PEP_XACML_OK) {
+            pep_log_error("xacml_attribute_unmarshal: can't set issuer: %s to XACML attribute",issuer);
+            xacml_attribute_delete(attribute);
+            return PEP_IO_ERROR;
         }
-        /* datatype (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_DATATYPE,key) == 0) {
-            const char * datatype= NULL;
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_attribute_delete(attribute);
-                return PEP_IO_ERROR;
-            }
-            if (h_string_type == HESSIAN_STRING) {
-                datatype= hessian_string_getstring(h_string);
-            }
-            if (xacml_attribute_setdatatype(attribute,datatype) != PEP_XACML_OK) {
-                pep_log_error("xacml_attribute_unmarshal: can't set datatype: %s to XACML attribute at: %d",datatype,i);
-                xacml_attribute_delete(attribute);
-                return PEP_IO_ERROR;
-            }
 
+        known_l++;
+    }
+    /* values list */
+    h_values= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTE_VALUES);
+    if (h_values != NULL) {
+        size_t h_values_l;
+        int j;
+        if (hessian_gettype(h_values) != HESSIAN_LIST) {
+            pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_ATTRIBUTE_VALUES);
+            xacml_attribute_delete(attribute);
+            return PEP_IO_ERROR;
         }
-        /* issuer (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_ISSUER,key) == 0) {
-            const char * issuer = NULL;
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
+        h_values_l= hessian_list_length(h_values);
+        for(j= 0; j<h_values_l; j++) {
+            const char * value;
+            size_t value_l;
+            hessian_object_t * h_value= hessian_list_get(h_values,j);
+            if (hessian_gettype(h_value) != HESSIAN_STRING) {
+                pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",XACML_HESSIAN_ATTRIBUTE_VALUES,j);
                 xacml_attribute_delete(attribute);
                 return PEP_IO_ERROR;
             }
-            if (h_string_type == HESSIAN_STRING) {
-                issuer= hessian_string_getstring(h_string);
-            }
-            if (xacml_attribute_setissuer(attribute,issuer) != PEP_XACML_OK) {
-                pep_log_error("xacml_attribute_unmarshal: can't set issuer: %s to XACML attribute at: %d",issuer,i);
+            value= hessian_string_getstring_n(h_value,&value_l);
+            if (xacml_attribute_addvalue_n(attribute,value,value_l) != PEP_XACML_OK) {
+                pep_log_error("xacml_attribute_unmarshal: can't add value: %s to XACML attribute at: %d",value,j);
                 xacml_attribute_delete(attribute);
                 return PEP_IO_ERROR;
             }
-
         }
-        /* values list */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_VALUES,key) == 0) {
-            hessian_object_t * h_values= hessian_map_getvalue(h_attribute,i);
-            size_t h_values_l;
-            int j;
-            if (hessian_gettype(h_values) != HESSIAN_LIST) {
-                pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian list.",key);
-                xacml_attribute_delete(attribute);
-                return PEP_IO_ERROR;
-            }
-            h_values_l= hessian_list_length(h_values);
-            for(j= 0; j<h_values_l; j++) {
-                const char * value;
-                hessian_object_t * h_value= hessian_list_get(h_values,j);
-                if (hessian_gettype(h_value) != HESSIAN_STRING) {
-                    pep_log_error("xacml_attribute_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
-                value= hessian_string_getstring(h_value);
-                if (xacml_attribute_addvalue(attribute,value) != PEP_XACML_OK) {
-                    pep_log_error("xacml_attribute_unmarshal: can't add value: %s to XACML attribute at: %d",value,j);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
-            }
 
-        }
-        else {
-            pep_log_warn("xacml_attribute_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_attribute,known_l,"xacml_attribute_unmarshal");
     *attr= attribute;
     return PEP_IO_OK;
 }
@@ -482,8 +510,8 @@ static int xacml_environment_marshal(const xacml_environment_t * env, hessian_ob
 static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian_object_t * h_environment) {
     const char * map_type;
     xacml_environment_t * environment;
-    size_t map_l;
-    int i;
+    hessian_object_t * h_attributes;
+    size_t known_l;
     if (hessian_gettype(h_environment) != HESSIAN_MAP) {
         pep_log_error("xacml_environment_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_environment), hessian_getclassname(h_environment));
         return PEP_IO_ERROR;
@@ -503,53 +531,36 @@ static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_environment);
-    for(i= 0; i<map_l; i++) {
-        const char * key;
-        hessian_object_t * h_map_key= hessian_map_getkey(h_environment,i);
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_environment_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_environment_delete(environment);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_environment_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+    h_attributes= hessian_map_get(h_environment,XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
+    if (h_attributes != NULL) {
+        size_t h_attributes_l;
+        int j;
+        if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
+            pep_log_error("xacml_environment_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
             xacml_environment_delete(environment);
             return PEP_IO_ERROR;
         }
-        if (strcmp(XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES,key) == 0) {
-            hessian_object_t * h_attributes= hessian_map_getvalue(h_environment,i);
-            size_t h_attributes_l;
-            int j;
-            if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
-                pep_log_error("xacml_environment_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+        h_attributes_l= hessian_list_length(h_attributes);
+        for(j= 0; j<h_attributes_l; j++) {
+            hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
+            xacml_attribute_t * attribute= NULL;
+            if (xacml_attribute_unmarshal(&attribute,h_attr)) {
+                pep_log_error("xacml_environment_unmarshal: can't unmarshal XACML attribute at: %d.",j);
                 xacml_environment_delete(environment);
                 return PEP_IO_ERROR;
             }
-            h_attributes_l= hessian_list_length(h_attributes);
-            for(j= 0; j<h_attributes_l; j++) {
-                hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
-                xacml_attribute_t * attribute= NULL;
-                if (xacml_attribute_unmarshal(&attribute,h_attr)) {
-                    pep_log_error("xacml_environment_unmarshal: can't unmarshal XACML attribute at: %d.",j);
-                    xacml_environment_delete(environment);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_environment_addattribute(environment,attribute) != PEP_XACML_OK) {
-                    pep_log_error("xacml_environment_unmarshal: can't add XACML attribute to XACML environment at: %d",j);
-                    xacml_environment_delete(environment);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
+            if (xacml_environment_addattribute(environment,attribute) != PEP_XACML_OK) {
+                pep_log_error("xacml_environment_unmarshal: can't add XACML attribute to XACML environment at: %d",j);
+                xacml_environment_delete(environment);
+                xacml_attribute_delete(attribute);
+                return PEP_IO_ERROR;
             }
         }
-        else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_environment_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_environment,known_l,"xacml_environment_unmarshal");
     *env= environment;
     return PEP_IO_OK;
 }
@@ -679,8 +690,9 @@ static int xacml_request_marshal(const xacml_request_t * request, hessian_object
 static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_t * h_request) {
     const char * map_type;
     xacml_request_t * request;
-    size_t map_l;
-    int i;
+    hessian_object_t * h_subjects, * h_resources, * h_action, * h_environment;
+    size_t known_l;
+    int j;
     if (hessian_gettype(h_request) != HESSIAN_MAP) {
         pep_log_error("xacml_request_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_request), hessian_getclassname(h_request));
         return PEP_IO_ERROR;
@@ -701,116 +713,101 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_request);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_request,i);
-        const char * key;
-        int j;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_request_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+    /* subjects list */
+    h_subjects= hessian_map_get(h_request,XACML_HESSIAN_REQUEST_SUBJECTS);
+    if (h_subjects != NULL) {
+        size_t h_subjects_l;
+        if (hessian_gettype(h_subjects) != HESSIAN_LIST) {
+            pep_log_error("xacml_request_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_REQUEST_SUBJECTS);
             xacml_request_delete(request);
             return PEP_IO_ERROR;
         }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_request_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+        h_subjects_l= hessian_list_length(h_subjects);
+        for(j= 0; j<h_subjects_l; j++) {
+            hessian_object_t * h_subject= hessian_list_get(h_subjects,j);
+            xacml_subject_t * subject= NULL;
+            if (xacml_subject_unmarshal(&subject,h_subject) != PEP_IO_OK) {
+                pep_log_error("xacml_request_unmarshal: can't unmarshal XACML subject at: %d.",j);
+                xacml_request_delete(request);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_request_addsubject(request,subject) != PEP_XACML_OK) {
+                pep_log_error("xacml_request_unmarshal: can't add XACML subject to XACML request at: %d",j);
+                xacml_request_delete(request);
+                xacml_subject_delete(subject);
+                return PEP_IO_ERROR;
+            }
+        }
+        known_l++;
+    }
+    /* resources list */
+    h_resources= hessian_map_get(h_request,XACML_HESSIAN_REQUEST_RESOURCES);
+    if (h_resources != NULL) {
+        size_t h_resources_l;
+        if (hessian_gettype(h_resources) != HESSIAN_LIST) {
+            pep_log_error("xacml_request_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_REQUEST_RESOURCES);
             xacml_request_delete(request);
             return PEP_IO_ERROR;
         }
-        /* subjects list */
-        if (strcmp(XACML_HESSIAN_REQUEST_SUBJECTS,key) == 0) {
-            hessian_object_t * h_subjects= hessian_map_getvalue(h_request,i);
-            size_t h_subjects_l;
-            if (hessian_gettype(h_subjects) != HESSIAN_LIST) {
-                pep_log_error("xacml_request_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+        h_resources_l= hessian_list_length(h_resources);
+        for(j= 0; j<h_resources_l; j++) {
+            hessian_object_t * h_resource= hessian_list_get(h_resources,j);
+            xacml_resource_t * resource= NULL;
+            if (xacml_resource_unmarshal(&resource,h_resource) != PEP_IO_OK) {
+                pep_log_error("xacml_request_unmarshal: can't unmarshal XACML resource at: %d.",j);
                 xacml_request_delete(request);
                 return PEP_IO_ERROR;
             }
-            h_subjects_l= hessian_list_length(h_subjects);
-            for(j= 0; j<h_subjects_l; j++) {
-                hessian_object_t * h_subject= hessian_list_get(h_subjects,j);
-                xacml_subject_t * subject= NULL;
-                if (xacml_subject_unmarshal(&subject,h_subject) != PEP_IO_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't unmarshal XACML subject at: %d.",j);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_request_addsubject(request,subject) != PEP_XACML_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't add XACML subject to XACML request at: %d",j);
-                    xacml_request_delete(request);
-                    xacml_subject_delete(subject);
-                    return PEP_IO_ERROR;
-                }
+            if (xacml_request_addresource(request,resource) != PEP_XACML_OK) {
+                pep_log_error("xacml_request_unmarshal: can't add XACML resource to XACML request at: %d",j);
+                xacml_request_delete(request);
+                xacml_resource_delete(resource);
+                return PEP_IO_ERROR;
             }
         }
-        /* resources list */
-        else if (strcmp(XACML_HESSIAN_REQUEST_RESOURCES,key) == 0) {
-            hessian_object_t * h_resources= hessian_map_getvalue(h_request,i);
-            size_t h_resources_l;
-            if (hessian_gettype(h_resources) != HESSIAN_LIST) {
-                pep_log_error("xacml_request_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+        known_l++;
+    }
+    /* action (null) */
+    h_action= hessian_map_get(h_request,XACML_HESSIAN_REQUEST_ACTION);
+    if (h_action != NULL) {
+        xacml_action_t * action= NULL;
+        if (hessian_gettype(h_action) != HESSIAN_NULL) {
+            if (xacml_action_unmarshal(&action,h_action) != PEP_IO_OK) {
+                pep_log_error("xacml_request_unmarshal: can't unmarshal XACML action.");
                 xacml_request_delete(request);
                 return PEP_IO_ERROR;
             }
-            h_resources_l= hessian_list_length(h_resources);
-            for(j= 0; j<h_resources_l; j++) {
-                hessian_object_t * h_resource= hessian_list_get(h_resources,j);
-                xacml_resource_t * resource= NULL;
-                if (xacml_resource_unmarshal(&resource,h_resource) != PEP_IO_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't unmarshal XACML resource at: %d.",j);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_request_addresource(request,resource) != PEP_XACML_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't add XACML resource to XACML request at: %d",j);
-                    xacml_request_delete(request);
-                    xacml_resource_delete(resource);
-                    return PEP_IO_ERROR;
-                }
+            if (xacml_request_setaction(request,action) != PEP_XACML_OK) {
+                pep_log_error("xacml_request_unmarshal: can't set XACML action to XACML request.");
+                xacml_action_delete(action);
+                xacml_request_delete(request);
+                return PEP_IO_ERROR;
             }
         }
-        /* action (null) */
-        else if (strcmp(XACML_HESSIAN_REQUEST_ACTION,key) == 0) {
-            hessian_object_t * h_action= hessian_map_getvalue(h_request,i);
-            xacml_action_t * action= NULL;
-            if (hessian_gettype(h_action) != HESSIAN_NULL) {
-                if (xacml_action_unmarshal(&action,h_action) != PEP_IO_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't unmarshal XACML action at: %d.",i);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_request_setaction(request,action) != PEP_XACML_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't set XACML action to XACML request at: %d.",i);
-                    xacml_action_delete(action);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
+        known_l++;
+    }
+    /* environment (null) */
+    h_environment= hessian_map_get(h_request,XACML_HESSIAN_REQUEST_ENVIRONMENT);
+    if (h_environment != NULL) {
+        xacml_environment_t * environment= NULL;
+        if (hessian_gettype(h_environment) != HESSIAN_NULL) {
+            if (xacml_environment_unmarshal(&environment,h_environment) != PEP_IO_OK) {
+                pep_log_error("xacml_request_unmarshal: can't unmarshal XACML environment.");
+                xacml_request_delete(request);
+                return PEP_IO_ERROR;
             }
-        }
-        /* environment (null) */
-        else if (strcmp(XACML_HESSIAN_REQUEST_ENVIRONMENT,key) == 0) {
-            hessian_object_t * h_environment= hessian_map_getvalue(h_request,i);
-            xacml_environment_t * environment= NULL;
-            if (hessian_gettype(h_environment) != HESSIAN_NULL) {
-                if (xacml_environment_unmarshal(&environment,h_environment) != PEP_IO_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't unmarshal XACML environment at: %d.",i);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_request_setenvironment(request,environment) != PEP_XACML_OK) {
-                    pep_log_error("xacml_request_unmarshal: can't set XACML environment to XACML request at: %d.",i);
-                    xacml_environment_delete(environment);
-                    xacml_request_delete(request);
-                    return PEP_IO_ERROR;
-                }
+            if (xacml_request_setenvironment(request,environment) != PEP_XACML_OK) {
+                pep_log_error("xacml_request_unmarshal: can't set XACML environment to XACML request.");
+                xacml_environment_delete(environment);
+                xacml_request_delete(request);
+                return PEP_IO_ERROR;
             }
         }
-        /* unkown key ??? */
-        else {
-            pep_log_warn("xacml_request_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_request,known_l,"xacml_request_unmarshal");
 
     *req= request;
     return PEP_IO_OK;
@@ -890,8 +887,9 @@ static int xacml_resource_marshal(const xacml_resource_t * resource, hessian_obj
 static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_object_t * h_resource) {
     const char * map_type;
     xacml_resource_t * resource;
-    size_t map_l;
-    int i, j;
+    hessian_object_t * h_string, * h_attributes;
+    size_t known_l;
+    int j;
     if (hessian_gettype(h_resource) != HESSIAN_MAP) {
         pep_log_error("xacml_resource_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_resource), hessian_getclassname(h_resource));
         return PEP_IO_ERROR;
@@ -912,73 +910,57 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_resource);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_resource,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_resource_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+    /* content (can be null) */
+    h_string= hessian_map_get(h_resource,XACML_HESSIAN_RESOURCE_CONTENT);
+    if (h_string != NULL) {
+        hessian_t h_string_type= hessian_gettype(h_string);
+        const char * content;
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_resource_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_RESOURCE_CONTENT);
             xacml_resource_delete(resource);
             return PEP_IO_ERROR;
         }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_resource_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+        content= NULL;
+        if (h_string_type == HESSIAN_STRING) {
+            content= hessian_string_getstring(h_string);
+        }
+        if (xacml_resource_setcontent(resource,content) != PEP_XACML_OK) {
+            pep_log_error("xacml_resource_unmarshal: can't set content: %s to XACML resource.",content);
             xacml_resource_delete(resource);
             return PEP_IO_ERROR;
         }
-        /* content (can be null) */
-        if (strcmp(XACML_HESSIAN_RESOURCE_CONTENT,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_resource,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            const char * content;
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_resource_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_resource_delete(resource);
-                return PEP_IO_ERROR;
-            }
-            content= NULL;
-            if (h_string_type == HESSIAN_STRING) {
-                content= hessian_string_getstring(h_string);
-            }
-            if (xacml_resource_setcontent(resource,content) != PEP_XACML_OK) {
-                pep_log_error("xacml_resource_unmarshal: can't set content: %s to XACML resource.",content);
+        known_l++;
+    }
+    /* attributes list */
+    h_attributes= hessian_map_get(h_resource,XACML_HESSIAN_RESOURCE_ATTRIBUTES);
+    if (h_attributes != NULL) {
+        size_t h_attributes_l;
+        if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
+            pep_log_error("xacml_resource_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_RESOURCE_ATTRIBUTES);
+            xacml_resource_delete(resource);
+            return PEP_IO_ERROR;
+        }
+        h_attributes_l= hessian_list_length(h_attributes);
+        for(j= 0; j<h_attributes_l; j++) {
+            hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
+            xacml_attribute_t * attribute= NULL;
+            if (xacml_attribute_unmarshal(&attribute,h_attr) != PEP_IO_OK) {
+                pep_log_error("xacml_resource_unmarshal: can't unmarshal XACML attribute at: %d.",j);
                 xacml_resource_delete(resource);
                 return PEP_IO_ERROR;
             }
-        }
-        /* attributes list */
-        else if (strcmp(XACML_HESSIAN_RESOURCE_ATTRIBUTES,key) == 0) {
-            hessian_object_t * h_attributes= hessian_map_getvalue(h_resource,i);
-            size_t h_attributes_l;
-            if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
-                pep_log_error("xacml_resource_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+            if (xacml_resource_addattribute(resource,attribute) != PEP_XACML_OK) {
+                pep_log_error("xacml_resource_unmarshal: can't add XACML attribute to XACML resource at: %d",j);
                 xacml_resource_delete(resource);
+                xacml_attribute_delete(attribute);
                 return PEP_IO_ERROR;
             }
-            h_attributes_l= hessian_list_length(h_attributes);
-            for(j= 0; j<h_attributes_l; j++) {
-                hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
-                xacml_attribute_t * attribute= NULL;
-                if (xacml_attribute_unmarshal(&attribute,h_attr) != PEP_IO_OK) {
-                    pep_log_error("xacml_resource_unmarshal: can't unmarshal XACML attribute at: %d.",j);
-                    xacml_resource_delete(resource);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_resource_addattribute(resource,attribute) != PEP_XACML_OK) {
-                    pep_log_error("xacml_resource_unmarshal: can't add XACML attribute to XACML resource at: %d",j);
-                    xacml_resource_delete(resource);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
-            }
-        }
-        else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_resource_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
         }
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_resource,known_l,"xacml_resource_unmarshal");
     *res= resource;
     return PEP_IO_OK;
 }
@@ -1057,8 +1039,9 @@ static int xacml_subject_marshal(const xacml_subject_t * subject, hessian_object
 static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object_t * h_subject) {
     const char * map_type;
     xacml_subject_t * subject;
-    size_t map_l;
-    int i, j;
+    hessian_object_t * h_string, * h_attributes;
+    size_t known_l;
+    int j;
     if (hessian_gettype(h_subject) != HESSIAN_MAP) {
         pep_log_error("xacml_subject_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_subject), hessian_getclassname(h_subject));
         return PEP_IO_ERROR;
@@ -1079,759 +1062,2384 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_subject);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_subject,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_subject_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
+    /* known map pair<key>s */
+    known_l= 0;
+    /* category (can be null) */
+    h_string= hessian_map_get(h_subject,XACML_HESSIAN_SUBJECT_CATEGORY);
+    if (h_string != NULL) {
+        hessian_t h_string_type= hessian_gettype(h_string);
+        const char * category;
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_subject_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_SUBJECT_CATEGORY);
             xacml_subject_delete(subject);
             return PEP_IO_ERROR;
         }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_subject_unmarshal: Hessian map<key>: NULL string at: %d.",i);
+        category= NULL;
+        if (h_string_type == HESSIAN_STRING) {
+            category= hessian_string_getstring(h_string);
+        }
+        if (xacml_subject_setcategory(subject,category) != PEP_XACML_OK) {
+            pep_log_error("xacml_subject_unmarshal: can't set category: %s to XACML subject.",category);
             xacml_subject_delete(subject);
             return PEP_IO_ERROR;
         }
-        /* category (can be null) */
-        if (strcmp(XACML_HESSIAN_SUBJECT_CATEGORY,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_subject,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            const char * category;
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_subject_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_subject_delete(subject);
-                return PEP_IO_ERROR;
-            }
-            category= NULL;
-            if (h_string_type == HESSIAN_STRING) {
-                category= hessian_string_getstring(h_string);
-            }
-            if (xacml_subject_setcategory(subject,category) != PEP_XACML_OK) {
-                pep_log_error("xacml_subject_unmarshal: can't set category: %s to XACML subject.",category);
+        known_l++;
+    }
+    /* attributes list */
+    h_attributes= hessian_map_get(h_subject,XACML_HESSIAN_SUBJECT_ATTRIBUTES);
+    if (h_attributes != NULL) {
+        size_t h_attributes_l;
+        if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
+            pep_log_error("xacml_subject_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_SUBJECT_ATTRIBUTES);
+            xacml_subject_delete(subject);
+            return PEP_IO_ERROR;
+        }
+        h_attributes_l= hessian_list_length(h_attributes);
+        for(j= 0; j<h_attributes_l; j++) {
+            hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
+            xacml_attribute_t * attribute= NULL;
+            if (xacml_attribute_unmarshal(&attribute,h_attr) != PEP_IO_OK) {
+                pep_log_error("xacml_subject_unmarshal: can't unmarshal XACML attribute at: %d.",j);
                 xacml_subject_delete(subject);
                 return PEP_IO_ERROR;
             }
-        }
-        /* attributes list */
-        else if (strcmp(XACML_HESSIAN_SUBJECT_ATTRIBUTES,key) == 0) {
-            hessian_object_t * h_attributes= hessian_map_getvalue(h_subject,i);
-            size_t h_attributes_l;
-            if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
-                pep_log_error("xacml_subject_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
+            if (xacml_subject_addattribute(subject,attribute) != PEP_XACML_OK) {
+                pep_log_error("xacml_subject_unmarshal: can't add XACML attribute to XACML subject at: %d",j);
                 xacml_subject_delete(subject);
+                xacml_attribute_delete(attribute);
                 return PEP_IO_ERROR;
             }
-            h_attributes_l= hessian_list_length(h_attributes);
-            for(j= 0; j<h_attributes_l; j++) {
-                hessian_object_t * h_attr= hessian_list_get(h_attributes,j);
-                xacml_attribute_t * attribute= NULL;
-                if (xacml_attribute_unmarshal(&attribute,h_attr) != PEP_IO_OK) {
-                    pep_log_error("xacml_subject_unmarshal: can't unmarshal XACML attribute at: %d.",j);
-                    xacml_subject_delete(subject);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_subject_addattribute(subject,attribute) != PEP_XACML_OK) {
-                    pep_log_error("xacml_subject_unmarshal: can't add XACML attribute to XACML subject at: %d",j);
-                    xacml_subject_delete(subject);
-                    xacml_attribute_delete(attribute);
-                    return PEP_IO_ERROR;
-                }
-            }
-
-        }
-        else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_subject_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
         }
 
+        known_l++;
     }
+    xacml_unmarshal_unknownkeys(h_subject,known_l,"xacml_subject_unmarshal");
 
     *subj= subject;
     return PEP_IO_OK;
 }
 
 
-/* OK */
-pep_error_t xacml_request_marshalling(const xacml_request_t * request, pep_buffer_t * output) {
-    hessian_object_t * h_request= NULL;
-    if (xacml_request_marshal(request,&h_request) != PEP_IO_OK) {
-        pep_log_error("xacml_request_marshalling: can't marshal XACML request into Hessian object.");
-        /* pep_errmsg("failed to marshal XACML request into Hessian object"); */
-        return PEP_ERR_MARSHALLING_HESSIAN;
-    }
-    if (hessian_serialize(h_request,output) != HESSIAN_OK) {
-        pep_log_error("xacml_request_marshalling: failed to serialize Hessian object.");
-        hessian_delete(h_request);
-        /* pep_errmsg("failed to serialize Hessian object"); */
-        return PEP_ERR_MARSHALLING_IO;
-    }
-    hessian_delete(h_request);
-    return PEP_OK;
-}
-
-/* OK */
-pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, pep_buffer_t * input) {
-    hessian_object_t * h_response= hessian_deserialize(input);
-    if (h_response == NULL) {
-        pep_log_error("xacml_response_unmarshalling: failed to deserialize Hessian object.");
-        /* pep_errmsg("failed to deserialize base64 encoded Hessian object"); */
-        return PEP_ERR_UNMARSHALLING_IO;
-    }
-    if (xacml_response_unmarshal(response, h_response) != PEP_IO_OK) {
-        pep_log_error("xacml_response_unmarshalling: can't unmarshal XACML response from Hessian object.");
-        hessian_delete(h_response);
-        /* pep_errmsg("failed to unmarshal XACML response from Hessian object"); */
-        return PEP_ERR_UNMARSHALLING_HESSIAN;
-    }
-    hessian_delete(h_response);
-    return PEP_OK;
-
-}
+/*
+ * Pre-encoded class names and keys of the request maps, the same strings as
+ * the XACML_HESSIAN_* constants.
+ */
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_ATTRIBUTE_CLASSNAME,"org.glite.authz.common.model.Attribute");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ATTRIBUTE_ID,"id");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ATTRIBUTE_DATATYPE,"dataType");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ATTRIBUTE_ISSUER,"issuer");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ATTRIBUTE_VALUES,"values");
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_SUBJECT_CLASSNAME,"org.glite.authz.common.model.Subject");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_SUBJECT_CATEGORY,"category");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_SUBJECT_ATTRIBUTES,"attributes");
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_RESOURCE_CLASSNAME,"org.glite.authz.common.model.Resource");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_RESOURCE_CONTENT,"resourceContent");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_RESOURCE_ATTRIBUTES,"attributes");
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_ACTION_CLASSNAME,"org.glite.authz.common.model.Action");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ACTION_ATTRIBUTES,"attributes");
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_ENVIRONMENT_CLASSNAME,"org.glite.authz.common.model.Environment");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_ENVIRONMENT_ATTRIBUTES,"attributes");
+HESSIAN_ENCODED_MAP_START(XACML_ENCODED_REQUEST_CLASSNAME,"org.glite.authz.common.model.Request");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_REQUEST_SUBJECTS,"subjects");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_REQUEST_RESOURCES,"resources");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_REQUEST_ACTION,"action");
+HESSIAN_ENCODED_STRING(XACML_ENCODED_REQUEST_ENVIRONMENT,"environment");
 
-/* OK */
-static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_object_t * h_response) {
-    const char * map_type;
-    xacml_response_t * response;
-    size_t map_l;
-    int i, j;
-    if (hessian_gettype(h_response) != HESSIAN_MAP) {
-        pep_log_error("xacml_response_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_response), hessian_getclassname(h_response));
+/**
+ * Writes the Hessian map for this Attribute.
+ */
+static int xacml_attribute_write(const xacml_attribute_t * attr, pep_buffer_t * output) {
+    const xacml_string_t * attr_id, * attr_dt, * attr_issuer;
+    size_t values_l;
+    int i;
+    if (attr == NULL) {
+        pep_log_error("xacml_attribute_write: NULL attribute object.");
         return PEP_IO_ERROR;
     }
-    map_type= hessian_map_gettype(h_response);
-    if (map_type == NULL) {
-        pep_log_error("xacml_response_unmarshal: NULL Hessian map type.");
+    /* mandatory attribute */
+    attr_id= xacml_attribute_getidstring(attr);
+    if (attr_id == NULL) {
+        pep_log_error("xacml_attribute_write: NULL attribute id.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_RESPONSE_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_response_unmarshal: wrong Hessian map type: %s.",map_type);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ATTRIBUTE_CLASSNAME,output) != HESSIAN_OK
+        || HESSIAN_ENCODED_WRITE(XACML_ENCODED_ATTRIBUTE_ID,output) != HESSIAN_OK
+        || hessian_string_write_n(attr_id->string,attr_id->length,xacml_string_utf8_length(attr_id),output) != HESSIAN_OK) {
+        pep_log_error("xacml_attribute_write: can't write pair<'%s','%s'> of Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ID,attr_id->string,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
         return PEP_IO_ERROR;
     }
-
-    response= xacml_response_create();
+    /* optional datatype */
+    attr_dt= xacml_attribute_getdatatypestring(attr);
+    if (attr_dt != NULL) {
+        if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ATTRIBUTE_DATATYPE,output) != HESSIAN_OK
+            || hessian_string_write_n(attr_dt->string,attr_dt->length,xacml_string_utf8_length(attr_dt),output) != HESSIAN_OK) {
+            pep_log_error("xacml_attribute_write: can't write pair<'%s','%s'> of Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_DATATYPE,attr_dt->string,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* optional issuer */
+    attr_issuer= xacml_attribute_getissuerstring(attr);
+    if (attr_issuer != NULL) {
+        if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ATTRIBUTE_ISSUER,output) != HESSIAN_OK
+            || hessian_string_write_n(attr_issuer->string,attr_issuer->length,xacml_string_utf8_length(attr_issuer),output) != HESSIAN_OK) {
+            pep_log_error("xacml_attribute_write: can't write pair<'%s','%s'> of Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ISSUER,attr_issuer->string,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* values list */
+    values_l= xacml_attribute_values_length(attr);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ATTRIBUTE_VALUES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,values_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_attribute_write: can't write %s Hessian list.", XACML_HESSIAN_ATTRIBUTE_VALUES);
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < values_l; i++) {
+        const xacml_string_t * value= xacml_attribute_getvaluestring(attr,i);
+        if (value == NULL || hessian_string_write_n(value->string,value->length,xacml_string_utf8_length(value),output) != HESSIAN_OK) {
+            pep_log_error("xacml_attribute_write: can't write Hessian string: %s at: %d.", (value != NULL) ? value->string : NULL, i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK || hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_attribute_write: can't end Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian map for this Subject.
+ */
+static int xacml_subject_write(const xacml_subject_t * subject, pep_buffer_t * output) {
+    const char * category;
+    size_t list_l;
+    int i;
+    if (subject == NULL) {
+        pep_log_error("xacml_subject_write: NULL subject object.");
+        return PEP_IO_ERROR;
+    }
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_SUBJECT_CLASSNAME,output) != HESSIAN_OK) {
+        pep_log_error("xacml_subject_write: can't write Hessian map: %s.", XACML_HESSIAN_SUBJECT_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    /* category (can be null) */
+    category= xacml_subject_getcategory(subject);
+    if (category != NULL) {
+        if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_SUBJECT_CATEGORY,output) != HESSIAN_OK
+            || hessian_string_write(category,output) != HESSIAN_OK) {
+            pep_log_error("xacml_subject_write: can't write category Hessian string: %s.", category);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* attributes list */
+    list_l= xacml_subject_attributes_length(subject);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_SUBJECT_ATTRIBUTES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_subject_write: can't write attributes Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_attribute_t * attr= xacml_subject_getattribute(subject,i);
+        if (xacml_attribute_write(attr,output) != PEP_IO_OK) {
+            pep_log_error("xacml_subject_write: can't write XACML attribute at: %d.", i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK || hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_subject_write: can't end Hessian map: %s.", XACML_HESSIAN_SUBJECT_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian map for this Resource.
+ */
+static int xacml_resource_write(const xacml_resource_t * resource, pep_buffer_t * output) {
+    const char * content;
+    size_t list_l;
+    int i;
+    if (resource == NULL) {
+        pep_log_error("xacml_resource_write: NULL resource object.");
+        return PEP_IO_ERROR;
+    }
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_RESOURCE_CLASSNAME,output) != HESSIAN_OK) {
+        pep_log_error("xacml_resource_write: can't write Hessian map: %s.", XACML_HESSIAN_RESOURCE_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    /* optional content */
+    content= xacml_resource_getcontent(resource);
+    if (content != NULL) {
+        if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_RESOURCE_CONTENT,output) != HESSIAN_OK
+            || hessian_string_write(content,output) != HESSIAN_OK) {
+            pep_log_error("xacml_resource_write: can't write content Hessian string: %s.", content);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* attributes list */
+    list_l= xacml_resource_attributes_length(resource);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_RESOURCE_ATTRIBUTES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_resource_write: can't write attributes Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_attribute_t * attr= xacml_resource_getattribute(resource,i);
+        if (xacml_attribute_write(attr,output) != PEP_IO_OK) {
+            pep_log_error("xacml_resource_write: can't write XACML attribute at: %d.", i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK || hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_resource_write: can't end Hessian map: %s.", XACML_HESSIAN_RESOURCE_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian map for this Action or a Hessian null if the Action is null.
+ */
+static int xacml_action_write(const xacml_action_t * action, pep_buffer_t * output) {
+    size_t list_l;
+    int i;
+    if (action == NULL) {
+        if (hessian_null_write(output) != HESSIAN_OK) {
+            pep_log_error("xacml_action_write: NULL action, but can't write Hessian null.");
+            return PEP_IO_ERROR;
+        }
+        return PEP_IO_OK;
+    }
+    /* attributes list */
+    list_l= xacml_action_attributes_length(action);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ACTION_CLASSNAME,output) != HESSIAN_OK
+        || HESSIAN_ENCODED_WRITE(XACML_ENCODED_ACTION_ATTRIBUTES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_action_write: can't write Hessian map: %s.", XACML_HESSIAN_ACTION_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_attribute_t * attr= xacml_action_getattribute(action,i);
+        if (xacml_attribute_write(attr,output) != PEP_IO_OK) {
+            pep_log_error("xacml_action_write: can't write attribute at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK || hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_action_write: can't end Hessian map: %s.", XACML_HESSIAN_ACTION_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian map for this Environment or a Hessian null if the Environment is null.
+ */
+static int xacml_environment_write(const xacml_environment_t * env, pep_buffer_t * output) {
+    size_t list_l;
+    int i;
+    if (env == NULL) {
+        if (hessian_null_write(output) != HESSIAN_OK) {
+            pep_log_error("xacml_environment_write: NULL environment, but can't write Hessian null.");
+            return PEP_IO_ERROR;
+        }
+        return PEP_IO_OK;
+    }
+    /* attributes list */
+    list_l= xacml_environment_attributes_length(env);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_ENVIRONMENT_CLASSNAME,output) != HESSIAN_OK
+        || HESSIAN_ENCODED_WRITE(XACML_ENCODED_ENVIRONMENT_ATTRIBUTES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_environment_write: can't write Hessian map: %s.", XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_attribute_t * attr= xacml_environment_getattribute(env,i);
+        if (xacml_attribute_write(attr,output) != PEP_IO_OK) {
+            pep_log_error("xacml_environment_write: can't write XACML attribute at: %d",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK || hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_environment_write: can't end Hessian map: %s.", XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian map for this Request.
+ */
+static int xacml_request_write(const xacml_request_t * request, pep_buffer_t * output) {
+    size_t list_l;
+    int i;
+    if (request == NULL) {
+        pep_log_error("xacml_request_write: NULL request object.");
+        return PEP_IO_ERROR;
+    }
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_REQUEST_CLASSNAME,output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't write request Hessian map: %s.",XACML_HESSIAN_REQUEST_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    /* subjects list */
+    list_l= xacml_request_subjects_length(request);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_REQUEST_SUBJECTS,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't write subjects Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_subject_t * subject= xacml_request_getsubject(request,i);
+        if (xacml_subject_write(subject,output) != PEP_IO_OK) {
+            pep_log_error("xacml_request_write: failed to write XACML subject at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't end subjects Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    /* resources list */
+    list_l= xacml_request_resources_length(request);
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_REQUEST_RESOURCES,output) != HESSIAN_OK
+        || hessian_list_write_start(NULL,list_l,output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't write resources Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        xacml_resource_t * resource= xacml_request_getresource(request,i);
+        if (xacml_resource_write(resource,output) != PEP_IO_OK) {
+            pep_log_error("xacml_request_write: failed to write XACML resource at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    if (hessian_list_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't end resources Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    /* action */
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_REQUEST_ACTION,output) != HESSIAN_OK
+        || xacml_action_write(xacml_request_getaction(request),output) != PEP_IO_OK) {
+        pep_log_error("xacml_request_write: failed to write XACML action.");
+        return PEP_IO_ERROR;
+    }
+    /* environment */
+    if (HESSIAN_ENCODED_WRITE(XACML_ENCODED_REQUEST_ENVIRONMENT,output) != HESSIAN_OK
+        || xacml_environment_write(xacml_request_getenvironment(request),output) != PEP_IO_OK) {
+        pep_log_error("xacml_request_write: failed to write XACML environment.");
+        return PEP_IO_ERROR;
+    }
+    if (hessian_map_write_end(output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_write: can't end request Hessian map.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Returns the number of bytes written by xacml_attribute_write(attr,output),
+ * or 0 if the Attribute can't be written.
+ */
+static size_t xacml_attribute_size(const xacml_attribute_t * attr) {
+    const xacml_string_t * attr_id, * attr_dt, * attr_issuer;
+    size_t size, values_l;
+    int i;
+    if (attr == NULL) {
+        pep_log_error("xacml_attribute_size: NULL attribute object.");
+        return 0;
+    }
+    attr_id= xacml_attribute_getidstring(attr);
+    if (attr_id == NULL) {
+        pep_log_error("xacml_attribute_size: NULL attribute id.");
+        return 0;
+    }
+    size= sizeof(XACML_ENCODED_ATTRIBUTE_CLASSNAME) + sizeof(XACML_ENCODED_ATTRIBUTE_ID) + hessian_string_write_size_n(attr_id->length,xacml_string_utf8_length(attr_id));
+    attr_dt= xacml_attribute_getdatatypestring(attr);
+    if (attr_dt != NULL) {
+        size+= sizeof(XACML_ENCODED_ATTRIBUTE_DATATYPE) + hessian_string_write_size_n(attr_dt->length,xacml_string_utf8_length(attr_dt));
+    }
+    attr_issuer= xacml_attribute_getissuerstring(attr);
+    if (attr_issuer != NULL) {
+        size+= sizeof(XACML_ENCODED_ATTRIBUTE_ISSUER) + hessian_string_write_size_n(attr_issuer->length,xacml_string_utf8_length(attr_issuer));
+    }
+    values_l= xacml_attribute_values_length(attr);
+    size+= sizeof(XACML_ENCODED_ATTRIBUTE_VALUES) + hessian_list_write_start_size(NULL,values_l);
+    for (i= 0; i < values_l; i++) {
+        const xacml_string_t * value= xacml_attribute_getvaluestring(attr,i);
+        if (value == NULL) {
+            pep_log_error("xacml_attribute_size: NULL value at: %d.",i);
+            return 0;
+        }
+        size+= hessian_string_write_size_n(value->length,xacml_string_utf8_length(value));
+    }
+    /* end of list and map */
+    return size + 2;
+}
+
+/**
+ * Returns the number of bytes written by xacml_subject_write(subject,output),
+ * or 0 if the Subject can't be written.
+ */
+static size_t xacml_subject_size(const xacml_subject_t * subject) {
+    const char * category;
+    size_t size, list_l, attr_size;
+    int i;
+    if (subject == NULL) {
+        pep_log_error("xacml_subject_size: NULL subject object.");
+        return 0;
+    }
+    size= sizeof(XACML_ENCODED_SUBJECT_CLASSNAME);
+    category= xacml_subject_getcategory(subject);
+    if (category != NULL) {
+        size+= sizeof(XACML_ENCODED_SUBJECT_CATEGORY) + hessian_string_write_size(category);
+    }
+    list_l= xacml_subject_attributes_length(subject);
+    size+= sizeof(XACML_ENCODED_SUBJECT_ATTRIBUTES) + hessian_list_write_start_size(NULL,list_l);
+    for (i= 0; i < list_l; i++) {
+        attr_size= xacml_attribute_size(xacml_subject_getattribute(subject,i));
+        if (attr_size == 0) return 0;
+        size+= attr_size;
+    }
+    /* end of list and map */
+    return size + 2;
+}
+
+/**
+ * Returns the number of bytes written by xacml_resource_write(resource,output),
+ * or 0 if the Resource can't be written.
+ */
+static size_t xacml_resource_size(const xacml_resource_t * resource) {
+    const char * content;
+    size_t size, list_l, attr_size;
+    int i;
+    if (resource == NULL) {
+        pep_log_error("xacml_resource_size: NULL resource object.");
+        return 0;
+    }
+    size= sizeof(XACML_ENCODED_RESOURCE_CLASSNAME);
+    content= xacml_resource_getcontent(resource);
+    if (content != NULL) {
+        size+= sizeof(XACML_ENCODED_RESOURCE_CONTENT) + hessian_string_write_size(content);
+    }
+    list_l= xacml_resource_attributes_length(resource);
+    size+= sizeof(XACML_ENCODED_RESOURCE_ATTRIBUTES) + hessian_list_write_start_size(NULL,list_l);
+    for (i= 0; i < list_l; i++) {
+        attr_size= xacml_attribute_size(xacml_resource_getattribute(resource,i));
+        if (attr_size == 0) return 0;
+        size+= attr_size;
+    }
+    /* end of list and map */
+    return size + 2;
+}
+
+/**
+ * Returns the number of bytes written by xacml_action_write(action,output),
+ * 1 for a Hessian null, or 0 if the Action can't be written.
+ */
+static size_t xacml_action_size(const xacml_action_t * action) {
+    size_t size, list_l, attr_size;
+    int i;
+    if (action == NULL) return 1;
+    list_l= xacml_action_attributes_length(action);
+    size= sizeof(XACML_ENCODED_ACTION_CLASSNAME) + sizeof(XACML_ENCODED_ACTION_ATTRIBUTES) + hessian_list_write_start_size(NULL,list_l);
+    for (i= 0; i < list_l; i++) {
+        attr_size= xacml_attribute_size(xacml_action_getattribute(action,i));
+        if (attr_size == 0) return 0;
+        size+= attr_size;
+    }
+    /* end of list and map */
+    return size + 2;
+}
+
+/**
+ * Returns the number of bytes written by xacml_environment_write(env,output),
+ * 1 for a Hessian null, or 0 if the Environment can't be written.
+ */
+static size_t xacml_environment_size(const xacml_environment_t * env) {
+    size_t size, list_l, attr_size;
+    int i;
+    if (env == NULL) return 1;
+    list_l= xacml_environment_attributes_length(env);
+    size= sizeof(XACML_ENCODED_ENVIRONMENT_CLASSNAME) + sizeof(XACML_ENCODED_ENVIRONMENT_ATTRIBUTES) + hessian_list_write_start_size(NULL,list_l);
+    for (i= 0; i < list_l; i++) {
+        attr_size= xacml_attribute_size(xacml_environment_getattribute(env,i));
+        if (attr_size == 0) return 0;
+        size+= attr_size;
+    }
+    /* end of list and map */
+    return size + 2;
+}
+
+size_t xacml_request_serialized_size(const xacml_request_t * request) {
+    size_t size, list_l, elt_size;
+    int i;
+    if (request == NULL) {
+        pep_log_error("xacml_request_serialized_size: NULL request object.");
+        return 0;
+    }
+    size= sizeof(XACML_ENCODED_REQUEST_CLASSNAME);
+    /* subjects list */
+    list_l= xacml_request_subjects_length(request);
+    size+= sizeof(XACML_ENCODED_REQUEST_SUBJECTS) + hessian_list_write_start_size(NULL,list_l) + 1;
+    for (i= 0; i < list_l; i++) {
+        elt_size= xacml_subject_size(xacml_request_getsubject(request,i));
+        if (elt_size == 0) return 0;
+        size+= elt_size;
+    }
+    /* resources list */
+    list_l= xacml_request_resources_length(request);
+    size+= sizeof(XACML_ENCODED_REQUEST_RESOURCES) + hessian_list_write_start_size(NULL,list_l) + 1;
+    for (i= 0; i < list_l; i++) {
+        elt_size= xacml_resource_size(xacml_request_getresource(request,i));
+        if (elt_size == 0) return 0;
+        size+= elt_size;
+    }
+    /* action and environment */
+    elt_size= xacml_action_size(xacml_request_getaction(request));
+    if (elt_size == 0) return 0;
+    size+= sizeof(XACML_ENCODED_REQUEST_ACTION) + elt_size;
+    elt_size= xacml_environment_size(xacml_request_getenvironment(request));
+    if (elt_size == 0) return 0;
+    size+= sizeof(XACML_ENCODED_REQUEST_ENVIRONMENT) + elt_size;
+    /* end of map */
+    return size + 1;
+}
+
+pep_error_t xacml_request_marshalling(const xacml_request_t * request, pep_buffer_t * output) {
+    size_t size= xacml_request_serialized_size(request);
+    if (size == 0) {
+        pep_log_error("xacml_request_marshalling: can't size XACML request.");
+        return PEP_ERR_MARSHALLING_HESSIAN;
+    }
+    /* the output buffer is sized once for the whole request */
+    if (pep_buffer_reserve(output,size) != BUFFER_OK) {
+        pep_log_error("xacml_request_marshalling: can't reserve %d bytes in output buffer.",(int)size);
+        return PEP_ERR_MEMORY;
+    }
+    if (xacml_request_write(request,output) != PEP_IO_OK) {
+        pep_log_error("xacml_request_marshalling: can't write XACML request as Hessian object.");
+        return PEP_ERR_MARSHALLING_HESSIAN;
+    }
+    return PEP_OK;
+}
+
+/* OK */
+pep_error_t xacml_request_marshalling_tree(const xacml_request_t * request, pep_buffer_t * output) {
+    hessian_object_t * h_request= NULL;
+    if (xacml_request_marshal(request,&h_request) != PEP_IO_OK) {
+        pep_log_error("xacml_request_marshalling_tree: can't marshal XACML request into Hessian object.");
+        /* pep_errmsg("failed to marshal XACML request into Hessian object"); */
+        return PEP_ERR_MARSHALLING_HESSIAN;
+    }
+    if (hessian_serialize(h_request,output) != HESSIAN_OK) {
+        pep_log_error("xacml_request_marshalling_tree: failed to serialize Hessian object.");
+        hessian_delete(h_request);
+        /* pep_errmsg("failed to serialize Hessian object"); */
+        return PEP_ERR_MARSHALLING_IO;
+    }
+    hessian_delete(h_request);
+    return PEP_OK;
+}
+
+pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, pep_buffer_t * input) {
+    pep_error_t rc;
+    xacml_response_parser_t * parser= xacml_response_parser_create();
+    if (parser == NULL) {
+        pep_log_error("xacml_response_unmarshalling: can't create XACML response parser.");
+        return PEP_ERR_MEMORY;
+    }
+    rc= xacml_response_parser_reset(parser,input,NULL);
+    if (rc == PEP_OK) {
+        rc= xacml_response_parser_finish(parser,input,response);
+    }
+    xacml_response_parser_delete(parser);
+    return rc;
+}
+
+pep_error_t xacml_response_unmarshalling_reader(xacml_response_t ** response, hessian_reader_t * reader, pep_buffer_t * input) {
+    return xacml_response_unmarshalling_reader_in(response,reader,input,NULL);
+}
+
+pep_error_t xacml_response_unmarshalling_reader_in(xacml_response_t ** response, hessian_reader_t * reader, pep_buffer_t * input, xacml_arena_t * arena) {
+    int rc;
+    if (hessian_reader_reset(reader,input) != HESSIAN_OK) {
+        pep_log_error("xacml_response_unmarshalling_reader: can't reset Hessian reader.");
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+    rc= xacml_response_read(reader,hessian_reader_next(reader),response,arena);
+    if (rc == PEP_IO_REF) {
+        /* the Hessian refs are only resolved in the object tree */
+        pep_log_debug("xacml_response_unmarshalling_reader: Hessian ref read, unmarshalling the object tree.");
+        return xacml_response_unmarshalling_tree(response,input);
+    }
+    if (rc != PEP_IO_OK) {
+        pep_log_error("xacml_response_unmarshalling_reader: can't read XACML response from Hessian input.");
+        return PEP_ERR_UNMARSHALLING_HESSIAN;
+    }
+    /* consume the bytes read */
+    pep_buffer_skip(input,hessian_reader_offset(reader));
+    return PEP_OK;
+}
+
+/* OK */
+pep_error_t xacml_response_unmarshalling_tree(xacml_response_t ** response, pep_buffer_t * input) {
+    hessian_object_t * h_response;
+    /* the Hessian object graph is allocated in an arena, and released at once */
+    hessian_arena_t * arena= hessian_arena_create(0);
+    if (arena == NULL) {
+        pep_log_error("xacml_response_unmarshalling_tree: can't create Hessian arena.");
+        return PEP_ERR_MEMORY;
+    }
+    h_response= hessian_deserialize_arena(input,arena);
+    if (h_response == NULL) {
+        pep_log_error("xacml_response_unmarshalling_tree: failed to deserialize Hessian object.");
+        /* pep_errmsg("failed to deserialize base64 encoded Hessian object"); */
+        hessian_arena_delete(arena);
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+    if (xacml_response_unmarshal(response, h_response) != PEP_IO_OK) {
+        pep_log_error("xacml_response_unmarshalling_tree: can't unmarshal XACML response from Hessian object.");
+        hessian_arena_delete(arena);
+        /* pep_errmsg("failed to unmarshal XACML response from Hessian object"); */
+        return PEP_ERR_UNMARSHALLING_HESSIAN;
+    }
+    hessian_arena_delete(arena);
+    return PEP_OK;
+}
+
+/* OK */
+static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_object_t * h_response) {
+    const char * map_type;
+    xacml_response_t * response;
+    hessian_object_t * h_request, * h_results;
+    size_t known_l;
+    int j;
+    if (hessian_gettype(h_response) != HESSIAN_MAP) {
+        pep_log_error("xacml_response_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_response), hessian_getclassname(h_response));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_response);
+    if (map_type == NULL) {
+        pep_log_error("xacml_response_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_RESPONSE_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_response_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+
+    response= xacml_response_create();
     if (response == NULL) {
         pep_log_error("xacml_response_unmarshal: can't create XACML response.");
         return PEP_IO_ERROR;
     }
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_response);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_response,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_response_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_response_delete(response);
+    /* known map pair<key>s */
+    known_l= 0;
+    /* request (can be null???) */
+    h_request= hessian_map_get(h_response,XACML_HESSIAN_RESPONSE_REQUEST);
+    if (h_request != NULL) {
+        if (hessian_gettype(h_request) != HESSIAN_NULL) {
+            xacml_request_t * request= NULL;
+            if (xacml_request_unmarshal(&request,h_request) != PEP_IO_OK) {
+                pep_log_error("xacml_response_unmarshal: can't unmarshal XACML request.");
+                xacml_response_delete(response);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_response_setrequest(response,request) != PEP_XACML_OK) {
+                pep_log_error("xacml_response_unmarshal: can't set XACML request in XACML response.");
+                xacml_request_delete(request);
+                xacml_response_delete(response);
+                return PEP_IO_ERROR;
+            }
+        }
+        else {
+            pep_log_warn("xacml_response_unmarshal: XACML request is NULL.");
+        }
+
+        known_l++;
+    }
+    /* results list */
+    h_results= hessian_map_get(h_response,XACML_HESSIAN_RESPONSE_RESULTS);
+    if (h_results != NULL) {
+        size_t h_results_l;
+        if (hessian_gettype(h_results) != HESSIAN_LIST) {
+            pep_log_error("xacml_response_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_RESPONSE_RESULTS);
+            xacml_response_delete(response);
+            return PEP_IO_ERROR;
+        }
+        h_results_l= hessian_list_length(h_results);
+        for(j= 0; j<h_results_l; j++) {
+            hessian_object_t * h_result= hessian_list_get(h_results,j);
+            xacml_result_t * result= NULL;
+            if (xacml_result_unmarshal(&result,h_result) != PEP_IO_OK) {
+                pep_log_error("xacml_response_unmarshal: can't unmarshal XACML result at: %d.",j);
+                xacml_response_delete(response);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_response_addresult(response,result) != PEP_XACML_OK) {
+                pep_log_error("xacml_response_unmarshal: can't add XACML result at: %d to XACML response.",j);
+                xacml_result_delete(result);
+                xacml_response_delete(response);
+                return PEP_IO_ERROR;
+            }
+        }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_response,known_l,"xacml_response_unmarshal");
+    *resp= response;
+    return PEP_IO_OK;
+}
+
+/* OK */
+static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t * h_result) {
+    const char * map_type;
+    xacml_result_t * result;
+    hessian_object_t * h_integer, * h_string, * h_status, * h_obligations;
+    size_t known_l;
+    int j;
+    if (hessian_gettype(h_result) != HESSIAN_MAP) {
+        pep_log_error("xacml_result_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_result), hessian_getclassname(h_result));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_result);
+    if (map_type == NULL) {
+        pep_log_error("xacml_result_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_RESULT_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_result_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+    result= xacml_result_create();
+    if (result == NULL) {
+        pep_log_error("xacml_result_unmarshal: can't create XACML result.");
+        return PEP_IO_ERROR;
+    }
+
+    /* known map pair<key>s */
+    known_l= 0;
+    /* decision (enum, mandatory) */
+    h_integer= hessian_map_get(h_result,XACML_HESSIAN_RESULT_DECISION);
+    if (h_integer != NULL) {
+        int32_t decision;
+        if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
+            pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian integer.",XACML_HESSIAN_RESULT_DECISION);
+            xacml_result_delete(result);
             return PEP_IO_ERROR;
         }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_response_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_response_delete(response);
+        decision= hessian_integer_getvalue(h_integer);
+        if (xacml_result_setdecision(result,decision) != PEP_XACML_OK) {
+            pep_log_error("xacml_result_unmarshal: can't set decision: %d to XACML result.",(int)decision);
+            xacml_result_delete(result);
             return PEP_IO_ERROR;
         }
-        /* request (can be null???) */
-        if (strcmp(XACML_HESSIAN_RESPONSE_REQUEST,key) == 0) {
-            hessian_object_t * h_request= hessian_map_getvalue(h_response,i);
-            if (hessian_gettype(h_request) != HESSIAN_NULL) {
-                xacml_request_t * request= NULL;
-                if (xacml_request_unmarshal(&request,h_request) != PEP_IO_OK) {
-                    pep_log_error("xacml_response_unmarshal: can't unmarshal XACML request.");
-                    xacml_response_delete(response);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_response_setrequest(response,request) != PEP_XACML_OK) {
-                    pep_log_error("xacml_response_unmarshal: can't set XACML request in XACML response.");
-                    xacml_request_delete(request);
-                    xacml_response_delete(response);
-                    return PEP_IO_ERROR;
-                }
+        known_l++;
+    }
+    /* resourceid (optional) */
+    h_string= hessian_map_get(h_result,XACML_HESSIAN_RESULT_RESOURCEID);
+    if (h_string != NULL) {
+        hessian_t h_string_type= hessian_gettype(h_string);
+        const char * resourceid;
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_RESULT_RESOURCEID);
+            xacml_result_delete(result);
+            return PEP_IO_ERROR;
+        }
+        resourceid= NULL;
+        if (h_string_type == HESSIAN_STRING) {
+            resourceid= hessian_string_getstring(h_string);
+        }
+        if (xacml_result_setresourceid(result, resourceid) != PEP_XACML_OK) {
+            pep_log_error("xacml_result_unmarshal: can't set resourceid: %s to XACML result.",resourceid);
+            xacml_result_delete(result);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* status (null?) */
+    h_status= hessian_map_get(h_result,XACML_HESSIAN_RESULT_STATUS);
+    if (h_status != NULL) {
+        if (hessian_gettype(h_status) != HESSIAN_NULL) {
+            xacml_status_t * status= NULL;
+            if (xacml_status_unmarshal(&status,h_status) != PEP_IO_OK) {
+                pep_log_error("xacml_result_unmarshal: can't unmarshal XACML status.");
+                xacml_result_delete(result);
+                return PEP_IO_ERROR;
             }
-            else {
-                pep_log_warn("xacml_response_unmarshal: XACML request is NULL.");
+            if (xacml_result_setstatus(result,status) != PEP_XACML_OK) {
+                pep_log_error("xacml_result_unmarshal: can't set XACML status to XACML result.");
+                xacml_result_delete(result);
+                xacml_status_delete(status);
+                return PEP_IO_ERROR;
+            }
+        }
+        else {
+            pep_log_warn("xacml_result_unmarshal: XACML status is NULL.");
+        }
+        known_l++;
+    }
+    /* obligations list */
+    h_obligations= hessian_map_get(h_result,XACML_HESSIAN_RESULT_OBLIGATIONS);
+    if (h_obligations != NULL) {
+        size_t h_obligations_l;
+        if (hessian_gettype(h_obligations) != HESSIAN_LIST) {
+            pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_RESULT_OBLIGATIONS);
+            xacml_result_delete(result);
+            return PEP_IO_ERROR;
+        }
+        h_obligations_l= hessian_list_length(h_obligations);
+        for(j= 0; j<h_obligations_l; j++) {
+            hessian_object_t * h_obligation= hessian_list_get(h_obligations,j);
+            xacml_obligation_t * obligation= NULL;
+            if (xacml_obligation_unmarshal(&obligation,h_obligation) != PEP_IO_OK) {
+                pep_log_error("xacml_result_unmarshal: can't unmarshal XACML obligation at: %d.", j);
+                xacml_result_delete(result);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_result_addobligation(result,obligation) != PEP_XACML_OK) {
+                pep_log_error("xacml_result_unmarshal: can't add XACML obligation at: %d to XACML result.", j);
+                xacml_result_delete(result);
+                xacml_obligation_delete(obligation);
+                return PEP_IO_ERROR;
+            }
+        }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_result,known_l,"xacml_result_unmarshal");
+    *res= result;
+    return PEP_IO_OK;
+}
+
+/* OK */
+static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t * h_status) {
+    const char * map_type;
+    xacml_status_t * status;
+    hessian_object_t * h_string, * h_statuscode;
+    size_t known_l;
+    if (hessian_gettype(h_status) != HESSIAN_MAP) {
+        pep_log_error("xacml_status_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_status), hessian_getclassname(h_status));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_status);
+    if (map_type == NULL) {
+        pep_log_error("xacml_status_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_STATUS_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_status_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+    status= xacml_status_create(NULL);
+    if (status == NULL) {
+        pep_log_error("xacml_status_unmarshal: can't create XACML status.");
+        return PEP_IO_ERROR;
+    }
+    /* known map pair<key>s */
+    known_l= 0;
+    /* message (can be null) */
+    h_string= hessian_map_get(h_status,XACML_HESSIAN_STATUS_MESSAGE);
+    if (h_string != NULL) {
+        if (hessian_gettype(h_string) != HESSIAN_NULL) {
+            const char * message;
+            if (hessian_gettype(h_string) != HESSIAN_STRING) {
+                pep_log_error("xacml_status_unmarshal: Hessian map<'%s',value> is not a Hessian string.",XACML_HESSIAN_STATUS_MESSAGE);
+                xacml_status_delete(status);
+                return PEP_IO_ERROR;
+            }
+            message= hessian_string_getstring(h_string);
+            if (xacml_status_setmessage(status,message) != PEP_XACML_OK) {
+                pep_log_error("xacml_status_unmarshal: can't set message: %s to XACML status",message);
+                xacml_status_delete(status);
+                return PEP_IO_ERROR;
+            }
+        }
+        known_l++;
+    }
+    /* subcode (can be null) */
+    h_statuscode= hessian_map_get(h_status,XACML_HESSIAN_STATUS_CODE);
+    if (h_statuscode != NULL) {
+        if (hessian_gettype(h_statuscode) != HESSIAN_NULL) {
+            xacml_statuscode_t * statuscode= NULL;
+            if (xacml_statuscode_unmarshal(&statuscode,h_statuscode) != PEP_IO_OK) {
+                pep_log_error("xacml_status_unmarshal: can't unmarshal XACML statuscode.");
+                xacml_status_delete(status);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_status_setcode(status,statuscode) != PEP_XACML_OK) {
+                pep_log_error("xacml_status_unmarshal: can't set XACML statuscode to XACML status.");
+                xacml_status_delete(status);
+                xacml_statuscode_delete(statuscode);
+                return PEP_IO_ERROR;
+            }
+        }
+        else {
+            pep_log_warn("xacml_status_unmarshal: subcode XACML statuscode is NULL.");
+        }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_status,known_l,"xacml_status_unmarshal");
+    *st= status;
+    return PEP_IO_OK;
+}
+
+/* OK */
+static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_object_t * h_statuscode) {
+    const char * map_type;
+    xacml_statuscode_t * statuscode;
+    hessian_object_t * h_string, * h_subcode;
+    size_t known_l;
+    if (hessian_gettype(h_statuscode) != HESSIAN_MAP) {
+        pep_log_error("xacml_statuscode_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_statuscode), hessian_getclassname(h_statuscode));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_statuscode);
+    if (map_type == NULL) {
+        pep_log_error("xacml_statuscode_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_STATUSCODE_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_statuscode_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+
+    statuscode= xacml_statuscode_create(NULL);
+    if (statuscode == NULL) {
+        pep_log_error("xacml_statuscode_unmarshal: cant't create XACML statuscode.");
+        return PEP_IO_ERROR;
+    }
+
+    /* known map pair<key>s */
+    known_l= 0;
+    /* code (mandatory) */
+    h_string= hessian_map_get(h_statuscode,XACML_HESSIAN_STATUSCODE_VALUE);
+    if (h_string != NULL) {
+        const char * code;
+        if (hessian_gettype(h_string) != HESSIAN_STRING) {
+            pep_log_error("xacml_statuscode_unmarshal: Hessian map<'%s',value> is not a Hessian string.",XACML_HESSIAN_STATUSCODE_VALUE);
+            xacml_statuscode_delete(statuscode);
+            return PEP_IO_ERROR;
+        }
+        code = hessian_string_getstring(h_string);
+        if (xacml_statuscode_setvalue(statuscode,code) != PEP_XACML_OK) {
+            pep_log_error("xacml_statuscode_unmarshal: can't set value: %s to XACML statuscode",code);
+            xacml_statuscode_delete(statuscode);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* subcode (can be null) */
+    h_subcode= hessian_map_get(h_statuscode,XACML_HESSIAN_STATUSCODE_SUBCODE);
+    if (h_subcode != NULL) {
+        if (hessian_gettype(h_subcode) != HESSIAN_NULL) {
+            xacml_statuscode_t * subcode= NULL;
+            if (xacml_statuscode_unmarshal(&subcode,h_subcode) != PEP_IO_OK) {
+                pep_log_error("xacml_statuscode_unmarshal: can't unmarshal subcode XACML statuscode.");
+                xacml_statuscode_delete(statuscode);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_statuscode_setsubcode(statuscode,subcode) != PEP_XACML_OK) {
+                pep_log_error("xacml_statuscode_unmarshal: can't set subcode XACML statuscode to XACML statuscode");
+                xacml_statuscode_delete(statuscode);
+                xacml_statuscode_delete(subcode);
+                return PEP_IO_ERROR;
+            }
+        }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_statuscode,known_l,"xacml_statuscode_unmarshal");
+    *stc= statuscode;
+    return PEP_IO_OK;
+}
+
+static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_object_t * h_obligation) {
+    const char * map_type;
+    xacml_obligation_t * obligation;
+    hessian_object_t * h_string, * h_integer, * h_assignments;
+    size_t known_l;
+    int j;
+    if (hessian_gettype(h_obligation) != HESSIAN_MAP) {
+        pep_log_error("xacml_obligation_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_obligation), hessian_getclassname(h_obligation));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_obligation);
+    if (map_type == NULL) {
+        pep_log_error("xacml_obligation_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_OBLIGATION_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_obligation_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+    obligation= xacml_obligation_create(NULL);
+    if (obligation == NULL) {
+        pep_log_error("xacml_obligation_unmarshal: can't create XACML obligation.");
+        return PEP_IO_ERROR;
+    }
+
+    /* known map pair<key>s */
+    known_l= 0;
+
+    /* id (mandatory) */
+    h_string= hessian_map_get(h_obligation,XACML_HESSIAN_OBLIGATION_ID);
+    if (h_string != NULL) {
+        const char * id;
+        if (hessian_gettype(h_string) != HESSIAN_STRING) {
+            pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian string.",XACML_HESSIAN_OBLIGATION_ID);
+            xacml_obligation_delete(obligation);
+            return PEP_IO_ERROR;
+        }
+        id= hessian_string_getstring(h_string);
+        if (xacml_obligation_setid(obligation,id) != PEP_XACML_OK) {
+            pep_log_error("xacml_obligation_unmarshal: can't set id: %s to XACML obligation",id);
+            xacml_obligation_delete(obligation);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* fulfillon (enum) */
+    h_integer= hessian_map_get(h_obligation,XACML_HESSIAN_OBLIGATION_FULFILLON);
+    if (h_integer != NULL) {
+        int32_t fulfillon;
+        if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
+            pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian integer.",XACML_HESSIAN_OBLIGATION_FULFILLON);
+            xacml_obligation_delete(obligation);
+            return PEP_IO_ERROR;
+        }
+        fulfillon= hessian_integer_getvalue(h_integer);
+        if (xacml_obligation_setfulfillon(obligation,fulfillon) != PEP_XACML_OK) {
+            pep_log_error("xacml_obligation_unmarshal: can't set fulfillon: %d to XACML obligation",(int)fulfillon);
+            xacml_obligation_delete(obligation);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* attribute assignments list */
+    h_assignments= hessian_map_get(h_obligation,XACML_HESSIAN_OBLIGATION_ASSIGNMENTS);
+    if (h_assignments != NULL) {
+        size_t h_assignments_l;
+        if (hessian_gettype(h_assignments) != HESSIAN_LIST) {
+            pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian list.",XACML_HESSIAN_OBLIGATION_ASSIGNMENTS);
+            xacml_obligation_delete(obligation);
+            return PEP_IO_ERROR;
+        }
+        h_assignments_l= hessian_list_length(h_assignments);
+        for(j= 0; j<h_assignments_l; j++) {
+            hessian_object_t * h_assignment= hessian_list_get(h_assignments,j);
+            xacml_attributeassignment_t * attribute= NULL;
+            if (xacml_attributeassignment_unmarshal(&attribute,h_assignment) != PEP_IO_OK) {
+                pep_log_error("xacml_obligation_unmarshal: can't unmarshal XACML attribute assignment at: %d.",j);
+                xacml_obligation_delete(obligation);
+                return PEP_IO_ERROR;
+            }
+            if (xacml_obligation_addattributeassignment(obligation,attribute) != PEP_XACML_OK) {
+                pep_log_error("xacml_obligation_unmarshal: can't add XACML attribute assignment to XACML obligation at: %d",j);
+                xacml_obligation_delete(obligation);
+                xacml_attributeassignment_delete(attribute);
+                return PEP_IO_ERROR;
             }
+        }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_obligation,known_l,"xacml_obligation_unmarshal");
+
+    *obl= obligation;
+    return PEP_IO_OK;
+
+}
+
+static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** attr, const hessian_object_t * h_attribute) {
+    const char * map_type;
+    xacml_attributeassignment_t * attribute;
+    hessian_object_t * h_string, * h_values;
+    size_t known_l;
+    int j;
+    if (hessian_gettype(h_attribute) != HESSIAN_MAP) {
+        pep_log_error("xacml_attributeassignment_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_attribute), hessian_getclassname(h_attribute));
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_map_gettype(h_attribute);
+    if (map_type == NULL) {
+        pep_log_error("xacml_attributeassignment_unmarshal: NULL Hessian map type.");
+        return PEP_IO_ERROR;
+    }
+    if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,map_type) != 0) {
+        pep_log_error("xacml_attributeassignment_unmarshal: wrong Hessian map type: %s.",map_type);
+        return PEP_IO_ERROR;
+    }
+
+    attribute= xacml_attributeassignment_create(NULL);
+    if (attribute == NULL) {
+        pep_log_error("xacml_attributeassignment_unmarshal: can't create XACML attribute assignment.");
+        return PEP_IO_ERROR;
+    }
+
+    /* known map pair<key>s */
+    known_l= 0;
 
+    /* id (mandatory) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID);
+    if (h_string != NULL) {
+        const char * id;
+        if (hessian_gettype(h_string) != HESSIAN_STRING) {
+            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        id= hessian_string_getstring(h_string);
+        if (xacml_attributeassignment_setid(attribute,id) != PEP_XACML_OK) {
+            pep_log_error("xacml_attributeassignment_unmarshal: can't set id: %s to XACML attribute assignment",id);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* datatype (optional) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE);
+    if (h_string != NULL) {
+        hessian_t h_string_type= hessian_gettype(h_string);
+        const char * datatype= NULL;
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        if (h_string_type == HESSIAN_STRING) {
+            datatype= hessian_string_getstring(h_string);
+        }
+        if (xacml_attributeassignment_setdatatype(attribute,datatype) != PEP_XACML_OK) {
+            pep_log_error("xacml_attributeassignment_unmarshal: can't set datatype: %s to XACML attribute assignment",datatype);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        known_l++;
+    }
+    /* value (optional) */
+    h_string= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE);
+    if (h_string != NULL) {
+        hessian_t h_string_type= hessian_gettype(h_string);
+        const char * value;
+        if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
+            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string or null.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        value= NULL;
+        if (h_string_type == HESSIAN_STRING) {
+            value= hessian_string_getstring(h_string);
+        }
+        if (xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
+            pep_log_error("xacml_attributeassignment_unmarshal: can't set value: %s to XACML attribute assignment",value);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
         }
-        /* results list */
-        else if (strcmp(XACML_HESSIAN_RESPONSE_RESULTS,key) == 0) {
-            hessian_object_t * h_results= hessian_map_getvalue(h_response,i);
-            size_t h_results_l;
-            if (hessian_gettype(h_results) != HESSIAN_LIST) {
-                pep_log_error("xacml_response_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key,i);
-                xacml_response_delete(response);
+        known_l++;
+    }
+    /* multiple values (back compatibility with PEPd <= 1.0) */
+    h_values= hessian_map_get(h_attribute,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+    if (h_values != NULL) {
+        size_t h_values_l;
+        if (hessian_gettype(h_values) != HESSIAN_LIST) {
+            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',...> is not a Hessian list.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+            xacml_attributeassignment_delete(attribute);
+            return PEP_IO_ERROR;
+        }
+        pep_log_warn("xacml_attributeassignment_unmarshal: DEPRECATED Hessian map<'%s',...> received.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+        h_values_l= hessian_list_length(h_values);
+        for(j= 0; j<h_values_l; j++) {
+            hessian_object_t * h_value= hessian_list_get(h_values,j);
+            const char * value;
+            if (hessian_gettype(h_value) != HESSIAN_STRING) {
+                pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES,j);
+                xacml_attributeassignment_delete(attribute);
                 return PEP_IO_ERROR;
             }
-            h_results_l= hessian_list_length(h_results);
-            for(j= 0; j<h_results_l; j++) {
-                hessian_object_t * h_result= hessian_list_get(h_results,j);
-                xacml_result_t * result= NULL;
-                if (xacml_result_unmarshal(&result,h_result) != PEP_IO_OK) {
-                    pep_log_error("xacml_response_unmarshal: can't unmarshal XACML result at: %d.",j);
-                    xacml_response_delete(response);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_response_addresult(response,result) != PEP_XACML_OK) {
-                    pep_log_error("xacml_response_unmarshal: can't add XACML result at: %d to XACML response.",j);
-                    xacml_result_delete(result);
-                    xacml_response_delete(response);
-                    return PEP_IO_ERROR;
-                }
+            value= hessian_string_getstring(h_value);
+            if (xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
+                pep_log_error("xacml_attributeassignment_unmarshal: can't set value: %s to XACML attribute assignment at: %d",value,j);
+                xacml_attributeassignment_delete(attribute);
+                return PEP_IO_ERROR;
             }
         }
+        known_l++;
+    }
+    xacml_unmarshal_unknownkeys(h_attribute,known_l,"xacml_attributeassignment_unmarshal");
+    *attr= attribute;
+    return PEP_IO_OK;
+
+}
+
+/*
+ * Hessian 1.0 pull reader unmarshalling: the XACML response is built while
+ * the Hessian tokens are read, without building the Hessian objects. The
+ * map<key> and the string values are only valid until the next token.
+ */
+
+/*
+ * XACML Hessian map<key> identifiers: the reader unmarshallers switch on the
+ * identifier of the key, looked up once, instead of comparing the key with
+ * each known key in turn.
+ */
+typedef enum {
+    XACML_KEY_UNKNOWN= 0,
+    XACML_KEY_ID,
+    XACML_KEY_CODE,
+    XACML_KEY_VALUE,
+    XACML_KEY_ACTION,
+    XACML_KEY_ISSUER,
+    XACML_KEY_STATUS,
+    XACML_KEY_VALUES,
+    XACML_KEY_MESSAGE,
+    XACML_KEY_REQUEST,
+    XACML_KEY_RESULTS,
+    XACML_KEY_SUBCODE,
+    XACML_KEY_CATEGORY,
+    XACML_KEY_DATATYPE,
+    XACML_KEY_DECISION,
+    XACML_KEY_SUBJECTS,
+    XACML_KEY_FULFILLON,
+    XACML_KEY_RESOURCES,
+    XACML_KEY_ATTRIBUTES,
+    XACML_KEY_RESOURCEID,
+    XACML_KEY_STATUSCODE,
+    XACML_KEY_ATTRIBUTEID,
+    XACML_KEY_ENVIRONMENT,
+    XACML_KEY_OBLIGATIONS,
+    XACML_KEY_RESOURCECONTENT,
+    XACML_KEY_ATTRIBUTEASSIGNMENTS,
+} xacml_key_t;
+
+typedef struct xacml_key_entry {
+    size_t length;
+    const char * name;
+    xacml_key_t id;
+} xacml_key_entry_t;
+
+/* the known keys of all the XACML classes, sorted by length, then by bytes */
+static const xacml_key_entry_t xacml_keys[]= {
+    { sizeof(XACML_HESSIAN_ATTRIBUTE_ID) - 1, XACML_HESSIAN_ATTRIBUTE_ID, XACML_KEY_ID },
+    { sizeof(XACML_HESSIAN_STATUSCODE_VALUE) - 1, XACML_HESSIAN_STATUSCODE_VALUE, XACML_KEY_CODE },
+    { sizeof(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE) - 1, XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE, XACML_KEY_VALUE },
+    { sizeof(XACML_HESSIAN_REQUEST_ACTION) - 1, XACML_HESSIAN_REQUEST_ACTION, XACML_KEY_ACTION },
+    { sizeof(XACML_HESSIAN_ATTRIBUTE_ISSUER) - 1, XACML_HESSIAN_ATTRIBUTE_ISSUER, XACML_KEY_ISSUER },
+    { sizeof(XACML_HESSIAN_RESULT_STATUS) - 1, XACML_HESSIAN_RESULT_STATUS, XACML_KEY_STATUS },
+    { sizeof(XACML_HESSIAN_ATTRIBUTE_VALUES) - 1, XACML_HESSIAN_ATTRIBUTE_VALUES, XACML_KEY_VALUES },
+    { sizeof(XACML_HESSIAN_STATUS_MESSAGE) - 1, XACML_HESSIAN_STATUS_MESSAGE, XACML_KEY_MESSAGE },
+    { sizeof(XACML_HESSIAN_RESPONSE_REQUEST) - 1, XACML_HESSIAN_RESPONSE_REQUEST, XACML_KEY_REQUEST },
+    { sizeof(XACML_HESSIAN_RESPONSE_RESULTS) - 1, XACML_HESSIAN_RESPONSE_RESULTS, XACML_KEY_RESULTS },
+    { sizeof(XACML_HESSIAN_STATUSCODE_SUBCODE) - 1, XACML_HESSIAN_STATUSCODE_SUBCODE, XACML_KEY_SUBCODE },
+    { sizeof(XACML_HESSIAN_SUBJECT_CATEGORY) - 1, XACML_HESSIAN_SUBJECT_CATEGORY, XACML_KEY_CATEGORY },
+    { sizeof(XACML_HESSIAN_ATTRIBUTE_DATATYPE) - 1, XACML_HESSIAN_ATTRIBUTE_DATATYPE, XACML_KEY_DATATYPE },
+    { sizeof(XACML_HESSIAN_RESULT_DECISION) - 1, XACML_HESSIAN_RESULT_DECISION, XACML_KEY_DECISION },
+    { sizeof(XACML_HESSIAN_REQUEST_SUBJECTS) - 1, XACML_HESSIAN_REQUEST_SUBJECTS, XACML_KEY_SUBJECTS },
+    { sizeof(XACML_HESSIAN_OBLIGATION_FULFILLON) - 1, XACML_HESSIAN_OBLIGATION_FULFILLON, XACML_KEY_FULFILLON },
+    { sizeof(XACML_HESSIAN_REQUEST_RESOURCES) - 1, XACML_HESSIAN_REQUEST_RESOURCES, XACML_KEY_RESOURCES },
+    { sizeof(XACML_HESSIAN_SUBJECT_ATTRIBUTES) - 1, XACML_HESSIAN_SUBJECT_ATTRIBUTES, XACML_KEY_ATTRIBUTES },
+    { sizeof(XACML_HESSIAN_RESULT_RESOURCEID) - 1, XACML_HESSIAN_RESULT_RESOURCEID, XACML_KEY_RESOURCEID },
+    { sizeof(XACML_HESSIAN_STATUS_CODE) - 1, XACML_HESSIAN_STATUS_CODE, XACML_KEY_STATUSCODE },
+    { sizeof(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID) - 1, XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID, XACML_KEY_ATTRIBUTEID },
+    { sizeof(XACML_HESSIAN_REQUEST_ENVIRONMENT) - 1, XACML_HESSIAN_REQUEST_ENVIRONMENT, XACML_KEY_ENVIRONMENT },
+    { sizeof(XACML_HESSIAN_RESULT_OBLIGATIONS) - 1, XACML_HESSIAN_RESULT_OBLIGATIONS, XACML_KEY_OBLIGATIONS },
+    { sizeof(XACML_HESSIAN_RESOURCE_CONTENT) - 1, XACML_HESSIAN_RESOURCE_CONTENT, XACML_KEY_RESOURCECONTENT },
+    { sizeof(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS) - 1, XACML_HESSIAN_OBLIGATION_ASSIGNMENTS, XACML_KEY_ATTRIBUTEASSIGNMENTS },
+};
+
+#define XACML_KEYS_L (sizeof(xacml_keys) / sizeof(xacml_key_entry_t))
+
+/**
+ * Returns the identifier of the key (not null terminated), or
+ * XACML_KEY_UNKNOWN. Binary search on the length, then on the bytes.
+ */
+static xacml_key_t xacml_key_getid(const char * key, size_t key_l) {
+    size_t lo= 0, hi= XACML_KEYS_L;
+    while (lo < hi) {
+        size_t mid= (lo + hi) / 2;
+        const xacml_key_entry_t * entry= &xacml_keys[mid];
+        int cmp;
+        if (entry->length != key_l) {
+            cmp= (entry->length < key_l) ? -1 : 1;
+        }
         else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_response_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
+            cmp= memcmp(entry->name,key,key_l);
         }
+        if (cmp == 0) return entry->id;
+        if (cmp < 0) lo= mid + 1;
+        else hi= mid;
     }
-    *resp= response;
-    return PEP_IO_OK;
+    return XACML_KEY_UNKNOWN;
 }
 
-/* OK */
-static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t * h_result) {
+/**
+ * Checks the token read: the expected one or a null if nullable.
+ */
+static int xacml_reader_check(hessian_token_t token, hessian_token_t expected, int nullable, const char * func, const char * key) {
+    if (token == expected || (nullable && token == HESSIAN_TOKEN_NULL)) {
+        return PEP_IO_OK;
+    }
+    if (token == HESSIAN_TOKEN_REF) {
+        pep_log_debug("%s: Hessian ref for map<'%s',value>, object tree required.",func,key);
+        return PEP_IO_REF;
+    }
+    pep_log_error("%s: Hessian map<'%s',value> is not the expected Hessian token: %d (%d).",func,key,(int)expected,(int)token);
+    return PEP_IO_ERROR;
+}
+
+/**
+ * Checks that the token read starts a Hessian map of the given class.
+ */
+static int xacml_reader_map(hessian_reader_t * reader, hessian_token_t token, const char * classname, const char * func) {
     const char * map_type;
-    xacml_result_t * result;
-    size_t map_l;
-    int i, j;
-    if (hessian_gettype(h_result) != HESSIAN_MAP) {
-        pep_log_error("xacml_result_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_result), hessian_getclassname(h_result));
+    if (token == HESSIAN_TOKEN_REF) {
+        pep_log_debug("%s: Hessian ref for %s, object tree required.",func,classname);
+        return PEP_IO_REF;
+    }
+    if (token != HESSIAN_TOKEN_MAP_START) {
+        pep_log_error("%s: wrong Hessian token: %d, map expected.",func,(int)token);
         return PEP_IO_ERROR;
     }
-    map_type= hessian_map_gettype(h_result);
+    map_type= hessian_reader_gettype(reader);
     if (map_type == NULL) {
-        pep_log_error("xacml_result_unmarshal: NULL Hessian map type.");
+        pep_log_error("%s: NULL Hessian map type.",func);
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_RESULT_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_result_unmarshal: wrong Hessian map type: %s.",map_type);
+    if (strcmp(classname,map_type) != 0) {
+        pep_log_error("%s: wrong Hessian map type: %s.",func,map_type);
         return PEP_IO_ERROR;
     }
-    result= xacml_result_create();
-    if (result == NULL) {
-        pep_log_error("xacml_result_unmarshal: can't create XACML result.");
+    return PEP_IO_OK;
+}
+
+/**
+ * Reads the next map<key>, the key is NULL at the end of the map. The key is
+ * not copied nor null terminated, and only valid until the next token.
+ */
+static int xacml_reader_key(hessian_reader_t * reader, const char ** key, size_t * key_l, const char * func) {
+    hessian_token_t token= hessian_reader_next(reader);
+    *key= NULL;
+    *key_l= 0;
+    if (token == HESSIAN_TOKEN_MAP_END) {
+        return PEP_IO_OK;
+    }
+    if (token != HESSIAN_TOKEN_STRING) {
+        pep_log_error("%s: Hessian map<key> is not an Hessian string (token: %d).",func,(int)token);
         return PEP_IO_ERROR;
     }
+    *key= hessian_reader_getview(reader,key_l);
+    if (*key == NULL) *key= "";
+    return PEP_IO_OK;
+}
 
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_result);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_result,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_result_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_result_delete(result);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_result_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_result_delete(result);
-            return PEP_IO_ERROR;
-        }
-        /* decision (enum, mandatory) */
-        if (strcmp(XACML_HESSIAN_RESULT_DECISION,key) == 0) {
-            hessian_object_t * h_integer= hessian_map_getvalue(h_result,i);
-            int32_t decision;
-            if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
-                pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian integer at: %d.",key,i);
-                xacml_result_delete(result);
-                return PEP_IO_ERROR;
-            }
-            decision= hessian_integer_getvalue(h_integer);
-            if (xacml_result_setdecision(result,decision) != PEP_XACML_OK) {
-                pep_log_error("xacml_result_unmarshal: can't set decision: %d to XACML result.",(int)decision);
-                xacml_result_delete(result);
-                return PEP_IO_ERROR;
-            }
-        }
-        /* resourceid (optional) */
-        else if (strcmp(XACML_HESSIAN_RESULT_RESOURCEID,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_result,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            const char * resourceid;
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_result_delete(result);
-                return PEP_IO_ERROR;
+/**
+ * Reads a string map<key,value>, the value is NULL for a Hessian null.
+ */
+static int xacml_reader_string_n(hessian_reader_t * reader, const char ** value, size_t * value_l, int nullable, const char * func, const char * key) {
+    hessian_token_t token= hessian_reader_next(reader);
+    int rc= xacml_reader_check(token,HESSIAN_TOKEN_STRING,nullable,func,key);
+    *value= NULL;
+    *value_l= 0;
+    if (rc == PEP_IO_OK && token == HESSIAN_TOKEN_STRING) {
+        *value= hessian_reader_getstring(reader,value_l);
+    }
+    return rc;
+}
+
+static int xacml_reader_string(hessian_reader_t * reader, const char ** value, int nullable, const char * func, const char * key) {
+    size_t value_l;
+    return xacml_reader_string_n(reader,value,&value_l,nullable,func,key);
+}
+
+/**
+ * Reads an integer map<key,value>.
+ */
+static int xacml_reader_integer(hessian_reader_t * reader, int32_t * value, const char * func, const char * key) {
+    int rc= xacml_reader_check(hessian_reader_next(reader),HESSIAN_TOKEN_INTEGER,FALSE,func,key);
+    *value= hessian_reader_getinteger(reader);
+    return rc;
+}
+
+/**
+ * Reads the start of a list map<key,value>.
+ */
+static int xacml_reader_list(hessian_reader_t * reader, const char * func, const char * key) {
+    return xacml_reader_check(hessian_reader_next(reader),HESSIAN_TOKEN_LIST_START,FALSE,func,key);
+}
+
+/**
+ * Skips the value of an unknown map<key>.
+ */
+static int xacml_reader_skipvalue(hessian_reader_t * reader, const char * func) {
+    hessian_token_t token= hessian_reader_next(reader);
+    if (token == HESSIAN_TOKEN_ERROR || token == HESSIAN_TOKEN_EOF || hessian_reader_skip(reader) != HESSIAN_OK) {
+        pep_log_error("%s: can't skip Hessian map<key,value>.",func);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+static int xacml_attribute_read(hessian_reader_t * reader, hessian_token_t token, xacml_attribute_t ** attr, xacml_arena_t * arena) {
+    xacml_attribute_t * attribute;
+    const char * key;
+    size_t key_l;
+    const char * value;
+    size_t value_l;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_ATTRIBUTE_CLASSNAME,"xacml_attribute_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    attribute= xacml_attribute_create_in(NULL,arena);
+    if (attribute == NULL) {
+        pep_log_error("xacml_attribute_read: can't create XACML attribute.");
+        return PEP_IO_ERROR;
+    }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_attribute_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* id (mandatory) */
+        case XACML_KEY_ID:
+            rc= xacml_reader_string_n(reader,&value,&value_l,FALSE,"xacml_attribute_read",XACML_HESSIAN_ATTRIBUTE_ID);
+            if (rc == PEP_IO_OK && xacml_attribute_setid_n(attribute,value,value_l) != PEP_XACML_OK) {
+                pep_log_error("xacml_attribute_read: can't set id: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
             }
-            resourceid= NULL;
-            if (h_string_type == HESSIAN_STRING) {
-                resourceid= hessian_string_getstring(h_string);
+            break;
+        /* datatype (optional) */
+        case XACML_KEY_DATATYPE:
+            rc= xacml_reader_string_n(reader,&value,&value_l,TRUE,"xacml_attribute_read",XACML_HESSIAN_ATTRIBUTE_DATATYPE);
+            if (rc == PEP_IO_OK && xacml_attribute_setdatatype_n(attribute,value,value_l) != PEP_XACML_OK) {
+                pep_log_error("xacml_attribute_read: can't set datatype: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
             }
-            if (xacml_result_setresourceid(result, resourceid) != PEP_XACML_OK) {
-                pep_log_error("xacml_result_unmarshal: can't set resourceid: %s to XACML result.",resourceid);
-                xacml_result_delete(result);
-                return PEP_IO_ERROR;
+            break;
+        /* issuer (optional) */
+        case XACML_KEY_ISSUER:
+            rc= xacml_reader_string_n(reader,&value,&value_l,TRUE,"xacml_attribute_read",XACML_HESSIAN_ATTRIBUTE_ISSUER);
+            if (rc == PEP_IO_OK && xacml_attribute_setissuer_n(attribute,value,value_l) != PEP_XACML_OK) {
+                pep_log_error("xacml_attribute_read: can't set issuer: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
             }
-        }
-        /* status (null?) */
-        else if (strcmp(XACML_HESSIAN_RESULT_STATUS,key) == 0) {
-            hessian_object_t * h_status= hessian_map_getvalue(h_result,i);
-            if (hessian_gettype(h_status) != HESSIAN_NULL) {
-                xacml_status_t * status= NULL;
-                if (xacml_status_unmarshal(&status,h_status) != PEP_IO_OK) {
-                    pep_log_error("xacml_result_unmarshal: can't unmarshal XACML status.");
-                    xacml_result_delete(result);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_result_setstatus(result,status) != PEP_XACML_OK) {
-                    pep_log_error("xacml_result_unmarshal: can't set XACML status to XACML result.");
-                    xacml_result_delete(result);
-                    xacml_status_delete(status);
-                    return PEP_IO_ERROR;
+            break;
+        /* values list */
+        case XACML_KEY_VALUES:
+            rc= xacml_reader_list(reader,"xacml_attribute_read",XACML_HESSIAN_ATTRIBUTE_VALUES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                rc= xacml_reader_check(token,HESSIAN_TOKEN_STRING,FALSE,"xacml_attribute_read",XACML_HESSIAN_ATTRIBUTE_VALUES);
+                if (rc == PEP_IO_OK) {
+                    value= hessian_reader_getstring(reader,&value_l);
+                    if (xacml_attribute_addvalue_n(attribute,value,value_l) != PEP_XACML_OK) {
+                        pep_log_error("xacml_attribute_read: can't add value: %s to XACML attribute.",value);
+                        rc= PEP_IO_ERROR;
+                    }
                 }
             }
-            else {
-                pep_log_warn("xacml_result_unmarshal: XACML status is NULL.");
-            }
+            break;
+        default:
+            pep_log_warn("xacml_attribute_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_attribute_read");
         }
-        /* obligations list */
-        else if (strcmp(XACML_HESSIAN_RESULT_OBLIGATIONS,key) == 0) {
-            hessian_object_t * h_obligations= hessian_map_getvalue(h_result,i);
-            size_t h_obligations_l;
-            if (hessian_gettype(h_obligations) != HESSIAN_LIST) {
-                pep_log_error("xacml_result_unmarshal: Hessian map<'%s',value> is not a Hessian list.",key);
-                xacml_result_delete(result);
-                return PEP_IO_ERROR;
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_attribute_delete(attribute);
+        return rc;
+    }
+    *attr= attribute;
+    return PEP_IO_OK;
+}
+
+static int xacml_subject_read(hessian_reader_t * reader, hessian_token_t token, xacml_subject_t ** subj, xacml_arena_t * arena) {
+    xacml_subject_t * subject;
+    const char * key;
+    size_t key_l;
+    const char * category;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_SUBJECT_CLASSNAME,"xacml_subject_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    subject= xacml_subject_create_in(arena);
+    if (subject == NULL) {
+        pep_log_error("xacml_subject_read: can't create XACML subject.");
+        return PEP_IO_ERROR;
+    }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_subject_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* category (can be null) */
+        case XACML_KEY_CATEGORY:
+            rc= xacml_reader_string(reader,&category,TRUE,"xacml_subject_read",XACML_HESSIAN_SUBJECT_CATEGORY);
+            if (rc == PEP_IO_OK && xacml_subject_setcategory(subject,category) != PEP_XACML_OK) {
+                pep_log_error("xacml_subject_read: can't set category: %s to XACML subject.",category);
+                rc= PEP_IO_ERROR;
             }
-            h_obligations_l= hessian_list_length(h_obligations);
-            for(j= 0; j<h_obligations_l; j++) {
-                hessian_object_t * h_obligation= hessian_list_get(h_obligations,j);
-                xacml_obligation_t * obligation= NULL;
-                if (xacml_obligation_unmarshal(&obligation,h_obligation) != PEP_IO_OK) {
-                    pep_log_error("xacml_result_unmarshal: can't unmarshal XACML obligation at: %d.", j);
-                    xacml_result_delete(result);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_result_addobligation(result,obligation) != PEP_XACML_OK) {
-                    pep_log_error("xacml_result_unmarshal: can't add XACML obligation at: %d to XACML result.", j);
-                    xacml_result_delete(result);
-                    xacml_obligation_delete(obligation);
-                    return PEP_IO_ERROR;
+            break;
+        /* attributes list */
+        case XACML_KEY_ATTRIBUTES:
+            rc= xacml_reader_list(reader,"xacml_subject_read",XACML_HESSIAN_SUBJECT_ATTRIBUTES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_attribute_t * attribute= NULL;
+                rc= xacml_attribute_read(reader,token,&attribute,arena);
+                if (rc == PEP_IO_OK && xacml_subject_addattribute(subject,attribute) != PEP_XACML_OK) {
+                    pep_log_error("xacml_subject_read: can't add XACML attribute to XACML subject.");
+                    xacml_attribute_delete(attribute);
+                    rc= PEP_IO_ERROR;
                 }
             }
+            break;
+        default:
+            pep_log_warn("xacml_subject_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_subject_read");
         }
-        else {
-            /* unkown key ??? */
-            pep_log_warn("xacml_result_unmarshal: unknown map<key>: %s at: %d.",key,i);
-        }
+        if (rc != PEP_IO_OK) break;
     }
-    *res= result;
+    if (rc != PEP_IO_OK) {
+        xacml_subject_delete(subject);
+        return rc;
+    }
+    *subj= subject;
     return PEP_IO_OK;
 }
 
-/* OK */
-static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t * h_status) {
-    const char * map_type;
-    xacml_status_t * status;
-    size_t map_l;
-    int i;
-    if (hessian_gettype(h_status) != HESSIAN_MAP) {
-        pep_log_error("xacml_status_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_status), hessian_getclassname(h_status));
-        return PEP_IO_ERROR;
+static int xacml_resource_read(hessian_reader_t * reader, hessian_token_t token, xacml_resource_t ** res, xacml_arena_t * arena) {
+    xacml_resource_t * resource;
+    const char * key;
+    size_t key_l;
+    const char * content;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_RESOURCE_CLASSNAME,"xacml_resource_read")) != PEP_IO_OK) {
+        return rc;
     }
-    map_type= hessian_map_gettype(h_status);
-    if (map_type == NULL) {
-        pep_log_error("xacml_status_unmarshal: NULL Hessian map type.");
+    resource= xacml_resource_create_in(arena);
+    if (resource == NULL) {
+        pep_log_error("xacml_resource_read: can't create XACML resource.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_STATUS_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_status_unmarshal: wrong Hessian map type: %s.",map_type);
-        return PEP_IO_ERROR;
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_resource_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* content (can be null) */
+        case XACML_KEY_RESOURCECONTENT:
+            rc= xacml_reader_string(reader,&content,TRUE,"xacml_resource_read",XACML_HESSIAN_RESOURCE_CONTENT);
+            if (rc == PEP_IO_OK && xacml_resource_setcontent(resource,content) != PEP_XACML_OK) {
+                pep_log_error("xacml_resource_read: can't set content: %s to XACML resource.",content);
+                rc= PEP_IO_ERROR;
+            }
+            break;
+        /* attributes list */
+        case XACML_KEY_ATTRIBUTES:
+            rc= xacml_reader_list(reader,"xacml_resource_read",XACML_HESSIAN_RESOURCE_ATTRIBUTES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_attribute_t * attribute= NULL;
+                rc= xacml_attribute_read(reader,token,&attribute,arena);
+                if (rc == PEP_IO_OK && xacml_resource_addattribute(resource,attribute) != PEP_XACML_OK) {
+                    pep_log_error("xacml_resource_read: can't add XACML attribute to XACML resource.");
+                    xacml_attribute_delete(attribute);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            break;
+        default:
+            pep_log_warn("xacml_resource_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_resource_read");
+        }
+        if (rc != PEP_IO_OK) break;
     }
-    status= xacml_status_create(NULL);
-    if (status == NULL) {
-        pep_log_error("xacml_status_unmarshal: can't create XACML status.");
+    if (rc != PEP_IO_OK) {
+        xacml_resource_delete(resource);
+        return rc;
+    }
+    *res= resource;
+    return PEP_IO_OK;
+}
+
+static int xacml_action_read(hessian_reader_t * reader, hessian_token_t token, xacml_action_t ** act, xacml_arena_t * arena) {
+    xacml_action_t * action;
+    const char * key;
+    size_t key_l;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_ACTION_CLASSNAME,"xacml_action_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    action= xacml_action_create_in(arena);
+    if (action == NULL) {
+        pep_log_error("xacml_action_read: can't create XACML action.");
         return PEP_IO_ERROR;
     }
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_status);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_status,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_status_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_status_delete(status);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_status_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_status_delete(status);
-            return PEP_IO_ERROR;
-        }
-        /* message (can be null) */
-        if (strcmp(XACML_HESSIAN_STATUS_MESSAGE,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_status,i);
-            if (hessian_gettype(h_string) != HESSIAN_NULL) {
-                const char * message;
-                if (hessian_gettype(h_string) != HESSIAN_STRING) {
-                    pep_log_error("xacml_status_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                    xacml_status_delete(status);
-                    return PEP_IO_ERROR;
-                }
-                message= hessian_string_getstring(h_string);
-                if (xacml_status_setmessage(status,message) != PEP_XACML_OK) {
-                    pep_log_error("xacml_status_unmarshal: can't set message: %s to XACML status at: %d",message,i);
-                    xacml_status_delete(status);
-                    return PEP_IO_ERROR;
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_action_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* attributes list */
+        case XACML_KEY_ATTRIBUTES:
+            rc= xacml_reader_list(reader,"xacml_action_read",XACML_HESSIAN_ACTION_ATTRIBUTES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_attribute_t * attribute= NULL;
+                rc= xacml_attribute_read(reader,token,&attribute,arena);
+                if (rc == PEP_IO_OK && xacml_action_addattribute(action,attribute) != PEP_XACML_OK) {
+                    pep_log_error("xacml_action_read: can't add XACML attribute to XACML action.");
+                    xacml_attribute_delete(attribute);
+                    rc= PEP_IO_ERROR;
                 }
             }
+            break;
+        default:
+            pep_log_warn("xacml_action_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_action_read");
         }
-        /* subcode (can be null) */
-        else if (strcmp(XACML_HESSIAN_STATUS_CODE,key) == 0) {
-            hessian_object_t * h_statuscode= hessian_map_getvalue(h_status,i);
-            if (hessian_gettype(h_statuscode) != HESSIAN_NULL) {
-                xacml_statuscode_t * statuscode= NULL;
-                if (xacml_statuscode_unmarshal(&statuscode,h_statuscode) != PEP_IO_OK) {
-                    pep_log_error("xacml_status_unmarshal: can't unmarshal XACML statuscode at: %d.", i);
-                    xacml_status_delete(status);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_status_setcode(status,statuscode) != PEP_XACML_OK) {
-                    pep_log_error("xacml_status_unmarshal: can't set XACML statuscode to XACML status.");
-                    xacml_status_delete(status);
-                    xacml_statuscode_delete(statuscode);
-                    return PEP_IO_ERROR;
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_action_delete(action);
+        return rc;
+    }
+    *act= action;
+    return PEP_IO_OK;
+}
+
+static int xacml_environment_read(hessian_reader_t * reader, hessian_token_t token, xacml_environment_t ** env, xacml_arena_t * arena) {
+    xacml_environment_t * environment;
+    const char * key;
+    size_t key_l;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_ENVIRONMENT_CLASSNAME,"xacml_environment_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    environment= xacml_environment_create_in(arena);
+    if (environment == NULL) {
+        pep_log_error("xacml_environment_read: can't create XACML environment.");
+        return PEP_IO_ERROR;
+    }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_environment_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* attributes list */
+        case XACML_KEY_ATTRIBUTES:
+            rc= xacml_reader_list(reader,"xacml_environment_read",XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_attribute_t * attribute= NULL;
+                rc= xacml_attribute_read(reader,token,&attribute,arena);
+                if (rc == PEP_IO_OK && xacml_environment_addattribute(environment,attribute) != PEP_XACML_OK) {
+                    pep_log_error("xacml_environment_read: can't add XACML attribute to XACML environment.");
+                    xacml_attribute_delete(attribute);
+                    rc= PEP_IO_ERROR;
                 }
             }
-            else {
-                pep_log_warn("xacml_status_unmarshal: subcode XACML statuscode is NULL.");
-            }
-        }
-        else {
-            pep_log_warn("xacml_status_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
+            break;
+        default:
+            pep_log_warn("xacml_environment_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_environment_read");
         }
+        if (rc != PEP_IO_OK) break;
     }
-    *st= status;
+    if (rc != PEP_IO_OK) {
+        xacml_environment_delete(environment);
+        return rc;
+    }
+    *env= environment;
     return PEP_IO_OK;
 }
 
-/* OK */
-static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_object_t * h_statuscode) {
-    const char * map_type;
-    xacml_statuscode_t * statuscode;
-    size_t map_l;
-    int i;
-    if (hessian_gettype(h_statuscode) != HESSIAN_MAP) {
-        pep_log_error("xacml_statuscode_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_statuscode), hessian_getclassname(h_statuscode));
-        return PEP_IO_ERROR;
+static int xacml_request_read(hessian_reader_t * reader, hessian_token_t token, xacml_request_t ** req, xacml_arena_t * arena) {
+    xacml_request_t * request;
+    const char * key;
+    size_t key_l;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_REQUEST_CLASSNAME,"xacml_request_read")) != PEP_IO_OK) {
+        return rc;
     }
-    map_type= hessian_map_gettype(h_statuscode);
-    if (map_type == NULL) {
-        pep_log_error("xacml_statuscode_unmarshal: NULL Hessian map type.");
+    request= xacml_request_create_in(arena);
+    if (request == NULL) {
+        pep_log_error("xacml_request_read: can't create XACML request.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_STATUSCODE_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_statuscode_unmarshal: wrong Hessian map type: %s.",map_type);
-        return PEP_IO_ERROR;
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_request_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* subjects list */
+        case XACML_KEY_SUBJECTS:
+            rc= xacml_reader_list(reader,"xacml_request_read",XACML_HESSIAN_REQUEST_SUBJECTS);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_subject_t * subject= NULL;
+                rc= xacml_subject_read(reader,token,&subject,arena);
+                if (rc == PEP_IO_OK && xacml_request_addsubject(request,subject) != PEP_XACML_OK) {
+                    pep_log_error("xacml_request_read: can't add XACML subject to XACML request.");
+                    xacml_subject_delete(subject);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            break;
+        /* resources list */
+        case XACML_KEY_RESOURCES:
+            rc= xacml_reader_list(reader,"xacml_request_read",XACML_HESSIAN_REQUEST_RESOURCES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_resource_t * resource= NULL;
+                rc= xacml_resource_read(reader,token,&resource,arena);
+                if (rc == PEP_IO_OK && xacml_request_addresource(request,resource) != PEP_XACML_OK) {
+                    pep_log_error("xacml_request_read: can't add XACML resource to XACML request.");
+                    xacml_resource_delete(resource);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            break;
+        /* action (null) */
+        case XACML_KEY_ACTION:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
+                xacml_action_t * action= NULL;
+                rc= xacml_action_read(reader,token,&action,arena);
+                if (rc == PEP_IO_OK && xacml_request_setaction(request,action) != PEP_XACML_OK) {
+                    pep_log_error("xacml_request_read: can't set XACML action to XACML request.");
+                    xacml_action_delete(action);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            break;
+        /* environment (null) */
+        case XACML_KEY_ENVIRONMENT:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
+                xacml_environment_t * environment= NULL;
+                rc= xacml_environment_read(reader,token,&environment,arena);
+                if (rc == PEP_IO_OK && xacml_request_setenvironment(request,environment) != PEP_XACML_OK) {
+                    pep_log_error("xacml_request_read: can't set XACML environment to XACML request.");
+                    xacml_environment_delete(environment);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            break;
+        default:
+            pep_log_warn("xacml_request_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_request_read");
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_request_delete(request);
+        return rc;
     }
+    *req= request;
+    return PEP_IO_OK;
+}
 
-    statuscode= xacml_statuscode_create(NULL);
+static int xacml_statuscode_read(hessian_reader_t * reader, hessian_token_t token, xacml_statuscode_t ** stc, xacml_arena_t * arena) {
+    xacml_statuscode_t * statuscode;
+    const char * key;
+    size_t key_l;
+    const char * code;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_STATUSCODE_CLASSNAME,"xacml_statuscode_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    statuscode= xacml_statuscode_create_in(NULL,arena);
     if (statuscode == NULL) {
-        pep_log_error("xacml_statuscode_unmarshal: cant't create XACML statuscode.");
+        pep_log_error("xacml_statuscode_read: can't create XACML statuscode.");
         return PEP_IO_ERROR;
     }
-
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_statuscode);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_statuscode,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_statuscode_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_statuscode_delete(statuscode);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_statuscode_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_statuscode_delete(statuscode);
-            return PEP_IO_ERROR;
-        }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_statuscode_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
         /* code (mandatory) */
-        if (strcmp(XACML_HESSIAN_STATUSCODE_VALUE,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_statuscode,i);
-            const char * code;
-            if (hessian_gettype(h_string) != HESSIAN_STRING) {
-                pep_log_error("xacml_statuscode_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                xacml_statuscode_delete(statuscode);
-                return PEP_IO_ERROR;
-            }
-            code = hessian_string_getstring(h_string);
-            if (xacml_statuscode_setvalue(statuscode,code) != PEP_XACML_OK) {
-                pep_log_error("xacml_statuscode_unmarshal: can't set value: %s to XACML statuscode at: %d",code,i);
-                xacml_statuscode_delete(statuscode);
-                return PEP_IO_ERROR;
+        case XACML_KEY_CODE:
+            rc= xacml_reader_string(reader,&code,FALSE,"xacml_statuscode_read",XACML_HESSIAN_STATUSCODE_VALUE);
+            if (rc == PEP_IO_OK && xacml_statuscode_setvalue(statuscode,code) != PEP_XACML_OK) {
+                pep_log_error("xacml_statuscode_read: can't set value: %s to XACML statuscode.",code);
+                rc= PEP_IO_ERROR;
             }
-        }
+            break;
         /* subcode (can be null) */
-        else if (strcmp(XACML_HESSIAN_STATUSCODE_SUBCODE, key) == 0) {
-            hessian_object_t * h_subcode= hessian_map_getvalue(h_statuscode,i);
-            if (hessian_gettype(h_subcode) != HESSIAN_NULL) {
+        case XACML_KEY_SUBCODE:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
                 xacml_statuscode_t * subcode= NULL;
-                if (xacml_statuscode_unmarshal(&subcode,h_subcode) != PEP_IO_OK) {
-                    pep_log_error("xacml_statuscode_unmarshal: can't unmarshal subcode XACML statuscode at: %d.",i);
-                    xacml_statuscode_delete(statuscode);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_statuscode_setsubcode(statuscode,subcode) != PEP_XACML_OK) {
-                    pep_log_error("xacml_statuscode_unmarshal: can't set subcode XACML statuscode to XACML statuscode at: %d",i);
-                    xacml_statuscode_delete(statuscode);
+                rc= xacml_statuscode_read(reader,token,&subcode,arena);
+                if (rc == PEP_IO_OK && xacml_statuscode_setsubcode(statuscode,subcode) != PEP_XACML_OK) {
+                    pep_log_error("xacml_statuscode_read: can't set subcode XACML statuscode to XACML statuscode.");
                     xacml_statuscode_delete(subcode);
-                    return PEP_IO_ERROR;
+                    rc= PEP_IO_ERROR;
                 }
             }
+            break;
+        default:
+            pep_log_warn("xacml_statuscode_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_statuscode_read");
         }
-        else {
-            pep_log_warn("xacml_statuscode_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_statuscode_delete(statuscode);
+        return rc;
     }
     *stc= statuscode;
     return PEP_IO_OK;
 }
 
-static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_object_t * h_obligation) {
-    const char * map_type;
-    xacml_obligation_t * obligation;
-    size_t map_l;
-    int i, j;
-    if (hessian_gettype(h_obligation) != HESSIAN_MAP) {
-        pep_log_error("xacml_obligation_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_obligation), hessian_getclassname(h_obligation));
+static int xacml_status_read(hessian_reader_t * reader, hessian_token_t token, xacml_status_t ** st, xacml_arena_t * arena) {
+    xacml_status_t * status;
+    const char * key;
+    size_t key_l;
+    const char * message;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_STATUS_CLASSNAME,"xacml_status_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    status= xacml_status_create_in(NULL,arena);
+    if (status == NULL) {
+        pep_log_error("xacml_status_read: can't create XACML status.");
         return PEP_IO_ERROR;
     }
-    map_type= hessian_map_gettype(h_obligation);
-    if (map_type == NULL) {
-        pep_log_error("xacml_obligation_unmarshal: NULL Hessian map type.");
-        return PEP_IO_ERROR;
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_status_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* message (can be null) */
+        case XACML_KEY_MESSAGE:
+            rc= xacml_reader_string(reader,&message,TRUE,"xacml_status_read",XACML_HESSIAN_STATUS_MESSAGE);
+            if (rc == PEP_IO_OK && message != NULL && xacml_status_setmessage(status,message) != PEP_XACML_OK) {
+                pep_log_error("xacml_status_read: can't set message: %s to XACML status.",message);
+                rc= PEP_IO_ERROR;
+            }
+            break;
+        /* status code (can be null) */
+        case XACML_KEY_STATUSCODE:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
+                xacml_statuscode_t * statuscode= NULL;
+                rc= xacml_statuscode_read(reader,token,&statuscode,arena);
+                if (rc == PEP_IO_OK && xacml_status_setcode(status,statuscode) != PEP_XACML_OK) {
+                    pep_log_error("xacml_status_read: can't set XACML statuscode to XACML status.");
+                    xacml_statuscode_delete(statuscode);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            else {
+                pep_log_warn("xacml_status_read: subcode XACML statuscode is NULL.");
+            }
+            break;
+        default:
+            pep_log_warn("xacml_status_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_status_read");
+        }
+        if (rc != PEP_IO_OK) break;
     }
-    if (strcmp(XACML_HESSIAN_OBLIGATION_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_obligation_unmarshal: wrong Hessian map type: %s.",map_type);
-        return PEP_IO_ERROR;
+    if (rc != PEP_IO_OK) {
+        xacml_status_delete(status);
+        return rc;
     }
-    obligation= xacml_obligation_create(NULL);
-    if (obligation == NULL) {
-        pep_log_error("xacml_obligation_unmarshal: can't create XACML obligation.");
+    *st= status;
+    return PEP_IO_OK;
+}
+
+static int xacml_attributeassignment_read(hessian_reader_t * reader, hessian_token_t token, xacml_attributeassignment_t ** attr, xacml_arena_t * arena) {
+    xacml_attributeassignment_t * attribute;
+    const char * key;
+    size_t key_l;
+    const char * value;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,"xacml_attributeassignment_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    attribute= xacml_attributeassignment_create_in(NULL,arena);
+    if (attribute == NULL) {
+        pep_log_error("xacml_attributeassignment_read: can't create XACML attribute assignment.");
         return PEP_IO_ERROR;
     }
-
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_obligation);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_obligation,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_obligation_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_obligation_delete(obligation);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_obligation_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_obligation_delete(obligation);
-            return PEP_IO_ERROR;
-        }
-
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_attributeassignment_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
         /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_OBLIGATION_ID,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_obligation,i);
-            const char * id;
-            if (hessian_gettype(h_string) != HESSIAN_STRING) {
-                pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                xacml_obligation_delete(obligation);
-                return PEP_IO_ERROR;
+        case XACML_KEY_ATTRIBUTEID:
+            rc= xacml_reader_string(reader,&value,FALSE,"xacml_attributeassignment_read",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setid(attribute,value) != PEP_XACML_OK) {
+                pep_log_error("xacml_attributeassignment_read: can't set id: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
             }
-            id= hessian_string_getstring(h_string);
-            if (xacml_obligation_setid(obligation,id) != PEP_XACML_OK) {
-                pep_log_error("xacml_obligation_unmarshal: can't set id: %s to XACML obligation at: %d",id,i);
-                xacml_obligation_delete(obligation);
-                return PEP_IO_ERROR;
+            break;
+        /* datatype (optional) */
+        case XACML_KEY_DATATYPE:
+            rc= xacml_reader_string(reader,&value,TRUE,"xacml_attributeassignment_read",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setdatatype(attribute,value) != PEP_XACML_OK) {
+                pep_log_error("xacml_attributeassignment_read: can't set datatype: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
             }
-        }
-        /* fulfillon (enum) */
-        else if (strcmp(XACML_HESSIAN_OBLIGATION_FULFILLON,key) == 0) {
-            hessian_object_t * h_integer= hessian_map_getvalue(h_obligation,i);
-            int32_t fulfillon;
-            if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
-                pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian integer at: %d.",key,i);
-                xacml_obligation_delete(obligation);
-                return PEP_IO_ERROR;
+            break;
+        /* value (optional) */
+        case XACML_KEY_VALUE:
+            rc= xacml_reader_string(reader,&value,TRUE,"xacml_attributeassignment_read",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
+                pep_log_error("xacml_attributeassignment_read: can't set value: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
             }
-            fulfillon= hessian_integer_getvalue(h_integer);
-            if (xacml_obligation_setfulfillon(obligation,fulfillon) != PEP_XACML_OK) {
-                pep_log_error("xacml_obligation_unmarshal: can't set fulfillon: %d to XACML obligation at: %d",(int)fulfillon,i);
-                xacml_obligation_delete(obligation);
-                return PEP_IO_ERROR;
+            break;
+        /* multiple values (back compatibility with PEPd <= 1.0) */
+        case XACML_KEY_VALUES:
+            pep_log_warn("xacml_attributeassignment_read: DEPRECATED Hessian map<'%s',...> received.",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+            rc= xacml_reader_list(reader,"xacml_attributeassignment_read",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                rc= xacml_reader_check(token,HESSIAN_TOKEN_STRING,FALSE,"xacml_attributeassignment_read",XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES);
+                if (rc == PEP_IO_OK) {
+                    value= hessian_reader_getstring(reader,NULL);
+                    if (xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
+                        pep_log_error("xacml_attributeassignment_read: can't set value: %s to XACML attribute assignment.",value);
+                        rc= PEP_IO_ERROR;
+                    }
+                }
             }
+            break;
+        default:
+            pep_log_warn("xacml_attributeassignment_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_attributeassignment_read");
         }
-        /* attribute assignments list */
-        else if (strcmp(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,key) == 0) {
-            hessian_object_t * h_assignments= hessian_map_getvalue(h_obligation,i);
-            size_t h_assignments_l;
-            if (hessian_gettype(h_assignments) != HESSIAN_LIST) {
-                pep_log_error("xacml_obligation_unmarshal: Hessian map<'%s',value> is not a Hessian list at: %d.",key, i);
-                xacml_obligation_delete(obligation);
-                return PEP_IO_ERROR;
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_attributeassignment_delete(attribute);
+        return rc;
+    }
+    *attr= attribute;
+    return PEP_IO_OK;
+}
+
+static int xacml_obligation_read(hessian_reader_t * reader, hessian_token_t token, xacml_obligation_t ** obl, xacml_arena_t * arena) {
+    xacml_obligation_t * obligation;
+    const char * key;
+    size_t key_l;
+    const char * id;
+    int32_t fulfillon;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_OBLIGATION_CLASSNAME,"xacml_obligation_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    obligation= xacml_obligation_create_in(NULL,arena);
+    if (obligation == NULL) {
+        pep_log_error("xacml_obligation_read: can't create XACML obligation.");
+        return PEP_IO_ERROR;
+    }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_obligation_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* id (mandatory) */
+        case XACML_KEY_ID:
+            rc= xacml_reader_string(reader,&id,FALSE,"xacml_obligation_read",XACML_HESSIAN_OBLIGATION_ID);
+            if (rc == PEP_IO_OK && xacml_obligation_setid(obligation,id) != PEP_XACML_OK) {
+                pep_log_error("xacml_obligation_read: can't set id: %s to XACML obligation.",id);
+                rc= PEP_IO_ERROR;
+            }
+            break;
+        /* fulfillon (enum) */
+        case XACML_KEY_FULFILLON:
+            rc= xacml_reader_integer(reader,&fulfillon,"xacml_obligation_read",XACML_HESSIAN_OBLIGATION_FULFILLON);
+            if (rc == PEP_IO_OK && xacml_obligation_setfulfillon(obligation,fulfillon) != PEP_XACML_OK) {
+                pep_log_error("xacml_obligation_read: can't set fulfillon: %d to XACML obligation.",(int)fulfillon);
+                rc= PEP_IO_ERROR;
             }
-            h_assignments_l= hessian_list_length(h_assignments);
-            for(j= 0; j<h_assignments_l; j++) {
-                hessian_object_t * h_assignment= hessian_list_get(h_assignments,j);
+            break;
+        /* attribute assignments list */
+        case XACML_KEY_ATTRIBUTEASSIGNMENTS:
+            rc= xacml_reader_list(reader,"xacml_obligation_read",XACML_HESSIAN_OBLIGATION_ASSIGNMENTS);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
                 xacml_attributeassignment_t * attribute= NULL;
-                if (xacml_attributeassignment_unmarshal(&attribute,h_assignment) != PEP_IO_OK) {
-                    pep_log_error("xacml_obligation_unmarshal: can't unmarshal XACML attribute assignment at: %d.",j);
-                    xacml_obligation_delete(obligation);
-                    return PEP_IO_ERROR;
-                }
-                if (xacml_obligation_addattributeassignment(obligation,attribute) != PEP_XACML_OK) {
-                    pep_log_error("xacml_obligation_unmarshal: can't add XACML attribute assignment to XACML obligation at: %d",j);
-                    xacml_obligation_delete(obligation);
+                rc= xacml_attributeassignment_read(reader,token,&attribute,arena);
+                if (rc == PEP_IO_OK && xacml_obligation_addattributeassignment(obligation,attribute) != PEP_XACML_OK) {
+                    pep_log_error("xacml_obligation_read: can't add XACML attribute assignment to XACML obligation.");
                     xacml_attributeassignment_delete(attribute);
-                    return PEP_IO_ERROR;
+                    rc= PEP_IO_ERROR;
                 }
             }
+            break;
+        default:
+            pep_log_warn("xacml_obligation_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_obligation_read");
         }
-        else {
-            pep_log_warn("xacml_obligation_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
-        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_obligation_delete(obligation);
+        return rc;
     }
-
     *obl= obligation;
     return PEP_IO_OK;
-
 }
 
-static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** attr, const hessian_object_t * h_attribute) {
-    const char * map_type;
-    xacml_attributeassignment_t * attribute;
-    size_t map_l;
-    int i, j;
-    if (hessian_gettype(h_attribute) != HESSIAN_MAP) {
-        pep_log_error("xacml_attributeassignment_unmarshal: wrong Hessian type: %d (%s).", hessian_gettype(h_attribute), hessian_getclassname(h_attribute));
-        return PEP_IO_ERROR;
-    }
-    map_type= hessian_map_gettype(h_attribute);
-    if (map_type == NULL) {
-        pep_log_error("xacml_attributeassignment_unmarshal: NULL Hessian map type.");
-        return PEP_IO_ERROR;
-    }
-    if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,map_type) != 0) {
-        pep_log_error("xacml_attributeassignment_unmarshal: wrong Hessian map type: %s.",map_type);
-        return PEP_IO_ERROR;
-    }
-
-    attribute= xacml_attributeassignment_create(NULL);
-    if (attribute == NULL) {
-        pep_log_error("xacml_attributeassignment_unmarshal: can't create XACML attribute assignment.");
+static int xacml_result_read(hessian_reader_t * reader, hessian_token_t token, xacml_result_t ** res, xacml_arena_t * arena) {
+    xacml_result_t * result;
+    const char * key;
+    size_t key_l;
+    const char * resourceid;
+    int32_t decision;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_RESULT_CLASSNAME,"xacml_result_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    result= xacml_result_create_in(arena);
+    if (result == NULL) {
+        pep_log_error("xacml_result_read: can't create XACML result.");
         return PEP_IO_ERROR;
     }
-
-    /* parse all map pair<key>s */
-    map_l= hessian_map_length(h_attribute);
-    for(i= 0; i<map_l; i++) {
-        hessian_object_t * h_map_key= hessian_map_getkey(h_attribute,i);
-        const char * key;
-        if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
-            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
-            xacml_attributeassignment_delete(attribute);
-            return PEP_IO_ERROR;
-        }
-        key= hessian_string_getstring(h_map_key);
-        if (key == NULL) {
-            pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<key>: NULL string at: %d.",i);
-            xacml_attributeassignment_delete(attribute);
-            return PEP_IO_ERROR;
-        }
-
-        /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            const char * id;
-            if (hessian_gettype(h_string) != HESSIAN_STRING) {
-                pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_result_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* decision (enum, mandatory) */
+        case XACML_KEY_DECISION:
+            rc= xacml_reader_integer(reader,&decision,"xacml_result_read",XACML_HESSIAN_RESULT_DECISION);
+            if (rc == PEP_IO_OK && xacml_result_setdecision(result,decision) != PEP_XACML_OK) {
+                pep_log_error("xacml_result_read: can't set decision: %d to XACML result.",(int)decision);
+                rc= PEP_IO_ERROR;
             }
-            id= hessian_string_getstring(h_string);
-            if (xacml_attributeassignment_setid(attribute,id) != PEP_XACML_OK) {
-                pep_log_error("xacml_attributeassignment_unmarshal: can't set id: %s to XACML attribute assignment at: %d",id,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+            break;
+        /* resourceid (optional) */
+        case XACML_KEY_RESOURCEID:
+            rc= xacml_reader_string(reader,&resourceid,TRUE,"xacml_result_read",XACML_HESSIAN_RESULT_RESOURCEID);
+            if (rc == PEP_IO_OK && xacml_result_setresourceid(result,resourceid) != PEP_XACML_OK) {
+                pep_log_error("xacml_result_read: can't set resourceid: %s to XACML result.",resourceid);
+                rc= PEP_IO_ERROR;
             }
-        }
-        /* datatype (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            const char * datatype= NULL;
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+            break;
+        /* status (null?) */
+        case XACML_KEY_STATUS:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
+                xacml_status_t * status= NULL;
+                rc= xacml_status_read(reader,token,&status,arena);
+                if (rc == PEP_IO_OK && xacml_result_setstatus(result,status) != PEP_XACML_OK) {
+                    pep_log_error("xacml_result_read: can't set XACML status to XACML result.");
+                    xacml_status_delete(status);
+                    rc= PEP_IO_ERROR;
+                }
             }
-            if (h_string_type == HESSIAN_STRING) {
-                datatype= hessian_string_getstring(h_string);
+            else {
+                pep_log_warn("xacml_result_read: XACML status is NULL.");
             }
-            if (xacml_attributeassignment_setdatatype(attribute,datatype) != PEP_XACML_OK) {
-                pep_log_error("xacml_attributeassignment_unmarshal: can't set datatype: %s to XACML attribute assignment at: %d",datatype,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+            break;
+        /* obligations list */
+        case XACML_KEY_OBLIGATIONS:
+            rc= xacml_reader_list(reader,"xacml_result_read",XACML_HESSIAN_RESULT_OBLIGATIONS);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_obligation_t * obligation= NULL;
+                rc= xacml_obligation_read(reader,token,&obligation,arena);
+                if (rc == PEP_IO_OK && xacml_result_addobligation(result,obligation) != PEP_XACML_OK) {
+                    pep_log_error("xacml_result_read: can't add XACML obligation to XACML result.");
+                    xacml_obligation_delete(obligation);
+                    rc= PEP_IO_ERROR;
+                }
             }
+            break;
+        default:
+            pep_log_warn("xacml_result_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_result_read");
         }
-        /* value (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,key) == 0) {
-            hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
-            hessian_t h_string_type= hessian_gettype(h_string);
-            const char * value;
-            if ( h_string_type != HESSIAN_STRING && h_string_type != HESSIAN_NULL) {
-                pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string or null at: %d.",key,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_result_delete(result);
+        return rc;
+    }
+    *res= result;
+    return PEP_IO_OK;
+}
+
+static int xacml_response_read(hessian_reader_t * reader, hessian_token_t token, xacml_response_t ** resp, xacml_arena_t * arena) {
+    xacml_response_t * response;
+    const char * key;
+    size_t key_l;
+    int rc;
+    if ((rc= xacml_reader_map(reader,token,XACML_HESSIAN_RESPONSE_CLASSNAME,"xacml_response_read")) != PEP_IO_OK) {
+        return rc;
+    }
+    response= xacml_response_create_in(arena);
+    if (response == NULL) {
+        pep_log_error("xacml_response_read: can't create XACML response.");
+        return PEP_IO_ERROR;
+    }
+    while ((rc= xacml_reader_key(reader,&key,&key_l,"xacml_response_read")) == PEP_IO_OK && key != NULL) {
+        switch (xacml_key_getid(key,key_l)) {
+        /* request (can be null???) */
+        case XACML_KEY_REQUEST:
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_TOKEN_NULL) {
+                xacml_request_t * request= NULL;
+                rc= xacml_request_read(reader,token,&request,arena);
+                if (rc == PEP_IO_OK && xacml_response_setrequest(response,request) != PEP_XACML_OK) {
+                    pep_log_error("xacml_response_read: can't set XACML request in XACML response.");
+                    xacml_request_delete(request);
+                    rc= PEP_IO_ERROR;
+                }
             }
-            value= NULL;
-            if (h_string_type == HESSIAN_STRING) {
-                value= hessian_string_getstring(h_string);
+            else {
+                pep_log_warn("xacml_response_read: XACML request is NULL.");
             }
-            if (xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
-                pep_log_error("xacml_attributeassignment_unmarshal: can't set value: %s to XACML attribute assignment at: %d",value,i);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+            break;
+        /* results list */
+        case XACML_KEY_RESULTS:
+            rc= xacml_reader_list(reader,"xacml_response_read",XACML_HESSIAN_RESPONSE_RESULTS);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_TOKEN_LIST_END) {
+                xacml_result_t * result= NULL;
+                rc= xacml_result_read(reader,token,&result,arena);
+                if (rc == PEP_IO_OK && xacml_response_addresult(response,result) != PEP_XACML_OK) {
+                    pep_log_error("xacml_response_read: can't add XACML result to XACML response.");
+                    xacml_result_delete(result);
+                    rc= PEP_IO_ERROR;
+                }
             }
+            break;
+        default:
+            pep_log_warn("xacml_response_read: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            rc= xacml_reader_skipvalue(reader,"xacml_response_read");
         }
-        /* multiple values (back compatibility with PEPd <= 1.0) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES,key) == 0) {
-            hessian_object_t * h_values= hessian_map_getvalue(h_attribute,i);
-            size_t h_values_l;
-            if (hessian_gettype(h_values) != HESSIAN_LIST) {
-                pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',...> is not a Hessian list.",key);
-                xacml_attributeassignment_delete(attribute);
-                return PEP_IO_ERROR;
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_response_delete(response);
+        return rc;
+    }
+    *resp= response;
+    return PEP_IO_OK;
+}
+
+/*
+ * The incremental XACML response parser states: the response is read result
+ * by result while the input arrives.
+ */
+typedef enum {
+    PARSER_RESPONSE= 0, /* response map start expected */
+    PARSER_KEY, /* response map<key> or map end expected */
+    PARSER_VALUE, /* response map<key,value> expected */
+    PARSER_RESULTS, /* results list start expected */
+    PARSER_RESULT, /* result or list end expected */
+    PARSER_DONE, /* response read */
+    PARSER_TREE, /* Hessian ref read, the object tree is required */
+    PARSER_ERROR
+} xacml_parser_state_t;
+
+struct xacml_response_parser {
+    hessian_reader_t * reader;
+    xacml_arena_t * arena; /* NULL: the response has its own arena */
+    int owned;
+    xacml_parser_state_t state;
+    xacml_key_t key; /* key of the PARSER_VALUE */
+    xacml_response_t * response; /* read so far */
+    int scanning; /* a value is scanned until its end */
+    size_t value_offset; /* offset and depth of the scanned value */
+    size_t value_depth;
+};
+
+xacml_response_parser_t * xacml_response_parser_create(void) {
+    xacml_response_parser_t * parser= calloc(1,sizeof(struct xacml_response_parser));
+    if (parser == NULL) {
+        pep_log_error("xacml_response_parser_create: can't allocate xacml_response_parser_t.");
+        return NULL;
+    }
+    parser->reader= hessian_reader_create();
+    if (parser->reader == NULL) {
+        pep_log_error("xacml_response_parser_create: can't create Hessian reader.");
+        free(parser);
+        return NULL;
+    }
+    parser->state= PARSER_ERROR;
+    return parser;
+}
+
+void xacml_response_parser_delete(xacml_response_parser_t * parser) {
+    if (parser == NULL) return;
+    xacml_response_delete(parser->response);
+    hessian_reader_delete(parser->reader);
+    free(parser);
+}
+
+pep_error_t xacml_response_parser_reset(xacml_response_parser_t * parser, pep_buffer_t * input, xacml_arena_t * arena) {
+    if (parser == NULL || input == NULL) {
+        pep_log_error("xacml_response_parser_reset: NULL parser or input buffer pointer.");
+        return PEP_ERR_NULL_POINTER;
+    }
+    xacml_response_delete(parser->response);
+    parser->response= NULL;
+    parser->arena= arena;
+    parser->owned= (arena == NULL);
+    parser->scanning= FALSE;
+    if (hessian_reader_reset(parser->reader,input) != HESSIAN_OK) {
+        pep_log_error("xacml_response_parser_reset: can't reset Hessian reader.");
+        parser->state= PARSER_ERROR;
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+    parser->state= PARSER_RESPONSE;
+    return PEP_OK;
+}
+
+/**
+ * Reads the tokens of the next value until its end, then rewinds the reader
+ * to the value start: the value is read again by the unmarshaller without
+ * HESSIAN_TOKEN_MORE tokens. The scan continues where it stopped with the next bytes.
+ */
+static int xacml_parser_scan(xacml_response_parser_t * parser) {
+    hessian_reader_t * reader= parser->reader;
+    hessian_token_t token;
+    if (!parser->scanning) {
+        parser->value_offset= hessian_reader_offset(reader);
+        parser->value_depth= hessian_reader_depth(reader);
+        parser->scanning= TRUE;
+    }
+    do {
+        token= hessian_reader_next(reader);
+        if (token == HESSIAN_TOKEN_MORE) {
+            return PEP_IO_MORE;
+        }
+        if (token == HESSIAN_TOKEN_ERROR || token == HESSIAN_TOKEN_EOF) {
+            pep_log_error("xacml_response_parser: truncated or invalid Hessian value at: %d.",(int)parser->value_offset);
+            return PEP_IO_ERROR;
+        }
+    } while (hessian_reader_depth(reader) > parser->value_depth);
+    parser->scanning= FALSE;
+    if (hessian_reader_rewind(reader,parser->value_offset,parser->value_depth) != HESSIAN_OK) {
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Reads the input as far as possible: returns PEP_IO_MORE if the input ends
+ * before the response, PEP_IO_OK once the response is read.
+ */
+static int xacml_parser_run(xacml_response_parser_t * parser) {
+    hessian_reader_t * reader= parser->reader;
+    hessian_token_t token;
+    const char * key;
+    size_t key_l;
+    int rc= PEP_IO_OK;
+    while (rc == PEP_IO_OK && parser->state < PARSER_DONE) {
+        switch (parser->state) {
+        case PARSER_RESPONSE:
+            token= hessian_reader_next(reader);
+            if (token == HESSIAN_TOKEN_MORE) return PEP_IO_MORE;
+            rc= xacml_reader_map(reader,token,XACML_HESSIAN_RESPONSE_CLASSNAME,"xacml_response_parser");
+            if (rc != PEP_IO_OK) break;
+            if (parser->owned) {
+                /* all the response objects and strings in one arena */
+                parser->response= xacml_response_create_owned(XACML_RESPONSE_ARENA_SIZE);
+                parser->arena= xacml_response_getarena(parser->response);
             }
-            pep_log_warn("xacml_attributeassignment_unmarshal: DEPRECATED Hessian map<'%s',...> received at: %d",key,i);
-            h_values_l= hessian_list_length(h_values);
-            for(j= 0; j<h_values_l; j++) {
-                hessian_object_t * h_value= hessian_list_get(h_values,j);
-                const char * value;
-                if (hessian_gettype(h_value) != HESSIAN_STRING) {
-                    pep_log_error("xacml_attributeassignment_unmarshal: Hessian map<'%s',value> is not a Hessian string at: %d.",key,j);
-                    xacml_attributeassignment_delete(attribute);
-                    return PEP_IO_ERROR;
+            else {
+                parser->response= xacml_response_create_in(parser->arena);
+            }
+            if (parser->response == NULL) {
+                pep_log_error("xacml_response_parser: can't create XACML response.");
+                rc= PEP_IO_ERROR;
+                break;
+            }
+            parser->state= PARSER_KEY;
+            break;
+        case PARSER_KEY:
+            token= hessian_reader_next(reader);
+            if (token == HESSIAN_TOKEN_MORE) return PEP_IO_MORE;
+            if (token == HESSIAN_TOKEN_MAP_END) {
+                parser->state= PARSER_DONE;
+                break;
+            }
+            if (token != HESSIAN_TOKEN_STRING) {
+                pep_log_error("xacml_response_parser: Hessian map<key> is not an Hessian string (token: %d).",(int)token);
+                rc= PEP_IO_ERROR;
+                break;
+            }
+            key= hessian_reader_getview(reader,&key_l);
+            parser->key= xacml_key_getid((key != NULL) ? key : "",key_l);
+            if (parser->key == XACML_KEY_UNKNOWN) {
+                pep_log_warn("xacml_response_parser: unknown Hessian map<key>: %.*s.",(int)key_l,key);
+            }
+            parser->state= (parser->key == XACML_KEY_RESULTS) ? PARSER_RESULTS : PARSER_VALUE;
+            break;
+        case PARSER_VALUE:
+            if ((rc= xacml_parser_scan(parser)) != PEP_IO_OK) break;
+            token= hessian_reader_next(reader);
+            if (parser->key != XACML_KEY_REQUEST) {
+                rc= (hessian_reader_skip(reader) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+            }
+            else if (token != HESSIAN_TOKEN_NULL) {
+                xacml_request_t * request= NULL;
+                rc= xacml_request_read(reader,token,&request,parser->arena);
+                if (rc == PEP_IO_OK && xacml_response_setrequest(parser->response,request) != PEP_XACML_OK) {
+                    pep_log_error("xacml_response_parser: can't set XACML request in XACML response.");
+                    xacml_request_delete(request);
+                    rc= PEP_IO_ERROR;
                 }
-                value= hessian_string_getstring(h_value);
-                if (xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
-                    pep_log_error("xacml_attributeassignment_unmarshal: can't set value: %s to XACML attribute assignment at: %d",value,j);
-                    xacml_attributeassignment_delete(attribute);
-                    return PEP_IO_ERROR;
+            }
+            else {
+                pep_log_warn("xacml_response_parser: XACML request is NULL.");
+            }
+            parser->state= PARSER_KEY;
+            break;
+        case PARSER_RESULTS:
+            token= hessian_reader_next(reader);
+            if (token == HESSIAN_TOKEN_MORE) return PEP_IO_MORE;
+            rc= xacml_reader_check(token,HESSIAN_TOKEN_LIST_START,FALSE,"xacml_response_parser",XACML_HESSIAN_RESPONSE_RESULTS);
+            parser->state= PARSER_RESULT;
+            break;
+        case PARSER_RESULT:
+            /* one result at once, or the list end */
+            if ((rc= xacml_parser_scan(parser)) != PEP_IO_OK) break;
+            token= hessian_reader_next(reader);
+            if (token == HESSIAN_TOKEN_LIST_END) {
+                parser->state= PARSER_KEY;
+            }
+            else {
+                xacml_result_t * result= NULL;
+                rc= xacml_result_read(reader,token,&result,parser->arena);
+                if (rc == PEP_IO_OK && xacml_response_addresult(parser->response,result) != PEP_XACML_OK) {
+                    pep_log_error("xacml_response_parser: can't add XACML result to XACML response.");
+                    xacml_result_delete(result);
+                    rc= PEP_IO_ERROR;
                 }
             }
-        }
-        else {
-            pep_log_warn("xacml_attributeassignment_unmarshal: unknown Hessian map<key>: %s at: %d.",key,i);
+            break;
+        default:
+            break;
         }
     }
-    *attr= attribute;
-    return PEP_IO_OK;
+    if (rc == PEP_IO_MORE) {
+        return rc;
+    }
+    if (rc != PEP_IO_OK) {
+        parser->state= (rc == PEP_IO_REF) ? PARSER_TREE : PARSER_ERROR;
+        xacml_response_delete(parser->response);
+        parser->response= NULL;
+    }
+    return rc;
+}
+
+pep_error_t xacml_response_parser_feed(xacml_response_parser_t * parser, pep_buffer_t * input) {
+    if (parser == NULL || input == NULL) {
+        pep_log_error("xacml_response_parser_feed: NULL parser or input buffer pointer.");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (parser->state >= PARSER_DONE) {
+        /* trailing bytes, or already failed */
+        return (parser->state == PARSER_ERROR) ? PEP_ERR_UNMARSHALLING_HESSIAN : PEP_OK;
+    }
+    if (hessian_reader_refill(parser->reader,input,TRUE) != HESSIAN_OK) {
+        parser->state= PARSER_ERROR;
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+    if (xacml_parser_run(parser) == PEP_IO_ERROR) {
+        return PEP_ERR_UNMARSHALLING_HESSIAN;
+    }
+    return PEP_OK;
+}
+
+pep_error_t xacml_response_parser_finish(xacml_response_parser_t * parser, pep_buffer_t * input, xacml_response_t ** response) {
+    if (parser == NULL || input == NULL || response == NULL) {
+        pep_log_error("xacml_response_parser_finish: NULL parser, input buffer or response pointer.");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (parser->state < PARSER_DONE) {
+        if (hessian_reader_refill(parser->reader,input,FALSE) != HESSIAN_OK) {
+            parser->state= PARSER_ERROR;
+            return PEP_ERR_UNMARSHALLING_IO;
+        }
+        xacml_parser_run(parser);
+    }
+    switch (parser->state) {
+    case PARSER_DONE:
+        /* consume the bytes read */
+        pep_buffer_skip(input,hessian_reader_offset(parser->reader));
+        *response= parser->response;
+        parser->response= NULL;
+        parser->state= PARSER_ERROR;
+        return PEP_OK;
+    case PARSER_TREE:
+        /* the Hessian refs are only resolved in the object tree */
+        pep_log_debug("xacml_response_parser_finish: Hessian ref read, unmarshalling the object tree.");
+        parser->state= PARSER_ERROR;
+        return xacml_response_unmarshalling_tree(response,input);
+    default:
+        pep_log_error("xacml_response_parser_finish: can't read XACML response from Hessian input.");
+        parser->state= PARSER_ERROR;
+        return PEP_ERR_UNMARSHALLING_HESSIAN;
+    }
+}
 
+size_t xacml_response_parser_offset(const xacml_response_parser_t * parser) {
+    if (parser == NULL) return 0;
+    return hessian_reader_offset(parser->reader);
 }
@@ -25,10 +25,13 @@ extern "C" {
 #include "error.h"
 #include "xacml.h"
 #include "buffer.h" /* ../util/buffer.h */
+#include "hessian.h" /* ../hessian/hessian.h */
 
 /**
  * Marshalls the PEP XACML request object and writes the serialized Hessian bytes
- * into the output buffer.
+ * directly into the output buffer, without building the intermediate Hessian
+ * objects. The output buffer is grown once, to the xacml_request_serialized_size()
+ * of the request. On error the output buffer may contain a partial request.
  *
  * @param const xacml_request_t * request the PEP XACML request to marshal.
  * @param pep_buffer_t * output buffer.
@@ -37,9 +40,33 @@ extern "C" {
  */
 pep_error_t xacml_request_marshalling(const xacml_request_t * request, pep_buffer_t * output);
 
+/**
+ * Returns the exact number of bytes written by xacml_request_marshalling(request,output),
+ * computed without writing.
+ *
+ * @param const xacml_request_t * request the PEP XACML request to size.
+ *
+ * @return size_t the serialized size, or 0 if the request can't be marshalled.
+ */
+size_t xacml_request_serialized_size(const xacml_request_t * request);
+
+/**
+ * Marshalls the PEP XACML request object into a Hessian object tree, then
+ * serializes it into the output buffer. The serialized bytes are identical
+ * to the ones of xacml_request_marshalling(request,output).
+ *
+ * @param const xacml_request_t * request the PEP XACML request to marshal.
+ * @param pep_buffer_t * output buffer.
+ *
+ * @return pep_error_t PEP_OK or an error code.
+ */
+pep_error_t xacml_request_marshalling_tree(const xacml_request_t * request, pep_buffer_t * output);
+
 /**
  * Reads the serialized Hessian bytes from the input buffer and unmarshalls the PEP
- * XACML response object.
+ * XACML response object. The response is built while the Hessian tokens are
+ * read, see xacml_response_parser_t, in its own arena: the strings are copied
+ * once and the objects allocated without a malloc each.
  *
  * On error, return code != PEP_OK, the PEP response object state is indeterminate.
  * (should be NULL)
@@ -61,6 +88,108 @@ pep_error_t xacml_request_marshalling(const xacml_request_t * request, pep_buffe
  */
 pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, pep_buffer_t * input);
 
+/**
+ * Reads the serialized Hessian bytes from the input buffer with the Hessian pull
+ * reader and unmarshalls the PEP XACML response object in one pass, without
+ * building the Hessian object tree. A response containing Hessian refs is
+ * unmarshalled with xacml_response_unmarshalling_tree(response,input).
+ *
+ * @param xacml_response_t ** response the unmarshalled PEP XACML response (output).
+ * @param hessian_reader_t * reader the Hessian reader to use, reset by the function.
+ * @param pep_buffer_t * input the buffer to read from.
+ *
+ * @return pep_error_t PEP_OK or an error code.
+ */
+pep_error_t xacml_response_unmarshalling_reader(xacml_response_t ** response, hessian_reader_t * reader, pep_buffer_t * input);
+
+/**
+ * Same as xacml_response_unmarshalling_reader(response,reader,input), but the
+ * PEP XACML response objects and strings are allocated from the arena. A
+ * response containing Hessian refs is still unmarshalled from the heap, in both
+ * cases the response is released with xacml_response_delete(response).
+ *
+ * @param xacml_arena_t * arena the arena to allocate from, or @a NULL for the heap.
+ */
+pep_error_t xacml_response_unmarshalling_reader_in(xacml_response_t ** response, hessian_reader_t * reader, pep_buffer_t * input, xacml_arena_t * arena);
+
+/**
+ * The incremental XACML response parser type: unmarshalls the PEP XACML
+ * response while its serialized Hessian bytes are appended to the input
+ * buffer, for example by the libcurl write callback. Each complete result is
+ * unmarshalled as soon as its last byte is fed.
+ *
+ * Example:
+ *   xacml_response_parser_reset(parser,input,NULL);
+ *   for each received chunk:
+ *       pep_buffer_write(chunk,1,chunk_l,input);
+ *       xacml_response_parser_feed(parser,input);
+ *   rc= xacml_response_parser_finish(parser,input,&response);
+ */
+typedef struct xacml_response_parser xacml_response_parser_t;
+
+/**
+ * Creates an incremental XACML response parser, reset it before use.
+ *
+ * @return xacml_response_parser_t * the new parser or @a NULL on error.
+ */
+xacml_response_parser_t * xacml_response_parser_create(void);
+
+/**
+ * Deletes the parser and the response read so far.
+ */
+void xacml_response_parser_delete(xacml_response_parser_t * parser);
+
+/**
+ * Resets the parser to read a new response from the input buffer, not
+ * consumed until xacml_response_parser_finish(parser,input,response).
+ *
+ * @param xacml_response_parser_t * parser the parser to reset.
+ * @param pep_buffer_t * input the buffer to read from.
+ * @param xacml_arena_t * arena the arena to allocate the response from, or
+ *        @a NULL for an own arena of the response, deleted with the response
+ *        by xacml_response_delete(response).
+ *
+ * @return pep_error_t PEP_OK or an error code.
+ */
+pep_error_t xacml_response_parser_reset(xacml_response_parser_t * parser, pep_buffer_t * input, xacml_arena_t * arena);
+
+/**
+ * Unmarshalls the complete results appended to the input buffer since the
+ * last call. An error is kept and returned again by the finish function.
+ *
+ * @return pep_error_t PEP_OK or an error code if the response is invalid.
+ */
+pep_error_t xacml_response_parser_feed(xacml_response_parser_t * parser, pep_buffer_t * input);
+
+/**
+ * Unmarshalls the rest of the complete input buffer and returns the PEP XACML
+ * response, then consumes the bytes read. A response containing Hessian refs
+ * is unmarshalled with xacml_response_unmarshalling_tree(response,input).
+ *
+ * @param xacml_response_parser_t * parser the parser.
+ * @param pep_buffer_t * input the buffer to read from, complete.
+ * @param xacml_response_t ** response the unmarshalled PEP XACML response (output).
+ *
+ * @return pep_error_t PEP_OK or an error code.
+ */
+pep_error_t xacml_response_parser_finish(xacml_response_parser_t * parser, pep_buffer_t * input, xacml_response_t ** response);
+
+/**
+ * Returns the number of input bytes unmarshalled so far.
+ */
+size_t xacml_response_parser_offset(const xacml_response_parser_t * parser);
+
+/**
+ * Deserializes the Hessian object tree from the input buffer, then unmarshalls
+ * the PEP XACML response object from it.
+ *
+ * @param xacml_response_t ** response the unmarshalled PEP XACML response (output).
+ * @param pep_buffer_t * input the buffer to read from.
+ *
+ * @return pep_error_t PEP_OK or an error code.
+ */
+pep_error_t xacml_response_unmarshalling_tree(xacml_response_t ** response, pep_buffer_t * input);
+
 /**
  * The Java class namespaces and variable name constants for the PEP model
  * Hessian serialization and deserialization mapping.
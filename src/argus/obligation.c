@@ -18,39 +18,45 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "linkedlist.h" /* ../util/linkedlist.h */
+#include "vector.h" /* ../util/vector.h */
 #include "log.h" /* ../util/log.h */
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_obligation {
-    char * id; /* mandatory */
+    const char * id; /* mandatory, shared with the atom table if interned */
+    xacml_atom_t atom;
     xacml_fulfillon_t fulfillon; /* optional */
-    pep_linkedlist_t * assignments; /* AttributeAssignments list */
+    pep_vector_t * assignments; /* AttributeAssignments list */
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 /* id can be NULL */
 xacml_obligation_t * xacml_obligation_create(const char * id) {
-    xacml_obligation_t * obligation= calloc(1,sizeof(xacml_obligation_t));
+    return xacml_obligation_create_in(id,NULL);
+}
+
+xacml_obligation_t * xacml_obligation_create_in(const char * id, xacml_arena_t * arena) {
+    xacml_obligation_t * obligation= xacml_calloc(XACML_ARENA(arena),sizeof(xacml_obligation_t));
     if (obligation == NULL) {
         pep_log_error("xacml_obligation_create: can't allocate xacml_obligation_t.");
         return NULL;
     }
+    obligation->arena= XACML_ARENA(arena);
     obligation->id= NULL;
+    obligation->atom= XACML_ATOM_NONE;
     if (id != NULL) {
-        size_t size= strlen(id);
-        obligation->id= calloc(size + 1,sizeof(char));
+        obligation->id= xacml_id_copy(obligation->arena,id,strlen(id),&obligation->atom);
         if (obligation->id == NULL) {
-            pep_log_error("xacml_obligation_create: can't allocate id (%d bytes).",(int)size);
-            free(obligation);
+            pep_log_error("xacml_obligation_create: can't allocate id (%d bytes).",(int)strlen(id));
+            xacml_free(obligation->arena,obligation);
             return NULL;
         }
-        strncpy(obligation->id,id,size);
     }
-    obligation->assignments= pep_llist_create();
+    obligation->assignments= xacml_vector_create(obligation->arena);
     if (obligation->assignments == NULL) {
         pep_log_error("xacml_obligation_create: can't create assignments list.");
-        free(obligation->id);
-        free(obligation);
+        xacml_id_free(obligation->arena,obligation->id,obligation->atom);
+        xacml_free(obligation->arena,obligation);
         return NULL;
     }
     obligation->fulfillon= XACML_FULFILLON_DENY;
@@ -59,7 +65,6 @@ xacml_obligation_t * xacml_obligation_create(const char * id) {
 
 /* id can't be NULL */
 int xacml_obligation_setid(xacml_obligation_t * obligation, const char * id) {
-    size_t size;
     if (obligation == NULL) {
         pep_log_error("xacml_obligation_setid: NULL obligation.");
         return PEP_XACML_ERROR;
@@ -69,15 +74,13 @@ int xacml_obligation_setid(xacml_obligation_t * obligation, const char * id) {
         return PEP_XACML_ERROR;
     }
     if (obligation->id != NULL) {
-        free(obligation->id);
+        xacml_id_free(obligation->arena,obligation->id,obligation->atom);
     }
-    size= strlen(id);
-    obligation->id= calloc(size + 1,sizeof(char));
+    obligation->id= xacml_id_copy(obligation->arena,id,strlen(id),&obligation->atom);
     if (obligation->id == NULL) {
-        pep_log_error("xacml_obligation_setid: can't allocate id (%d bytes).", (int)size);
+        pep_log_error("xacml_obligation_setid: can't allocate id (%d bytes).", (int)strlen(id));
         return PEP_XACML_ERROR;
     }
-    strncpy(obligation->id,id,size);
     return PEP_XACML_OK;
 
 }
@@ -89,6 +92,14 @@ const char * xacml_obligation_getid(const xacml_obligation_t * obligation) {
     return obligation->id;
 }
 
+xacml_atom_t xacml_obligation_getatom(const xacml_obligation_t * obligation) {
+    if (obligation == NULL) {
+        pep_log_error("xacml_obligation_getatom: NULL obligation.");
+        return XACML_ATOM_NONE;
+    }
+    return obligation->atom;
+}
+
 
 xacml_fulfillon_t xacml_obligation_getfulfillon(const xacml_obligation_t * obligation) {
     if (obligation == NULL) {
@@ -125,7 +136,7 @@ int xacml_obligation_addattributeassignment(xacml_obligation_t * obligation, xac
         pep_log_error("xacml_obligation_addattributeassignment: NULL attribute assignment.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(obligation->assignments,attr) != LLIST_OK) {
+    if (pep_vector_add(obligation->assignments,attr) != VECTOR_OK) {
         pep_log_error("xacml_obligation_addattributeassignment: can't add attribute assignment to list.");
         return PEP_XACML_ERROR;
 
@@ -138,7 +149,7 @@ size_t xacml_obligation_attributeassignments_length(const xacml_obligation_t * o
         pep_log_warn("xacml_obligation_attributeassignments_length: NULL obligation.");
         return 0;
     }
-    return pep_llist_length(obligation->assignments);
+    return pep_vector_length(obligation->assignments);
 }
 
 xacml_attributeassignment_t * xacml_obligation_getattributeassignment(const xacml_obligation_t * obligation,int i) {
@@ -146,14 +157,16 @@ xacml_attributeassignment_t * xacml_obligation_getattributeassignment(const xacm
         pep_log_error("xacml_obligation_getattributeassignment: NULL obligation.");
         return NULL;
     }
-    return pep_llist_get(obligation->assignments,i);
+    return pep_vector_get(obligation->assignments,i);
 }
 
 void xacml_obligation_delete(xacml_obligation_t * obligation) {
     if (obligation == NULL) return;
-    if (obligation->id != NULL) free(obligation->id);
-    pep_llist_delete_elements(obligation->assignments,(pep_llist_delete_elt_f)xacml_attributeassignment_delete);
-    pep_llist_delete(obligation->assignments);
+    pep_vector_delete_elements(obligation->assignments,(pep_vector_delete_elt_f)xacml_attributeassignment_delete);
+    /* released with the arena */
+    if (obligation->arena != NULL) return;
+    if (obligation->id != NULL) xacml_id_free(NULL,obligation->id,obligation->atom);
+    pep_vector_delete(obligation->assignments);
     free(obligation);
     obligation= NULL;
 }
@@ -19,15 +19,20 @@
 
 #include <stdarg.h>  /* va_list, va_arg, ... */
 #include <string.h>
+#include <ctype.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "buffer.h"
 #include "base64.h"
 #include "log.h"
 
+/* from ../hessian */
+#include "hessian.h"
+
 #include "pep.h"
 #include "io.h"
 #include "error.h"
@@ -50,29 +55,175 @@ static const int    DEFAULT_LOG_LEVEL= PEP_LOGLEVEL_NONE;
 static const FILE * DEFAULT_LOG_FILE= NULL;
 static const int    DEFAULT_PIPS_ENABLED= TRUE;
 static const int    DEFAULT_OHS_ENABLED= TRUE;
+static const size_t DEFAULT_BUFFER_SHRINK_SIZE= 0; /* keep high-water mark */
+static const int    DEFAULT_BINARY_BODY= FALSE;
+static const long   DEFAULT_MAX_CONNECTIONS= 16L;
+/* the input buffer is sized from the response Content-Length up to this size */
+static const size_t MAX_RESPONSE_RESERVE_SIZE= 16 * 1024 * 1024;
+
+/* the socket action constants of pep.h are the libcurl ones */
+#if PEP_POLL_IN != CURL_POLL_IN || PEP_POLL_OUT != CURL_POLL_OUT || PEP_POLL_INOUT != CURL_POLL_INOUT || PEP_POLL_REMOVE != CURL_POLL_REMOVE
+#error "PEP_POLL_* constants differ from CURL_POLL_*"
+#endif
+#if PEP_EVENT_IN != CURL_CSELECT_IN || PEP_EVENT_OUT != CURL_CSELECT_OUT || PEP_EVENT_ERR != CURL_CSELECT_ERR || PEP_SOCKET_TIMEOUT != CURL_SOCKET_TIMEOUT
+#error "PEP_EVENT_* constants differ from CURL_CSELECT_*"
+#endif
+
+/* media type of the raw (not base64 encoded) Hessian body */
+#define BINARY_BODY_CONTENT_TYPE "application/x-hessian"
 /* default SSL cipher without ECDH: OpenSSL 1.0 bug */
 /*
 static const char * DEFAULT_SSL_CIPHER_LIST= "DEFAULT:-ECDH";
 */
 
+typedef struct pep_transport pep_transport_t;
+typedef struct pep_async pep_async_t;
+typedef struct pep_batch pep_batch_t;
+typedef struct pep_batch_slot pep_batch_slot_t;
+
 /** internal functions prototypes */
 static void init_pep_defaults(PEP * pep);
-static void init_curl_defaults(PEP * pep);
+static void configure_curl(const PEP * pep, CURL * curl);
+static int init_http_headers(PEP * pep);
+static pep_transport_t * transport_create(PEP * pep, int slot);
+static void transport_delete(pep_transport_t * transport);
+static pep_transport_t * transport_checkout(PEP * pep);
+static void transport_checkin(PEP * pep, pep_transport_t * transport);
+static pep_error_t pep_authorize_request(PEP * pep, xacml_request_t ** request, xacml_response_t ** response);
+static pep_error_t pep_process_pips(PEP * pep, xacml_request_t ** request);
+static pep_error_t pep_process_response(PEP * pep, xacml_request_t ** request, xacml_response_t ** response);
 /* static void init_log_defaults(const PEP * pep); */
-static int set_curl_endpoint_url(const PEP * pep);
-static int set_curl_connection_timeout(const PEP * pep);
-static int set_curl_ssl_validation(const PEP * pep);
-static int set_curl_ssl_cipher_list(const PEP * pep);
-static int set_curl_server_cert(const PEP * pep);
-static int set_curl_server_capath(const PEP * pep);
-static int set_curl_client_cert(const PEP * pep);
-static int set_curl_client_key(const PEP * pep);
-static int set_curl_client_keypassword(const PEP * pep);
-static int set_curl_verbose(const PEP * pep);
-static int set_curl_stderr(const PEP * pep);
-static int set_curl_nosignal(const PEP * pep);
-static int set_curl_http_headers(PEP * pep);
-static int set_curl_ssl_option_allow_beast(PEP * pep);
+static int set_curl_endpoint_url(const PEP * pep, CURL * curl);
+static int set_curl_connection_timeout(const PEP * pep, CURL * curl);
+static int set_curl_ssl_validation(const PEP * pep, CURL * curl);
+static int set_curl_ssl_cipher_list(const PEP * pep, CURL * curl);
+static int set_curl_server_cert(const PEP * pep, CURL * curl);
+static int set_curl_server_capath(const PEP * pep, CURL * curl);
+static int set_curl_client_cert(const PEP * pep, CURL * curl);
+static int set_curl_client_key(const PEP * pep, CURL * curl);
+static int set_curl_client_keypassword(const PEP * pep, CURL * curl);
+static int set_curl_verbose(const PEP * pep, CURL * curl);
+static int set_curl_stderr(const PEP * pep, CURL * curl);
+static int set_curl_nosignal(const PEP * pep, CURL * curl);
+static int set_curl_ssl_option_allow_beast(const PEP * pep, CURL * curl);
+static int set_curl_share(const PEP * pep, CURL * curl);
+static int set_curl_pipewait(const PEP * pep, CURL * curl);
+static void share_lock(CURL * curl, curl_lock_data data, curl_lock_access access, void * share);
+static void share_unlock(CURL * curl, curl_lock_data data, void * share);
+static pep_error_t pep_authorize_transport(PEP * pep, pep_transport_t * transport, const xacml_request_t * request, xacml_response_t ** response);
+static pep_error_t pep_authorize_marshal(PEP * pep, pep_transport_t * transport, const xacml_request_t * request);
+static pep_error_t pep_authorize_response(PEP * pep, pep_transport_t * transport, long http_code, xacml_response_t ** response);
+static pep_error_t pep_authorize_perform(PEP * pep, pep_transport_t * transport, int binary, long * http_code);
+static pep_error_t pep_authorize_setup(PEP * pep, pep_transport_t * transport, int binary);
+static pep_error_t async_init(PEP * pep);
+static pep_error_t async_submit(PEP * pep, pep_async_t * async);
+static pep_error_t transfer_start(PEP * pep, CURLM * multi, pep_transport_t * transport, int binary, void * private);
+static void async_check_completions(PEP * pep);
+static void async_complete(PEP * pep, pep_async_t * async, CURLcode result);
+static void async_finish(PEP * pep, pep_async_t * async);
+static void async_link(PEP * pep, pep_async_t * async);
+static void async_unlink(PEP * pep, pep_async_t * async);
+static void async_queue_done(PEP * pep, pep_async_t * async);
+static void async_abort(PEP * pep);
+static int async_socket_function(CURL * curl, curl_socket_t fd, int what, void * pep, void * socketdata);
+static pep_error_t batch_run(PEP * pep, xacml_request_t ** requests, int n, xacml_response_t ** responses, pep_error_t * errors);
+static int batch_start_next(pep_batch_t * batch, pep_batch_slot_t * slot);
+static int batch_complete(pep_batch_t * batch, pep_batch_slot_t * slot, CURLcode result);
+static pep_transport_t * batch_transport_checkout(pep_batch_t * batch);
+static void batch_transport_checkin(PEP * pep, pep_transport_t * transport);
+static void batch_transports_release(PEP * pep);
+static CURLM * batch_multi_checkout(PEP * pep);
+static void batch_multi_checkin(PEP * pep, CURLM * multi);
+static int async_timer_function(CURLM * multi, long timeout_ms, void * pep);
+static pep_transport_t * async_transport_checkout(PEP * pep);
+static void async_transport_checkin(PEP * pep, pep_transport_t * transport);
+static size_t read_request(void * dst, size_t size, size_t count, void * transport);
+static int is_binary_content_type(const char * content_type);
+static int is_binary_body_rejected(long http_code);
+static void shrink_buffers(const PEP * pep, pep_transport_t * transport);
+static void reserve_input(pep_transport_t * transport);
+static size_t write_response(void * src, size_t size, size_t count, void * transport);
+
+/**
+ * Shared libcurl cache: one lock per shared data type, the TLS sessions and
+ * the DNS cache are locked independently. The connection pool is not shared:
+ * libcurl doesn't support its use by concurrent threads, each PEP handle keeps
+ * its own connection alive.
+ */
+struct pep_share {
+    CURLSH * curlsh;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+};
+
+/* maximum number of pooled transports of a frozen PEP handle */
+#ifndef PEP_TRANSPORT_POOL_SIZE
+#define PEP_TRANSPORT_POOL_SIZE 64
+#endif
+
+/* transport pool slot states */
+#define TRANSPORT_SLOT_EMPTY 0
+#define TRANSPORT_SLOT_FREE 1
+#define TRANSPORT_SLOT_BUSY 2
+
+/**
+ * Transient state of an authorization: the curl handle and the transport
+ * buffers, reused between calls. A PEP handle uses its first transport until
+ * it is frozen, then each concurrent pep_authorize() checks one out of the
+ * pool of the handle.
+ */
+struct pep_transport {
+    PEP * pep; /* owner, for the curl callbacks */
+    int slot; /* pool slot, -1 for a transient transport */
+    CURL * curl;
+    int response_binary; /* response body is raw Hessian: TRUE, FALSE or -1 (unknown yet) */
+    pep_buffer_t * output;
+    pep_base64_encoder_t * b64encoder; /* streams the base64 encoded output */
+    pep_base64_decoder_t * b64decoder; /* decodes the response into the input buffer */
+    pep_buffer_t * input; /* response body, decoded while it arrives */
+    xacml_response_parser_t * parser; /* unmarshals the response while it arrives */
+};
+
+/**
+ * Asynchronous authorization: submitted by pep_authorize_async(), transferred
+ * by the multi handle of the PEP handle with its own transport, and completed
+ * by pep_async_perform(). The in-flight authorizations are doubly linked, the
+ * failed submissions are queued until their callback is called.
+ */
+struct pep_async {
+    pep_transport_t * transport;
+    int binary; /* body of the current transfer */
+    int fallback; /* binary body rejected, resent base64 encoded */
+    xacml_request_t * request;
+    xacml_response_t * response;
+    pep_error_t rc;
+    pep_authorize_callback * callback;
+    void * userdata;
+    pep_async_t * prev;
+    pep_async_t * next;
+};
+
+/**
+ * pep_authorize_batch(): the requests are sent in order by a window of
+ * slots, each slot sends its next request when the previous one completes.
+ * The transfers share the connections of the batch multi handle.
+ */
+struct pep_batch {
+    PEP * pep;
+    CURLM * multi;
+    xacml_request_t ** requests;
+    xacml_response_t ** responses;
+    pep_error_t * errors;
+    int n;
+    int next; /* next request to send */
+    int n_transports; /* transports checked out */
+};
+
+struct pep_batch_slot {
+    pep_transport_t * transport;
+    int item; /* index of the request in progress, -1 if none */
+    int binary; /* body of the current transfer */
+    int fallback; /* binary body rejected, resent base64 encoded */
+};
 
 /** 
 * ADT for PEP client handle.
@@ -82,14 +233,14 @@ static int set_curl_ssl_option_allow_beast(PEP * pep);
 */
 struct pep_handle {
     int id;
-    CURL * curl;
+    int frozen; /* options, PIPs and OHs immutable, pep_authorize() reentrant */
     struct curl_slist * curl_http_headers;
-    pep_linkedlist_t * pips;
-    pep_linkedlist_t * ohs;
+    struct curl_slist * curl_binary_http_headers; /* headers for the binary body */
+    pep_vector_t * pips;
+    pep_vector_t * ohs;
     char * option_endpoint_url; /* current url */
-    pep_linkedlist_t * option_endpoint_urls; /* urls list */
-    int option_loglevel;
-    FILE * option_logout;
+    pep_vector_t * option_endpoint_urls; /* urls list */
+    pep_log_context_t log_context; /* log level, output and handler of the handle */
     long option_timeout; 
     char * option_server_cert;
     char * option_server_capath;
@@ -100,11 +251,27 @@ struct pep_handle {
     char * option_ssl_cipher_list;
     int option_pips_enabled;
     int option_ohs_enabled;
-    // temporary buffers for pep_authorize
-    pep_buffer_t * output;
-    pep_buffer_t * b64output;
-    pep_buffer_t * input;
-    pep_buffer_t * b64input;
+    size_t option_buffer_shrink_size;
+    int option_binary_body;
+    int binary_body_rejected; /* endpoint rejected the binary body, use base64 (atomic) */
+    pep_share_t * option_share; /* shared libcurl cache, not owned */
+    long option_max_connections;
+    pep_socket_callback * option_socket_function; /* event loop integration */
+    pep_timer_callback * option_timer_function;
+    void * option_async_userdata;
+    // transports for pep_authorize, the first one is used until frozen
+    pep_transport_t * transports[PEP_TRANSPORT_POOL_SIZE];
+    int transport_states[PEP_TRANSPORT_POOL_SIZE]; /* TRANSPORT_SLOT_* (atomic) */
+    // asynchronous engine, created by the first pep_authorize_async()
+    CURLM * multi;
+    pep_async_t * async_first; /* in-flight authorizations */
+    int async_running; /* number of in-flight authorizations */
+    pep_async_t * async_done; /* failed submissions, callback not called yet */
+    pep_async_t * async_done_last;
+    pep_vector_t * async_transports; /* idle transports of the engine */
+    long async_timeout_ms; /* last timeout requested by the engine */
+    int async_wakeup; /* timer set to 0 for the failed submissions */
+    CURLM * batch_multi; /* idle multi handle of pep_authorize_batch(), keeps its connections (atomic) */
 };
 
 /* GLOBAL NOT THREAD SAFE FUNCTION */
@@ -124,6 +291,57 @@ void pep_global_cleanup(void) {
 }
 
 
+pep_share_t * pep_share_create(void) {
+    CURLSHcode share_rc;
+    int i;
+    pep_share_t * share= calloc(1,sizeof(struct pep_share));
+    if (share == NULL) {
+        pep_log_error("pep_share_create: can't allocate struct pep_share: %d", (int)sizeof(struct pep_share));
+        return NULL;
+    }
+    share->curlsh= curl_share_init();
+    if (share->curlsh == NULL) {
+        pep_log_error("pep_share_create: can't create CURLSH share handle.");
+        free(share);
+        return NULL;
+    }
+    for (i= 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&share->locks[i],NULL);
+    }
+    curl_share_setopt(share->curlsh,CURLSHOPT_LOCKFUNC,share_lock);
+    curl_share_setopt(share->curlsh,CURLSHOPT_UNLOCKFUNC,share_unlock);
+    curl_share_setopt(share->curlsh,CURLSHOPT_USERDATA,share);
+    share_rc= curl_share_setopt(share->curlsh,CURLSHOPT_SHARE,CURL_LOCK_DATA_DNS);
+    if (share_rc != CURLSHE_OK) {
+        pep_log_warn("pep_share_create: can't share the DNS cache: %s.",curl_share_strerror(share_rc));
+    }
+    share_rc= curl_share_setopt(share->curlsh,CURLSHOPT_SHARE,CURL_LOCK_DATA_SSL_SESSION);
+    if (share_rc != CURLSHE_OK) {
+        pep_log_warn("pep_share_create: can't share the TLS sessions: %s.",curl_share_strerror(share_rc));
+    }
+    return share;
+}
+
+pep_error_t pep_share_delete(pep_share_t * share) {
+    CURLSHcode share_rc;
+    int i;
+    if (share == NULL) {
+        pep_log_error("pep_share_delete: NULL share.");
+        return PEP_ERR_NULL_POINTER;
+    }
+    share_rc= curl_share_cleanup(share->curlsh);
+    if (share_rc != CURLSHE_OK) {
+        /* the share is left intact, the caller can retry */
+        pep_log_error("pep_share_delete: can't release the share, still used by a PEP handle: %s.",curl_share_strerror(share_rc));
+        return PEP_ERR_SHARE_IN_USE;
+    }
+    for (i= 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&share->locks[i]);
+    }
+    free(share);
+    return PEP_OK;
+}
+
 /* create and init */
 PEP * pep_initialize(void) {
 
@@ -135,39 +353,54 @@ PEP * pep_initialize(void) {
     }
     /* set default PEP values */
     init_pep_defaults(pep);
-    
-    /* create and init curl handle */
-    pep->curl= curl_easy_init();
-    if (pep->curl == NULL) {
-        pep_log_error("pep_initialize: can't create CURL session handle.");
-        free(pep);
+
+    /* create the http headers */
+    if (init_http_headers(pep) != 0) {
+        pep_log_error("pep_initialize: HTTP headers allocation failed.");
+        pep_destroy(pep);
         return NULL;
     }
-    /* set default CURL options */
-    init_curl_defaults(pep);
-        
+
     /* create all required lists */
-    pep->pips= pep_llist_create();
-    if (pep->pips == NULL) {
-        pep_log_error("pep_initialize: PIPs list allocation failed.");
-        curl_easy_cleanup(pep->curl);
-        free(pep);
+    pep->pips= pep_vector_create(0);
+    pep->ohs= pep_vector_create(0);
+    if (pep->pips == NULL || pep->ohs == NULL) {
+        pep_log_error("pep_initialize: PIPs or OHs list allocation failed.");
+        pep_destroy(pep);
         return NULL;
     }
-    pep->ohs= pep_llist_create();
-    if (pep->ohs == NULL) {
-        pep_log_error("pep_initialize: OHs list allocation failed.");
-        curl_easy_cleanup(pep->curl);
-        pep_llist_delete(pep->pips);
-        free(pep);
+
+    /* create the first transport: curl handle and transport buffers */
+    pep->transports[0]= transport_create(pep,0);
+    if (pep->transports[0] == NULL) {
+        pep_log_error("pep_initialize: transport allocation failed.");
+        pep_destroy(pep);
         return NULL;
     }
-    
+
     pep->option_endpoint_urls= NULL; // not used
     
     return pep;
 }
 
+pep_error_t pep_freeze(PEP * pep) {
+    int i;
+    if (pep == NULL) {
+        pep_log_error("pep_freeze: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        return PEP_OK;
+    }
+    /* the first transport and the ones of the batch slots become pooled ones */
+    for (i= 0; i < PEP_TRANSPORT_POOL_SIZE; i++) {
+        if (pep->transports[i] != NULL) pep->transport_states[i]= TRANSPORT_SLOT_FREE;
+    }
+    __atomic_store_n(&pep->frozen,TRUE,__ATOMIC_RELEASE);
+    pep_log_debug("pep_freeze: PEP#%d frozen",pep->id);
+    return PEP_OK;
+}
+
 int pep_getid(PEP * pep) {
     if (pep == NULL) {
         pep_log_error("pep_getid: NULL pep handle");
@@ -188,11 +421,15 @@ pep_error_t pep_addpip(PEP * pep, const pep_pip_t * pip) {
         pep_log_error("pep_addpip: NULL pip pointer");
         return PEP_ERR_NULL_POINTER;
     }
+    if (__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        pep_log_error("pep_addpip: PEP#%d is frozen, can't add PIP[%s].",pep->id,pip->id);
+        return PEP_ERR_HANDLE_FROZEN;
+    }
     if ((pip_rc= pip->init()) != 0) {
         pep_log_error("pep_addpip: PIP[%s] init() failed: %d.",pip->id, pip_rc);
         return PEP_ERR_PIP_INIT;
     }
-    if (pep_llist_add(pep->pips,(pep_pip_t *)pip) != LLIST_OK) {
+    if (pep_vector_add(pep->pips,(pep_pip_t *)pip) != VECTOR_OK) {
         pep_log_error("pep_addpip: failed to add initialized PIP[%s] into PEP#%d list.",pip->id,pep->id);
         return PEP_ERR_LLIST;
     }
@@ -209,11 +446,15 @@ pep_error_t pep_addobligationhandler(PEP * pep, const pep_obligationhandler_t *
         pep_log_error("pep_addobligationhandler: NULL oh pointer");
         return PEP_ERR_NULL_POINTER;
     }
+    if (__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        pep_log_error("pep_addobligationhandler: PEP#%d is frozen, can't add OH[%s].",pep->id,oh->id);
+        return PEP_ERR_HANDLE_FROZEN;
+    }
     if ((oh_rc= oh->init()) != 0) {
         pep_log_error("pep_addobligationhandler: OH[%s] init() failed: %d",oh->id, oh_rc);
         return PEP_ERR_OH_INIT;
     }
-    if (pep_llist_add(pep->ohs,(pep_obligationhandler_t *)oh) != LLIST_OK) {
+    if (pep_vector_add(pep->ohs,(pep_obligationhandler_t *)oh) != VECTOR_OK) {
         pep_log_error("pep_addobligationhandler: failed to add initialized OH[%s] into PEP#%d list.",oh->id,pep->id);
         return PEP_ERR_LLIST;
     }
@@ -228,10 +469,19 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
     int value= -1;
     FILE * file= NULL;
     pep_log_handler_callback * log_handler= NULL;
+    const pep_log_context_t * log_context;
+    CURL * curl;
     if (pep == NULL) {
         pep_log_error("pep_setoption: NULL pep handle");
         return PEP_ERR_NULL_POINTER;
     }
+    if (__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        pep_log_error("pep_setoption: PEP#%d is frozen, can't set option: %d",pep->id,option);
+        return PEP_ERR_HANDLE_FROZEN;
+    }
+    /* the options are set on the first transport, the only one until frozen */
+    curl= pep->transports[0]->curl;
+    log_context= pep_log_setcontext(&pep->log_context);
     va_start(args,option);
     switch (option) {
         case PEP_OPTION_ENDPOINT_URL:
@@ -255,7 +505,9 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_endpoint_url,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_URL: %s",pep->id,pep->option_endpoint_url);
-            set_curl_endpoint_url(pep);
+            /* the new endpoint may accept the binary body */
+            pep->binary_body_rejected= FALSE;
+            set_curl_endpoint_url(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_TIMEOUT:
             value= va_arg(args,int);
@@ -263,7 +515,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
                 pep->option_timeout= (long)value;
             }
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_TIMEOUT: %d",pep->id,(int)(pep->option_timeout));
-            set_curl_connection_timeout(pep);
+            set_curl_connection_timeout(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_SSL_VALIDATION:
             value= va_arg(args,int);
@@ -274,7 +526,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
                 pep->option_ssl_validation= FALSE;
             }
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_SSL_VALIDATION: %s",pep->id,(pep->option_ssl_validation == TRUE) ? "TRUE" : "FALSE");
-            set_curl_ssl_validation(pep);
+            set_curl_ssl_validation(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST:
             str= va_arg(args,char *);
@@ -297,7 +549,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_ssl_cipher_list,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST: %s",pep->id,pep->option_ssl_cipher_list);
-            set_curl_ssl_cipher_list(pep);
+            set_curl_ssl_cipher_list(pep,curl);
             break;
             
         case PEP_OPTION_ENDPOINT_SERVER_CERT:
@@ -321,7 +573,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_server_cert,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_SERVER_CERT: %s",pep->id,pep->option_server_cert);
-            set_curl_server_cert(pep);
+            set_curl_server_cert(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_SERVER_CAPATH:
             str= va_arg(args,char *);
@@ -344,7 +596,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_server_capath,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_SERVER_CAPATH: %s",pep->id,pep->option_server_capath);
-            set_curl_server_capath(pep);
+            set_curl_server_capath(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_CLIENT_CERT:
             str= va_arg(args,char *);
@@ -367,7 +619,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_client_cert,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_CLIENT_CERT: %s",pep->id,pep->option_client_cert);
-            set_curl_client_cert(pep);
+            set_curl_client_cert(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_CLIENT_KEY:
             str= va_arg(args,char *);
@@ -390,7 +642,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_client_key,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_CLIENT_KEY: %s",pep->id,pep->option_client_key);
-            set_curl_client_key(pep);
+            set_curl_client_key(pep,curl);
             break;
         case PEP_OPTION_ENDPOINT_CLIENT_KEYPASSWORD:
             str= va_arg(args,char *);
@@ -414,7 +666,7 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             strncpy(pep->option_client_keypassword,str,str_l);
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_CLIENT_KEYPASSWORD: %d char long",pep->id,(int)strlen(pep->option_client_keypassword));
-            set_curl_client_keypassword(pep);
+            set_curl_client_keypassword(pep,curl);
             break;
         case PEP_OPTION_ENABLE_PIPS:
             value= va_arg(args,int);
@@ -436,26 +688,79 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENABLE_OBLIGATIONHANDLERS: %s",pep->id,(pep->option_ohs_enabled == TRUE) ? "TRUE" : "FALSE");
             break;
+        case PEP_OPTION_BUFFER_SHRINK_SIZE:
+            value= va_arg(args,int);
+            if (value < 0) {
+                pep_log_error("pep_setoption: PEP#%d PEP_OPTION_BUFFER_SHRINK_SIZE argument is negative: %d.",pep->id,value);
+                rc= PEP_ERR_OPTION_INVALID;
+                break;
+            }
+            pep->option_buffer_shrink_size= (size_t)value;
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_BUFFER_SHRINK_SIZE: %d",pep->id,(int)(pep->option_buffer_shrink_size));
+            break;
+        case PEP_OPTION_ENDPOINT_BINARY_BODY:
+            value= va_arg(args,int);
+            if (value == 1) {
+                pep->option_binary_body= TRUE;
+            }
+            else {
+                pep->option_binary_body= FALSE;
+            }
+            pep->binary_body_rejected= FALSE;
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_BINARY_BODY: %s",pep->id,(pep->option_binary_body == TRUE) ? "TRUE" : "FALSE");
+            break;
         case PEP_OPTION_LOG_LEVEL:
             value= va_arg(args,int);
             if (PEP_LOGLEVEL_NONE <= value && value <= PEP_LOGLEVEL_DEBUG) {
-                pep->option_loglevel= value;
-                pep_log_setlevel(pep->option_loglevel);
+                pep->log_context.level= value;
+                /* the default outside of the pep-function calls */
+                pep_log_setlevel(value);
             }
-            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_LOG_LEVEL: %d",pep->id,pep->option_loglevel);
-            set_curl_verbose(pep);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_LOG_LEVEL: %d",pep->id,(int)pep->log_context.level);
+            set_curl_verbose(pep,curl);
             break;
         case PEP_OPTION_LOG_STDERR:
             file= va_arg(args,FILE *);
-            pep->option_logout= file;
-            pep_log_setout(pep->option_logout);
-            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_LOG_STDERR: %p",pep->id,pep->option_logout);
-            set_curl_stderr(pep);
+            pep->log_context.out= file;
+            pep_log_setout(file);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_LOG_STDERR: %p",pep->id,pep->log_context.out);
+            set_curl_stderr(pep,curl);
             break;
         case PEP_OPTION_LOG_HANDLER:
             log_handler= va_arg(args,pep_log_handler_callback *);
-            pep_log_sethandler(log_handler);
-            pep_log_debug("pep_setoption: PEP_OPTION_LOG_HANDLER: %p",log_handler);
+            pep->log_context.handler= (pep_log_handler_func *)log_handler;
+            pep_log_sethandler((pep_log_handler_func *)log_handler);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_LOG_HANDLER: %p",pep->id,log_handler);
+            break;
+        case PEP_OPTION_ENDPOINT_MAX_CONNECTIONS:
+            value= va_arg(args,int);
+            if (value >= 0) {
+                pep->option_max_connections= (long)value;
+            }
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_MAX_CONNECTIONS: %d",pep->id,(int)pep->option_max_connections);
+            if (pep->batch_multi != NULL) {
+                curl_multi_setopt(pep->batch_multi,CURLMOPT_MAX_HOST_CONNECTIONS,pep->option_max_connections);
+            }
+            break;
+        case PEP_OPTION_ASYNC_SOCKET_FUNCTION:
+            pep->option_socket_function= va_arg(args,pep_socket_callback *);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ASYNC_SOCKET_FUNCTION: %p",pep->id,pep->option_socket_function);
+            break;
+        case PEP_OPTION_ASYNC_TIMER_FUNCTION:
+            pep->option_timer_function= va_arg(args,pep_timer_callback *);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ASYNC_TIMER_FUNCTION: %p",pep->id,pep->option_timer_function);
+            break;
+        case PEP_OPTION_ASYNC_USERDATA:
+            pep->option_async_userdata= va_arg(args,void *);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_ASYNC_USERDATA: %p",pep->id,pep->option_async_userdata);
+            break;
+        case PEP_OPTION_SHARE:
+            pep->option_share= va_arg(args,pep_share_t *);
+            pep_log_debug("pep_setoption: PEP#%d PEP_OPTION_SHARE: %p",pep->id,pep->option_share);
+            if (set_curl_share(pep,curl) != 0) {
+                pep->option_share= NULL;
+                rc= PEP_ERR_OPTION_INVALID;
+            }
             break;
         default:
             pep_log_error("pep_setoption: PEP#%d invalid option: %d",pep->id,option);
@@ -463,189 +768,279 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             break;
     }
     va_end(args);
+    /* the batch transports are created again with the new options */
+    batch_transports_release(pep);
+    pep_log_setcontext(log_context);
     return rc;
 }
 
 
 pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_t ** response) {
-    int i= 0;
-    int pip_rc, oh_rc;
-    //pep_buffer_t * output, * b64output, * b64input, * input;
-    size_t output_l, b64output_l;
-    pep_error_t marshal_rc, unmarshal_rc;
-    CURLcode curl_rc;
-    long http_code= 0;
-    xacml_request_t * effective_request;
+    const pep_log_context_t * log_context;
+    pep_error_t rc;
     if (pep == NULL) {
         pep_log_error("pep_authorize: NULL pep handle");
         return PEP_ERR_NULL_POINTER;
     }
-    if (pep->option_endpoint_url == NULL) {
-        pep_log_error("pep_authorize: NULL mandatory option PEP_OPTION_ENDPOINT_URL");
+    /* log with the handle options in this thread */
+    log_context= pep_log_setcontext(&pep->log_context);
+    rc= pep_authorize_request(pep,request,response);
+    pep_log_setcontext(log_context);
+    return rc;
+}
+
+/**
+ * Applies the PIPs and submits the request to the asynchronous engine of the
+ * handle. The failed submissions are completed by pep_async_perform(), never
+ * before pep_authorize_async() returns.
+ */
+pep_error_t pep_authorize_async(PEP * pep, xacml_request_t * request, pep_authorize_callback * callback, void * userdata) {
+    const pep_log_context_t * log_context;
+    pep_async_t * async;
+    pep_error_t rc;
+    if (pep == NULL) {
+        pep_log_error("pep_authorize_async: NULL pep handle");
         return PEP_ERR_NULL_POINTER;
     }
-    if (request == NULL || *request == NULL) {
-        pep_log_error("pep_authorize: PEP#%d NULL request pointer",pep->id);
+    if (request == NULL || callback == NULL) {
+        pep_log_error("pep_authorize_async: PEP#%d NULL request or callback pointer",pep->id);
         return PEP_ERR_NULL_POINTER;
     }
-    
-    /* apply pips if enabled and any */
-    if (pep->option_pips_enabled && pep_llist_length(pep->pips) > 0) {
-        size_t pips_l= pep_llist_length(pep->pips);
-        pep_log_info("pep_authorize: PEP#%d %d PIPs available, processing...",pep->id, (int)pips_l);
-        for (i= 0; i<pips_l; i++) {
-            pep_pip_t * pip= pep_llist_get(pep->pips,i);
-            if (pip != NULL) {
-                pep_log_debug("pep_authorize: PEP#%d calling pip[%s]->process(request)...",pep->id,pip->id);
-                pip_rc= pip->process(request);
-                if (pip_rc != 0) {
-                    pep_log_error("pep_authorize: PIP[%s] process(request) failed: %d", pip->id, pip_rc);
-                    return PEP_ERR_PIP_PROCESS;
-                }
-            }
-        }
-    }
-
-    /* marshal the authorization request into output buffer */
-    pep->output= pep_buffer_create(512);
-    if (pep->output == NULL) {
-        pep_log_error("pep_authorize: PEP#%d can't create output buffer (512 bytes).",pep->id);
-        return PEP_ERR_MEMORY;
+    if (pep->option_endpoint_url == NULL) {
+        pep_log_error("pep_authorize_async: NULL mandatory option PEP_OPTION_ENDPOINT_URL");
+        return PEP_ERR_NULL_POINTER;
     }
-    marshal_rc= xacml_request_marshalling(*request,pep->output);
-    if ( marshal_rc != PEP_OK ) {
-        pep_log_error("pep_authorize: PEP#%d can't marshal XACML request: %s.",pep->id,pep_strerror(marshal_rc));
-        pep_buffer_delete(pep->output);
-        return marshal_rc;
+    log_context= pep_log_setcontext(&pep->log_context);
+    rc= async_init(pep);
+    if (rc != PEP_OK) {
+        pep_log_setcontext(log_context);
+        return rc;
     }
-
-    /* base64 encode the output buffer */
-    output_l= pep_buffer_length(pep->output);
-    pep->b64output= pep_buffer_create( output_l );
-    if (pep->b64output == NULL) {
-        pep_log_error("pep_authorize: PEP#%d can't create base64 output buffer (%d bytes).",pep->id,(int)output_l);
-        pep_buffer_delete(pep->output);
+    async= calloc(1,sizeof(struct pep_async));
+    if (async == NULL) {
+        pep_log_error("pep_authorize_async: PEP#%d can't allocate struct pep_async.",pep->id);
+        pep_log_setcontext(log_context);
         return PEP_ERR_MEMORY;
     }
-    
-    pep_log_debug("pep_authorize: PEP#%d: encoding base64 output...",pep->id);
-    pep_base64_encode_buffer_l(pep->output,pep->b64output,BASE64_DEFAULT_LINE_SIZE);
-
-    /* output buffer not needed anymore. */
-    pep_buffer_delete(pep->output);
+    async->request= request;
+    async->callback= callback;
+    async->userdata= userdata;
 
-    /* configure curl handler to POST the base64 encoded marshalled PEP request buffer */
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_POST, 1L);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_POST,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        return PEP_ERR_CURL + curl_rc;
+    /* apply pips if enabled and any, then marshal and submit */
+    rc= pep_process_pips(pep,&async->request);
+    if (rc == PEP_OK) {
+        rc= async_submit(pep,async);
     }
-    b64output_l= pep_buffer_length(pep->b64output);
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_POSTFIELDSIZE, (long)b64output_l);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_POSTFIELDSIZE,%d) failed: %s.",pep->id,(int)b64output_l,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        return PEP_ERR_CURL + curl_rc;
+    if (rc != PEP_OK) {
+        async->rc= rc;
+        async_queue_done(pep,async);
     }
+    pep_log_setcontext(log_context);
+    return PEP_OK;
+}
 
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_READDATA, pep->b64output);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_READDATA,b64output) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        return PEP_ERR_CURL + curl_rc;
+pep_error_t pep_async_perform(PEP * pep, int * running) {
+    const pep_log_context_t * log_context;
+    CURLMcode multi_rc;
+    int still_running= 0;
+    pep_error_t rc= PEP_OK;
+    if (pep == NULL) {
+        pep_log_error("pep_async_perform: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
     }
-
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_READFUNCTION, pep_buffer_read);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_READFUNCTION,buffer_read) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        return PEP_ERR_CURL + curl_rc;
+    log_context= pep_log_setcontext(&pep->log_context);
+    if (pep->multi != NULL) {
+        multi_rc= curl_multi_perform(pep->multi,&still_running);
+        if (multi_rc != CURLM_OK) {
+            pep_log_error("pep_async_perform: PEP#%d curl_multi_perform failed: %s.",pep->id,curl_multi_strerror(multi_rc));
+            rc= PEP_ERR_ASYNC;
+        }
+        async_check_completions(pep);
     }
-
-
-    /* configure curl handler to read the base64 encoded HTTP response */
-    pep->b64input= pep_buffer_create(1024);
-    if (pep->b64input == NULL) {
-        pep_log_error("pep_authorize: PEP#%d can't create base64 input buffer.",pep->id);
-        pep_buffer_delete(pep->b64output);
-        return PEP_ERR_MEMORY;
+    if (running != NULL) {
+        *running= pep->async_running;
     }
+    pep_log_setcontext(log_context);
+    return rc;
+}
 
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_WRITEDATA, pep->b64input);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEDATA,b64input) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        pep_buffer_delete(pep->b64input);
-        return PEP_ERR_CURL + curl_rc;
+pep_error_t pep_async_wait(PEP * pep, int timeout_ms) {
+    const pep_log_context_t * log_context;
+    CURLMcode multi_rc;
+    pep_error_t rc= PEP_OK;
+    if (pep == NULL) {
+        pep_log_error("pep_async_wait: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
     }
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_WRITEFUNCTION, pep_buffer_write);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEFUNCTION,buffer_write) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        pep_buffer_delete(pep->b64input);
-        return PEP_ERR_CURL + curl_rc;
+    /* nothing to wait for, or completions to deliver */
+    if (pep->multi == NULL || pep->async_running == 0 || pep->async_done != NULL) {
+        return PEP_OK;
     }
+    log_context= pep_log_setcontext(&pep->log_context);
+#if LIBCURL_VERSION_NUM >= 0x074200
+    multi_rc= curl_multi_poll(pep->multi,NULL,0,timeout_ms,NULL);
+#else
+    multi_rc= curl_multi_wait(pep->multi,NULL,0,timeout_ms,NULL);
+#endif
+    if (multi_rc != CURLM_OK) {
+        pep_log_error("pep_async_wait: PEP#%d curl_multi_wait failed: %s.",pep->id,curl_multi_strerror(multi_rc));
+        rc= PEP_ERR_ASYNC;
+    }
+    pep_log_setcontext(log_context);
+    return rc;
+}
 
-
-    /* send the request */
-    pep_log_info("pep_authorize: PEP#%d sending XACML request to: %s",pep->id,pep->option_endpoint_url);
-    curl_rc= curl_easy_perform(pep->curl);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d sending XACML request to %s failed: curl[%d] %s.",pep->id,pep->option_endpoint_url,(int)curl_rc,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        pep_buffer_delete(pep->b64input);
-        return PEP_ERR_CURL + curl_rc;
+pep_error_t pep_socket_action(PEP * pep, int fd, int events, int * running) {
+    const pep_log_context_t * log_context;
+    CURLMcode multi_rc;
+    int still_running= 0;
+    pep_error_t rc= PEP_OK;
+    if (pep == NULL) {
+        pep_log_error("pep_socket_action: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    log_context= pep_log_setcontext(&pep->log_context);
+    if (pep->multi != NULL) {
+        multi_rc= curl_multi_socket_action(pep->multi,(curl_socket_t)fd,events,&still_running);
+        if (multi_rc != CURLM_OK) {
+            pep_log_error("pep_socket_action: PEP#%d curl_multi_socket_action(%d,%d) failed: %s.",pep->id,fd,events,curl_multi_strerror(multi_rc));
+            rc= PEP_ERR_ASYNC;
+        }
+        /* completions delivered inline */
+        async_check_completions(pep);
+    }
+    if (running != NULL) {
+        *running= pep->async_running;
     }
+    pep_log_setcontext(log_context);
+    return rc;
+}
 
-    /* check for HTTP 200 response code */
-    http_code= 0;
-    curl_rc= curl_easy_getinfo(pep->curl,CURLINFO_RESPONSE_CODE,&http_code);
-    if (curl_rc != CURLE_OK) {
-        pep_log_error("pep_authorize: PEP#%d curl_easy_getinfo(pep->curl,CURLINFO_RESPONSE_CODE,&http_code) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        pep_buffer_delete(pep->b64output);
-        pep_buffer_delete(pep->b64input);
-        return PEP_ERR_CURL + curl_rc;
+pep_error_t pep_socket_assign(PEP * pep, int fd, void * socketdata) {
+    CURLMcode multi_rc;
+    if (pep == NULL) {
+        pep_log_error("pep_socket_assign: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
     }
-    if (http_code != 200) {
-        pep_log_error("pep_authorize: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
-        pep_buffer_delete(pep->b64output);
-        pep_buffer_delete(pep->b64input);
-        return PEP_ERR_AUTHZ_REQUEST;
+    if (pep->multi == NULL) {
+        pep_log_error("pep_socket_assign: PEP#%d no asynchronous authorization submitted.",pep->id);
+        return PEP_ERR_ASYNC;
+    }
+    multi_rc= curl_multi_assign(pep->multi,(curl_socket_t)fd,socketdata);
+    if (multi_rc != CURLM_OK) {
+        pep_log_error("pep_socket_assign: PEP#%d curl_multi_assign(%d) failed: %s.",pep->id,fd,curl_multi_strerror(multi_rc));
+        return PEP_ERR_ASYNC;
     }
+    return PEP_OK;
+}
 
-    /* not required anymore */
-    pep_buffer_delete(pep->b64output);
+pep_error_t pep_authorize_batch(PEP * pep, xacml_request_t ** requests, int n, xacml_response_t ** responses, pep_error_t * errors) {
+    const pep_log_context_t * log_context;
+    pep_error_t rc;
+    int i;
+    if (pep == NULL) {
+        pep_log_error("pep_authorize_batch: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (n < 0 || (n > 0 && (requests == NULL || responses == NULL || errors == NULL))) {
+        pep_log_error("pep_authorize_batch: PEP#%d NULL requests, responses or errors array (%d requests)",pep->id,n);
+        return PEP_ERR_NULL_POINTER;
+    }
+    for (i= 0; i < n; i++) {
+        responses[i]= NULL;
+        errors[i]= PEP_OK;
+    }
+    if (pep->option_endpoint_url == NULL) {
+        pep_log_error("pep_authorize_batch: NULL mandatory option PEP_OPTION_ENDPOINT_URL");
+        for (i= 0; i < n; i++) errors[i]= PEP_ERR_NULL_POINTER;
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (n == 0) {
+        return PEP_OK;
+    }
+    /* log with the handle options in this thread */
+    log_context= pep_log_setcontext(&pep->log_context);
+    rc= batch_run(pep,requests,n,responses,errors);
+    pep_log_setcontext(log_context);
+    return rc;
+}
 
-    pep_log_debug("pep_authorize: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
+/**
+ * Applies the PIPs, sends the request with a transport of the handle and
+ * applies the OHs. The handle is only read, concurrent calls on a frozen
+ * handle use different transports.
+ */
+static pep_error_t pep_authorize_request(PEP * pep, xacml_request_t ** request, xacml_response_t ** response) {
+    pep_error_t rc;
+    pep_transport_t * transport;
+    if (pep->option_endpoint_url == NULL) {
+        pep_log_error("pep_authorize: NULL mandatory option PEP_OPTION_ENDPOINT_URL");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (request == NULL || *request == NULL) {
+        pep_log_error("pep_authorize: PEP#%d NULL request pointer",pep->id);
+        return PEP_ERR_NULL_POINTER;
+    }
+    
+    /* apply pips if enabled and any */
+    rc= pep_process_pips(pep,request);
+    if (rc != PEP_OK) {
+        return rc;
+    }
 
-    /* create the Hessian input buffer */
-    pep->input= pep_buffer_create(1024);
-    if (pep->input == NULL) {
-        pep_log_error("pep_authorize: PEP#%d can't create input buffer.",pep->id);
-        pep_buffer_delete(pep->b64input);
+    /* send the request and receive the response through the transport buffers */
+    transport= transport_checkout(pep);
+    if (transport == NULL) {
+        pep_log_error("pep_authorize: PEP#%d no transport available.",pep->id);
         return PEP_ERR_MEMORY;
     }
-
-    /* base64 decode the input buffer into the Hessian buffer. */
-    pep_log_debug("pep_authorize: PEP#%d: decoding base64 input...",pep->id);
-    pep_base64_decode_buffer(pep->b64input,pep->input);
-
-    /* unmarshal the PEP response */
-    unmarshal_rc= xacml_response_unmarshalling(response,pep->input);
-    if ( unmarshal_rc != PEP_OK) {
-        pep_log_error("pep_authorize: PEP#%d can't unmarshal the XACML response: %s.", pep->id, pep_strerror(unmarshal_rc));
-        pep_buffer_delete(pep->b64input);
-        pep_buffer_delete(pep->input);
-        return unmarshal_rc;
+    rc= pep_authorize_transport(pep,transport,*request,response);
+    
+    /* apply the buffers shrink policy, whatever the transport result */
+    shrink_buffers(pep,transport);
+    transport_checkin(pep,transport);
+    
+    if (rc != PEP_OK) {
+        return rc;
     }
 
-    pep_log_info("pep_authorize: PEP#%d XACML Response decoded and deserialized.",pep->id);
+    /* effective request and obligation handlers */
+    return pep_process_response(pep,request,response);
+}
 
-    /* not required anymore */
-    pep_buffer_delete(pep->b64input);
-    pep_buffer_delete(pep->input);
+/**
+ * Applies the PIPs of the handle to the request, if enabled.
+ */
+static pep_error_t pep_process_pips(PEP * pep, xacml_request_t ** request) {
+    int i, pip_rc;
+    size_t pips_l;
+    if (!pep->option_pips_enabled || pep_vector_length(pep->pips) == 0) {
+        return PEP_OK;
+    }
+    pips_l= pep_vector_length(pep->pips);
+    pep_log_info("pep_authorize: PEP#%d %d PIPs available, processing...",pep->id, (int)pips_l);
+    for (i= 0; i<pips_l; i++) {
+        pep_pip_t * pip= pep_vector_get(pep->pips,i);
+        if (pip != NULL) {
+            pep_log_debug("pep_authorize: PEP#%d calling pip[%s]->process(request)...",pep->id,pip->id);
+            pip_rc= pip->process(request);
+            if (pip_rc != 0) {
+                pep_log_error("pep_authorize: PIP[%s] process(request) failed: %d", pip->id, pip_rc);
+                return PEP_ERR_PIP_PROCESS;
+            }
+        }
+    }
+    return PEP_OK;
+}
 
+/**
+ * Replaces the request by the effective request of the response, if any,
+ * then applies the OHs of the handle, if enabled.
+ */
+static pep_error_t pep_process_response(PEP * pep, xacml_request_t ** request, xacml_response_t ** response) {
+    int i, oh_rc;
+    size_t ohs_l;
+    xacml_request_t * effective_request;
 
     /* get effective response */
     effective_request= xacml_response_getrequest(*response);
@@ -658,22 +1053,22 @@ pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_
     }
 
     /* apply obligation handlers if enabled and any */
-    if (pep->option_ohs_enabled && pep_llist_length(pep->ohs) > 0) {
-        size_t ohs_l= pep_llist_length(pep->ohs);
-        pep_log_info("pep_authorize: PEP#%d %d OHs available, processing...",pep->id,(int)ohs_l);
-        for (i= 0; i<ohs_l; i++) {
-            pep_obligationhandler_t * oh= pep_llist_get(pep->ohs,i);
-            if (oh != NULL) {
-                pep_log_debug("pep_authorize: PEP#%d calling OH[%s]->process(request,response)...",pep->id,oh->id);
-                oh_rc = oh->process(request,response);
-                if (oh_rc != 0) {
-                    pep_log_error("pep_authorize: PEP#%d OH[%s] process(request,response) failed: %d.",pep->id,oh->id,oh_rc);
-                    return PEP_ERR_OH_PROCESS;
-                }
+    if (!pep->option_ohs_enabled || pep_vector_length(pep->ohs) == 0) {
+        return PEP_OK;
+    }
+    ohs_l= pep_vector_length(pep->ohs);
+    pep_log_info("pep_authorize: PEP#%d %d OHs available, processing...",pep->id,(int)ohs_l);
+    for (i= 0; i<ohs_l; i++) {
+        pep_obligationhandler_t * oh= pep_vector_get(pep->ohs,i);
+        if (oh != NULL) {
+            pep_log_debug("pep_authorize: PEP#%d calling OH[%s]->process(request,response)...",pep->id,oh->id);
+            oh_rc = oh->process(request,response);
+            if (oh_rc != 0) {
+                pep_log_error("pep_authorize: PEP#%d OH[%s] process(request,response) failed: %d.",pep->id,oh->id,oh_rc);
+                return PEP_ERR_OH_PROCESS;
             }
         }
     }
-    
     return PEP_OK;
 }
 
@@ -681,21 +1076,35 @@ pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_
 void pep_destroy(PEP * pep) {
     int pips_destroy_rc= 0;
     int ohs_destroy_rc= 0;
+    const pep_log_context_t * log_context;
+    int i;
     
     if (pep == NULL) return;
+    log_context= pep_log_setcontext(&pep->log_context);
+
+    /* abort the asynchronous authorizations and release the engine */
+    async_abort(pep);
+    if (pep->batch_multi != NULL) {
+        curl_multi_cleanup(pep->batch_multi);
+        pep->batch_multi= NULL;
+    }
+
+    /* release the transports: curl handles and transport buffers */
+    for (i= 0; i < PEP_TRANSPORT_POOL_SIZE; i++) {
+        transport_delete(pep->transports[i]);
+        pep->transports[i]= NULL;
+    }
 
     /* release curl http headers */
     if (pep->curl_http_headers != NULL) {
         curl_slist_free_all(pep->curl_http_headers);
         pep->curl_http_headers= NULL;
     }
-
-    /* release curl */
-    if (pep->curl != NULL) {
-        curl_easy_cleanup(pep->curl);
-        pep->curl= NULL;
+    if (pep->curl_binary_http_headers != NULL) {
+        curl_slist_free_all(pep->curl_binary_http_headers);
+        pep->curl_binary_http_headers= NULL;
     }
-    
+
     /* free options... */
     if (pep->option_endpoint_url != NULL) {
         free(pep->option_endpoint_url);
@@ -728,29 +1137,30 @@ void pep_destroy(PEP * pep) {
     }
 
     /* destroy all pips if any */
-    while (pep_llist_length(pep->pips) > 0) {
-        pep_pip_t * pip= pep_llist_remove(pep->pips,0);
+    while (pep_vector_length(pep->pips) > 0) {
+        pep_pip_t * pip= pep_vector_remove(pep->pips,0);
         if (pip != NULL) {
             pips_destroy_rc += pip->destroy();
         }
     }
-    pep_llist_delete(pep->pips);
+    pep_vector_delete(pep->pips);
     if (pips_destroy_rc > 0) {
         pep_log_warn("pep_destroy: some PIP->destroy() failed...");
     }
 
     /* destroy all obligation handlers if any */
-    while (pep_llist_length(pep->ohs) > 0) {
-        pep_obligationhandler_t * oh= pep_llist_remove(pep->ohs,0);
+    while (pep_vector_length(pep->ohs) > 0) {
+        pep_obligationhandler_t * oh= pep_vector_remove(pep->ohs,0);
         if (oh != NULL) {
             ohs_destroy_rc += oh->destroy();
         }
     }
-    pep_llist_delete(pep->ohs);
+    pep_vector_delete(pep->ohs);
     if (ohs_destroy_rc > 0) {
         pep_log_warn("pep_destroy: some OH->destroy() failed...");
     }
 
+    pep_log_setcontext(log_context);
     free(pep);
 }
 
@@ -762,13 +1172,16 @@ void pep_destroy(PEP * pep) {
 /** set the pep handle default values */
 static void init_pep_defaults(PEP * pep) {
     if (pep==NULL) return;
-    /* increase client counter */
-    pep->id= n_pep_clients++;
+    /* increase client counter, handles are created by any thread */
+    pep->id= __atomic_fetch_add(&n_pep_clients,1,__ATOMIC_RELAXED);
+    pep->frozen= FALSE;
     pep->curl_http_headers= NULL;
+    pep->curl_binary_http_headers= NULL;
     /* set default options */
     pep->option_endpoint_url= NULL;
-    pep->option_loglevel= DEFAULT_LOG_LEVEL;
-    pep->option_logout= (FILE *)DEFAULT_LOG_FILE;
+    pep_log_initcontext(&pep->log_context);
+    pep->log_context.level= DEFAULT_LOG_LEVEL;
+    pep->log_context.out= (FILE *)DEFAULT_LOG_FILE;
     pep->option_timeout= (long)DEFAULT_CURL_TIMEOUT; 
     pep->option_server_cert= NULL;
     pep->option_server_capath= NULL;
@@ -779,69 +1192,1005 @@ static void init_pep_defaults(PEP * pep) {
     pep->option_ssl_cipher_list= NULL;
     pep->option_pips_enabled= DEFAULT_PIPS_ENABLED;
     pep->option_ohs_enabled= DEFAULT_OHS_ENABLED;
+    pep->option_buffer_shrink_size= DEFAULT_BUFFER_SHRINK_SIZE;
+    pep->option_binary_body= DEFAULT_BINARY_BODY;
+    pep->binary_body_rejected= FALSE;
+    pep->option_share= NULL;
+    pep->option_max_connections= DEFAULT_MAX_CONNECTIONS;
+    pep->multi= NULL;
+    pep->async_first= NULL;
+    pep->async_running= 0;
+    pep->async_done= NULL;
+    pep->async_done_last= NULL;
+    pep->async_transports= NULL;
+    pep->option_socket_function= NULL;
+    pep->option_timer_function= NULL;
+    pep->option_async_userdata= NULL;
+    pep->async_timeout_ms= -1;
+    pep->async_wakeup= FALSE;
+    pep->batch_multi= NULL;
 }
 
-/** set some curl default value */
-static void init_curl_defaults(PEP * pep) {
-    /* set default http headers */
-    set_curl_http_headers(pep);
-    /* set default timeout */
-    set_curl_connection_timeout(pep);
-    /* set default ssl validation */
-    set_curl_ssl_validation(pep);
-    /* disable signal for multi-threading */
-    set_curl_nosignal(pep);
-    /* enable curl SSL option CURLSSLOPT_ALLOW_BEAST (libcurl >= 7.25) */
-    set_curl_ssl_option_allow_beast(pep);
+/**
+ * Marshals, encodes and sends the XACML request, then receives, decodes and
+ * unmarshals the XACML response. All the transport buffers are owned by the
+ * transport and reused between calls.
+ */
+static pep_error_t pep_authorize_transport(PEP * pep, pep_transport_t * transport, const xacml_request_t * request, xacml_response_t ** response) {
+    pep_error_t marshal_rc, perform_rc;
+    long http_code= 0;
+    int binary;
+
+    /* marshal the authorization request into output buffer */
+    marshal_rc= pep_authorize_marshal(pep,transport,request);
+    if ( marshal_rc != PEP_OK ) {
+        return marshal_rc;
+    }
+
+    /* send the request */
+    binary= (pep->option_binary_body == TRUE && __atomic_load_n(&pep->binary_body_rejected,__ATOMIC_RELAXED) == FALSE);
+    perform_rc= pep_authorize_perform(pep,transport,binary,&http_code);
+    if (perform_rc == PEP_OK && binary && is_binary_body_rejected(http_code)) {
+        /* the PEP daemon doesn't support the binary body, resend it base64 encoded */
+        pep_log_warn("pep_authorize_transport: PEP#%d binary body rejected by %s (HTTP status code: %d), falling back to base64.",pep->id,pep->option_endpoint_url,(int)http_code);
+        perform_rc= pep_authorize_perform(pep,transport,FALSE,&http_code);
+        if (perform_rc == PEP_OK && http_code == 200) {
+            /* remembered by all the transports of the handle */
+            __atomic_store_n(&pep->binary_body_rejected,TRUE,__ATOMIC_RELAXED);
+        }
+    }
+    if (perform_rc != PEP_OK) {
+        return perform_rc;
+    }
+
+    return pep_authorize_response(pep,transport,http_code,response);
 }
 
 /**
- * Set curl SSL option CURLSSLOPT_ALLOW_BEAST to renable SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS
- * to support old/broken SSL Java version.
- * 
- * See http://curl.haxx.se/mail/lib-2012-02/0001.html
- * 
- * The curl SSL option CURLSSLOPT_ALLOW_BEAST is not present in all version of libcurl, only in version >= 7.25
+ * Marshals the XACML request into the output buffer of the transport.
  */
-static int set_curl_ssl_option_allow_beast(PEP * pep) {
-#ifdef CURLSSLOPT_ALLOW_BEAST
-    CURLcode curl_rc;
-    pep_log_debug("set_curl_ssl_option_allow_beast: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST)...",pep->id);
-    curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST);
-    if (curl_rc != CURLE_OK) {
-        pep_log_warn("set_curl_ssl_option_allow_beast: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        return PEP_ERR_CURL + curl_rc;
-    }   
-#endif
-    return 0;
-}
+static pep_error_t pep_authorize_marshal(PEP * pep, pep_transport_t * transport, const xacml_request_t * request) {
+    pep_error_t marshal_rc;
+
+    /* reuse the transport buffers, they keep their allocated memory */
+    pep_buffer_reset(transport->output);
+
+    marshal_rc= xacml_request_marshalling(request,transport->output);
+    if ( marshal_rc != PEP_OK ) {
+        pep_log_error("pep_authorize_transport: PEP#%d can't marshal XACML request: %s.",pep->id,pep_strerror(marshal_rc));
+    }
+    return marshal_rc;
+}
+
+/**
+ * Checks the HTTP status code of the transfer, then unmarshals the XACML
+ * response, already decoded into the input buffer of the transport.
+ */
+static pep_error_t pep_authorize_response(PEP * pep, pep_transport_t * transport, long http_code, xacml_response_t ** response) {
+    pep_error_t unmarshal_rc;
+
+    /* check for HTTP 200 response code */
+    if (http_code != 200) {
+        pep_log_error("pep_authorize_transport: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
+        return PEP_ERR_AUTHZ_REQUEST;
+    }
+
+    pep_log_debug("pep_authorize_transport: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
+
+    /* the response is already decoded, except a final incomplete base64 block */
+    if (pep_base64_decoder_flush(transport->b64decoder) != BUFFER_OK) {
+        pep_log_error("pep_authorize_transport: PEP#%d can't decode the base64 response.",pep->id);
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+
+    /* unmarshal the rest of the PEP response */
+    unmarshal_rc= xacml_response_parser_finish(transport->parser,transport->input,response);
+    if ( unmarshal_rc != PEP_OK) {
+        pep_log_error("pep_authorize_transport: PEP#%d can't unmarshal the XACML response: %s.", pep->id, pep_strerror(unmarshal_rc));
+        return unmarshal_rc;
+    }
+
+    pep_log_info("pep_authorize_transport: PEP#%d XACML Response decoded and deserialized.",pep->id);
+
+    return PEP_OK;
+}
+
+/**
+ * POSTs the marshalled request of the output buffer, raw (binary) or base64
+ * encoded, and decodes the response body while it arrives. The HTTP status
+ * code is returned in http_code.
+ */
+static pep_error_t pep_authorize_perform(PEP * pep, pep_transport_t * transport, int binary, long * http_code) {
+    pep_error_t setup_rc;
+    CURLcode curl_rc;
+
+    setup_rc= pep_authorize_setup(pep,transport,binary);
+    if (setup_rc != PEP_OK) {
+        return setup_rc;
+    }
+
+    /* send the request */
+    pep_log_info("pep_authorize_perform: PEP#%d sending XACML request to: %s (%s body)",pep->id,pep->option_endpoint_url,binary ? "binary" : "base64");
+    curl_rc= curl_easy_perform(transport->curl);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_perform: PEP#%d sending XACML request to %s failed: curl[%d] %s.",pep->id,pep->option_endpoint_url,(int)curl_rc,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+
+    *http_code= 0;
+    curl_rc= curl_easy_getinfo(transport->curl,CURLINFO_RESPONSE_CODE,http_code);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_perform: PEP#%d curl_easy_getinfo(transport->curl,CURLINFO_RESPONSE_CODE,&http_code) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+    return PEP_OK;
+}
+
+/**
+ * Resets the transport buffers and configures the curl handle of the
+ * transport to POST the marshalled request, raw (binary) or base64 encoded,
+ * and to decode the response.
+ */
+static pep_error_t pep_authorize_setup(PEP * pep, pep_transport_t * transport, int binary) {
+    size_t output_l;
+    CURLcode curl_rc;
+
+    /* the output buffer is sent again on fallback */
+    pep_buffer_rewind(transport->output);
+    pep_base64_decoder_reset(transport->b64decoder);
+    pep_buffer_reset(transport->input);
+    if (xacml_response_parser_reset(transport->parser,transport->input,NULL) != PEP_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d can't reset the XACML response parser.",pep->id);
+        return PEP_ERR_UNMARSHALLING_IO;
+    }
+    transport->response_binary= -1;
+
+    /* configure curl handler to POST the marshalled PEP request buffer */
+    curl_rc= curl_easy_setopt(transport->curl, CURLOPT_POST, 1L);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_POST,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+    curl_rc= curl_easy_setopt(transport->curl, CURLOPT_HTTPHEADER, binary ? pep->curl_binary_http_headers : pep->curl_http_headers);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_HTTPHEADER,%s) failed: %s.",pep->id,binary ? "curl_binary_http_headers" : "curl_http_headers",curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+    if (binary) {
+        /* the output buffer is sent as is */
+        output_l= pep_buffer_length(transport->output);
+        curl_rc= curl_easy_setopt(transport->curl, CURLOPT_READDATA, transport);
+        if (curl_rc != CURLE_OK) {
+            pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_READDATA,transport) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+            return PEP_ERR_CURL + curl_rc;
+        }
+        curl_rc= curl_easy_setopt(transport->curl, CURLOPT_READFUNCTION, read_request);
+        if (curl_rc != CURLE_OK) {
+            pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_READFUNCTION,read_request) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+            return PEP_ERR_CURL + curl_rc;
+        }
+    }
+    else {
+        /* the output buffer is base64 encoded on demand, while curl sends it */
+        output_l= pep_base64_encoded_length(pep_buffer_length(transport->output),BASE64_DEFAULT_LINE_SIZE);
+        pep_base64_encoder_reset(transport->b64encoder,transport->output);
+        curl_rc= curl_easy_setopt(transport->curl, CURLOPT_READDATA, transport->b64encoder);
+        if (curl_rc != CURLE_OK) {
+            pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_READDATA,b64encoder) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+            return PEP_ERR_CURL + curl_rc;
+        }
+        curl_rc= curl_easy_setopt(transport->curl, CURLOPT_READFUNCTION, pep_base64_encoder_read);
+        if (curl_rc != CURLE_OK) {
+            pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_READFUNCTION,base64_encoder_read) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+            return PEP_ERR_CURL + curl_rc;
+        }
+    }
+    curl_rc= curl_easy_setopt(transport->curl, CURLOPT_POSTFIELDSIZE, (long)output_l);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_POSTFIELDSIZE,%d) failed: %s.",pep->id,(int)output_l,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+
+    /* configure curl handler to decode the HTTP response */
+    curl_rc= curl_easy_setopt(transport->curl, CURLOPT_WRITEDATA, transport);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEDATA,transport) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+    curl_rc= curl_easy_setopt(transport->curl, CURLOPT_WRITEFUNCTION, write_response);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("pep_authorize_setup: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEFUNCTION,write_response) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+
+    return PEP_OK;
+}
+
+/**
+ * CURLOPT_READFUNCTION callback: reads the raw marshalled request.
+ */
+static size_t read_request(void * dst, size_t size, size_t count, void * _transport) {
+    pep_transport_t * transport= (pep_transport_t *)_transport;
+    return pep_buffer_read(dst,size,count,transport->output);
+}
+
+/**
+ * Returns TRUE if the media type of the content_type header value is the
+ * binary body one, the parameters are ignored.
+ */
+static int is_binary_content_type(const char * content_type) {
+    const char * binary= BINARY_BODY_CONTENT_TYPE;
+    if (content_type == NULL) return FALSE;
+    while (*binary != '\0') {
+        if (tolower((unsigned char)*content_type) != *binary) return FALSE;
+        content_type++;
+        binary++;
+    }
+    return (*content_type == '\0' || *content_type == ';' || *content_type == ' ') ? TRUE : FALSE;
+}
+
+/**
+ * Returns TRUE if the HTTP status code means the PEP daemon doesn't support
+ * the binary body: 415 Unsupported Media Type, 406 Not Acceptable or 400 Bad
+ * Request. Other errors (5xx, 403, ...) are not related to the body encoding.
+ */
+static int is_binary_body_rejected(long http_code) {
+    return (http_code == 415 || http_code == 406 || http_code == 400) ? TRUE : FALSE;
+}
+
+/**
+ * CURLOPT_WRITEFUNCTION callback: base64 decodes the response body chunk by
+ * chunk into the input buffer, while it arrives, and unmarshals the results
+ * already received. A response with the binary body content type is copied
+ * without decoding. The body of a non 200 response is dropped.
+ */
+static size_t write_response(void * src, size_t size, size_t count, void * _transport) {
+    pep_transport_t * transport= (pep_transport_t *)_transport;
+    long http_code= 0;
+    char * content_type= NULL;
+    size_t written;
+    curl_easy_getinfo(transport->curl,CURLINFO_RESPONSE_CODE,&http_code);
+    if (http_code != 200) {
+        return size * count;
+    }
+    if (transport->response_binary == -1) {
+        curl_easy_getinfo(transport->curl,CURLINFO_CONTENT_TYPE,&content_type);
+        transport->response_binary= is_binary_content_type(content_type);
+        pep_log_debug("write_response: PEP#%d response Content-Type: %s",transport->pep->id,(content_type != NULL) ? content_type : "(none)");
+        reserve_input(transport);
+    }
+    if (transport->response_binary == TRUE) {
+        written= pep_buffer_write(src,size,count,transport->input);
+    }
+    else {
+        written= pep_base64_decoder_write(src,size,count,transport->b64decoder);
+    }
+    /* an invalid response is reported once the transfer is done */
+    xacml_response_parser_feed(transport->parser,transport->input);
+    return written;
+}
+
+/**
+ * Sizes the input buffer once for the whole response body, from its
+ * Content-Length, so a large response is received without growing the buffer
+ * chunk after chunk. A base64 body decodes to at most 3/4 of its length.
+ * Without Content-Length (chunked transfer), the buffer grows as before.
+ */
+static void reserve_input(pep_transport_t * transport) {
+    size_t body_l;
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t length= -1;
+    if (curl_easy_getinfo(transport->curl,CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,&length) != CURLE_OK || length <= 0) return;
+#else
+    double length= -1;
+    if (curl_easy_getinfo(transport->curl,CURLINFO_CONTENT_LENGTH_DOWNLOAD,&length) != CURLE_OK || length <= 0) return;
+#endif
+    body_l= (size_t)length;
+    if (body_l > MAX_RESPONSE_RESERVE_SIZE) return;
+    if (transport->response_binary != TRUE) {
+        body_l= (body_l / 4 + 1) * 3;
+    }
+    if (pep_buffer_reserve(transport->input,body_l) != BUFFER_OK) {
+        pep_log_warn("reserve_input: PEP#%d can't reserve %d bytes for the response.",transport->pep->id,(int)body_l);
+    }
+}
+
+/**
+ * Applies the buffers shrink policy: releases the memory allocated above
+ * option_buffer_shrink_size by the buffers of the transport. A zero size keeps the
+ * high-water mark.
+ */
+static void shrink_buffers(const PEP * pep, pep_transport_t * transport) {
+    size_t size;
+    if (pep == NULL || transport == NULL || pep->option_buffer_shrink_size == 0) return;
+    size= pep->option_buffer_shrink_size;
+    pep_buffer_reset(transport->output);
+    pep_buffer_shrink(transport->output,size);
+    pep_buffer_reset(transport->input);
+    pep_buffer_shrink(transport->input,size);
+}
+
+/**
+ * Creates a transport of the PEP handle: a curl handle configured with the
+ * handle options and empty transport buffers. slot is the pool slot or -1.
+ */
+static pep_transport_t * transport_create(PEP * pep, int slot) {
+    pep_transport_t * transport= calloc(1,sizeof(struct pep_transport));
+    if (transport == NULL) {
+        pep_log_error("transport_create: PEP#%d can't allocate struct pep_transport.",pep->id);
+        return NULL;
+    }
+    transport->pep= pep;
+    transport->slot= slot;
+    transport->response_binary= -1;
+    transport->curl= curl_easy_init();
+    transport->output= pep_buffer_create(512);
+    transport->b64encoder= pep_base64_encoder_create(BASE64_DEFAULT_LINE_SIZE);
+    transport->input= pep_buffer_create(512);
+    transport->parser= xacml_response_parser_create();
+    transport->b64decoder= pep_base64_decoder_create(pep_buffer_write,transport->input);
+    if (transport->curl == NULL || transport->output == NULL || transport->b64encoder == NULL
+        || transport->input == NULL || transport->parser == NULL || transport->b64decoder == NULL) {
+        pep_log_error("transport_create: PEP#%d can't create CURL session handle or transport buffers.",pep->id);
+        transport_delete(transport);
+        return NULL;
+    }
+    configure_curl(pep,transport->curl);
+    return transport;
+}
+
+static void transport_delete(pep_transport_t * transport) {
+    if (transport == NULL) return;
+    if (transport->curl != NULL) {
+        curl_easy_cleanup(transport->curl);
+    }
+    pep_buffer_delete(transport->output);
+    pep_base64_encoder_delete(transport->b64encoder);
+    pep_base64_decoder_delete(transport->b64decoder);
+    pep_buffer_delete(transport->input);
+    xacml_response_parser_delete(transport->parser);
+    free(transport);
+}
+
+/**
+ * Returns a transport for an authorization. Until the PEP handle is frozen,
+ * it is the first transport of the handle. Then a free pooled transport is
+ * taken (lock-free, by compare and swap of its slot state), or a new one is
+ * created in an empty slot. When all the slots are busy, a transient
+ * transport is created, and deleted at checkin.
+ */
+static pep_transport_t * transport_checkout(PEP * pep) {
+    int i;
+    pep_transport_t * transport;
+    if (!__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        return pep->transports[0];
+    }
+    for (i= 0; i < PEP_TRANSPORT_POOL_SIZE; i++) {
+        if (__sync_bool_compare_and_swap(&pep->transport_states[i],TRANSPORT_SLOT_FREE,TRANSPORT_SLOT_BUSY)) {
+            return pep->transports[i];
+        }
+    }
+    for (i= 0; i < PEP_TRANSPORT_POOL_SIZE; i++) {
+        if (__sync_bool_compare_and_swap(&pep->transport_states[i],TRANSPORT_SLOT_EMPTY,TRANSPORT_SLOT_BUSY)) {
+            transport= transport_create(pep,i);
+            if (transport == NULL) {
+                __atomic_store_n(&pep->transport_states[i],TRANSPORT_SLOT_EMPTY,__ATOMIC_RELEASE);
+                return NULL;
+            }
+            pep->transports[i]= transport;
+            pep_log_debug("transport_checkout: PEP#%d transport %d created.",pep->id,i);
+            return transport;
+        }
+    }
+    pep_log_warn("transport_checkout: PEP#%d all the %d pooled transports are busy, creating a transient one.",pep->id,PEP_TRANSPORT_POOL_SIZE);
+    return transport_create(pep,-1);
+}
+
+/**
+ * Returns the transport to the pool of a frozen PEP handle.
+ */
+static void transport_checkin(PEP * pep, pep_transport_t * transport) {
+    if (transport == NULL || !__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) return;
+    if (transport->slot < 0) {
+        transport_delete(transport);
+        return;
+    }
+    __atomic_store_n(&pep->transport_states[transport->slot],TRANSPORT_SLOT_FREE,__ATOMIC_RELEASE);
+}
+
+/**
+ * Creates the asynchronous engine of the handle: the multi handle and the list
+ * of idle transports. The handle is frozen, the transports of the engine are
+ * configured once with its options.
+ */
+static pep_error_t async_init(PEP * pep) {
+    CURLMcode multi_rc;
+    if (pep->multi != NULL) return PEP_OK;
+    if ((pep->option_socket_function == NULL) != (pep->option_timer_function == NULL)) {
+        pep_log_error("async_init: PEP#%d PEP_OPTION_ASYNC_SOCKET_FUNCTION and PEP_OPTION_ASYNC_TIMER_FUNCTION must be set together.",pep->id);
+        return PEP_ERR_OPTION_INVALID;
+    }
+    pep_freeze(pep);
+    pep->async_transports= pep_vector_create(0);
+    pep->multi= curl_multi_init();
+    if (pep->async_transports == NULL || pep->multi == NULL) {
+        pep_log_error("async_init: PEP#%d can't create CURLM multi handle or transports list.",pep->id);
+        pep_vector_delete(pep->async_transports);
+        pep->async_transports= NULL;
+        if (pep->multi != NULL) {
+            curl_multi_cleanup(pep->multi);
+            pep->multi= NULL;
+        }
+        return PEP_ERR_ASYNC;
+    }
+    if (pep->option_max_connections > 0) {
+        multi_rc= curl_multi_setopt(pep->multi,CURLMOPT_MAX_HOST_CONNECTIONS,pep->option_max_connections);
+        if (multi_rc != CURLM_OK) {
+            pep_log_warn("async_init: PEP#%d can't limit the connections to %d: %s.",pep->id,(int)pep->option_max_connections,curl_multi_strerror(multi_rc));
+        }
+    }
+    if (pep->option_socket_function != NULL) {
+        /* the event loop of the application watches the sockets and the timer */
+        curl_multi_setopt(pep->multi,CURLMOPT_SOCKETFUNCTION,async_socket_function);
+        curl_multi_setopt(pep->multi,CURLMOPT_SOCKETDATA,pep);
+        curl_multi_setopt(pep->multi,CURLMOPT_TIMERFUNCTION,async_timer_function);
+        curl_multi_setopt(pep->multi,CURLMOPT_TIMERDATA,pep);
+    }
+    pep_log_debug("async_init: PEP#%d asynchronous engine created",pep->id);
+    return PEP_OK;
+}
+
+/**
+ * Marshals the request into a transport of the engine and adds its transfer
+ * to the multi handle.
+ */
+static pep_error_t async_submit(PEP * pep, pep_async_t * async) {
+    pep_error_t rc;
+    int binary;
+    async->transport= async_transport_checkout(pep);
+    if (async->transport == NULL) {
+        pep_log_error("pep_authorize_async: PEP#%d no transport available.",pep->id);
+        return PEP_ERR_MEMORY;
+    }
+    rc= pep_authorize_marshal(pep,async->transport,async->request);
+    if (rc != PEP_OK) {
+        return rc;
+    }
+    binary= (pep->option_binary_body == TRUE && __atomic_load_n(&pep->binary_body_rejected,__ATOMIC_RELAXED) == FALSE);
+    async->binary= binary;
+    rc= transfer_start(pep,pep->multi,async->transport,binary,async);
+    if (rc != PEP_OK) {
+        return rc;
+    }
+    async_link(pep,async);
+    return PEP_OK;
+}
+
+/**
+ * Configures the transport to POST the marshalled request and adds it to
+ * the multi handle. private is returned by CURLINFO_PRIVATE at completion.
+ */
+static pep_error_t transfer_start(PEP * pep, CURLM * multi, pep_transport_t * transport, int binary, void * private) {
+    CURLMcode multi_rc;
+    CURLcode curl_rc;
+    pep_error_t rc;
+    rc= pep_authorize_setup(pep,transport,binary);
+    if (rc != PEP_OK) {
+        return rc;
+    }
+    curl_rc= curl_easy_setopt(transport->curl,CURLOPT_PRIVATE,(char *)private);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("transfer_start: PEP#%d curl_easy_setopt(curl,CURLOPT_PRIVATE,private) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }
+    pep_log_info("transfer_start: PEP#%d sending XACML request to: %s (%s body)",pep->id,pep->option_endpoint_url,binary ? "binary" : "base64");
+    multi_rc= curl_multi_add_handle(multi,transport->curl);
+    if (multi_rc != CURLM_OK) {
+        pep_log_error("transfer_start: PEP#%d curl_multi_add_handle failed: %s.",pep->id,curl_multi_strerror(multi_rc));
+        return PEP_ERR_ASYNC;
+    }
+    return PEP_OK;
+}
+
+/**
+ * Completes the finished transfers of the multi handle, then the failed
+ * submissions, and restores the engine timeout of the event loop.
+ */
+static void async_check_completions(PEP * pep) {
+    CURLMsg * msg;
+    int n_msgs= 0;
+    while ((msg= curl_multi_info_read(pep->multi,&n_msgs)) != NULL) {
+        if (msg->msg == CURLMSG_DONE) {
+            CURL * curl= msg->easy_handle;
+            CURLcode result= msg->data.result;
+            char * async= NULL;
+            curl_easy_getinfo(curl,CURLINFO_PRIVATE,&async);
+            curl_multi_remove_handle(pep->multi,curl);
+            async_complete(pep,(pep_async_t *)async,result);
+        }
+    }
+    while (pep->async_done != NULL) {
+        pep_async_t * async= pep->async_done;
+        pep->async_done= async->next;
+        if (pep->async_done == NULL) pep->async_done_last= NULL;
+        async_finish(pep,async);
+    }
+    if (pep->async_wakeup) {
+        /* failed submissions completed, restore the engine timeout */
+        pep->async_wakeup= FALSE;
+        pep->option_timer_function(pep,pep->async_timeout_ms,pep->option_async_userdata);
+    }
+}
+
+/**
+ * Completes a finished transfer: resends a rejected binary body base64
+ * encoded, or unmarshals the response, applies the OHs and calls the callback.
+ */
+static void async_complete(PEP * pep, pep_async_t * async, CURLcode result) {
+    long http_code= 0;
+    pep_error_t rc;
+    if (result != CURLE_OK) {
+        pep_log_error("async_complete: PEP#%d sending XACML request to %s failed: curl[%d] %s.",pep->id,pep->option_endpoint_url,(int)result,curl_easy_strerror(result));
+        rc= PEP_ERR_CURL + result;
+    }
+    else {
+        curl_easy_getinfo(async->transport->curl,CURLINFO_RESPONSE_CODE,&http_code);
+        if (async->binary && is_binary_body_rejected(http_code)) {
+            /* the PEP daemon doesn't support the binary body, resend it base64 encoded */
+            pep_log_warn("async_complete: PEP#%d binary body rejected by %s (HTTP status code: %d), falling back to base64.",pep->id,pep->option_endpoint_url,(int)http_code);
+            async->fallback= TRUE;
+            async->binary= FALSE;
+            rc= transfer_start(pep,pep->multi,async->transport,FALSE,async);
+            if (rc == PEP_OK) return;
+        }
+        else {
+            if (async->fallback && http_code == 200) {
+                /* remembered by all the transports of the handle */
+                __atomic_store_n(&pep->binary_body_rejected,TRUE,__ATOMIC_RELAXED);
+            }
+            rc= pep_authorize_response(pep,async->transport,http_code,&async->response);
+            if (rc == PEP_OK) {
+                rc= pep_process_response(pep,&async->request,&async->response);
+            }
+        }
+    }
+    async_unlink(pep,async);
+    async->rc= rc;
+    async_finish(pep,async);
+}
+
+/**
+ * Releases the transport of the authorization and calls its callback, which
+ * owns the request and the response.
+ */
+static void async_finish(PEP * pep, pep_async_t * async) {
+    if (async->transport != NULL) {
+        async_transport_checkin(pep,async->transport);
+        async->transport= NULL;
+    }
+    async->callback(pep,async->request,async->response,async->rc,async->userdata);
+    free(async);
+}
+
+static void async_link(PEP * pep, pep_async_t * async) {
+    async->prev= NULL;
+    async->next= pep->async_first;
+    if (pep->async_first != NULL) pep->async_first->prev= async;
+    pep->async_first= async;
+    pep->async_running++;
+}
+
+static void async_unlink(PEP * pep, pep_async_t * async) {
+    if (async->prev != NULL) async->prev->next= async->next;
+    else pep->async_first= async->next;
+    if (async->next != NULL) async->next->prev= async->prev;
+    async->prev= async->next= NULL;
+    pep->async_running--;
+}
+
+/**
+ * Sends the requests of the batch with a window of at most
+ * option_max_connections concurrent transfers, and completes them. Only an
+ * error of the multi handle fails the batch, the requests still in progress or
+ * not sent then fail with PEP_ERR_ASYNC.
+ */
+static pep_error_t batch_run(PEP * pep, xacml_request_t ** requests, int n, xacml_response_t ** responses, pep_error_t * errors) {
+    pep_batch_t batch;
+    pep_batch_slot_t * slots;
+    CURLMsg * msg;
+    CURLMcode multi_rc;
+    pep_error_t rc= PEP_OK;
+    int k, window, active= 0, n_msgs= 0, running= 0;
+
+    window= (pep->option_max_connections > 0 && pep->option_max_connections < n) ? (int)pep->option_max_connections : n;
+    slots= calloc(window,sizeof(pep_batch_slot_t));
+    if (slots == NULL) {
+        pep_log_error("pep_authorize_batch: PEP#%d can't allocate %d transfer slots.",pep->id,window);
+        for (k= 0; k < n; k++) errors[k]= PEP_ERR_MEMORY;
+        return PEP_ERR_MEMORY;
+    }
+    batch.multi= batch_multi_checkout(pep);
+    if (batch.multi == NULL) {
+        free(slots);
+        for (k= 0; k < n; k++) errors[k]= PEP_ERR_ASYNC;
+        return PEP_ERR_ASYNC;
+    }
+    batch.pep= pep;
+    batch.requests= requests;
+    batch.responses= responses;
+    batch.errors= errors;
+    batch.n= n;
+    batch.next= 0;
+    batch.n_transports= 0;
+
+    pep_log_info("pep_authorize_batch: PEP#%d %d requests, %d concurrent transfers",pep->id,n,window);
+    for (k= 0; k < window; k++) {
+        slots[k].item= -1;
+        if (batch_start_next(&batch,&slots[k])) active++;
+    }
+    while (active > 0) {
+        multi_rc= curl_multi_perform(batch.multi,&running);
+        if (multi_rc != CURLM_OK) {
+            pep_log_error("pep_authorize_batch: PEP#%d curl_multi_perform failed: %s.",pep->id,curl_multi_strerror(multi_rc));
+            rc= PEP_ERR_ASYNC;
+            break;
+        }
+        while ((msg= curl_multi_info_read(batch.multi,&n_msgs)) != NULL) {
+            if (msg->msg == CURLMSG_DONE) {
+                CURL * curl= msg->easy_handle;
+                CURLcode result= msg->data.result;
+                char * slot= NULL;
+                curl_easy_getinfo(curl,CURLINFO_PRIVATE,&slot);
+                curl_multi_remove_handle(batch.multi,curl);
+                if (!batch_complete(&batch,(pep_batch_slot_t *)slot,result) && !batch_start_next(&batch,(pep_batch_slot_t *)slot)) {
+                    active--;
+                }
+            }
+        }
+        if (active > 0) {
+#if LIBCURL_VERSION_NUM >= 0x074200
+            multi_rc= curl_multi_poll(batch.multi,NULL,0,1000,NULL);
+#else
+            multi_rc= curl_multi_wait(batch.multi,NULL,0,1000,NULL);
+#endif
+            if (multi_rc != CURLM_OK) {
+                pep_log_error("pep_authorize_batch: PEP#%d curl_multi_wait failed: %s.",pep->id,curl_multi_strerror(multi_rc));
+                rc= PEP_ERR_ASYNC;
+                break;
+            }
+        }
+    }
+
+    /* release the transports, after an engine error fail the requests left */
+    for (k= 0; k < window; k++) {
+        if (slots[k].item >= 0) {
+            curl_multi_remove_handle(batch.multi,slots[k].transport->curl);
+            errors[slots[k].item]= PEP_ERR_ASYNC;
+        }
+        if (slots[k].transport != NULL) {
+            batch_transport_checkin(pep,slots[k].transport);
+        }
+    }
+    for (; batch.next < n; batch.next++) {
+        errors[batch.next]= PEP_ERR_ASYNC;
+    }
+    batch_multi_checkin(pep,batch.multi);
+    free(slots);
+    return rc;
+}
+
+/**
+ * Applies the PIPs to the next request of the batch and starts its transfer
+ * with the transport of the slot. The requests failing before the transfer
+ * are skipped. Returns FALSE if no request is left.
+ */
+static int batch_start_next(pep_batch_t * batch, pep_batch_slot_t * slot) {
+    PEP * pep= batch->pep;
+    pep_error_t rc;
+    int i, binary;
+    slot->item= -1;
+    while (batch->next < batch->n) {
+        i= batch->next++;
+        if (batch->requests[i] == NULL) {
+            pep_log_error("pep_authorize_batch: PEP#%d NULL request %d",pep->id,i);
+            batch->errors[i]= PEP_ERR_NULL_POINTER;
+            continue;
+        }
+        rc= pep_process_pips(pep,&batch->requests[i]);
+        if (rc == PEP_OK && slot->transport == NULL) {
+            slot->transport= batch_transport_checkout(batch);
+            if (slot->transport == NULL) {
+                pep_log_error("pep_authorize_batch: PEP#%d no transport available.",pep->id);
+                rc= PEP_ERR_MEMORY;
+            }
+        }
+        if (rc == PEP_OK) {
+            rc= pep_authorize_marshal(pep,slot->transport,batch->requests[i]);
+        }
+        if (rc == PEP_OK) {
+            binary= (pep->option_binary_body == TRUE && __atomic_load_n(&pep->binary_body_rejected,__ATOMIC_RELAXED) == FALSE);
+            slot->binary= binary;
+            slot->fallback= FALSE;
+            rc= transfer_start(pep,batch->multi,slot->transport,binary,slot);
+        }
+        if (rc == PEP_OK) {
+            slot->item= i;
+            return TRUE;
+        }
+        batch->errors[i]= rc;
+    }
+    return FALSE;
+}
+
+/**
+ * Completes the finished transfer of a slot: resends a rejected binary body
+ * base64 encoded, or unmarshals the response and applies the OHs. Returns
+ * TRUE if the request is resent.
+ */
+static int batch_complete(pep_batch_t * batch, pep_batch_slot_t * slot, CURLcode result) {
+    PEP * pep= batch->pep;
+    int i= slot->item;
+    long http_code= 0;
+    pep_error_t rc;
+    if (result != CURLE_OK) {
+        pep_log_error("pep_authorize_batch: PEP#%d sending XACML request %d to %s failed: curl[%d] %s.",pep->id,i,pep->option_endpoint_url,(int)result,curl_easy_strerror(result));
+        rc= PEP_ERR_CURL + result;
+    }
+    else {
+        curl_easy_getinfo(slot->transport->curl,CURLINFO_RESPONSE_CODE,&http_code);
+        if (slot->binary && is_binary_body_rejected(http_code)) {
+            /* the PEP daemon doesn't support the binary body, resend it base64 encoded */
+            pep_log_warn("pep_authorize_batch: PEP#%d binary body rejected by %s (HTTP status code: %d), falling back to base64.",pep->id,pep->option_endpoint_url,(int)http_code);
+            slot->fallback= TRUE;
+            slot->binary= FALSE;
+            rc= transfer_start(pep,batch->multi,slot->transport,FALSE,slot);
+            if (rc == PEP_OK) return TRUE;
+        }
+        else {
+            if (slot->fallback && http_code == 200) {
+                /* remembered by all the transports of the handle */
+                __atomic_store_n(&pep->binary_body_rejected,TRUE,__ATOMIC_RELAXED);
+            }
+            rc= pep_authorize_response(pep,slot->transport,http_code,&batch->responses[i]);
+            if (rc == PEP_OK) {
+                rc= pep_process_response(pep,&batch->requests[i],&batch->responses[i]);
+            }
+        }
+    }
+    batch->errors[i]= rc;
+    slot->item= -1;
+    return FALSE;
+}
+
+/**
+ * Returns a transport for a slot of the batch. A frozen handle checks the
+ * transports out of its pool. Otherwise the slot k uses the transport k of
+ * the pool, created by the first batch and kept for the next ones, the
+ * slots beyond the pool size transient transports.
+ */
+static pep_transport_t * batch_transport_checkout(pep_batch_t * batch) {
+    PEP * pep= batch->pep;
+    int k;
+    if (!__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        k= batch->n_transports++;
+        if (k >= PEP_TRANSPORT_POOL_SIZE) {
+            return transport_create(pep,-1);
+        }
+        if (pep->transports[k] == NULL) {
+            pep->transports[k]= transport_create(pep,k);
+            pep_log_debug("pep_authorize_batch: PEP#%d transport %d created.",pep->id,k);
+        }
+        return pep->transports[k];
+    }
+    batch->n_transports++;
+    return transport_checkout(pep);
+}
+
+/* applies the buffers shrink policy and returns the transport */
+static void batch_transport_checkin(PEP * pep, pep_transport_t * transport) {
+    shrink_buffers(pep,transport);
+    if (!__atomic_load_n(&pep->frozen,__ATOMIC_ACQUIRE)) {
+        if (transport->slot < 0) transport_delete(transport);
+        return;
+    }
+    transport_checkin(pep,transport);
+}
+
+/**
+ * Releases the batch transports of a handle not frozen yet, configured with
+ * the previous options. The first transport is kept, the options are set on it.
+ */
+static void batch_transports_release(PEP * pep) {
+    int i;
+    for (i= 1; i < PEP_TRANSPORT_POOL_SIZE; i++) {
+        if (pep->transports[i] != NULL) {
+            transport_delete(pep->transports[i]);
+            pep->transports[i]= NULL;
+        }
+    }
+}
+
+/**
+ * Takes the idle batch multi handle of the PEP handle, with its connections
+ * kept alive, or creates a new one if it is used by a concurrent batch.
+ */
+static CURLM * batch_multi_checkout(PEP * pep) {
+    CURLMcode multi_rc;
+    CURLM * multi= __atomic_exchange_n(&pep->batch_multi,NULL,__ATOMIC_ACQUIRE);
+    if (multi != NULL) return multi;
+    multi= curl_multi_init();
+    if (multi == NULL) {
+        pep_log_error("pep_authorize_batch: PEP#%d can't create CURLM multi handle.",pep->id);
+        return NULL;
+    }
+    if (pep->option_max_connections > 0) {
+        multi_rc= curl_multi_setopt(multi,CURLMOPT_MAX_HOST_CONNECTIONS,pep->option_max_connections);
+        if (multi_rc != CURLM_OK) {
+            pep_log_warn("pep_authorize_batch: PEP#%d can't limit the connections to %d: %s.",pep->id,(int)pep->option_max_connections,curl_multi_strerror(multi_rc));
+        }
+    }
+    return multi;
+}
+
+/* keeps the multi handle for the next batch, or releases it */
+static void batch_multi_checkin(PEP * pep, CURLM * multi) {
+    if (!__sync_bool_compare_and_swap(&pep->batch_multi,NULL,multi)) {
+        curl_multi_cleanup(multi);
+    }
+}
+
+/**
+ * Queues a failed submission, completed by pep_async_perform() or by
+ * pep_socket_action(). With an event loop, the timer is set to expire now.
+ */
+static void async_queue_done(PEP * pep, pep_async_t * async) {
+    async->next= NULL;
+    if (pep->async_done_last != NULL) pep->async_done_last->next= async;
+    else pep->async_done= async;
+    pep->async_done_last= async;
+    if (pep->option_timer_function != NULL && !pep->async_wakeup) {
+        pep->async_wakeup= TRUE;
+        pep->option_timer_function(pep,0,pep->option_async_userdata);
+    }
+}
+
+/**
+ * CURLMOPT_SOCKETFUNCTION callback: the socket events to watch, forwarded to
+ * the event loop.
+ */
+static int async_socket_function(CURL * curl, curl_socket_t fd, int what, void * _pep, void * socketdata) {
+    PEP * pep= (PEP *)_pep;
+    return pep->option_socket_function(pep,(int)fd,what,pep->option_async_userdata,socketdata);
+}
+
+/**
+ * CURLMOPT_TIMERFUNCTION callback: the engine timeout, forwarded to the event
+ * loop unless the timer is already set to expire now.
+ */
+static int async_timer_function(CURLM * multi, long timeout_ms, void * _pep) {
+    PEP * pep= (PEP *)_pep;
+    pep->async_timeout_ms= timeout_ms;
+    if (pep->async_wakeup) return 0;
+    return pep->option_timer_function(pep,timeout_ms,pep->option_async_userdata);
+}
+
+/**
+ * Aborts the in-flight authorizations (PEP_ERR_ASYNC_ABORTED), completes the
+ * failed submissions and releases the engine.
+ */
+static void async_abort(PEP * pep) {
+    size_t i;
+    if (pep->multi == NULL) return;
+    while (pep->async_first != NULL) {
+        pep_async_t * async= pep->async_first;
+        curl_multi_remove_handle(pep->multi,async->transport->curl);
+        async_unlink(pep,async);
+        async->rc= PEP_ERR_ASYNC_ABORTED;
+        async_finish(pep,async);
+    }
+    async_check_completions(pep);
+    curl_multi_cleanup(pep->multi);
+    pep->multi= NULL;
+    for (i= 0; i < pep_vector_length(pep->async_transports); i++) {
+        transport_delete(pep_vector_get(pep->async_transports,i));
+    }
+    pep_vector_delete(pep->async_transports);
+    pep->async_transports= NULL;
+}
+
+/* takes an idle transport of the engine, or creates a new one */
+static pep_transport_t * async_transport_checkout(PEP * pep) {
+    size_t transports_l= pep_vector_length(pep->async_transports);
+    if (transports_l > 0) {
+        return pep_vector_remove(pep->async_transports,transports_l - 1);
+    }
+    return transport_create(pep,-1);
+}
+
+/* applies the buffers shrink policy and keeps the transport for reuse */
+static void async_transport_checkin(PEP * pep, pep_transport_t * transport) {
+    shrink_buffers(pep,transport);
+    if (pep_vector_add(pep->async_transports,transport) != VECTOR_OK) {
+        transport_delete(transport);
+    }
+}
+
+/** set all the curl options of a new curl handle from the PEP handle options */
+static void configure_curl(const PEP * pep, CURL * curl) {
+    /* set default timeout */
+    set_curl_connection_timeout(pep,curl);
+    /* set default ssl validation */
+    set_curl_ssl_validation(pep,curl);
+    /* disable signal for multi-threading */
+    set_curl_nosignal(pep,curl);
+    /* enable curl SSL option CURLSSLOPT_ALLOW_BEAST (libcurl >= 7.25) */
+    set_curl_ssl_option_allow_beast(pep,curl);
+    /* options already set on the PEP handle */
+    set_curl_endpoint_url(pep,curl);
+    set_curl_ssl_cipher_list(pep,curl);
+    set_curl_server_cert(pep,curl);
+    set_curl_server_capath(pep,curl);
+    set_curl_client_cert(pep,curl);
+    set_curl_client_key(pep,curl);
+    set_curl_client_keypassword(pep,curl);
+    set_curl_verbose(pep,curl);
+    set_curl_stderr(pep,curl);
+    set_curl_share(pep,curl);
+    /* multiplex the transfers of a multi handle on an HTTP/2 connection */
+    set_curl_pipewait(pep,curl);
+}
+
+/**
+ * Set curl SSL option CURLSSLOPT_ALLOW_BEAST to renable SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS
+ * to support old/broken SSL Java version.
+ * 
+ * See http://curl.haxx.se/mail/lib-2012-02/0001.html
+ * 
+ * The curl SSL option CURLSSLOPT_ALLOW_BEAST is not present in all version of libcurl, only in version >= 7.25
+ */
+static int set_curl_ssl_option_allow_beast(const PEP * pep, CURL * curl) {
+#ifdef CURLSSLOPT_ALLOW_BEAST
+    CURLcode curl_rc;
+    pep_log_debug("set_curl_ssl_option_allow_beast: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST)...",pep->id);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST);
+    if (curl_rc != CURLE_OK) {
+        pep_log_warn("set_curl_ssl_option_allow_beast: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_OPTIONS,CURLSSLOPT_ALLOW_BEAST) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL + curl_rc;
+    }   
+#endif
+    return 0;
+}
 
 /** 
- * set curl http headers:
+ * create the curl http headers, set on each request:
  * - disable 'Expect: 100-continue' HTTP 1.1 header in POST
  * - set 'User-Agent: <value>' header
  */
-static int set_curl_http_headers(PEP * pep) {
-    CURLcode curl_rc;
+static int init_http_headers(PEP * pep) {
     /* disable 'Expect: 100-continue' HTTP 1.1 header in POST */
     pep->curl_http_headers= curl_slist_append(pep->curl_http_headers, "Expect:");  
-    pep_log_debug("set_curl_http_headers: PEP#%d curl_http_headers: 'Expect:'",pep->id);    
+    pep_log_debug("init_http_headers: PEP#%d curl_http_headers: 'Expect:'",pep->id);    
     /* set 'User-Agent:' header */
     pep->curl_http_headers= curl_slist_append(pep->curl_http_headers, "User-Agent: " PACKAGE_NAME "/" PACKAGE_VERSION );  
-    pep_log_debug("set_curl_http_headers: PEP#%d curl_http_headers: 'User-Agent: " PACKAGE_NAME "/" PACKAGE_VERSION "'",pep->id);    
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_HTTPHEADER, pep->curl_http_headers);
-    if (curl_rc != CURLE_OK) {
-        pep_log_warn("set_curl_http_headers: PEP#%d curl_easy_setopt(curl,CURLOPT_HTTPHEADER,curl_http_headers) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+    pep_log_debug("init_http_headers: PEP#%d curl_http_headers: 'User-Agent: " PACKAGE_NAME "/" PACKAGE_VERSION "'",pep->id);    
+    /* same headers, plus the binary body content type, for PEP_OPTION_ENDPOINT_BINARY_BODY */
+    pep->curl_binary_http_headers= curl_slist_append(pep->curl_binary_http_headers, "Expect:");
+    pep->curl_binary_http_headers= curl_slist_append(pep->curl_binary_http_headers, "User-Agent: " PACKAGE_NAME "/" PACKAGE_VERSION );
+    pep->curl_binary_http_headers= curl_slist_append(pep->curl_binary_http_headers, "Content-Type: " BINARY_BODY_CONTENT_TYPE);
+    pep->curl_binary_http_headers= curl_slist_append(pep->curl_binary_http_headers, "Accept: " BINARY_BODY_CONTENT_TYPE ", text/plain");
+    pep_log_debug("init_http_headers: PEP#%d curl_binary_http_headers: 'Content-Type: " BINARY_BODY_CONTENT_TYPE "'",pep->id);
+    if (pep->curl_http_headers == NULL || pep->curl_binary_http_headers == NULL) {
+        pep_log_error("init_http_headers: PEP#%d can't allocate the HTTP headers.",pep->id);
         return 1;
     }
     return 0;
 }
 
 /** disable signal for multi-threading */
-static int set_curl_nosignal(const PEP * pep) {
+static int set_curl_nosignal(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_nosignal: PEP#%d curl_easy_setopt(curl,CURLOPT_NOSIGNAL,1)",pep->id);
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_NOSIGNAL, 1);
+    curl_rc= curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
     if (curl_rc != CURLE_OK) {
         pep_log_warn("set_curl_nosignal: PEP#%d curl_easy_setopt(curl,CURLOPT_NOSIGNAL,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
         return 1;
@@ -850,10 +2199,10 @@ static int set_curl_nosignal(const PEP * pep) {
 }
 
 /** set libcurl CURLOPT_URL */
-static int set_curl_endpoint_url(const PEP * pep) {
+static int set_curl_endpoint_url(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_endpoint_url: PEP#%d option_endpoint_url: %s",pep->id,pep->option_endpoint_url);
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_URL, pep->option_endpoint_url);
+    curl_rc= curl_easy_setopt(curl, CURLOPT_URL, pep->option_endpoint_url);
     if (curl_rc != CURLE_OK) {
         pep_log_error("set_curl_endpoint_url: PEP#%d curl_easy_setopt(curl,CURLOPT_URL,%s) failed: %s.",pep->id,pep->option_endpoint_url,curl_easy_strerror(curl_rc));
         return 1;
@@ -863,10 +2212,10 @@ static int set_curl_endpoint_url(const PEP * pep) {
 
 
 /* set libcurl CURLOPT_TIMEOUT */
-static int set_curl_connection_timeout(const PEP * pep) {
+static int set_curl_connection_timeout(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_connection_timeout: PEP#%d option_timeout: %d",pep->id,(int)(pep->option_timeout));
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_TIMEOUT, pep->option_timeout);
+    curl_rc= curl_easy_setopt(curl, CURLOPT_TIMEOUT, pep->option_timeout);
     if (curl_rc != CURLE_OK) {
         pep_log_error("set_curl_connection_timeout: PEP#%d curl_easy_setopt(curl,CURLOPT_TIMEOUT,%d) failed: %s",pep->id, (int)(pep->option_timeout),curl_easy_strerror(curl_rc));
         return 1;
@@ -875,10 +2224,10 @@ static int set_curl_connection_timeout(const PEP * pep) {
 }
 
 /* set libcurl CURLOPT_SSL_VERIFYPEER */
-static int set_curl_ssl_validation(const PEP * pep) {
+static int set_curl_ssl_validation(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_ssl_validation: PEP#%d option_ssl_validation: %s",pep->id,pep->option_ssl_validation ? "TRUE" : "FALSE");
-    curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSL_VERIFYPEER,pep->option_ssl_validation);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_SSL_VERIFYPEER,pep->option_ssl_validation);
     if (curl_rc != CURLE_OK) {
         pep_log_error("set_curl_ssl_validation: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_VERIFYPEER,%d) failed: %s",pep->option_ssl_validation,curl_easy_strerror(curl_rc));
         return 1;
@@ -887,11 +2236,11 @@ static int set_curl_ssl_validation(const PEP * pep) {
 }
 
 /* set libcurl CURLOPT_SSL_CIPHER_LIST iff option_ssl_cipher_list not NULL */
-static int set_curl_ssl_cipher_list(const PEP * pep) {
+static int set_curl_ssl_cipher_list(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_ssl_cipher_list: PEP#%d option_ssl_cipher_list: %s",pep->id,pep->option_ssl_cipher_list);
     if (pep->option_ssl_cipher_list != NULL) {
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSL_CIPHER_LIST,pep->option_ssl_cipher_list);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_SSL_CIPHER_LIST,pep->option_ssl_cipher_list);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_ssl_cipher_list: PEP#%d curl_easy_setopt(curl,CURLOPT_SSL_CIPHER_LIST,%s) failed: %s",pep->id,pep->option_ssl_cipher_list,curl_easy_strerror(curl_rc));
             return 1;
@@ -901,11 +2250,11 @@ static int set_curl_ssl_cipher_list(const PEP * pep) {
 }
 
 /** set libcurl CURLOPT_CAINFO iff option_server_cert not NULL */
-static int set_curl_server_cert(const PEP * pep) {
+static int set_curl_server_cert(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_server_cert: PEP#%d option_server_cert: %s",pep->id,pep->option_server_cert);
     if (pep->option_server_cert != NULL) {
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_CAINFO,pep->option_server_cert);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_CAINFO,pep->option_server_cert);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_server_cert: PEP#%d curl_easy_setopt(curl,CURLOPT_CAINFO,%s) failed: %s",pep->id,pep->option_server_cert,curl_easy_strerror(curl_rc));
             return 1;
@@ -915,11 +2264,11 @@ static int set_curl_server_cert(const PEP * pep) {
 }
 
 /** set libcurl CURLOPT_CAPATH iff option_server_capath not NULL */
-static int set_curl_server_capath(const PEP * pep) {
+static int set_curl_server_capath(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_server_capath: PEP#%d option_server_capath: %s",pep->id,pep->option_server_capath);
     if (pep->option_server_capath != NULL) {
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_CAPATH,pep->option_server_capath);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_CAPATH,pep->option_server_capath);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_server_capath: PEP#%d curl_easy_setopt(curl,CURLOPT_CAPATH,%s) failed: %s",pep->id,pep->option_server_capath,curl_easy_strerror(curl_rc));
             return 1;
@@ -929,11 +2278,11 @@ static int set_curl_server_capath(const PEP * pep) {
 }
 
 /** set libcurl CURLOPT_SSLCERT iff option_client_cert not NULL */
-static int set_curl_client_cert(const PEP * pep) {
+static int set_curl_client_cert(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_client_cert: PEP#%d option_client_cert: %s",pep->id,pep->option_client_cert);
     if (pep->option_client_cert != NULL) {
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSLCERT,pep->option_client_cert);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_SSLCERT,pep->option_client_cert);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_client_cert: PEP#%d curl_easy_setopt(curl,CURLOPT_SSLCERT,%s) failed: %s",pep->id,pep->option_client_cert,curl_easy_strerror(curl_rc));
             return 1;
@@ -944,11 +2293,11 @@ static int set_curl_client_cert(const PEP * pep) {
 
 
 /** set libcurl CURLOPT_SSLKEY iff option_client_key not NULL */
-static int set_curl_client_key(const PEP * pep) {
+static int set_curl_client_key(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     pep_log_debug("set_curl_client_key: PEP#%d option_client_key: %s",pep->id,pep->option_client_key);
     if (pep->option_client_key != NULL) {
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSLKEY,pep->option_client_key);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_SSLKEY,pep->option_client_key);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_client_key: PEP#%d curl_easy_setopt(curl,CURLOPT_SSLKEY,%s) failed: %s",pep->id,pep->option_client_key,curl_easy_strerror(curl_rc));
             return 1;
@@ -959,11 +2308,11 @@ static int set_curl_client_key(const PEP * pep) {
 
 
 /** set libcurl CURLOPT_SSLKEYPASSWD iff option_client_keypassword not NULL */
-static int set_curl_client_keypassword(const PEP * pep) {
+static int set_curl_client_keypassword(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     if (pep->option_client_keypassword != NULL) {
         pep_log_debug("set_curl_client_keypassword: PEP#%d option_client_keypassword: %d char long",pep->id,(int)strlen(pep->option_client_keypassword));
-        curl_rc= curl_easy_setopt(pep->curl,CURLOPT_SSLKEYPASSWD,pep->option_client_keypassword);
+        curl_rc= curl_easy_setopt(curl,CURLOPT_SSLKEYPASSWD,pep->option_client_keypassword);
         if (curl_rc != CURLE_OK) {
             pep_log_error("set_curl_client_keypassword: PEP#%d curl_easy_setopt(curl,CURLOPT_SSLKEYPASSWD,%s) failed: %s",pep->id,pep->option_client_keypassword,curl_easy_strerror(curl_rc));
             return 1;
@@ -972,15 +2321,15 @@ static int set_curl_client_keypassword(const PEP * pep) {
     return 0;
 }
 
-/** set libcurl CURLOPT_VERBOSE to true if option_loglevel >= DEBUG, false otherwise */
-static int set_curl_verbose(const PEP * pep) {
+/** set libcurl CURLOPT_VERBOSE to true if the log level >= DEBUG, false otherwise */
+static int set_curl_verbose(const PEP * pep, CURL * curl) {
     CURLcode curl_rc;
     long enabled= 0L;
-    pep_log_debug("set_curl_verbose: PEP#%d option_loglevel: %d",pep->id,pep->option_loglevel);
-    if (pep->option_loglevel >= PEP_LOGLEVEL_DEBUG) {
+    pep_log_debug("set_curl_verbose: PEP#%d log level: %d",pep->id,(int)pep->log_context.level);
+    if (pep->log_context.level >= PEP_LOGLEVEL_DEBUG) {
         enabled= 1L;
     }
-    curl_rc= curl_easy_setopt(pep->curl,CURLOPT_VERBOSE,enabled);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_VERBOSE,enabled);
     if (curl_rc != CURLE_OK) {
         pep_log_error("set_curl_verbose: PEP#%d curl_easy_setopt(curl,CURLOPT_VERBOSE,%d) failed: %s",pep->id,(int)enabled,curl_easy_strerror(curl_rc));
         return 1;
@@ -989,15 +2338,58 @@ static int set_curl_verbose(const PEP * pep) {
 }
 
 /** set libcurl CURLOPT_STDERR */
-static int set_curl_stderr(const PEP * pep) {
+static int set_curl_stderr(const PEP * pep, CURL * curl) {
+    CURLcode curl_rc;
+    pep_log_debug("set_curl_stderr: PEP#%d log output: %p",pep->id,pep->log_context.out);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_STDERR,pep->log_context.out);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("set_curl_stderr: PEP#%d curl_easy_setopt(curl,CURLOPT_STDERR,%p) failed: %s",pep->id,pep->log_context.out,curl_easy_strerror(curl_rc));
+        return 1;
+    }
+    return 0;
+}
+
+/** set libcurl CURLOPT_SHARE to the shared cache, or stop sharing if option_share is NULL */
+static int set_curl_share(const PEP * pep, CURL * curl) {
+    CURLcode curl_rc;
+    CURLSH * curlsh= (pep->option_share != NULL) ? pep->option_share->curlsh : NULL;
+    pep_log_debug("set_curl_share: PEP#%d option_share: %p",pep->id,pep->option_share);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_SHARE,curlsh);
+    if (curl_rc != CURLE_OK) {
+        pep_log_error("set_curl_share: PEP#%d curl_easy_setopt(curl,CURLOPT_SHARE,%p) failed: %s",pep->id,curlsh,curl_easy_strerror(curl_rc));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * set libcurl CURLOPT_PIPEWAIT: in a multi handle, a transfer waits for a
+ * connection being established to know if it can be multiplexed (HTTP/2)
+ * instead of opening a new connection. CURLOPT_PIPEWAIT is only present in
+ * libcurl >= 7.43
+ */
+static int set_curl_pipewait(const PEP * pep, CURL * curl) {
+#if LIBCURL_VERSION_NUM >= 0x072B00
     CURLcode curl_rc;
-    pep_log_debug("set_curl_stderr: PEP#%d option_logout: %p",pep->id,pep->option_logout);
-    curl_rc= curl_easy_setopt(pep->curl,CURLOPT_STDERR,pep->option_logout);
+    curl_rc= curl_easy_setopt(curl,CURLOPT_PIPEWAIT,1L);
     if (curl_rc != CURLE_OK) {
-        pep_log_error("set_curl_stderr: PEP#%d curl_easy_setopt(curl,CURLOPT_STDERR,%p) failed: %s",pep->id,pep->option_logout,curl_easy_strerror(curl_rc));
+        pep_log_warn("set_curl_pipewait: PEP#%d curl_easy_setopt(curl,CURLOPT_PIPEWAIT,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
         return 1;
     }
+#endif
     return 0;
 }
 
+/** CURLSHOPT_LOCKFUNC callback: locks the shared data type */
+static void share_lock(CURL * curl, curl_lock_data data, curl_lock_access access, void * _share) {
+    pep_share_t * share= (pep_share_t *)_share;
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) return;
+    pthread_mutex_lock(&share->locks[data]);
+}
 
+/** CURLSHOPT_UNLOCKFUNC callback: unlocks the shared data type */
+static void share_unlock(CURL * curl, curl_lock_data data, void * _share) {
+    pep_share_t * share= (pep_share_t *)_share;
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) return;
+    pthread_mutex_unlock(&share->locks[data]);
+}
@@ -40,18 +40,36 @@ extern "C" {
  * 
  * <p>
  * <h2>Multi-threading</h2>
- * Version 2.X of the PEP client C API is multi-thread friendly. However, you are not allowed 
- * to share a PEP handle among multiple threads:
+ * Version 2.X of the PEP client C API is multi-thread friendly. A PEP handle can be used
+ * by several threads only once frozen:
  * <ul> 
- * <li>Each thread must create its own PEP handle. 
- * <li>Never ever call pep-functions simultaneously using the same  handle  from  several
- *      threads. The PEP library is thread-safe and can be used in any number of threads, but you
- *      must use separate PEP handles if you want to use it in more than  one  thread
- *      simultaneously.
+ * <li>Either each thread creates its own PEP handle, and never calls pep-functions
+ *      simultaneously using the same handle from several threads.
+ * <li>Or one thread creates and configures a PEP handle (options, PIPs and OHs), then
+ *      freezes it with pep_freeze(). The configuration of a frozen handle can't be changed
+ *      anymore, and any number of threads can call pep_authorize() simultaneously with it.
+ *      Each call uses its own connection and transport buffers, taken from a pool of the
+ *      handle. The PIPs and OHs of a frozen handle must be thread-safe.
  * </ul> 
  * If your threads are object (OO programming, ...), it is recommended you to 
  * create (pep_initialize) the PEP handle in the constructor, and release it (pep_destroy) 
  * in the destructor. 
+ * <p>
+ * Many authorizations can be sent at once with pep_authorize_batch(), over a few concurrent
+ * connections instead of one round trip after the other.
+ * <p>
+ * A PEP handle can also send many authorizations without blocking, from one thread:
+ * pep_authorize_async() submits a request and returns, pep_async_perform() and
+ * pep_async_wait() drive all the submitted requests and call their completion
+ * callbacks. The first asynchronous authorization freezes the handle. Instead of
+ * pep_async_wait(), the sockets and the timeout of the asynchronous authorizations can be
+ * watched by the event loop of the application (epoll, libevent, libuv, ...), see
+ * pep_socket_action().
+ * <p>
+ * The PEP handles of the threads can share one TLS session and DNS cache: create a
+ * pep_share_t with pep_share_create() and set it on each handle with the option
+ * {@link #PEP_OPTION_SHARE}. A new handle then resumes the TLS session of another
+ * one instead of doing a full handshake with the PEP daemon.
  * <h4>Application using libcurl</h4>
  * If the application using the PEP client API uses libcurl too, then it is recommended to 
  * bootstrap your application with curl_global_init(CURL_GLOBAL_ALL). The PEP client API uses SSL
@@ -82,7 +100,13 @@ extern "C" {
  * Sets PEP client log levels and log output.
  *
  * By default the log level is {@link #PEP_LOGLEVEL_NONE} and the log output is NULL, therefore,
- * the PEP client doesn't log anything.
+ * the PEP client doesn't log anything. The log options are options of the PEP handle: they
+ * apply to the pep-functions called with this handle, in any thread, including the PIPs, OHs
+ * and callbacks they call, and don't change the logging of the other handles during their calls.
+ * <p>
+ * As up to version 2.3, the log options also set the process-wide logging: the
+ * xacml-functions called directly by the application, outside of a pep-function, log with
+ * the last log options set.
  *
  * See @ref Error for example how to handle error in your code.
  *
@@ -165,6 +189,75 @@ typedef int pep_log_handler_callback(int level, const char * format, va_list arg
  */
 typedef struct pep_handle PEP;
 
+/**
+ * Shared libcurl cache (TLS sessions and DNS) for several PEP handles, possibly
+ * used by different threads. The share is internally locked.
+ *
+ * @see pep_share_create() and the option {@link #PEP_OPTION_SHARE}.
+ */
+typedef struct pep_share pep_share_t;
+
+/**
+ * Completion callback of an asynchronous authorization, called once by pep_async_perform()
+ * (or by pep_destroy() with {@link #PEP_ERR_ASYNC_ABORTED}).
+ *
+ * The callback owns the request and the response, and must delete them. The request is the
+ * @b effective XACML request, as processed by the PEPd. The response is @c NULL if the
+ * authorization failed before a response was received.
+ *
+ * The callback can submit new asynchronous authorizations, but must not call
+ * pep_async_perform(), pep_async_wait() or pep_destroy().
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param request the XACML request.
+ * @param response the XACML response received, or @c NULL.
+ * @param rc {@link #pep_error_t} PEP_OK on success or an error code.
+ * @param userdata the user data given to pep_authorize_async().
+ *
+ * @see pep_authorize_async(pep,request,callback,userdata)
+ */
+typedef void pep_authorize_callback(PEP * pep, xacml_request_t * request, xacml_response_t * response, pep_error_t rc, void * userdata);
+
+/** @name Socket actions
+ * Socket events to watch, for the {@link #pep_socket_callback} (same values as libcurl CURL_POLL_*),
+ * and socket events ready, for pep_socket_action() (same values as libcurl CURL_CSELECT_*).
+ * @{
+ */
+#define PEP_POLL_IN      1 /**< Wait for incoming data */
+#define PEP_POLL_OUT     2 /**< Wait for when writing is possible */
+#define PEP_POLL_INOUT   3 /**< Wait for incoming data and for when writing is possible */
+#define PEP_POLL_REMOVE  4 /**< Stop watching the socket, it is about to be closed */
+#define PEP_EVENT_IN     1 /**< Socket is readable */
+#define PEP_EVENT_OUT    2 /**< Socket is writable */
+#define PEP_EVENT_ERR    4 /**< Socket has an error */
+#define PEP_SOCKET_TIMEOUT -1 /**< pep_socket_action() fd when the timer expired */
+/** @} */
+
+/**
+ * Socket callback of the application event loop: called by the asynchronous engine when
+ * the events to watch on a socket change.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param fd the socket.
+ * @param what {@link #PEP_POLL_IN}, {@link #PEP_POLL_OUT}, {@link #PEP_POLL_INOUT} or {@link #PEP_POLL_REMOVE}.
+ * @param userdata the user data of the option {@link #PEP_OPTION_ASYNC_USERDATA}.
+ * @param socketdata the socket data assigned with pep_socket_assign(), or @c NULL.
+ * @return int 0 or -1 on error.
+ */
+typedef int pep_socket_callback(PEP * pep, int fd, int what, void * userdata, void * socketdata);
+
+/**
+ * Timer callback of the application event loop: called by the asynchronous engine when its
+ * timeout changes. When the timer expires, the event loop calls
+ * pep_socket_action(pep,PEP_SOCKET_TIMEOUT,0,&running).
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param timeout_ms the timeout in milliseconds, 0 to expire as soon as possible, -1 to delete the timer.
+ * @param userdata the user data of the option {@link #PEP_OPTION_ASYNC_USERDATA}.
+ * @return int 0 or -1 on error.
+ */
+typedef int pep_timer_callback(PEP * pep, long timeout_ms, void * userdata);
+
 /**
  * PEP client configuration options.
  *
@@ -184,7 +277,14 @@ typedef enum pep_option {
     PEP_OPTION_ENDPOINT_TIMEOUT, /**< Timeout for the connection to endpoint URL in second (default 30s) */
     PEP_OPTION_ENABLE_PIPS, /**< Enable PIPs pre-processing: 0 or 1 (default 1) */
     PEP_OPTION_ENABLE_OBLIGATIONHANDLERS, /**< Enable OHs post-processing: 0 or 1 (default 1) */
-    PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST /**< PEP client list of ciphers to use for the SSL connection: string */
+    PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST, /**< PEP client list of ciphers to use for the SSL connection: string */
+    PEP_OPTION_BUFFER_SHRINK_SIZE, /**< Maximum size in bytes kept by each transport buffer after an authorization, 0 to keep the high-water mark (default 0) */
+    PEP_OPTION_ENDPOINT_BINARY_BODY, /**< Send and accept raw @c application/x-hessian bodies, fall back to base64 if the PEP daemon rejects it (HTTP 400, 406 or 415): 0 or 1 (default 0) */
+    PEP_OPTION_SHARE, /**< Use the TLS session and DNS caches of a {@link #pep_share_t}, @c NULL to stop sharing (default @c NULL) */
+    PEP_OPTION_ENDPOINT_MAX_CONNECTIONS, /**< Maximum number of connections to the PEP daemon opened by the asynchronous engine and by pep_authorize_batch(), 0 for no limit (default 16) */
+    PEP_OPTION_ASYNC_SOCKET_FUNCTION, /**< Set the {@link #pep_socket_callback} of the application event loop (default @c NULL) */
+    PEP_OPTION_ASYNC_TIMER_FUNCTION, /**< Set the {@link #pep_timer_callback} of the application event loop (default @c NULL) */
+    PEP_OPTION_ASYNC_USERDATA /**< Set the user data given to the socket and timer callbacks (default @c NULL) */
 } pep_option_t;
 
 /**
@@ -221,6 +321,29 @@ pep_error_t pep_global_init(void);
  */
 void pep_global_cleanup(void);
 
+/**
+ * Creates a new shared cache for the PEP handles: the handles using it with the
+ * option {@link #PEP_OPTION_SHARE} resume each other TLS sessions with the PEP
+ * daemon and resolve the endpoint host once. A share can be used by the PEP
+ * handles of several threads. Each handle still keeps its own connection.
+ *
+ * @return the share or NULL on error.
+ */
+pep_share_t * pep_share_create(void);
+
+/**
+ * Releases the shared cache. All the PEP handles using it must be destroyed
+ * (pep_destroy) or stop sharing it before. Otherwise the share is left intact
+ * and {@link #PEP_ERR_SHARE_IN_USE} is returned: release the remaining handles
+ * and call pep_share_delete() again.
+ *
+ * @param share pointer to the {@link #pep_share_t} to release.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success, PEP_ERR_SHARE_IN_USE if still used
+ *         by a PEP handle or PEP_ERR_NULL_POINTER.
+ */
+pep_error_t pep_share_delete(pep_share_t * share);
+
 /**
  * Creates and initializes a new PEP client @b handle. This function must be the first function 
  * to call, and it returns a PEP client handle that you must use as input to other PEP client 
@@ -265,6 +388,18 @@ pep_error_t pep_addpip(PEP * pep, const pep_pip_t * pip);
  */
 pep_error_t pep_addobligationhandler(PEP * pep, const pep_obligationhandler_t * oh);
 
+/**
+ * Freezes the PEP client configuration: the options, PIPs and OHs can't be changed
+ * anymore, and pep_authorize() can then be called simultaneously by several threads
+ * with the same handle. pep_setoption(), pep_addpip() and pep_addobligationhandler()
+ * return {@link #PEP_ERR_HANDLE_FROZEN} after this call.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_freeze(PEP * pep);
+
 /**
  * Sets a PEP client configuration option.
  *
@@ -320,6 +455,36 @@ pep_error_t pep_addobligationhandler(PEP * pep, const pep_obligationhandler_t *
  *   // already enabled by default, only for example purpose
  *   pep_setoption(pep,PEP_OPTION_ENABLE_OBLIGATIONHANDLERS, (int)1);
  * @endcode
+ * Option {@link #PEP_OPTION_BUFFER_SHRINK_SIZE} @c int argument:
+ * @code
+ *   // release transport buffer memory above 64KB after each authorization
+ *   pep_setoption(pep,PEP_OPTION_BUFFER_SHRINK_SIZE, (int)65536);
+ * @endcode
+ * Option {@link #PEP_OPTION_ENDPOINT_BINARY_BODY} @c int argument:
+ * @code
+ *   // POST the Hessian request without base64 encoding (Content-Type: application/x-hessian)
+ *   pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY, (int)1);
+ * @endcode
+ * Option {@link #PEP_OPTION_SHARE} {@link #pep_share_t} @c * argument:
+ * @code
+ *   // one share for the PEP handles of all the threads
+ *   pep_share_t * share= pep_share_create();
+ *   ...
+ *   // in each thread
+ *   pep_setoption(pep,PEP_OPTION_SHARE, (pep_share_t *)share);
+ * @endcode
+ * Option {@link #PEP_OPTION_ENDPOINT_MAX_CONNECTIONS} @c int argument:
+ * @code
+ *   // the asynchronous and batch authorizations share at most 4 connections, the others wait
+ *   pep_setoption(pep,PEP_OPTION_ENDPOINT_MAX_CONNECTIONS, (int)4);
+ * @endcode
+ * Options {@link #PEP_OPTION_ASYNC_SOCKET_FUNCTION}, {@link #PEP_OPTION_ASYNC_TIMER_FUNCTION} and {@link #PEP_OPTION_ASYNC_USERDATA}:
+ * @code
+ *   // the sockets and timer of the asynchronous engine are watched by my event loop
+ *   pep_setoption(pep,PEP_OPTION_ASYNC_SOCKET_FUNCTION, (pep_socket_callback *)my_socket_callback);
+ *   pep_setoption(pep,PEP_OPTION_ASYNC_TIMER_FUNCTION, (pep_timer_callback *)my_timer_callback);
+ *   pep_setoption(pep,PEP_OPTION_ASYNC_USERDATA, (void *)my_loop);
+ * @endcode
  *
  */
 pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
@@ -333,6 +498,8 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
  * the response is received from the PEPd.
  *
  * After the call, the @c request parameter is the @b effective XACML request, as processed by the PEPd.
+ * <p>
+ * Can be called simultaneously by several threads with the same handle once it is frozen (pep_freeze).
  *
  * @param pep pointer to the @b handle of the PEP client.
  * @param request address of the pointer to the {@link #xacml_request_t} to send.
@@ -342,8 +509,148 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
  */
 pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_t ** response);
 
+/**
+ * Sends the n XACML requests to the PEP daemon and returns their XACML responses, like n
+ * pep_authorize() calls but with the requests in flight at the same time: over at most
+ * {@link #PEP_OPTION_ENDPOINT_MAX_CONNECTIONS} concurrent connections, or multiplexed over
+ * one HTTP/2 connection. The connections, and the curl handles and transport buffers of the
+ * concurrent transfers, are kept for the next batch.
+ *
+ * The PIPs are applied to each request before it is sent, and the ObligationHandlers to each
+ * response when it is received. After the call, requests[i] is the @b effective XACML request,
+ * responses[i] the response received (or @c NULL) and errors[i] the result of the request i.
+ * The error of a request doesn't fail the others. The caller deletes the requests and the
+ * responses.
+ * <p>
+ * Can be called simultaneously by several threads with the same handle once it is frozen (pep_freeze).
+ *
+ * Example:
+ * @code
+ *   xacml_request_t * requests[N];
+ *   xacml_response_t * responses[N];
+ *   pep_error_t errors[N];
+ *   ...
+ *   rc= pep_authorize_batch(pep,requests,N,responses,errors);
+ *   for (i= 0; rc == PEP_OK && i < N; i++) {
+ *      if (errors[i] != PEP_OK) {
+ *         fprintf(stderr,"request %d failed: %s\n",i,pep_strerror(errors[i]));
+ *      }
+ *   }
+ * @endcode
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param requests array of the n pointers to the {@link #xacml_request_t} to send.
+ * @param n number of requests.
+ * @param responses array of n pointers, set to the {@link #xacml_response_t} received.
+ * @param errors array of n {@link #pep_error_t}, set to the result of each request.
+ *
+ * @return {@link #pep_error_t} PEP_OK if the batch was processed (see errors for the result
+ *         of each request) or an error code.
+ */
+pep_error_t pep_authorize_batch(PEP * pep, xacml_request_t ** requests, int n, xacml_response_t ** responses, pep_error_t * errors);
+
+/**
+ * Submits the XACML request to the asynchronous engine of the PEP handle and returns
+ * without waiting for the response. The PIPs are applied to the request before it is sent,
+ * the ObligationHandlers are applied to the response when it is received, then the
+ * callback is called with the request and the response by pep_async_perform().
+ *
+ * On success the request is owned by the PEP handle until it is given back to the
+ * callback. The callback is called once, even if the PIPs or the submission fail, and never
+ * before pep_authorize_async() returns.
+ * <p>
+ * The first call freezes the PEP handle (pep_freeze). The asynchronous functions of a handle
+ * must be called by one thread at a time, pep_authorize() can still be called by other threads.
+ *
+ * Example of an event loop:
+ * @code
+ *   int running;
+ *   for (i= 0; i < n; i++) {
+ *      pep_authorize_async(pep,requests[i],my_callback,&my_contexts[i]);
+ *   }
+ *   do {
+ *      pep_async_perform(pep,&running);
+ *      if (running > 0) pep_async_wait(pep,1000);
+ *   } while (running > 0);
+ * @endcode
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param request pointer to the {@link #xacml_request_t} to send.
+ * @param callback the {@link #pep_authorize_callback} completion callback.
+ * @param userdata user data given to the callback.
+ *
+ * @return {@link #pep_error_t} PEP_OK if the request is submitted or an error code, then
+ *         the callback is not called and the request is still owned by the caller.
+ */
+pep_error_t pep_authorize_async(PEP * pep, xacml_request_t * request, pep_authorize_callback * callback, void * userdata);
+
+/**
+ * Transfers the submitted asynchronous authorizations as far as possible without blocking,
+ * and calls the callbacks of the completed ones.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param running if not @c NULL, set to the number of authorizations still in progress.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_async_perform(PEP * pep, int * running);
+
+/**
+ * Waits until a connection of the asynchronous authorizations is ready, or until the
+ * timeout expires. Returns immediately if no authorization is in progress. Call
+ * pep_async_perform() afterwards.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param timeout_ms maximum time to wait in milliseconds.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_async_wait(PEP * pep, int timeout_ms);
+
+/**
+ * Drives the asynchronous authorizations from the event loop of the application, when a
+ * socket is ready or when the timer expired, and calls the callbacks of the completed ones
+ * before returning. The socket and timer callbacks (options {@link #PEP_OPTION_ASYNC_SOCKET_FUNCTION}
+ * and {@link #PEP_OPTION_ASYNC_TIMER_FUNCTION}) must be set before the first pep_authorize_async(),
+ * they tell the event loop which sockets to watch and when the timer expires. No thread
+ * is created by the PEP client.
+ *
+ * Example with libevent:
+ * @code
+ *   void my_event(evutil_socket_t fd, short kind, void * pep) {
+ *      int events= ((kind & EV_READ) ? PEP_EVENT_IN : 0) | ((kind & EV_WRITE) ? PEP_EVENT_OUT : 0);
+ *      pep_socket_action((PEP *)pep,fd,events,NULL);
+ *   }
+ *   void my_timeout(evutil_socket_t fd, short kind, void * pep) {
+ *      pep_socket_action((PEP *)pep,PEP_SOCKET_TIMEOUT,0,NULL);
+ *   }
+ * @endcode
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param fd the ready socket, or {@link #PEP_SOCKET_TIMEOUT} when the timer expired.
+ * @param events the ready socket events: {@link #PEP_EVENT_IN}, {@link #PEP_EVENT_OUT}, {@link #PEP_EVENT_ERR} or 0.
+ * @param running if not @c NULL, set to the number of authorizations still in progress.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_socket_action(PEP * pep, int fd, int events, int * running);
+
+/**
+ * Assigns the application data of a socket (e.g. its event structure), given back to the
+ * {@link #pep_socket_callback} of this socket.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param fd the socket.
+ * @param socketdata the socket data.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_socket_assign(PEP * pep, int fd, void * socketdata);
+
 /**
  * Cleanups and destroys the PEP client. Any uses of the @b handle after this function has been called are illegal. 
+ * The asynchronous authorizations still in progress are aborted, their callback is called
+ * with {@link #PEP_ERR_ASYNC_ABORTED}.
  *
  * @param pep pointer to the @b handle of the PEP client.
  *
@@ -113,7 +113,8 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
         for(j= 0; j<subject_attrs_l; j++) {
             xacml_attribute_t * attr= xacml_subject_getattribute(subject,j);
             const char * attr_id= xacml_attribute_getid(attr);
-            if (strncmp(XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN,attr_id,strlen(XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN)) == 0) {
+            xacml_atom_t attr_atom= xacml_attribute_getatom(attr);
+            if (attr_atom == XACML_ATOM_AUTHZINTEROP_SUBJECT_CERTCHAIN) {
                 xacml_attribute_t * keyinfo= xacml_attribute_clone(attr);
                 pep_log_debug("%s: clone subject[%d].attribute[%d].id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID, i,j,attr_id);
                 if (keyinfo!=NULL) {
@@ -130,7 +131,7 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
                     pep_log_warn("%s: failed to clone subject[%d].attribute[%d]",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID, i,j);
                 }
             }
-            else if (strncmp(XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN,attr_id,strlen(XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN))==0) {
+            else if (attr_atom == XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN) {
                 xacml_attribute_t * fqan_primary= xacml_attribute_clone(attr);
                 pep_log_debug("%s: clone subject[%d].attribute[%d].id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID, i,j,attr_id);
                 if (fqan_primary!=NULL) {
@@ -147,7 +148,7 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
                     pep_log_warn("%s: failed to clone subject[%d].attribute[%d]",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID, i,j);
                 }
             }
-            else if (strncmp(XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN,attr_id,strlen(XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN))==0) {
+            else if (attr_atom == XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_FQAN) {
                 xacml_attribute_t * fqans= xacml_attribute_clone(attr);
                 pep_log_debug("%s: clone subject[%d].attribute[%d].id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID, i,j,attr_id);
                 if (fqans!=NULL) {
@@ -183,7 +184,8 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
     for (i= 0; i<environment_attrs_l; i++) {
         xacml_attribute_t * attr= xacml_environment_getattribute(environment,i);
         const char * attr_id= xacml_attribute_getid(attr);
-        if (strncmp(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID,attr_id,strlen(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID))==0) {
+        xacml_atom_t attr_atom= xacml_attribute_getatom(attr);
+        if (attr_atom == XACML_ATOM_GRIDWN_ATTRIBUTE_PROFILE_ID) {
             pep_log_debug("%s: found environment.attribute[%d].id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID,i,attr_id);
             profile_id_present= 1;
         }
@@ -228,9 +230,9 @@ static int gridwn2authzinterop_oh_process(xacml_request_t ** request,xacml_respo
             size_t obligations_l= xacml_result_obligations_length(result);
             for (j= 0; j<obligations_l; j++) {
                 xacml_obligation_t * obligation= xacml_result_getobligation(result,j);
-                const char * obligation_id= xacml_obligation_getid(obligation);
+                xacml_atom_t obligation_atom= xacml_obligation_getatom(obligation);
                 xacml_fulfillon_t obligation_fulfillon= xacml_obligation_getfulfillon(obligation);
-                if (strncmp(XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX,obligation_id,strlen(XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX))==0) {
+                if (obligation_atom == XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX) {
                     /* do local POSIX resolve for uid/gids */
                     const char * username= NULL;
                     const char * groupname= NULL;
@@ -240,15 +242,15 @@ static int gridwn2authzinterop_oh_process(xacml_request_t ** request,xacml_respo
                     pep_log_debug("%s: resolve local POSIX account mapping",GRIDWN_TO_AUTHZINTEROP_ADAPTER_ID);
                     for (k= 0; k<attrs_l; k++) {
                         xacml_attributeassignment_t * attr= xacml_obligation_getattributeassignment(obligation,k);
-                        const char * attr_id= xacml_attributeassignment_getid(attr);
+                        xacml_atom_t attr_atom= xacml_attributeassignment_getatom(attr);
                         const char * attr_value= xacml_attributeassignment_getvalue(attr);
-                        if (strcmp(XACML_GRIDWN_ATTRIBUTE_USER_ID,attr_id)==0) {
+                        if (attr_atom == XACML_ATOM_GRIDWN_ATTRIBUTE_USER_ID) {
                             username= attr_value;
                         }
-                        else if (strcmp(XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY,attr_id)==0) {
+                        else if (attr_atom == XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY) {
                             groupname= attr_value;
                         }
-                        else if (strcmp(XACML_GRIDWN_ATTRIBUTE_GROUP_ID,attr_id)==0) {
+                        else if (attr_atom == XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID) {
                             groupnames[n_groupnames++]= (char *)attr_value;
                         }
                     }
@@ -161,6 +161,72 @@ static const char XACML_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN[]= "http://authz-
 /** @} */
 
 
+/**
+ * Atoms of the XACML profiles identifiers, see @ref Atom. The deprecated
+ * identifiers share the atom of their replacement.
+ */
+enum xacml_profiles_atoms {
+    XACML_ATOM_COMMONAUTHZ_PROFILE_1_1= XACML_ATOM_XACML_LAST, /**< #XACML_COMMONAUTHZ_PROFILE_1_1 */
+    XACML_ATOM_DCISEC_ATTRIBUTE_PROFILE_ID, /**< #XACML_DCISEC_ATTRIBUTE_PROFILE_ID */
+    XACML_ATOM_DCISEC_ATTRIBUTE_SUBJECT_ISSUER, /**< #XACML_DCISEC_ATTRIBUTE_SUBJECT_ISSUER */
+    XACML_ATOM_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION, /**< #XACML_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION */
+    XACML_ATOM_DCISEC_ATTRIBUTE_GROUP, /**< #XACML_DCISEC_ATTRIBUTE_GROUP */
+    XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_PRIMARY, /**< #XACML_DCISEC_ATTRIBUTE_GROUP_PRIMARY */
+    XACML_ATOM_DCISEC_ATTRIBUTE_ROLE, /**< #XACML_DCISEC_ATTRIBUTE_ROLE */
+    XACML_ATOM_DCISEC_ATTRIBUTE_ROLE_PRIMARY, /**< #XACML_DCISEC_ATTRIBUTE_ROLE_PRIMARY */
+    XACML_ATOM_DCISEC_ATTRIBUTE_RESOURCE_OWNER, /**< #XACML_DCISEC_ATTRIBUTE_RESOURCE_OWNER */
+    XACML_ATOM_DCISEC_ACTION_NAMESPACE, /**< #XACML_DCISEC_ACTION_NAMESPACE */
+    XACML_ATOM_DCISEC_ACTION_ANY, /**< #XACML_DCISEC_ACTION_ANY */
+    XACML_ATOM_DCISEC_OBLIGATION_MAP_LOCAL_USER, /**< #XACML_DCISEC_OBLIGATION_MAP_LOCAL_USER */
+    XACML_ATOM_DCISEC_OBLIGATION_MAP_POSIX_USER, /**< #XACML_DCISEC_OBLIGATION_MAP_POSIX_USER */
+    XACML_ATOM_DCISEC_ATTRIBUTE_USER_ID, /**< #XACML_DCISEC_ATTRIBUTE_USER_ID */
+    XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID, /**< #XACML_DCISEC_ATTRIBUTE_GROUP_ID */
+    XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY, /**< #XACML_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY */
+    XACML_ATOM_GRIDWN_PROFILE_VERSION, /**< #XACML_GRIDWN_PROFILE_VERSION */
+    XACML_ATOM_GLITE_ATTRIBUTE_PROFILE_ID, /**< #XACML_GLITE_ATTRIBUTE_PROFILE_ID */
+    XACML_ATOM_GLITE_ATTRIBUTE_SUBJECT_ISSUER, /**< #XACML_GLITE_ATTRIBUTE_SUBJECT_ISSUER */
+    XACML_ATOM_GLITE_ATTRIBUTE_VOMS_ISSUER, /**< #XACML_GLITE_ATTRIBUTE_VOMS_ISSUER */
+    XACML_ATOM_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION, /**< #XACML_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION */
+    XACML_ATOM_GLITE_ATTRIBUTE_FQAN, /**< #XACML_GLITE_ATTRIBUTE_FQAN */
+    XACML_ATOM_GLITE_ATTRIBUTE_FQAN_PRIMARY, /**< #XACML_GLITE_ATTRIBUTE_FQAN_PRIMARY */
+    XACML_ATOM_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER, /**< #XACML_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER */
+    XACML_ATOM_GLITE_ATTRIBUTE_USER_ID, /**< #XACML_GLITE_ATTRIBUTE_USER_ID */
+    XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID, /**< #XACML_GLITE_ATTRIBUTE_GROUP_ID */
+    XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY, /**< #XACML_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY */
+    XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP, /**< #XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP */
+    XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX, /**< #XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX */
+    XACML_ATOM_GLITE_DATATYPE_FQAN, /**< #XACML_GLITE_DATATYPE_FQAN */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ID, /**< #XACML_AUTHZINTEROP_SUBJECT_X509_ID */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ISSUER, /**< #XACML_AUTHZINTEROP_SUBJECT_X509_ISSUER */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_VO, /**< #XACML_AUTHZINTEROP_SUBJECT_VO */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_CERTCHAIN, /**< #XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_FQAN, /**< #XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN */
+    XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN, /**< #XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_UIDGID, /**< #XACML_AUTHZINTEROP_OBLIGATION_UIDGID */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS, /**< #XACML_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_USERNAME, /**< #XACML_AUTHZINTEROP_OBLIGATION_USERNAME */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_AFS_TOKEN, /**< #XACML_AUTHZINTEROP_OBLIGATION_AFS_TOKEN */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID, /**< #XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID, /**< #XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME, /**< #XACML_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME */
+    XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN, /**< #XACML_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN */
+    XACML_ATOM_PROFILES_LAST, /**< first atom available for the user registered identifiers */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_PROFILE_ID= XACML_ATOM_GLITE_ATTRIBUTE_PROFILE_ID, /**< #XACML_GRIDWN_ATTRIBUTE_PROFILE_ID (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER= XACML_ATOM_GLITE_ATTRIBUTE_SUBJECT_ISSUER, /**< #XACML_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION= XACML_ATOM_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION, /**< #XACML_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_FQAN= XACML_ATOM_GLITE_ATTRIBUTE_FQAN, /**< #XACML_GRIDWN_ATTRIBUTE_FQAN (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_FQAN_PRIMARY= XACML_ATOM_GLITE_ATTRIBUTE_FQAN_PRIMARY, /**< #XACML_GRIDWN_ATTRIBUTE_FQAN_PRIMARY (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_PILOT_JOB_CLASSIFIER= XACML_ATOM_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER, /**< #XACML_GRIDWN_ATTRIBUTE_PILOT_JOB_CLASSIFIER (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_VOMS_ISSUER= XACML_ATOM_GLITE_ATTRIBUTE_VOMS_ISSUER, /**< #XACML_GRIDWN_ATTRIBUTE_VOMS_ISSUER (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_USER_ID= XACML_ATOM_GLITE_ATTRIBUTE_USER_ID, /**< #XACML_GRIDWN_ATTRIBUTE_USER_ID (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID= XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID, /**< #XACML_GRIDWN_ATTRIBUTE_GROUP_ID (same identifier) */
+    XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY= XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY, /**< #XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY (same identifier) */
+    XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP= XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP, /**< #XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP (same identifier) */
+    XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX= XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX, /**< #XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX (same identifier) */
+    XACML_ATOM_GRIDWN_DATATYPE_FQAN= XACML_ATOM_GLITE_DATATYPE_FQAN /**< #XACML_GRIDWN_DATATYPE_FQAN (same identifier) */
+};
+
+
 /** @defgroup ProfilesAdapters PIP and Obligation Handler Profile Adapters
  *  @ingroup Profiles
  *
@@ -18,38 +18,45 @@
 #include <stdlib.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_request {
-    pep_linkedlist_t * subjects;
-    pep_linkedlist_t * resources;
+    pep_vector_t * subjects;
+    pep_vector_t * resources;
     xacml_action_t * action;
     xacml_environment_t * environment;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
+    xacml_arena_owner_t * owner; /* own arena, or NULL */
 };
 
 /**
  * Creates an empty PEP request.
  */
 xacml_request_t * xacml_request_create() {
-    xacml_request_t * request= calloc(1,sizeof(struct xacml_request));
+    return xacml_request_create_in(NULL);
+}
+
+xacml_request_t * xacml_request_create_in(xacml_arena_t * arena) {
+    xacml_request_t * request= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_request));
     if (request == NULL) {
         pep_log_error("xacml_request_create: can't allocate xacml_request_t.");
         return NULL;
     }
-    request->subjects= pep_llist_create();
+    request->arena= XACML_ARENA(arena);
+    request->subjects= xacml_vector_create(request->arena);
     if (request->subjects == NULL) {
         pep_log_error("xacml_request_create: can't create subjects list.");
-        free(request);
+        xacml_free(request->arena,request);
         return NULL;
     }
-    request->resources= pep_llist_create();
+    request->resources= xacml_vector_create(request->arena);
     if (request->resources == NULL) {
         pep_log_error("xacml_request_create: can't create resources list.");
-        pep_llist_delete(request->subjects);
-        free(request);
+        pep_vector_delete(request->subjects);
+        xacml_free(request->arena,request);
         return NULL;
     }
     request->action= NULL;
@@ -62,7 +69,7 @@ int xacml_request_addsubject(xacml_request_t * request, xacml_subject_t * subjec
         pep_log_error("xacml_request_addsubject: NULL request or subject.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(request->subjects,subject) != LLIST_OK) {
+    if (pep_vector_add(request->subjects,subject) != VECTOR_OK) {
         pep_log_error("xacml_request_addsubject: can't add subject to list.");
         return PEP_XACML_ERROR;
     }
@@ -74,7 +81,7 @@ size_t xacml_request_subjects_length(const xacml_request_t * request) {
         pep_log_warn("xacml_request_subjects_length: NULL request.");
         return 0;
     }
-    return pep_llist_length(request->subjects);
+    return pep_vector_length(request->subjects);
 }
 
 xacml_subject_t * xacml_request_getsubject(const xacml_request_t * request, int index) {
@@ -82,7 +89,7 @@ xacml_subject_t * xacml_request_getsubject(const xacml_request_t * request, int
         pep_log_error("xacml_request_getsubject: NULL request.");
         return NULL;
     }
-    return pep_llist_get(request->subjects,index);
+    return pep_vector_get(request->subjects,index);
 }
 
 int xacml_request_addresource(xacml_request_t * request, xacml_resource_t * resource) {
@@ -90,7 +97,7 @@ int xacml_request_addresource(xacml_request_t * request, xacml_resource_t * reso
         pep_log_error("xacml_request_addresource: NULL request or resource.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(request->resources,resource) != LLIST_OK) {
+    if (pep_vector_add(request->resources,resource) != VECTOR_OK) {
         pep_log_error("xacml_request_addresource: can't add resource to list.");
         return PEP_XACML_ERROR;
     }
@@ -102,7 +109,7 @@ size_t xacml_request_resources_length(const xacml_request_t * request) {
         pep_log_warn("xacml_request_resources_length: NULL request.");
         return 0;
     }
-    return pep_llist_length(request->resources);
+    return pep_vector_length(request->resources);
 }
 
 xacml_resource_t * xacml_request_getresource(const xacml_request_t * request, int index) {
@@ -110,7 +117,7 @@ xacml_resource_t * xacml_request_getresource(const xacml_request_t * request, in
         pep_log_error("xacml_request_getresource: NULL request.");
         return NULL;
     }
-    return pep_llist_get(request->resources,index);
+    return pep_vector_get(request->resources,index);
 }
 
 int xacml_request_setaction(xacml_request_t * request, xacml_action_t * action) {
@@ -154,13 +161,24 @@ xacml_environment_t * xacml_request_getenvironment(const xacml_request_t * reque
  */
 void xacml_request_delete(xacml_request_t * request) {
     if (request == NULL) return;
-    pep_llist_delete_elements(request->subjects,(pep_llist_delete_elt_f)xacml_subject_delete);
-    pep_llist_delete(request->subjects);
-    pep_llist_delete_elements(request->resources,(pep_llist_delete_elt_f)xacml_resource_delete);
-    pep_llist_delete(request->resources);
+    pep_vector_delete_elements(request->subjects,(pep_vector_delete_elt_f)xacml_subject_delete);
+    pep_vector_delete_elements(request->resources,(pep_vector_delete_elt_f)xacml_resource_delete);
     if (request->action != NULL) xacml_action_delete(request->action);
     if (request->environment != NULL) xacml_environment_delete(request->environment);
+    /* released with the arena */
+    if (request->arena != NULL) {
+        xacml_arena_owner_release(request->owner);
+        return;
+    }
+    pep_vector_delete(request->subjects);
+    pep_vector_delete(request->resources);
     free(request);
     request= NULL;
 }
 
+void xacml_request_setowner(xacml_request_t * request, xacml_arena_owner_t * owner) {
+    if (request == NULL || request->arena != owner->arena || request->owner != NULL) return;
+    xacml_arena_owner_acquire(owner);
+    request->owner= owner;
+}
+
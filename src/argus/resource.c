@@ -19,26 +19,32 @@
 #include <string.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_resource {
     char * content;
-    pep_linkedlist_t * attributes;
+    pep_vector_t * attributes;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 xacml_resource_t * xacml_resource_create() {
-    xacml_resource_t * resource= calloc(1,sizeof(struct xacml_resource));
+    return xacml_resource_create_in(NULL);
+}
+
+xacml_resource_t * xacml_resource_create_in(xacml_arena_t * arena) {
+    xacml_resource_t * resource= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_resource));
     if (resource == NULL) {
         pep_log_error("xacml_resource_create: can't allocate xacml_resource_t.");
         return NULL;
     }
-    resource->attributes= pep_llist_create();
+    resource->arena= XACML_ARENA(arena);
+    resource->attributes= xacml_vector_create(resource->arena);
     if (resource->attributes == NULL) {
         pep_log_error("xacml_resource_create: can't allocate attributes list.");
-        free(resource);
+        xacml_free(resource->arena,resource);
         return NULL;
     }
     resource->content= NULL;
@@ -50,7 +56,7 @@ int xacml_resource_addattribute(xacml_resource_t * resource, xacml_attribute_t *
         pep_log_error("xacml_resource_addattribute: NULL resource or attribute.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(resource->attributes,attr) != LLIST_OK) {
+    if (pep_vector_add(resource->attributes,attr) != VECTOR_OK) {
         pep_log_error("xacml_resource_addattribute: can't add attribute to list.");
         return PEP_XACML_ERROR;
     }
@@ -62,7 +68,7 @@ size_t xacml_resource_attributes_length(const xacml_resource_t * resource) {
         pep_log_warn("xacml_resource_attributes_length: NULL resource.");
         return 0;
     }
-    return pep_llist_length(resource->attributes);
+    return pep_vector_length(resource->attributes);
 }
 
 xacml_attribute_t * xacml_resource_getattribute(const xacml_resource_t * resource, int index) {
@@ -70,7 +76,7 @@ xacml_attribute_t * xacml_resource_getattribute(const xacml_resource_t * resourc
         pep_log_error("xacml_resource_getattribute: NULL resource.");
         return NULL;
     }
-    return pep_llist_get(resource->attributes, index);
+    return pep_vector_get(resource->attributes, index);
 }
 
 /* if content is NULL, delete existing */
@@ -80,11 +86,11 @@ int xacml_resource_setcontent(xacml_resource_t * resource, const char * content)
         return PEP_XACML_ERROR;
     }
     if (resource->content != NULL) {
-        free(resource->content);
+        xacml_free(resource->arena,resource->content);
     }
     if (content != NULL) {
         size_t size= strlen(content);
-        resource->content= calloc(size + 1, sizeof(char));
+        resource->content= xacml_calloc(resource->arena,size + 1);
         if (resource->content == NULL) {
             pep_log_error("xacml_resource_setcontent: can't allocate content (%d bytes).", (int)size);
             return PEP_XACML_ERROR;
@@ -104,8 +110,10 @@ const char * xacml_resource_getcontent(const xacml_resource_t * resource) {
 
 void xacml_resource_delete(xacml_resource_t * resource) {
     if (resource == NULL) return;
-    pep_llist_delete_elements(resource->attributes,(pep_llist_delete_elt_f)xacml_attribute_delete);
-    pep_llist_delete(resource->attributes);
+    pep_vector_delete_elements(resource->attributes,(pep_vector_delete_elt_f)xacml_attribute_delete);
+    /* released with the arena */
+    if (resource->arena != NULL) return;
+    pep_vector_delete(resource->attributes);
     if (resource->content != NULL) free(resource->content);
     free(resource);
     resource= NULL;
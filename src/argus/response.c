@@ -19,32 +19,60 @@
 #include <string.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_response {
     xacml_request_t * request; /* original request */
-    pep_linkedlist_t * results; /* list of results */
+    pep_vector_t * results; /* list of results */
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
+    xacml_arena_owner_t * owner; /* own arena, or NULL */
 };
 
 xacml_response_t * xacml_response_create() {
-    xacml_response_t * response= calloc(1,sizeof(struct xacml_response));
+    return xacml_response_create_in(NULL);
+}
+
+xacml_response_t * xacml_response_create_in(xacml_arena_t * arena) {
+    xacml_response_t * response= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_response));
     if (response == NULL) {
         pep_log_error("xacml_response_create: can't allocate xacml_response_t.");
         return NULL;
     }
-    response->results= pep_llist_create();
+    response->arena= XACML_ARENA(arena);
+    response->results= xacml_vector_create(response->arena);
     if (response->results == NULL) {
         pep_log_error("xacml_response_create: can't create results list.");
-        free(response);
+        xacml_free(response->arena,response);
         return NULL;
     }
     response->request= NULL;
     return response;
 }
 
+xacml_response_t * xacml_response_create_owned(size_t block_size) {
+    xacml_response_t * response;
+    xacml_arena_owner_t * owner= xacml_arena_owner_create(block_size);
+    if (owner == NULL) {
+        pep_log_error("xacml_response_create_owned: can't create arena.");
+        return NULL;
+    }
+    response= xacml_response_create_in((xacml_arena_t *)owner->arena);
+    if (response == NULL) {
+        xacml_arena_owner_release(owner);
+        return NULL;
+    }
+    response->owner= owner;
+    return response;
+}
+
+xacml_arena_t * xacml_response_getarena(const xacml_response_t * response) {
+    if (response == NULL) return NULL;
+    return (xacml_arena_t *)response->arena;
+}
+
 int xacml_response_setrequest(xacml_response_t * response, xacml_request_t * request) {
     if (response == NULL || request == NULL) {
         pep_log_error("xacml_response_setrequest: NULL response or request.");
@@ -72,6 +100,10 @@ xacml_request_t * xacml_response_relinquishrequest(xacml_response_t * response)
     /* forget about the request, caller is responsible to call xacml_delete_request */
     request= response->request;
     response->request= NULL;
+    /* the request keeps the own arena of the response */
+    if (request != NULL && response->owner != NULL) {
+        xacml_request_setowner(request,response->owner);
+    }
     return request;
 }
 
@@ -81,7 +113,7 @@ int xacml_response_addresult(xacml_response_t * response, xacml_result_t * resul
         pep_log_error("xacml_response_addresult: NULL response or result.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(response->results,result) != LLIST_OK) {
+    if (pep_vector_add(response->results,result) != VECTOR_OK) {
         pep_log_error("xacml_response_addresult: can't add result to list.");
         return PEP_XACML_ERROR;
     }
@@ -93,7 +125,7 @@ size_t xacml_response_results_length(const xacml_response_t * response) {
         pep_log_warn("xacml_response_results_length: NULL response.");
         return 0;
     }
-    return pep_llist_length(response->results);
+    return pep_vector_length(response->results);
 }
 
 xacml_result_t * xacml_response_getresult(const xacml_response_t * response, int index) {
@@ -101,14 +133,19 @@ xacml_result_t * xacml_response_getresult(const xacml_response_t * response, int
         pep_log_error("xacml_response_getresult: NULL response.");
         return NULL;
     }
-    return pep_llist_get(response->results,index);
+    return pep_vector_get(response->results,index);
 }
 
 void xacml_response_delete(xacml_response_t * response) {
     if (response == NULL) return;
     if (response->request != NULL) xacml_request_delete(response->request);
-    pep_llist_delete_elements(response->results,(pep_llist_delete_elt_f)xacml_result_delete);
-    pep_llist_delete(response->results);
+    pep_vector_delete_elements(response->results,(pep_vector_delete_elt_f)xacml_result_delete);
+    /* released with the arena */
+    if (response->arena != NULL) {
+        xacml_arena_owner_release(response->owner);
+        return;
+    }
+    pep_vector_delete(response->results);
     free(response);
     response= NULL;
 }
@@ -19,28 +19,34 @@
 #include <string.h>
 
 /* from ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_result {
     char * resourceid;
     xacml_decision_t decision;
     xacml_status_t * status;
-    pep_linkedlist_t * obligations; /* */
+    pep_vector_t * obligations; /* */
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 xacml_result_t * xacml_result_create() {
-    xacml_result_t * result= calloc(1,sizeof(struct xacml_result));
+    return xacml_result_create_in(NULL);
+}
+
+xacml_result_t * xacml_result_create_in(xacml_arena_t * arena) {
+    xacml_result_t * result= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_result));
     if (result == NULL) {
         pep_log_error("xacml_result_create: can't allocate xacml_result_t.");
         return NULL;
     }
-    result->obligations= pep_llist_create();
+    result->arena= XACML_ARENA(arena);
+    result->obligations= xacml_vector_create(result->arena);
     if (result->obligations == NULL) {
         pep_log_error("xacml_result_create: can't allocate obligations list.");
-        free(result);
+        xacml_free(result->arena,result);
         return NULL;
     }
     result->decision= XACML_DECISION_DENY;
@@ -91,12 +97,12 @@ int xacml_result_setresourceid(xacml_result_t * result, const char * resourceid)
         return PEP_XACML_ERROR;
     }
     if (result->resourceid != NULL) {
-        free(result->resourceid);
+        xacml_free(result->arena,result->resourceid);
         result->resourceid= NULL;
     }
     if (resourceid != NULL) {
         size_t size= strlen(resourceid);
-        result->resourceid= calloc(size + 1, sizeof(char));
+        result->resourceid= xacml_calloc(result->arena,size + 1);
         if (result->resourceid == NULL) {
             pep_log_error("xacml_result_setresourceid: can't allocate resourceid (%d bytes).",(int)size);
             return PEP_XACML_ERROR;
@@ -129,7 +135,7 @@ int xacml_result_addobligation(xacml_result_t * result, xacml_obligation_t * obl
         pep_log_error("xacml_result_addobligation: NULL result or obligation.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(result->obligations,obligation) != LLIST_OK) {
+    if (pep_vector_add(result->obligations,obligation) != VECTOR_OK) {
         pep_log_error("xacml_result_addobligation: can't add obligation to list.");
         return PEP_XACML_ERROR;
     }
@@ -141,7 +147,7 @@ size_t xacml_result_obligations_length(const xacml_result_t * result) {
         pep_log_warn("xacml_result_obligations_length: NULL result.");
         return 0;
     }
-    return pep_llist_length(result->obligations);
+    return pep_vector_length(result->obligations);
 }
 
 xacml_obligation_t * xacml_result_getobligation(const xacml_result_t * result, int i) {
@@ -149,7 +155,7 @@ xacml_obligation_t * xacml_result_getobligation(const xacml_result_t * result, i
         pep_log_error("xacml_result_getobligation: NULL result.");
         return NULL;
     }
-    return pep_llist_get(result->obligations,i);
+    return pep_vector_get(result->obligations,i);
 }
 
 int xacml_result_removeobligation(xacml_result_t * result, int i) {
@@ -158,7 +164,7 @@ int xacml_result_removeobligation(xacml_result_t * result, int i) {
         pep_log_error("xacml_result_removeobligation: NULL result.");
         return PEP_XACML_ERROR;
     }
-    obligation = pep_llist_remove(result->obligations,i);
+    obligation = pep_vector_remove(result->obligations,i);
     if (obligation == NULL) {
         pep_log_error("xacml_result_removeobligation: failed to remove obligation from list.");
         return PEP_XACML_ERROR;
@@ -170,10 +176,12 @@ int xacml_result_removeobligation(xacml_result_t * result, int i) {
 
 void xacml_result_delete(xacml_result_t * result) {
     if (result == NULL) return;
-    if (result->resourceid != NULL) free(result->resourceid);
     if (result->status != NULL) xacml_status_delete(result->status);
-    pep_llist_delete_elements(result->obligations,(pep_llist_delete_elt_f)xacml_obligation_delete);
-    pep_llist_delete(result->obligations);
+    pep_vector_delete_elements(result->obligations,(pep_vector_delete_elt_f)xacml_obligation_delete);
+    /* released with the arena */
+    if (result->arena != NULL) return;
+    if (result->resourceid != NULL) free(result->resourceid);
+    pep_vector_delete(result->obligations);
     free(result);
     result= NULL;
 }
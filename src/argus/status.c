@@ -21,7 +21,7 @@
 /* from ../util */
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 /************************************************************
  * PEP Status functions
@@ -29,22 +29,28 @@
 struct xacml_status {
     char * message;
     xacml_statuscode_t * code;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 /* message can be null */
 xacml_status_t * xacml_status_create(const char * message) {
-    xacml_status_t * status= calloc(1,sizeof(struct xacml_status));
+    return xacml_status_create_in(message,NULL);
+}
+
+xacml_status_t * xacml_status_create_in(const char * message, xacml_arena_t * arena) {
+    xacml_status_t * status= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_status));
     if (status == NULL) {
         pep_log_error("xacml_status_create: can't allocate xacml_status_t.");
         return NULL;
     }
+    status->arena= XACML_ARENA(arena);
     status->message= NULL;
     if (message != NULL) {
         size_t size= strlen(message);
-        status->message= calloc(size + 1,sizeof(char));
+        status->message= xacml_calloc(status->arena,size + 1);
         if (status->message == NULL) {
             pep_log_error("xacml_status_create: can't allocate message (%d bytes).",(int)size);
-            free(status);
+            xacml_free(status->arena,status);
             return NULL;
         }
         strncpy(status->message,message,size);
@@ -64,9 +70,9 @@ int xacml_status_setmessage(xacml_status_t * status, const char * message) {
         pep_log_error("xacml_status_setmessage: NULL message.");
         return PEP_XACML_ERROR;
     }
-    if (status->message != NULL) free(status->message);
+    if (status->message != NULL) xacml_free(status->arena,status->message);
     size= strlen(message);
-    status->message= calloc(size + 1,sizeof(char));
+    status->message= xacml_calloc(status->arena,size + 1);
     if (status->message == NULL) {
         pep_log_error("xacml_status_setmessage: can't allocate message (%d bytes).",(int)size);
         return PEP_XACML_ERROR;
@@ -106,10 +112,12 @@ xacml_statuscode_t * xacml_status_getcode(const xacml_status_t * status) {
 
 void xacml_status_delete(xacml_status_t * status) {
     if (status == NULL) return;
-    if (status->message != NULL) free(status->message);
     if (status->code != NULL) {
         xacml_statuscode_delete(status->code);
     }
+    /* released with the arena */
+    if (status->arena != NULL) return;
+    if (status->message != NULL) free(status->message);
     free(status);
     status= NULL;
 }
@@ -120,22 +128,28 @@ void xacml_status_delete(xacml_status_t * status) {
 struct xacml_statuscode {
     char * value;
     struct xacml_statuscode * subcode;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 /* value can be NULL, not recommended */
 xacml_statuscode_t * xacml_statuscode_create(const char * value) {
-    xacml_statuscode_t * status_code= calloc(1,sizeof(struct xacml_statuscode));
+    return xacml_statuscode_create_in(value,NULL);
+}
+
+xacml_statuscode_t * xacml_statuscode_create_in(const char * value, xacml_arena_t * arena) {
+    xacml_statuscode_t * status_code= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_statuscode));
     if (status_code == NULL) {
         pep_log_error("xacml_statuscode_create: can't allocate xacml_statuscode_t.");
         return NULL;
     }
+    status_code->arena= XACML_ARENA(arena);
     status_code->value= NULL;
     if (value != NULL) {
         size_t size= strlen(value);
-        status_code->value= calloc(size + 1,sizeof(char));
+        status_code->value= xacml_calloc(status_code->arena,size + 1);
         if (status_code->value == NULL) {
             pep_log_error("xacml_statuscode_create: can't allocate value (%d bytes).",(int)size);
-            free(status_code);
+            xacml_free(status_code->arena,status_code);
             return NULL;
         }
         strncpy(status_code->value,value,size);
@@ -155,9 +169,9 @@ int xacml_statuscode_setvalue(xacml_statuscode_t * status_code, const char * val
         pep_log_error("xacml_statuscode_setcode: NULL value string.");
         return PEP_XACML_ERROR;
     }
-    if (status_code->value != NULL) free(status_code->value);
+    if (status_code->value != NULL) xacml_free(status_code->arena,status_code->value);
     size= strlen(value);
-    status_code->value= calloc(size + 1,sizeof(char));
+    status_code->value= xacml_calloc(status_code->arena,size + 1);
     if (status_code->value == NULL) {
         pep_log_error("xacml_statuscode_setcode: can't allocate value (%d bytes).",(int)size);
         return PEP_XACML_ERROR;
@@ -197,10 +211,12 @@ xacml_statuscode_t * xacml_statuscode_getsubcode(const xacml_statuscode_t * stat
 
 void xacml_statuscode_delete(xacml_statuscode_t * status_code) {
     if (status_code == NULL) return;
-    if (status_code->value != NULL) free(status_code->value);
     if (status_code->subcode != NULL) {
         xacml_statuscode_delete(status_code->subcode);
     }
+    /* released with the arena */
+    if (status_code->arena != NULL) return;
+    if (status_code->value != NULL) free(status_code->value);
     free(status_code);
     status_code= NULL;
 }
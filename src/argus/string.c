@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "i_xacml.h"
+
+/************************************************************
+ * XACML length-carrying string functions
+ */
+
+int xacml_string_set(hessian_arena_t * arena, xacml_string_t * string, const char * bytes, size_t length) {
+    char * copy= NULL;
+    if (bytes != NULL) {
+        copy= xacml_calloc(arena,length + 1);
+        if (copy == NULL) return PEP_XACML_ERROR;
+        memcpy(copy,bytes,length);
+    }
+    xacml_string_clear(arena,string);
+    string->string= copy;
+    string->length= (copy != NULL) ? length : 0;
+    string->utf8_length= XACML_UTF8_UNKNOWN;
+    return PEP_XACML_OK;
+}
+
+void xacml_string_clear(hessian_arena_t * arena, xacml_string_t * string) {
+    if (string->string != NULL) xacml_free(arena,(char *)string->string);
+    string->string= NULL;
+    string->length= 0;
+    string->utf8_length= XACML_UTF8_UNKNOWN;
+}
+
+xacml_string_t * xacml_string_create(hessian_arena_t * arena, const char * bytes, size_t length) {
+    /* the bytes follow the descriptor */
+    xacml_string_t * string= xacml_calloc(arena,sizeof(xacml_string_t) + length + 1);
+    char * copy;
+    if (string == NULL) return NULL;
+    copy= (char *)(string + 1);
+    memcpy(copy,bytes,length);
+    string->string= copy;
+    string->length= length;
+    string->utf8_length= XACML_UTF8_UNKNOWN;
+    return string;
+}
+
+size_t xacml_string_utf8_length(const xacml_string_t * string) {
+    if (string->utf8_length == XACML_UTF8_UNKNOWN) {
+        /* cached in the const string */
+        ((xacml_string_t *)string)->utf8_length= hessian_utf8_count(string->string,string->length);
+    }
+    return string->utf8_length;
+}
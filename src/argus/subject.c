@@ -19,26 +19,32 @@
 #include <string.h>
 
 /* form ../util */
-#include "linkedlist.h"
+#include "vector.h"
 #include "log.h"
 
-#include "xacml.h"
+#include "i_xacml.h"
 
 struct xacml_subject {
     char * category;
-    pep_linkedlist_t * attributes;
+    pep_vector_t * attributes;
+    hessian_arena_t * arena; /* NULL: allocated from the heap */
 };
 
 xacml_subject_t * xacml_subject_create() {
-    xacml_subject_t * subject= calloc(1,sizeof(struct xacml_subject));
+    return xacml_subject_create_in(NULL);
+}
+
+xacml_subject_t * xacml_subject_create_in(xacml_arena_t * arena) {
+    xacml_subject_t * subject= xacml_calloc(XACML_ARENA(arena),sizeof(struct xacml_subject));
     if (subject == NULL) {
         pep_log_error("xacml_subject_create: can't allocate xacml_subject_t.");
         return NULL;
     }
-    subject->attributes= pep_llist_create();
+    subject->arena= XACML_ARENA(arena);
+    subject->attributes= xacml_vector_create(subject->arena);
     if (subject->attributes == NULL) {
         pep_log_error("xacml_subject_create: can't allocate attributes list.");
-        free(subject);
+        xacml_free(subject->arena,subject);
         return NULL;
     }
     subject->category= NULL;
@@ -52,11 +58,11 @@ int xacml_subject_setcategory(xacml_subject_t * subject, const char * category)
         return PEP_XACML_ERROR;
     }
     if (subject->category != NULL) {
-        free(subject->category);
+        xacml_free(subject->arena,subject->category);
     }
     if (category != NULL) {
         size_t size= strlen(category);
-        subject->category= calloc(size + 1, sizeof(char));
+        subject->category= xacml_calloc(subject->arena,size + 1);
         if (subject->category == NULL) {
             pep_log_error("xacml_subject_setcategory: can't allocate category (%d bytes).", (int)size);
             return PEP_XACML_ERROR;
@@ -79,7 +85,7 @@ int xacml_subject_addattribute(xacml_subject_t * subject, xacml_attribute_t * at
         pep_log_error("xacml_subject_addattribute: NULL subject or attribute.");
         return PEP_XACML_ERROR;
     }
-    if (pep_llist_add(subject->attributes,attr) != LLIST_OK) {
+    if (pep_vector_add(subject->attributes,attr) != VECTOR_OK) {
         pep_log_error("xacml_subject_addattribute: can't add attribute to list.");
         return PEP_XACML_ERROR;
     }
@@ -91,7 +97,7 @@ size_t xacml_subject_attributes_length(const xacml_subject_t * subject) {
         pep_log_warn("xacml_subject_attributes_length: NULL subject.");
         return 0;
     }
-    return pep_llist_length(subject->attributes);
+    return pep_vector_length(subject->attributes);
 }
 
 xacml_attribute_t * xacml_subject_getattribute(const xacml_subject_t * subject, int index) {
@@ -99,13 +105,15 @@ xacml_attribute_t * xacml_subject_getattribute(const xacml_subject_t * subject,
         pep_log_error("xacml_subject_getattribute: NULL subject.");
         return NULL;
     }
-    return pep_llist_get(subject->attributes, index);
+    return pep_vector_get(subject->attributes, index);
 }
 
 void xacml_subject_delete(xacml_subject_t * subject) {
     if (subject == NULL) return;
-    pep_llist_delete_elements(subject->attributes,(pep_llist_delete_elt_f)xacml_attribute_delete);
-    pep_llist_delete(subject->attributes);
+    pep_vector_delete_elements(subject->attributes,(pep_vector_delete_elt_f)xacml_attribute_delete);
+    /* released with the arena */
+    if (subject->arena != NULL) return;
+    pep_vector_delete(subject->attributes);
     if (subject->category != NULL) {
         free(subject->category);
     }
@@ -68,6 +68,112 @@ static const char XACML_DATATYPE_BASE64BINARY[]= "http://www.w3.org/2001/XMLSche
 static const char XACML_DATATYPE_DAY_TIME_DURATION[]= "http://www.w3.org/TR/2002/WD-xquery-operators-20020816#dayTimeDuration"; /**<  XACML data-type @c dayTimeDuration identifier (XACML 2.0, B.3) */
 static const char XACML_DATATYPE_YEAR_MONTH_DURATION[]= "http://www.w3.org/TR/2002/WD-xquery-operators-20020816#yearMonthDuration"; /**<  XACML data-type @c yearMonthDuration identifier (XACML 2.0, B.3) */
 
+/**
+ * @anchor Atom
+ * PEP XACML identifier atom type. Every identifier defined in xacml.h and
+ * profiles.h, and every identifier registered with xacml_atom_intern(), is
+ * mapped to a small integer atom: the XACML objects carrying an identifier
+ * can be compared by atom instead of by string. The atom of an identifier
+ * not interned is #XACML_ATOM_NONE.
+ */
+typedef int xacml_atom_t;
+
+/**
+ * Atoms of the XACML identifiers defined in xacml.h. See profiles.h for the
+ * profiles identifiers atoms.
+ */
+enum xacml_atoms {
+    XACML_ATOM_NONE= 0, /**< not an interned identifier */
+    XACML_ATOM_DATATYPE_X500NAME, /**< #XACML_DATATYPE_X500NAME */
+    XACML_ATOM_DATATYPE_RFC822NAME, /**< #XACML_DATATYPE_RFC822NAME */
+    XACML_ATOM_DATATYPE_IPADDRESS, /**< #XACML_DATATYPE_IPADDRESS */
+    XACML_ATOM_DATATYPE_DNSNAME, /**< #XACML_DATATYPE_DNSNAME */
+    XACML_ATOM_DATATYPE_STRING, /**< #XACML_DATATYPE_STRING */
+    XACML_ATOM_DATATYPE_BOOLEAN, /**< #XACML_DATATYPE_BOOLEAN */
+    XACML_ATOM_DATATYPE_INTEGER, /**< #XACML_DATATYPE_INTEGER */
+    XACML_ATOM_DATATYPE_DOUBLE, /**< #XACML_DATATYPE_DOUBLE */
+    XACML_ATOM_DATATYPE_TIME, /**< #XACML_DATATYPE_TIME */
+    XACML_ATOM_DATATYPE_DATE, /**< #XACML_DATATYPE_DATE */
+    XACML_ATOM_DATATYPE_DATETIME, /**< #XACML_DATATYPE_DATETIME */
+    XACML_ATOM_DATATYPE_ANYURI, /**< #XACML_DATATYPE_ANYURI */
+    XACML_ATOM_DATATYPE_HEXBINARY, /**< #XACML_DATATYPE_HEXBINARY */
+    XACML_ATOM_DATATYPE_BASE64BINARY, /**< #XACML_DATATYPE_BASE64BINARY */
+    XACML_ATOM_DATATYPE_DAY_TIME_DURATION, /**< #XACML_DATATYPE_DAY_TIME_DURATION */
+    XACML_ATOM_DATATYPE_YEAR_MONTH_DURATION, /**< #XACML_DATATYPE_YEAR_MONTH_DURATION */
+    XACML_ATOM_SUBJECT_ID, /**< #XACML_SUBJECT_ID */
+    XACML_ATOM_SUBJECT_ID_QUALIFIER, /**< #XACML_SUBJECT_ID_QUALIFIER */
+    XACML_ATOM_SUBJECT_KEY_INFO, /**< #XACML_SUBJECT_KEY_INFO */
+    XACML_ATOM_SUBJECT_CATEGORY_ACCESS, /**< #XACML_SUBJECT_CATEGORY_ACCESS */
+    XACML_ATOM_SUBJECT_CATEGORY_INTERMEDIARY, /**< #XACML_SUBJECT_CATEGORY_INTERMEDIARY */
+    XACML_ATOM_SUBJECT_CATEGORY_RECIPIENT, /**< #XACML_SUBJECT_CATEGORY_RECIPIENT */
+    XACML_ATOM_SUBJECT_CATEGORY_CODEBASE, /**< #XACML_SUBJECT_CATEGORY_CODEBASE */
+    XACML_ATOM_SUBJECT_CATEGORY_REQUESTING_MACHINE, /**< #XACML_SUBJECT_CATEGORY_REQUESTING_MACHINE */
+    XACML_ATOM_RESOURCE_ID, /**< #XACML_RESOURCE_ID */
+    XACML_ATOM_ACTION_ID, /**< #XACML_ACTION_ID */
+    XACML_ATOM_ENVIRONMENT_CURRENT_TIME, /**< #XACML_ENVIRONMENT_CURRENT_TIME */
+    XACML_ATOM_ENVIRONMENT_CURRENT_DATE, /**< #XACML_ENVIRONMENT_CURRENT_DATE */
+    XACML_ATOM_ENVIRONMENT_CURRENT_DATETIME, /**< #XACML_ENVIRONMENT_CURRENT_DATETIME */
+    XACML_ATOM_STATUSCODE_OK, /**< #XACML_STATUSCODE_OK */
+    XACML_ATOM_STATUSCODE_MISSINGATTRIBUTE, /**< #XACML_STATUSCODE_MISSINGATTRIBUTE */
+    XACML_ATOM_STATUSCODE_SYNTAXERROR, /**< #XACML_STATUSCODE_SYNTAXERROR */
+    XACML_ATOM_STATUSCODE_PROCESSINGERROR, /**< #XACML_STATUSCODE_PROCESSINGERROR */
+    XACML_ATOM_XACML_LAST /**< first atom after the XACML identifiers */
+};
+
+/**
+ * Interns the identifier: registers it in the global atom table if needed.
+ * The interned identifiers are kept until the end of the process.
+ * @param id the identifier to intern
+ * @return xacml_atom_t the identifier atom or #XACML_ATOM_NONE on error.
+ */
+xacml_atom_t xacml_atom_intern(const char * id);
+
+/**
+ * Returns the atom of an interned identifier, without registering it.
+ * @param id the identifier
+ * @return xacml_atom_t the identifier atom or #XACML_ATOM_NONE if not interned.
+ */
+xacml_atom_t xacml_atom_lookup(const char * id);
+
+/**
+ * Returns the interned identifier of the atom.
+ * @param atom the atom
+ * @return const char * the identifier or @a NULL if the atom is unknown.
+ */
+const char * xacml_atom_tostring(xacml_atom_t atom);
+
+/**
+ * @anchor Arena
+ * PEP XACML object arena type. The XACML objects created in an arena by the
+ * xacml_*_create_in() functions, with their strings and lists, are allocated
+ * from the arena memory blocks and released all at once by xacml_arena_reset()
+ * or xacml_arena_delete(). The xacml_*_delete() functions only delete the
+ * heap objects added to an object created in an arena, the arena memory is not
+ * released. The responses returned by pep_authorize() have their own arena,
+ * deleted by xacml_response_delete().
+ */
+typedef struct xacml_arena xacml_arena_t;
+
+/**
+ * Creates a XACML object arena.
+ * @param block_size the arena memory blocks size, or @a 0 for the default size (8KB)
+ * @return xacml_arena_t * pointer to the new arena or @a NULL on error.
+ */
+xacml_arena_t * xacml_arena_create(size_t block_size);
+
+/**
+ * Releases all the XACML objects created in the arena at once. The arena
+ * memory blocks are kept for the next objects.
+ * @param arena pointer to the arena
+ */
+void xacml_arena_reset(xacml_arena_t * arena);
+
+/**
+ * Deletes the arena and all the XACML objects created in it.
+ * @param arena pointer to the arena
+ */
+void xacml_arena_delete(xacml_arena_t * arena);
+
 /**
  * @anchor Attribute
  * PEP XACML Attribute type.
@@ -81,6 +187,12 @@ typedef struct xacml_attribute xacml_attribute_t;
  */
 xacml_attribute_t * xacml_attribute_create(const char * id);
 
+/**
+ * Creates a XACML Attribute in the arena, see xacml_attribute_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_attribute_t * xacml_attribute_create_in(const char * id, xacml_arena_t * arena);
+
 /**
  * Sets the id attribute of the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -89,6 +201,15 @@ xacml_attribute_t * xacml_attribute_create(const char * id);
  */
 int xacml_attribute_setid(xacml_attribute_t * attr, const char * id);
 
+/**
+ * Sets the id attribute of the XACML Attribute from the id_l bytes of id.
+ * @param attr pointer to the XACML Attribute
+ * @param id the id attribute
+ * @param id_l the id length in bytes
+ * @return int {@link #PEP_XACML_OK} or {@link #PEP_XACML_ERROR} on error.
+ */
+int xacml_attribute_setid_n(xacml_attribute_t * attr, const char * id, size_t id_l);
+
 /**
  * Gets the id attribute of the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -96,6 +217,21 @@ int xacml_attribute_setid(xacml_attribute_t * attr, const char * id);
  */
 const char * xacml_attribute_getid(const xacml_attribute_t * attr);
 
+/**
+ * Gets the id attribute of the XACML Attribute and its length.
+ * @param attr pointer to the XACML Attribute
+ * @param id_l the id length in bytes (output), if not @a NULL
+ * @return const char * the id attribute or @a NULL
+ */
+const char * xacml_attribute_getid_n(const xacml_attribute_t * attr, size_t * id_l);
+
+/**
+ * Gets the atom of the id attribute of the XACML Attribute.
+ * @param attr pointer to the XACML Attribute
+ * @return xacml_atom_t the id atom or #XACML_ATOM_NONE if the id is not interned or not set
+ */
+xacml_atom_t xacml_attribute_getatom(const xacml_attribute_t * attr);
+
 /**
  * Sets the datatype attribute of the XACML Attribute. Default datatype: {@link #XACML_DATATYPE_STRING}
  * @param attr pointer to the XACML Attribute
@@ -104,6 +240,15 @@ const char * xacml_attribute_getid(const xacml_attribute_t * attr);
  */
 int xacml_attribute_setdatatype(xacml_attribute_t * attr, const char * datatype);
 
+/**
+ * Sets the datatype attribute of the XACML Attribute from the datatype_l bytes of datatype.
+ * @param attr pointer to the XACML Attribute
+ * @param datatype the datatype attribute (can be NULL)
+ * @param datatype_l the datatype length in bytes
+ * @return int {@link #PEP_XACML_OK} or {@link #PEP_XACML_ERROR} on error.
+ */
+int xacml_attribute_setdatatype_n(xacml_attribute_t * attr, const char * datatype, size_t datatype_l);
+
 /**
  * Gets the datatype attribute of the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -111,6 +256,14 @@ int xacml_attribute_setdatatype(xacml_attribute_t * attr, const char * datatype)
  */
 const char * xacml_attribute_getdatatype(const xacml_attribute_t * attr);
 
+/**
+ * Gets the datatype attribute of the XACML Attribute and its length.
+ * @param attr pointer to the XACML Attribute
+ * @param datatype_l the datatype length in bytes (output), if not @a NULL
+ * @return const char * the datatype attribute or @a NULL
+ */
+const char * xacml_attribute_getdatatype_n(const xacml_attribute_t * attr, size_t * datatype_l);
+
 /**
  * Sets the issuer attribute of the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -119,6 +272,15 @@ const char * xacml_attribute_getdatatype(const xacml_attribute_t * attr);
  */
 int xacml_attribute_setissuer(xacml_attribute_t * attr, const char * issuer);
 
+/**
+ * Sets the issuer attribute of the XACML Attribute from the issuer_l bytes of issuer.
+ * @param attr pointer to the XACML Attribute
+ * @param issuer the issuer attribute
+ * @param issuer_l the issuer length in bytes
+ * @return int {@link #PEP_XACML_OK} or {@link #PEP_XACML_ERROR} on error.
+ */
+int xacml_attribute_setissuer_n(xacml_attribute_t * attr, const char * issuer, size_t issuer_l);
+
 /**
  * Gets the issuer attribute of the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -126,6 +288,14 @@ int xacml_attribute_setissuer(xacml_attribute_t * attr, const char * issuer);
  */
 const char * xacml_attribute_getissuer(const xacml_attribute_t * attr);
 
+/**
+ * Gets the issuer attribute of the XACML Attribute and its length.
+ * @param attr pointer to the XACML Attribute
+ * @param issuer_l the issuer length in bytes (output), if not @a NULL
+ * @return const char * the issuer attribute or @a NULL
+ */
+const char * xacml_attribute_getissuer_n(const xacml_attribute_t * attr, size_t * issuer_l);
+
 /**
  * Adds a value element to the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -134,6 +304,15 @@ const char * xacml_attribute_getissuer(const xacml_attribute_t * attr);
  */
 int xacml_attribute_addvalue(xacml_attribute_t * attr, const char *value);
 
+/**
+ * Adds the value_l bytes of value as a value element to the XACML Attribute.
+ * @param attr pointer to the XACML Attribute
+ * @param value the value (string) to add
+ * @param value_l the value length in bytes
+ * @return int {@link #PEP_XACML_OK} or {@link #PEP_XACML_ERROR} on error.
+ */
+int xacml_attribute_addvalue_n(xacml_attribute_t * attr, const char * value, size_t value_l);
+
 /**
  * Returns the number of AttributeValue in the XACML Attribute.
  * @param attr pointer to the XACML Attribute
@@ -151,6 +330,15 @@ size_t xacml_attribute_values_length(const xacml_attribute_t * attr);
  */
 const char * xacml_attribute_getvalue(const xacml_attribute_t * attr,int value_idx);
 
+/**
+ * Gets the AttributeValue of the XACML Attribute at index and its length.
+ * @param attr pointer to the XACML Attribute
+ * @param value_idx index of the AttributeValue to get in range [0..length-1].
+ * @param value_l the AttributeValue length in bytes (output), if not @a NULL
+ * @return const char * the AttributeValue or @a NULL if index is out of range.
+ */
+const char * xacml_attribute_getvalue_n(const xacml_attribute_t * attr, int value_idx, size_t * value_l);
+
 /**
  * Deletes the XACML Attribute.
  * @param attr pointer to the XACML Attribute to delete
@@ -190,6 +378,12 @@ static const char XACML_SUBJECT_CATEGORY_REQUESTING_MACHINE[]= "urn:oasis:names:
  */
 xacml_subject_t * xacml_subject_create(void);
 
+/**
+ * Creates a XACML Subject in the arena, see xacml_subject_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_subject_t * xacml_subject_create_in(xacml_arena_t * arena);
+
 /**
  * Sets the XACML Subject/\@SubjectCategory attribute.
  * @param subject pointer to the XACML Subject
@@ -262,6 +456,12 @@ static const char XACML_RESOURCE_ID[]= "urn:oasis:names:tc:xacml:1.0:resource:re
  */
 xacml_resource_t * xacml_resource_create(void);
 
+/**
+ * Creates a XACML Resource in the arena, see xacml_resource_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_resource_t * xacml_resource_create_in(xacml_arena_t * arena);
+
 /**
  * Sets the XACML Resource/ResourceContent element as string.
  * @param resource pointer the XACML Resource
@@ -325,6 +525,12 @@ static const char XACML_ACTION_ID[]= "urn:oasis:names:tc:xacml:1.0:action:action
  */
 xacml_action_t * xacml_action_create(void);
 
+/**
+ * Creates a XACML Action in the arena, see xacml_action_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_action_t * xacml_action_create_in(xacml_arena_t * arena);
+
 /**
  * Adds a XACML Attribute to the XACML Action
  * @param action pointer to the XACML Action
@@ -375,6 +581,12 @@ static const char XACML_ENVIRONMENT_CURRENT_DATETIME[]= "urn:oasis:names:tc:xacm
  */
 xacml_environment_t * xacml_environment_create(void);
 
+/**
+ * Creates a XACML Environment in the arena, see xacml_environment_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_environment_t * xacml_environment_create_in(xacml_arena_t * arena);
+
 /**
  * Adds a XACML Attribute to the XACML Environment
  * @param env pointer to the XACML Environment
@@ -418,6 +630,12 @@ typedef struct xacml_request xacml_request_t;
  */
 xacml_request_t * xacml_request_create(void);
 
+/**
+ * Creates a XACML Request in the arena, see xacml_request_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_request_t * xacml_request_create_in(xacml_arena_t * arena);
+
 /**
  * Adds a XACML Subject to the XACML Request.
  * @param request pointer to the XACML Request
@@ -524,6 +742,12 @@ static const char XACML_STATUSCODE_PROCESSINGERROR[]= "urn:oasis:names:tc:xacml:
  */
 xacml_statuscode_t * xacml_statuscode_create(const char * value);
 
+/**
+ * Creates a XACML StatusCode in the arena, see xacml_statuscode_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_statuscode_t * xacml_statuscode_create_in(const char * value, xacml_arena_t * arena);
+
 /**
  * Sets the XACML StatusCode/\@Value attribute
  * @param  statuscode pointer the XACML StatusCode
@@ -581,6 +805,12 @@ typedef struct xacml_status xacml_status_t;
  */
 xacml_status_t * xacml_status_create(const char * message);
 
+/**
+ * Creates a XACML Status in the arena, see xacml_status_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_status_t * xacml_status_create_in(const char * message, xacml_arena_t * arena);
+
 /**
  * Sets the XACML Status/StatusMessage element (string)
  * @param status pointer to the XACML Status
@@ -630,6 +860,12 @@ typedef struct xacml_attributeassignment xacml_attributeassignment_t;
  */
 xacml_attributeassignment_t * xacml_attributeassignment_create(const char * id);
 
+/**
+ * Creates a XACML AttributeAssignment in the arena, see xacml_attributeassignment_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_attributeassignment_t * xacml_attributeassignment_create_in(const char * id, xacml_arena_t * arena);
+
 /**
  * Sets the XACML AttributeAssignment/\@AttributeId attribute.
  * @param attr pointer to the XACML AttributeAssignment
@@ -645,6 +881,13 @@ int xacml_attributeassignment_setid(xacml_attributeassignment_t * attr, const ch
  */
 const char * xacml_attributeassignment_getid(const xacml_attributeassignment_t * attr);
 
+/**
+ * Gets the atom of the id attribute of the XACML AttributeAssignment.
+ * @param attr pointer to the XACML AttributeAssignment
+ * @return xacml_atom_t the id atom or #XACML_ATOM_NONE if the id is not interned or not set
+ */
+xacml_atom_t xacml_attributeassignment_getatom(const xacml_attributeassignment_t * attr);
+
 /**
  * Sets the XACML AttributeAssignment/\@DataType attribute.
  * @param attr pointer to the XACML AttributeAssignment
@@ -724,6 +967,12 @@ typedef struct xacml_obligation xacml_obligation_t;
  */
 xacml_obligation_t * xacml_obligation_create(const char * id);
 
+/**
+ * Creates a XACML Obligation in the arena, see xacml_obligation_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_obligation_t * xacml_obligation_create_in(const char * id, xacml_arena_t * arena);
+
 /**
  * Sets the XACML Obligation/\@ObligationId attribute.
  * @param obligation pointer to the XACML Obligation
@@ -739,6 +988,13 @@ int xacml_obligation_setid(xacml_obligation_t * obligation, const char * id);
  */
 const char * xacml_obligation_getid(const xacml_obligation_t * obligation);
 
+/**
+ * Gets the atom of the id attribute of the XACML Obligation.
+ * @param obligation pointer to the XACML Obligation
+ * @return xacml_atom_t the id atom or #XACML_ATOM_NONE if the id is not interned or not set
+ */
+xacml_atom_t xacml_obligation_getatom(const xacml_obligation_t * obligation);
+
 /**
  * Gets the XACML Obligation/\@FulfillOn attribute.
  * @param obligation pointer to the XACML Obligation
@@ -809,6 +1065,12 @@ typedef struct xacml_result xacml_result_t;
  */
 xacml_result_t * xacml_result_create(void);
 
+/**
+ * Creates a XACML Result in the arena, see xacml_result_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_result_t * xacml_result_create_in(xacml_arena_t * arena);
+
 /**
  * Gets the XACML Result/Decision value.
  * @param result pointer to the XACML Result
@@ -909,6 +1171,12 @@ typedef struct xacml_response xacml_response_t;
  */
 xacml_response_t * xacml_response_create(void);
 
+/**
+ * Creates a XACML Response in the arena, see xacml_response_create().
+ * @param arena pointer to the arena, or @a NULL to allocate from the heap
+ */
+xacml_response_t * xacml_response_create_in(xacml_arena_t * arena);
+
 /** @internal
  * Sets the effective XACML Request associated to the XACML Response. The effective
  * XACML Request is normally send back from the PEPd.
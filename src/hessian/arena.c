@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hessian.h"
+#include "i_hessian.h"
+#include "log.h"
+
+/*****************************************
+ * Hessian arena (bump) memory allocator *
+ *****************************************/
+
+/*
+ * The arena allocates from fixed size blocks, chained in allocation order.
+ * On reset the blocks are kept and reused, only the oversized blocks (for
+ * allocations bigger than a quarter of the block size) are released.
+ */
+
+/* default block size */
+#ifndef HESSIAN_ARENA_BLOCK_SIZE
+#define HESSIAN_ARENA_BLOCK_SIZE 8192
+#endif
+
+/* allocation alignment, must be a power of 2 */
+#ifndef HESSIAN_ARENA_ALIGN
+#define HESSIAN_ARENA_ALIGN 16
+#endif
+
+typedef struct arena_block {
+    struct arena_block * next;
+    size_t size;
+    size_t used;
+    unsigned char * data;
+} arena_block_t;
+
+struct hessian_arena {
+    size_t block_size;
+    arena_block_t * first; /* standard blocks */
+    arena_block_t * current;
+    arena_block_t * large; /* oversized blocks */
+};
+
+static arena_block_t * arena_block_create(size_t size);
+static void * arena_block_alloc(arena_block_t * block, size_t size);
+static void arena_blocks_delete(arena_block_t * block);
+
+hessian_arena_t * hessian_arena_create(size_t block_size) {
+    hessian_arena_t * arena= calloc(1,sizeof(struct hessian_arena));
+    if (arena == NULL) {
+        pep_log_error("hessian_arena_create: can't allocate hessian_arena_t.");
+        return NULL;
+    }
+    arena->block_size= (block_size > 0) ? block_size : HESSIAN_ARENA_BLOCK_SIZE;
+    arena->first= arena_block_create(arena->block_size);
+    if (arena->first == NULL) {
+        pep_log_error("hessian_arena_create: can't allocate first block (%d bytes).",(int)arena->block_size);
+        free(arena);
+        return NULL;
+    }
+    arena->current= arena->first;
+    arena->large= NULL;
+    return arena;
+}
+
+void hessian_arena_delete(hessian_arena_t * arena) {
+    if (arena == NULL) return;
+    arena_blocks_delete(arena->first);
+    arena_blocks_delete(arena->large);
+    free(arena);
+}
+
+void hessian_arena_reset(hessian_arena_t * arena) {
+    arena_block_t * block;
+    if (arena == NULL) return;
+    for (block= arena->first; block != NULL; block= block->next) {
+        block->used= 0;
+    }
+    arena->current= arena->first;
+    arena_blocks_delete(arena->large);
+    arena->large= NULL;
+}
+
+void * hessian_arena_alloc(hessian_arena_t * arena, size_t size) {
+    void * p;
+    if (arena == NULL) {
+        pep_log_error("hessian_arena_alloc: NULL arena pointer.");
+        return NULL;
+    }
+    if (size == 0) size= 1;
+    /* oversized allocation, in its own block */
+    if (size > arena->block_size / 4) {
+        arena_block_t * block= arena_block_create(size);
+        if (block == NULL) {
+            pep_log_error("hessian_arena_alloc: can't allocate block (%d bytes).",(int)size);
+            return NULL;
+        }
+        block->next= arena->large;
+        arena->large= block;
+        return arena_block_alloc(block,size);
+    }
+    while ((p= arena_block_alloc(arena->current,size)) == NULL) {
+        if (arena->current->next == NULL) {
+            arena->current->next= arena_block_create(arena->block_size);
+            if (arena->current->next == NULL) {
+                pep_log_error("hessian_arena_alloc: can't allocate block (%d bytes).",(int)arena->block_size);
+                return NULL;
+            }
+        }
+        arena->current= arena->current->next;
+    }
+    return p;
+}
+
+/*
+ * Internal allocation functions, from the arena or from the heap if the
+ * arena is NULL.
+ */
+void * hessian_calloc(hessian_arena_t * arena, size_t size) {
+    if (arena == NULL) return calloc(1,size);
+    return hessian_arena_alloc(arena,size);
+}
+
+void * hessian_realloc(hessian_arena_t * arena, void * ptr, size_t size, size_t new_size) {
+    void * p;
+    if (arena == NULL) return realloc(ptr,new_size);
+    p= hessian_arena_alloc(arena,new_size);
+    if (p != NULL && ptr != NULL) {
+        memcpy(p,ptr,(size < new_size) ? size : new_size);
+    }
+    return p;
+}
+
+void hessian_free(hessian_arena_t * arena, void * ptr) {
+    if (arena == NULL) free(ptr);
+}
+
+static arena_block_t * arena_block_create(size_t size) {
+    /* the block data follows the block header, with room for the alignment */
+    arena_block_t * block= malloc(sizeof(arena_block_t) + size + HESSIAN_ARENA_ALIGN);
+    if (block == NULL) return NULL;
+    block->next= NULL;
+    block->size= size;
+    block->used= 0;
+    block->data= (unsigned char *)(((uintptr_t)(block + 1) + HESSIAN_ARENA_ALIGN - 1) & ~((uintptr_t)HESSIAN_ARENA_ALIGN - 1));
+    return block;
+}
+
+/* returns NULL if the block is full */
+static void * arena_block_alloc(arena_block_t * block, size_t size) {
+    size_t used= (block->used + HESSIAN_ARENA_ALIGN - 1) & ~((size_t)HESSIAN_ARENA_ALIGN - 1);
+    void * p;
+    if (used > block->size || size > block->size - used) return NULL;
+    p= block->data + used;
+    block->used= used + size;
+    memset(p,0,size);
+    return p;
+}
+
+static void arena_blocks_delete(arena_block_t * block) {
+    while (block != NULL) {
+        arena_block_t * next= block->next;
+        free(block);
+        block= next;
+    }
+}
@@ -127,13 +127,14 @@ static int hessian_binary_deserialize (hessian_object_t * object, int tag, pep_b
         int b16= pep_buffer_getc(input);
         int b8= pep_buffer_getc(input);
         size_t bin_l= (b16 << 8) + b8;
-        /* fully read string (chunk) */
-        size_t n_bytes= 0;
-        while(n_bytes < bin_l) {
-            int b= pep_buffer_getc(input);
-            pep_buffer_putc(b,buf);
-            n_bytes++;
+        /* copy the whole chunk at once */
+        if (b16 == BUFFER_EOF || b8 == BUFFER_EOF || pep_buffer_length(input) < bin_l) {
+            pep_log_error("hessian_binary_deserialize: truncated binary chunk (%d bytes).",(int)bin_l);
+            pep_buffer_delete(buf);
+            return HESSIAN_ERROR;
         }
+        pep_buffer_write(pep_buffer_peek(input),1,bin_l,buf);
+        pep_buffer_skip(input,bin_l);
         /* was it final chunk? */
         if (tag == class->chunk_tag) {
             tag= pep_buffer_getc(input);
@@ -146,7 +147,7 @@ static int hessian_binary_deserialize (hessian_object_t * object, int tag, pep_b
     /* copy the buffer into the hessian binary */
     buf_l= pep_buffer_length(buf);
     self->length= buf_l;
-    self->data= calloc(self->length,sizeof(char));
+    self->data= hessian_calloc(self->arena,self->length);
     if (self->data == NULL) {
         pep_log_error("hessian_binary_deserialize: can't allocated data (%d bytes).", (int)self->length);
         pep_buffer_delete(buf);
@@ -164,7 +165,6 @@ static int hessian_binary_serialize (const hessian_object_t * object, pep_buffer
     hessian_binary_t * self= (hessian_object_t *) object;
     const hessian_class_t * class;
     size_t byte_l, pos;
-    int b8, b16;
     const char * chunk, * rest;
     if (self == NULL) {
         pep_log_error("hessian_binary_serialize: NULL object pointer.");
@@ -184,10 +184,7 @@ static int hessian_binary_serialize (const hessian_object_t * object, pep_buffer
     while (byte_l > HESSIAN_CHUNK_SIZE) {
         /* send binary chunks */
         pep_buffer_putc(class->chunk_tag,output);
-        b16= HESSIAN_CHUNK_SIZE >> 8;
-        b8= HESSIAN_CHUNK_SIZE & 0x00FF;
-        pep_buffer_putc(b16,output);
-        pep_buffer_putc(b8,output);
+        pep_buffer_put_u16(HESSIAN_CHUNK_SIZE,output);
         /* write HESSIAN_CHUNK_SIZE bytes */
         chunk= &(self->data[pos]);
         pep_buffer_write(chunk,1,HESSIAN_CHUNK_SIZE,output);
@@ -196,10 +193,7 @@ static int hessian_binary_serialize (const hessian_object_t * object, pep_buffer
     }
 
     pep_buffer_putc(class->tag,output);
-    b16= byte_l >> 8;
-    b8= byte_l & 0x00FF;
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
+    pep_buffer_put_u16((uint16_t)byte_l,output);
     rest= &(self->data[pos]);
     pep_buffer_write(rest,1,byte_l,output);
 
@@ -20,6 +20,7 @@
 #include <stdio.h>
 
 #include "hessian.h"
+#include "i_hessian.h"
 #include "log.h"
 
 /**
@@ -195,6 +196,8 @@ void hessian_delete(hessian_object_t * object) {
         pep_log_error("hessian_delete: no class descriptor.");
         return;
     }
+    /* released with its arena */
+    if (((hessian_null_t *)object)->arena != NULL) return;
     if (class->dtor) {
         if ( class->dtor(object) == HESSIAN_ERROR ) {
             pep_log_error("hessian_delete: object destructor failed.");
@@ -206,6 +209,11 @@ void hessian_delete(hessian_object_t * object) {
 
 int hessian_serialize(const hessian_object_t * object, pep_buffer_t * output) {
     const hessian_class_t * class = hessian_getclass(object);
+    /* the buffer fast paths don't check the pointer */
+    if (output == NULL) {
+        pep_log_error("hessian_serialize: NULL output pointer.");
+        return HESSIAN_ERROR;
+    }
     if (class == NULL) {
         pep_log_error("hessian_serialize: NULL class descriptor.");
         return HESSIAN_ERROR;
@@ -222,14 +230,37 @@ int hessian_serialize(const hessian_object_t * object, pep_buffer_t * output) {
 }
 
 hessian_object_t * hessian_deserialize(pep_buffer_t * input) {
-    int tag= pep_buffer_getc(input);
+    int tag;
+    if (input == NULL) {
+        pep_log_error("hessian_deserialize: NULL input pointer.");
+        return NULL;
+    }
+    tag= pep_buffer_getc(input);
     return hessian_deserialize_tag(tag,input);
 }
 
 hessian_object_t * hessian_deserialize_tag(int tag, pep_buffer_t * input) {
+    return hessian_deserialize_tag_arena(tag,input,NULL);
+}
+
+hessian_object_t * hessian_deserialize_arena(pep_buffer_t * input, hessian_arena_t * arena) {
+    int tag;
+    if (arena == NULL || input == NULL) {
+        pep_log_error("hessian_deserialize_arena: NULL arena or input pointer.");
+        return NULL;
+    }
+    tag= pep_buffer_getc(input);
+    return hessian_deserialize_tag_arena(tag,input,arena);
+}
+
+hessian_object_t * hessian_deserialize_tag_arena(int tag, pep_buffer_t * input, hessian_arena_t * arena) {
     hessian_t type= _gettype(tag);
     const hessian_class_t * class;
     void * object;
+    if (input == NULL) {
+        pep_log_error("hessian_deserialize: NULL input pointer.");
+        return NULL;
+    }
     if (type == HESSIAN_UNKNOWN) {
         pep_log_error("hessian_deserialize: unknown serialization tag: %c", tag );
         return NULL;
@@ -240,18 +271,20 @@ hessian_object_t * hessian_deserialize_tag(int tag, pep_buffer_t * input) {
         return NULL;
     }
     /* allocate the object class descriptor */
-    object = calloc(1, class->size);
+    object = hessian_calloc(arena, class->size);
     if (object == NULL) {
         pep_log_error("hessian_deserialize: can't allocate object (%d bytes)", (int)class->size );
         return NULL;
     }
-    /* first memory element of object is the class pointer */
+    /* first memory element of object is the class pointer, second the owning arena */
     *(const hessian_class_t **) object = class;
+    ((hessian_null_t *)object)->arena= arena;
     /* deserialize the object */
     if (class->deserialize) {
         if (class->deserialize(object, tag, input) == HESSIAN_OK) return object;
         else {
             pep_log_error("hessian_deserialize: failed to deserialize object: %s tag: %c", class->name, tag);
+            hessian_delete(object);
             return NULL;
         }
     }
@@ -262,6 +295,21 @@ hessian_object_t * hessian_deserialize_tag(int tag, pep_buffer_t * input) {
     }
 }
 
+/**
+ * Deletes the objects of the array, each distinct object only once.
+ */
+void hessian_delete_objects(hessian_object_t ** objects, size_t n) {
+    size_t i, j;
+    if (objects == NULL) return;
+    for (i= 0; i < n; i++) {
+        int shared= FALSE;
+        for (j= 0; j < i && !shared; j++) {
+            if (objects[j] == objects[i]) shared= TRUE;
+        }
+        if (!shared) hessian_delete(objects[i]);
+    }
+}
+
 /*******************************************************/
 
 const hessian_class_t * hessian_getclass(const hessian_object_t * object) {
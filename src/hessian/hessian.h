@@ -61,7 +61,8 @@ extern "C" {
 hessian_object_t * hessian_create (hessian_t type, ...);
 
 /**
- * Destroy a Hessian object.
+ * Destroy a Hessian object. Does nothing for an object allocated in an arena,
+ * it is released with the arena, see hessian_arena_reset(hessian_arena_t *).
  *
  * @param hessian_object_t * object the pointer to the Hessian object to destroy.
  */
@@ -100,6 +101,69 @@ hessian_object_t * hessian_deserialize (pep_buffer_t * input);
  */
 hessian_object_t * hessian_deserialize_tag (int tag, pep_buffer_t * input);
 
+/**
+ * Deserializes an Hessian object graph from the input buffer, all the objects
+ * are allocated in the arena. The objects must not be deleted, the graph is
+ * released at once by resetting or deleting the arena. The first character
+ * delimiter is directly read from the buffer.
+ *
+ * @param pep_buffer_t * input pointer to the input buffer.
+ * @param hessian_arena_t * arena the arena to allocate the objects from.
+ *
+ * @return hessian_object_t * pointer to the deserialized Hessian object
+ *         or NULL if an error occurs.
+ */
+hessian_object_t * hessian_deserialize_arena (pep_buffer_t * input, hessian_arena_t * arena);
+
+/**
+ * Deserializes an Hessian object graph from the input buffer, identified with
+ * the first tag character delimiter. All the objects are allocated in the arena.
+ *
+ * @param int tag the first character delimiter.
+ * @param pep_buffer_t * input pointer to the input buffer.
+ * @param hessian_arena_t * arena the arena to allocate the objects from, or NULL
+ *        to allocate the objects from the heap.
+ *
+ * @return hessian_object_t * pointer to the deserialized Hessian object
+ *         or NULL if an error occurs.
+ */
+hessian_object_t * hessian_deserialize_tag_arena (int tag, pep_buffer_t * input, hessian_arena_t * arena);
+
+/**
+ * Creates an arena allocator. The memory is allocated in blocks, and released
+ * at once when the arena is reset or deleted.
+ *
+ * @param size_t block_size the size of the arena blocks, or 0 for the default size.
+ *
+ * @return hessian_arena_t * pointer to the arena or NULL if an error occurs.
+ */
+hessian_arena_t * hessian_arena_create (size_t block_size);
+
+/**
+ * Releases all the memory allocated in the arena, the blocks are kept for
+ * the next allocations.
+ *
+ * @param hessian_arena_t * arena pointer to the arena.
+ */
+void hessian_arena_reset (hessian_arena_t * arena);
+
+/**
+ * Deletes the arena and all the memory allocated in it.
+ *
+ * @param hessian_arena_t * arena pointer to the arena.
+ */
+void hessian_arena_delete (hessian_arena_t * arena);
+
+/**
+ * Allocates zeroed and aligned memory in the arena.
+ *
+ * @param hessian_arena_t * arena pointer to the arena.
+ * @param size_t size the size to allocate.
+ *
+ * @return void * pointer to the allocated memory or NULL if an error occurs.
+ */
+void * hessian_arena_alloc (hessian_arena_t * arena, size_t size);
+
 /**
  * Gets the type hessian_t of an object.
  *
@@ -165,11 +229,19 @@ int64_t hessian_long_getvalue(const hessian_object_t * h_long);
 double hessian_double_getvalue(const hessian_object_t * h_double);
 
 /**
- *  Hessian UTF-8 string getters
+ *  Hessian UTF-8 string getters. The byte and UTF-8 chars lengths are kept
+ *  by the string, hessian_string_getstring_n() returns the byte length.
  */
 size_t hessian_string_utf8_length(const hessian_object_t *string);
 size_t hessian_string_length(const hessian_object_t *string);
 const char * hessian_string_getstring(const hessian_object_t *string);
+const char * hessian_string_getstring_n(const hessian_object_t *string, size_t * length);
+
+/**
+ * Creates an Hessian string from the length bytes of string, same as
+ * hessian_create(HESSIAN_STRING,string) without measuring the string again.
+ */
+hessian_object_t * hessian_string_create_n(const char * string, size_t length);
 
 /**
  *  UTF-8 string utilities
@@ -177,6 +249,71 @@ const char * hessian_string_getstring(const hessian_object_t *string);
 size_t hessian_utf8_strlen(const char *array);
 char * hessian_utf8_bgets(size_t utf8_l, pep_buffer_t * input);
 
+/**
+ * UTF-8 kernels. The default {@link #HESSIAN_UTF8_KERNEL_AUTO} selects at
+ * runtime the fastest kernel supported by the CPU.
+ */
+typedef enum hessian_utf8_kernel {
+    HESSIAN_UTF8_KERNEL_AUTO = 0, /**< Best kernel supported by the CPU (default) */
+    HESSIAN_UTF8_KERNEL_SCALAR, /**< Portable byte by byte kernel */
+    HESSIAN_UTF8_KERNEL_SSE2, /**< x86 SSE2 kernel */
+    HESSIAN_UTF8_KERNEL_AVX2 /**< x86 AVX2 kernel */
+} hessian_utf8_kernel_t;
+
+/**
+ * Sets the UTF-8 kernel used to count, split and validate the strings. The
+ * results are identical whatever the kernel.
+ *
+ * @param hessian_utf8_kernel_t kernel the kernel to use.
+ *
+ * @return int HESSIAN_OK or HESSIAN_ERROR if the kernel is not supported by
+ *             the CPU or was not compiled in (HESSIAN_NO_SIMD).
+ */
+int hessian_utf8_setkernel(hessian_utf8_kernel_t kernel);
+
+/**
+ * Returns the UTF-8 kernel effectively used, never {@link #HESSIAN_UTF8_KERNEL_AUTO}.
+ *
+ * @return hessian_utf8_kernel_t the kernel used.
+ */
+hessian_utf8_kernel_t hessian_utf8_getkernel(void);
+
+/**
+ * Counts the UTF-8 chars (the lead bytes) in the data.
+ *
+ * @param const char * data the UTF-8 bytes.
+ * @param size_t data_l the number of bytes.
+ *
+ * @return size_t the number of chars.
+ */
+size_t hessian_utf8_count(const char * data, size_t data_l);
+
+/**
+ * Returns the byte offset of the n-th UTF-8 char of the data (0 based), that
+ * is the number of bytes of the n first chars.
+ *
+ * @param const char * data the UTF-8 bytes.
+ * @param size_t data_l the number of bytes.
+ * @param size_t n the char index.
+ *
+ * @return size_t the byte offset, data_l if the data contains exactly n chars
+ *         or (size_t)-1 if the data contains less than n chars.
+ */
+size_t hessian_utf8_offset(const char * data, size_t data_l, size_t n);
+
+/**
+ * Validates the UTF-8 data (RFC 3629): rejects the invalid lead bytes, stray
+ * continuation bytes, truncated and overlong sequences and the code points
+ * above U+10FFFF. The encoded UTF-16 surrogates are accepted, as written by
+ * Java Hessian for the supplementary chars.
+ *
+ * @param const char * data the UTF-8 bytes.
+ * @param size_t data_l the number of bytes.
+ *
+ * @return int TRUE if the data is valid UTF-8, FALSE otherwise.
+ */
+int hessian_utf8_validate(const char * data, size_t data_l);
+
 /**
  *  Hessian XML getters
  */
@@ -235,11 +372,242 @@ int32_t hessian_ref_getvalue(const hessian_object_t * ref);
  * Adds a Hessian <key,value> objects pair to the Hessian map.
  */
 int hessian_map_add(hessian_object_t * map, hessian_object_t * key, hessian_object_t * value);
+int hessian_map_settype(hessian_object_t * map, const char * type);
 const char * hessian_map_gettype(const hessian_object_t * map);
 size_t hessian_map_length(const hessian_object_t * map);
 hessian_object_t * hessian_map_getkey(const hessian_object_t * map, int index);
 hessian_object_t * hessian_map_getvalue(const hessian_object_t * map, int index);
 
+/**
+ * Returns the value of the pair with the Hessian string key, or NULL if the
+ * map has no such key. The string keys of large maps are hash indexed, the
+ * index is built by the first lookup.
+ */
+hessian_object_t * hessian_map_get(const hessian_object_t * map, const char * key);
+
+/**
+ * Direct serialization, without building the Hessian objects. The bytes are
+ * identical to the ones written by hessian_serialize(object,output) for the
+ * equivalent Hessian object. A map or list is started, its content written,
+ * then ended. hessian_string_write_n() takes the already known byte and UTF-8
+ * chars lengths of the string.
+ *
+ * All functions return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_null_write(pep_buffer_t * output);
+int hessian_string_write(const char * string, pep_buffer_t * output);
+int hessian_string_write_n(const char * string, size_t length, size_t utf8_length, pep_buffer_t * output);
+int hessian_map_write_start(const char * type, pep_buffer_t * output);
+int hessian_map_write_end(pep_buffer_t * output);
+int hessian_list_write_start(const char * type, size_t length, pep_buffer_t * output);
+int hessian_list_write_end(pep_buffer_t * output);
+
+/**
+ * Serialized sizes: the number of bytes written by the corresponding direct
+ * serialization function, computed without writing. The end of a map or list
+ * and a Hessian null are 1 byte.
+ */
+size_t hessian_string_write_size(const char * string);
+size_t hessian_string_write_size_n(size_t length, size_t utf8_length);
+size_t hessian_map_write_start_size(const char * type);
+size_t hessian_list_write_start_size(const char * type, size_t length);
+
+/**
+ * Pre-encoded Hessian fragments for the constant class names and map keys.
+ * The fragment is a static const structure holding the bytes written by
+ * hessian_string_write(literal,output), or hessian_map_write_start(literal,output)
+ * for a map start, encoded at compile time. The literal must be ASCII and
+ * shorter than HESSIAN_CHUNK_SIZE chars.
+ *
+ * HESSIAN_ENCODED_STRING(XACML_ENCODED_ID,"id");
+ * HESSIAN_ENCODED_WRITE(XACML_ENCODED_ID,output);
+ */
+#define HESSIAN_ENCODED_STRING(name,literal) \
+    static const struct { char tag, b16, b8; char bytes[sizeof(literal) - 1]; } name= \
+    { 'S', (char)((sizeof(literal) - 1) >> 8), (char)((sizeof(literal) - 1) & 0xFF), literal }
+#define HESSIAN_ENCODED_MAP_START(name,literal) \
+    static const struct { char tag, type_tag, b16, b8; char bytes[sizeof(literal) - 1]; } name= \
+    { 'M', 't', (char)((sizeof(literal) - 1) >> 8), (char)((sizeof(literal) - 1) & 0xFF), literal }
+#define HESSIAN_ENCODED_WRITE(name,output) \
+    hessian_encoded_write(&(name),sizeof(name),(output))
+
+/**
+ * Writes the size bytes of a pre-encoded fragment with a single copy.
+ *
+ * @return int HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_encoded_write(const void * encoded, size_t size, pep_buffer_t * output);
+
+/**
+ * Hessian pull reader token types.
+ */
+typedef enum {
+    HESSIAN_TOKEN_MORE= -2,
+    HESSIAN_TOKEN_ERROR= -1,
+    HESSIAN_TOKEN_EOF= 0,
+    HESSIAN_TOKEN_NULL,
+    HESSIAN_TOKEN_BOOLEAN,
+    HESSIAN_TOKEN_INTEGER,
+    HESSIAN_TOKEN_LONG,
+    HESSIAN_TOKEN_DOUBLE,
+    HESSIAN_TOKEN_DATE,
+    HESSIAN_TOKEN_STRING,
+    HESSIAN_TOKEN_XML,
+    HESSIAN_TOKEN_BINARY,
+    HESSIAN_TOKEN_REMOTE,
+    HESSIAN_TOKEN_REF,
+    HESSIAN_TOKEN_MAP_START,
+    HESSIAN_TOKEN_MAP_END,
+    HESSIAN_TOKEN_LIST_START,
+    HESSIAN_TOKEN_LIST_END
+} hessian_token_t;
+
+/**
+ * The ADT Hessian pull reader type. The reader returns the serialized objects
+ * of an input buffer token by token, without building the objects: the maps
+ * and lists are returned as start and end tokens, and the values are only
+ * valid until the next call. The input can be read while it arrives, see
+ * hessian_reader_refill().
+ */
+typedef struct hessian_reader hessian_reader_t;
+
+/**
+ * Creates a Hessian pull reader.
+ *
+ * @return hessian_reader_t * pointer to the new reader or NULL if an error occurs.
+ */
+hessian_reader_t * hessian_reader_create(void);
+
+/**
+ * Deletes the Hessian pull reader.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ */
+void hessian_reader_delete(hessian_reader_t * reader);
+
+/**
+ * Resets the Hessian pull reader to read the bytes of the input buffer. The
+ * input buffer is not consumed, see hessian_reader_offset(reader).
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ * @param pep_buffer_t * input the buffer to read from.
+ *
+ * @return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_reader_reset(hessian_reader_t * reader, pep_buffer_t * input);
+
+/**
+ * Points the reader to the input buffer again after bytes were appended to
+ * it, the reader keeps its position. If partial is TRUE, the input is not
+ * complete yet: a token truncated by the end of the input is returned as
+ * HESSIAN_TOKEN_MORE, and read again after the next refill.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ * @param pep_buffer_t * input the buffer to read from, not consumed since the reset.
+ * @param int partial TRUE if more bytes will be appended to the input.
+ *
+ * @return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_reader_refill(hessian_reader_t * reader, pep_buffer_t * input, int partial);
+
+/**
+ * Reads the next token.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ *
+ * @return hessian_token_t the token type, HESSIAN_TOKEN_EOF at the end of the
+ *         input, HESSIAN_TOKEN_ERROR if the input is invalid or truncated, or
+ *         HESSIAN_TOKEN_MORE if the partial input ends within the token.
+ */
+hessian_token_t hessian_reader_next(hessian_reader_t * reader);
+
+/**
+ * Skips the value of the token just read: for a map or list start token,
+ * all the tokens up to the matching end token are skipped.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ *
+ * @return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_reader_skip(hessian_reader_t * reader);
+
+/**
+ * Returns the number of bytes read from the input buffer.
+ *
+ * @param const hessian_reader_t * reader pointer to the reader.
+ *
+ * @return size_t the offset of the next token in the input buffer.
+ */
+size_t hessian_reader_offset(const hessian_reader_t * reader);
+
+/**
+ * Returns the number of maps and lists started and not ended yet.
+ */
+size_t hessian_reader_depth(const hessian_reader_t * reader);
+
+/**
+ * Moves the reader back to a previous position, as returned by
+ * hessian_reader_offset(reader) and hessian_reader_depth(reader) before a
+ * token, to read the tokens again.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ * @param size_t offset the offset of the token to read again.
+ * @param size_t depth the containers depth at this offset.
+ *
+ * @return HESSIAN_OK or HESSIAN_ERROR if the position is not a previous one.
+ */
+int hessian_reader_rewind(hessian_reader_t * reader, size_t offset, size_t depth);
+
+/**
+ * Returns the value of a boolean, integer or ref token.
+ */
+int32_t hessian_reader_getinteger(const hessian_reader_t * reader);
+
+/**
+ * Returns the value of a long or date token.
+ */
+int64_t hessian_reader_getlong(const hessian_reader_t * reader);
+
+/**
+ * Returns the value of a double token.
+ */
+double hessian_reader_getdouble(const hessian_reader_t * reader);
+
+/**
+ * Returns the value of a string, xml, binary or remote (url) token. The
+ * value is null terminated and only valid until the next call.
+ *
+ * @param hessian_reader_t * reader pointer to the reader.
+ * @param size_t * length the length in bytes of the value (output), can be NULL.
+ *
+ * @return const char * the value or NULL if the token has no such value.
+ */
+const char * hessian_reader_getstring(hessian_reader_t * reader, size_t * length);
+
+/**
+ * Returns the value of a string, xml, binary or remote (url) token, without
+ * copy. The value is NOT null terminated, a single chunk string points into
+ * the input buffer, and is only valid until the next call or until the input
+ * buffer is modified.
+ *
+ * @param const hessian_reader_t * reader pointer to the reader.
+ * @param size_t * length the length in bytes of the value (output).
+ *
+ * @return const char * the value or NULL if the token has no such value.
+ */
+const char * hessian_reader_getview(const hessian_reader_t * reader, size_t * length);
+
+/**
+ * Returns the type of a map start, list start or remote token, NULL if the
+ * object has no type. The type is only valid until the next call.
+ */
+const char * hessian_reader_gettype(const hessian_reader_t * reader);
+
+/**
+ * Returns the length of a list start token, or -1 if unknown.
+ */
+int32_t hessian_reader_getlength(const hessian_reader_t * reader);
+
 /**
  * Stupid boolean constants
  */
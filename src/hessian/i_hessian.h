@@ -46,6 +46,32 @@ extern "C" {
 #define HESSIAN_CHUNK_SIZE INT16_MAX
 #endif
 
+/*
+ * Internal allocation functions: allocate from the arena, or from the heap
+ * if the arena is NULL. hessian_free does nothing for an arena.
+ */
+void * hessian_calloc(hessian_arena_t * arena, size_t size);
+void * hessian_realloc(hessian_arena_t * arena, void * ptr, size_t size, size_t new_size);
+void hessian_free(hessian_arena_t * arena, void * ptr);
+
+/*
+ * Internal UTF-8 string reader, the returned char array is allocated from
+ * the arena or from the heap if the arena is NULL.
+ */
+char * hessian_utf8_bgets_arena(size_t utf8_l, pep_buffer_t * input, hessian_arena_t * arena);
+
+/*
+ * Returns the number of bytes of the first utf8_l UTF-8 chars of data, or
+ * (size_t)-1 if data is truncated. Invalid sequences are logged and kept.
+ */
+size_t hessian_utf8_bytes(const char * data, size_t data_l, size_t utf8_l);
+
+/*
+ * Deletes the n objects of the array, the objects shared by several array
+ * elements (Hessian refs) are deleted only once.
+ */
+void hessian_delete_objects(hessian_object_t ** objects, size_t n);
+
 #ifdef  __cplusplus
 }
 #endif
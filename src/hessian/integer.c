@@ -70,7 +70,7 @@ static hessian_object_t * hessian_integer_ctor (hessian_object_t * object, va_li
 static int hessian_integer_serialize (const hessian_object_t * object, pep_buffer_t * output) {
     const hessian_integer_t * self= object;
     const hessian_class_t * class;
-    int32_t value, b8, b16, b24, b32;
+    int32_t value;
     if (self == NULL) {
         pep_log_error("hessian_integer_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -85,15 +85,11 @@ static int hessian_integer_serialize (const hessian_object_t * object, pep_buffe
         return HESSIAN_ERROR;
     }
     value= self->value;
-    b32 = (value >> 24) & 0x000000FF;
-    b24 = (value >> 16) & 0x000000FF;
-    b16 = (value >> 8) & 0x000000FF;
-    b8 = value & 0x000000FF;
-    pep_buffer_putc(class->tag,output);
-    pep_buffer_putc(b32,output);
-    pep_buffer_putc(b24,output);
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
+    if (pep_buffer_putc(class->tag,output) == BUFFER_ERROR
+        || pep_buffer_put_u32((uint32_t)value,output) != BUFFER_OK) {
+        pep_log_error("hessian_integer_serialize: can't write integer: %d.",(int)value);
+        return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
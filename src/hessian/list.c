@@ -21,7 +21,6 @@
 
 #include "hessian.h"
 #include "i_hessian.h"
-#include "linkedlist.h"
 #include "log.h"
 
 
@@ -33,6 +32,8 @@ static OBJECT_DTOR(hessian_list);
 static OBJECT_SERIALIZE(hessian_list);
 static OBJECT_DESERIALIZE(hessian_list);
 
+static int hessian_list_grow(hessian_list_t * self, size_t size);
+
 /**
  * Initializes and registers the Hessian list class.
  */
@@ -61,11 +62,9 @@ static hessian_object_t * hessian_list_ctor (hessian_object_t * list, va_list *
         return NULL;
     }
     self->type= NULL;
-    self->list= pep_llist_create();
-    if (self->list == NULL) {
-        pep_log_error("hessian_list_ctor: can't create list.");
-        return NULL;
-    }
+    self->items= NULL;
+    self->items_l= 0;
+    self->items_size= 0;
     return self;
 }
 
@@ -80,8 +79,8 @@ static int hessian_list_dtor (hessian_object_t * list) {
         return HESSIAN_ERROR;
     }
     if (self->type != NULL) free(self->type);
-    pep_llist_delete_elements(self->list,(pep_llist_delete_elt_f)hessian_delete);
-    pep_llist_delete(self->list);
+    hessian_delete_objects(self->items,self->items_l);
+    if (self->items != NULL) free(self->items);
     return HESSIAN_OK;
 }
 
@@ -105,10 +104,13 @@ int hessian_list_add(hessian_object_t * list, hessian_object_t * object) {
         pep_log_error("hessian_list_add: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    if (pep_llist_add(self->list, object) != LLIST_OK) {
-        pep_log_error("hessian_list_add: can't add object to list.");
-        return HESSIAN_ERROR;
+    if (self->items_l == self->items_size) {
+        if (hessian_list_grow(self,(self->items_size > 0) ? self->items_size * 2 : 8) != HESSIAN_OK) {
+            pep_log_error("hessian_list_add: can't add object to list.");
+            return HESSIAN_ERROR;
+        }
     }
+    self->items[self->items_l++]= object;
     return HESSIAN_OK;
 }
 
@@ -118,8 +120,8 @@ int hessian_list_add(hessian_object_t * list, hessian_object_t * object) {
 static int hessian_list_serialize (const hessian_object_t * list, pep_buffer_t * output) {
     const hessian_list_t * self= list;
     const hessian_class_t * class;
-    size_t str_l, utf8_l, list_l;
-    int b32, b24, b16, b8, i;
+    size_t list_l;
+    int i;
     if (self == NULL) {
         pep_log_error("hessian_list_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -134,36 +136,13 @@ static int hessian_list_serialize (const hessian_object_t * list, pep_buffer_t *
         return HESSIAN_ERROR;
     }
 
-    pep_buffer_putc(class->tag,output);
-    /* write type if any */
-    if (self->type != NULL) {
-        str_l= strlen(self->type);
-        utf8_l= hessian_utf8_strlen(self->type);
-        b16= utf8_l >> 8;
-        b8= utf8_l & 0x00FF;
-        pep_buffer_putc('t',output);
-        pep_buffer_putc(b16,output);
-        pep_buffer_putc(b8,output);
-        pep_buffer_write(self->type,1,str_l,output);
-    }
-    /* write length if any */
-    list_l= pep_llist_length(self->list);
-    if (list_l > 0) {
-        int32_t value= (int32_t)list_l;
-        b32 = (value >> 24) & 0x000000FF;
-        b24 = (value >> 16) & 0x000000FF;
-        b16 = (value >> 8) & 0x000000FF;
-        b8 = value & 0x000000FF;
-        pep_buffer_putc('l',output);
-        pep_buffer_putc(b32,output);
-        pep_buffer_putc(b24,output);
-        pep_buffer_putc(b16,output);
-        pep_buffer_putc(b8,output);
-    }
+    /* list tag, type and length if any */
+    list_l= self->items_l;
+    hessian_list_write_start(self->type,list_l,output);
     /* write all objects */
     i= 0;
     for( i= 0; i < list_l; i++ ) {
-        hessian_object_t * object= pep_llist_get(self->list,i);
+        hessian_object_t * object= self->items[i];
         if (object == NULL) {
             pep_log_error("hessian_list_add: NULL object pointer at: %d.",i);
             return HESSIAN_ERROR;
@@ -174,7 +153,45 @@ static int hessian_list_serialize (const hessian_object_t * list, pep_buffer_t *
         }
     }
 
-    pep_buffer_putc(class->chunk_tag,output);
+    return hessian_list_write_end(output);
+}
+
+int hessian_list_write_start(const char * type, size_t length, pep_buffer_t * output) {
+    size_t str_l, utf8_l;
+    if (output == NULL) {
+        pep_log_error("hessian_list_write_start: NULL output pointer.");
+        return HESSIAN_ERROR;
+    }
+    pep_buffer_putc(_hessian_list_descr.tag,output);
+    /* write type if any */
+    if (type != NULL) {
+        str_l= strlen(type);
+        utf8_l= hessian_utf8_strlen(type);
+        pep_buffer_putc('t',output);
+        pep_buffer_put_u16((uint16_t)utf8_l,output);
+        pep_buffer_write(type,1,str_l,output);
+    }
+    /* write length if any */
+    if (length > 0) {
+        pep_buffer_putc('l',output);
+        if (pep_buffer_put_u32((uint32_t)length,output) != BUFFER_OK) {
+            pep_log_error("hessian_list_write_start: can't write length: %d.",(int)length);
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+size_t hessian_list_write_start_size(const char * type, size_t length) {
+    /* tag, type tag, length and bytes, and length tag and int32 */
+    return 1 + ((type != NULL) ? 3 + strlen(type) : 0) + ((length > 0) ? 5 : 0);
+}
+
+int hessian_list_write_end(pep_buffer_t * output) {
+    if (output == NULL || pep_buffer_putc(_hessian_list_descr.chunk_tag,output) == BUFFER_ERROR) {
+        pep_log_error("hessian_list_write_end: can't write end of list.");
+        return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
@@ -184,8 +201,6 @@ static int hessian_list_serialize (const hessian_object_t * list, pep_buffer_t *
 static int hessian_list_deserialize (hessian_object_t * list, int tag, pep_buffer_t * input) {
     hessian_list_t * self= list;
     const hessian_class_t * class;
-    pep_linkedlist_t * refs;
-    size_t refs_l;
     int32_t length;
     int next_tag, i;
     if (self == NULL) {
@@ -207,12 +222,6 @@ static int hessian_list_deserialize (hessian_object_t * list, int tag, pep_buffe
         return HESSIAN_ERROR;
     }
     length= -1;
-    /* alloc the refs list for Hessian ref handling */
-    refs= pep_llist_create();
-    if (refs == NULL) {
-        pep_log_error("hessian_list_deserialize: can't create temp references list.");
-        return HESSIAN_ERROR;
-    }
     /* begin parsing */
     next_tag= pep_buffer_getc(input);
     /* optional type */
@@ -221,85 +230,75 @@ static int hessian_list_deserialize (hessian_object_t * list, int tag, pep_buffe
         int b16= pep_buffer_getc(input);
         int b8= pep_buffer_getc(input);
         size_t utf8_l= (b16 << 8) + b8;
-        char * type= hessian_utf8_bgets(utf8_l,input);
+        char * type= hessian_utf8_bgets_arena(utf8_l,input,self->arena);
         if (type == NULL) {
             pep_log_error("hessian_list_deserialize: can't read list type: %d chars.", (int)utf8_l);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
         self->type= type;
         next_tag= pep_buffer_getc(input);
     }
-    /* optional length, unused. */
+    /* optional length, used to size the items array. */
     if (next_tag == 'l') {
-        /* read int32, don't do anything with it... */
         int32_t b32 = pep_buffer_getc(input);
         int32_t b24 = pep_buffer_getc(input);
         int32_t b16 = pep_buffer_getc(input);
         int32_t b8 = pep_buffer_getc(input);
         length= (b32 << 24) + (b24 << 16) + (b16 << 8) + b8;
+        /* each element takes at least one byte */
+        if (length > 0 && (size_t)length <= pep_buffer_length(input)) {
+            if (hessian_list_grow(self,length) != HESSIAN_OK) {
+                pep_log_error("hessian_list_deserialize: can't allocate list (%d elements).",(int)length);
+                return HESSIAN_ERROR;
+            }
+        }
         next_tag= pep_buffer_getc(input);
     }
     /* do until tag != 'z' */
     while( next_tag != class->chunk_tag && next_tag != BUFFER_EOF) {
-        /* standard Hessian object, add to the refs list. */
-        hessian_object_t * o= hessian_deserialize_tag(next_tag,input);
+        hessian_object_t * o= hessian_deserialize_tag_arena(next_tag,input,self->arena);
         if (o == NULL) {
             pep_log_error("hessian_list_deserialize: can't deserialize object with tag: %c.", next_tag);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
-        if (pep_llist_add(refs,o) != LLIST_OK) {
-            pep_log_error("hessian_list_deserialize: can't add object to temp references list.");
+        if (hessian_list_add(self,o) != HESSIAN_OK) {
+            pep_log_error("hessian_list_deserialize: can't add object to list.");
             hessian_delete(o);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
         next_tag= pep_buffer_getc(input);
     }
 
-    /* alloc the objects list and fill with element from the refs lists. */
-    self->list= pep_llist_create();
-    if (self->list == NULL) {
-        pep_log_error("hessian_list_deserialize: can't create list.");
-        pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-        pep_llist_delete(refs);
-        return HESSIAN_ERROR;
-    }
-    refs_l= pep_llist_length(refs);
-    for (i= 0; i < refs_l; i++) {
-        hessian_object_t * o= (hessian_object_t *)pep_llist_get(refs,i);
-        if (o == NULL) {
-            pep_log_error("hessian_list_deserialize: NULL object in refs at: %d.",i);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-            pep_llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
-        /* handle the ref object */
+    /* references handling, replace ref object by real referenced object. */
+    for (i= 0; i < self->items_l; i++) {
+        hessian_object_t * o= self->items[i];
         if (hessian_gettype(o) == HESSIAN_REF) {
             /* get the ref index */
             int ref_index= hessian_ref_getvalue(o);
-            hessian_delete(o); /* not needed anymore */
-            /* get the real object */
-            o= (hessian_object_t *)pep_llist_get(refs,ref_index);
-            if (o == NULL) {
-                pep_log_error("hessian_list_deserialize: NULL referenced object in refs at: %d.",ref_index);
-                pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-                pep_llist_delete(refs);
+            if (ref_index < 0 || ref_index >= self->items_l || hessian_gettype(self->items[ref_index]) == HESSIAN_REF) {
+                pep_log_error("hessian_list_deserialize: invalid referenced object in list at: %d.",ref_index);
                 return HESSIAN_ERROR;
             }
+            hessian_delete(o); /* not needed anymore */
+            self->items[i]= self->items[ref_index];
         }
-        if (pep_llist_add(self->list,o) != LLIST_OK) {
-            pep_log_error("hessian_list_deserialize: can't add object to list.");
-            hessian_delete(o);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)hessian_delete);
-            pep_llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
     }
-    pep_llist_delete(refs);
+    return HESSIAN_OK;
+}
+
+/**
+ * Grows the items array of the list to size elements.
+ */
+static int hessian_list_grow(hessian_list_t * self, size_t size) {
+    hessian_object_t ** items;
+    if (size <= self->items_size) return HESSIAN_OK;
+    items= hessian_realloc(self->arena,self->items,self->items_size * sizeof(hessian_object_t *),size * sizeof(hessian_object_t *));
+    if (items == NULL) {
+        pep_log_error("hessian_list_grow: can't allocate items array (%d elements).",(int)size);
+        return HESSIAN_ERROR;
+    }
+    self->items= items;
+    self->items_size= size;
     return HESSIAN_OK;
 }
 
@@ -324,12 +323,12 @@ int hessian_list_settype(hessian_object_t * list, const char * type) {
     }
     /* free if already set */
     if (self->type != NULL) {
-        free(self->type);
+        hessian_free(self->arena,self->type);
         self->type= NULL;
     }
     if (type != NULL) {
         size_t type_l= strlen(type);
-        self->type= calloc(type_l + 1, sizeof(char));
+        self->type= hessian_calloc(self->arena,type_l + 1);
         if (self->type == NULL) {
             pep_log_error("hessian_list_settype: can't allocate type (%d chars).",(int)type_l);
             return HESSIAN_ERROR;
@@ -383,7 +382,7 @@ size_t hessian_list_length(const hessian_object_t * list) {
         pep_log_error("hessian_list_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return pep_llist_length(self->list);
+    return self->items_l;
 }
 
 /**
@@ -405,6 +404,10 @@ hessian_object_t * hessian_list_get(const hessian_object_t * list, int index) {
         pep_log_error("hessian_list_get: wrong class type: %d.",class->type);
         return NULL;
     }
-    return (hessian_object_t *) pep_llist_get(self->list,index);
+    if (index < 0 || index >= self->items_l) {
+        pep_log_error("hessian_list_get: index out of bounds: %d.",index);
+        return NULL;
+    }
+    return self->items[index];
 }
 
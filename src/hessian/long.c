@@ -72,7 +72,6 @@ static int hessian_long_serialize (const hessian_object_t * object, pep_buffer_t
     const hessian_long_t * self= object;
     const hessian_class_t * class;
     int64_t value;
-    int b8, b16, b24, b32, b40, b48, b56, b64;
     if (self == NULL) {
         pep_log_error("hessian_long_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -87,23 +86,11 @@ static int hessian_long_serialize (const hessian_object_t * object, pep_buffer_t
         return HESSIAN_ERROR;
     }
     value= self->value;
-    b64 = (value >> 56) & 0x000000FF;
-    b56 = (value >> 48) & 0x000000FF;
-    b48 = (value >> 40) & 0x000000FF;
-    b40 = (value >> 32) & 0x000000FF;
-    b32 = (value >> 24) & 0x000000FF;
-    b24 = (value >> 16) & 0x000000FF;
-    b16 = (value >> 8) & 0x000000FF;
-    b8 = value & 0x000000FF;
-    pep_buffer_putc(class->tag,output);
-    pep_buffer_putc(b64,output);
-    pep_buffer_putc(b56,output);
-    pep_buffer_putc(b48,output);
-    pep_buffer_putc(b40,output);
-    pep_buffer_putc(b32,output);
-    pep_buffer_putc(b24,output);
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
+    if (pep_buffer_putc(class->tag,output) == BUFFER_ERROR
+        || pep_buffer_put_u64((uint64_t)value,output) != BUFFER_OK) {
+        pep_log_error("hessian_long_serialize: can't write long.");
+        return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
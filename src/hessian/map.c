@@ -46,16 +46,18 @@ static const hessian_class_t _hessian_map_descr = {
 };
 const void * hessian_map_class = &_hessian_map_descr;
 
-/**
- * Internal map <key,value> pair types
- */
-typedef struct map_pair {
-    hessian_object_t * key;
-    hessian_object_t * value;
-} map_pair_t;
+static int hessian_map_grow(hessian_map_t * self, size_t size);
+static int hessian_map_addpair(hessian_map_t * self, hessian_object_t * key, hessian_object_t * value);
+static int hessian_map_index_build(hessian_map_t * self, size_t size);
+static void hessian_map_index_insert(hessian_map_t * self, size_t i);
 
-static map_pair_t * map_pair_create(hessian_object_t * key, hessian_object_t * value);
-static void map_pair_delete(map_pair_t * pair);
+/*
+ * Maps with at least HESSIAN_MAP_INDEX_MIN pairs are hash indexed on their
+ * string keys, the smaller maps are searched linearly.
+ */
+#ifndef HESSIAN_MAP_INDEX_MIN
+#define HESSIAN_MAP_INDEX_MIN 8
+#endif
 
 
 /**
@@ -83,12 +85,11 @@ static hessian_object_t * hessian_map_ctor (hessian_object_t * object, va_list *
         return NULL;
     }
     strncpy(self->type,type,type_l);
-    self->map= pep_llist_create();
-    if (self->map == NULL) {
-        pep_log_error("hessian_map_ctor: can't create map.");
-        free(self->type);
-        return NULL;
-    }
+    self->pairs= NULL;
+    self->pairs_l= 0;
+    self->pairs_size= 0;
+    self->index= NULL;
+    self->index_size= 0;
     return self;
 }
 
@@ -97,29 +98,14 @@ static hessian_object_t * hessian_map_ctor (hessian_object_t * object, va_list *
  */
 static int hessian_map_dtor (hessian_object_t * object) {
     hessian_map_t * self= object;
-    pep_linkedlist_t * keys_values;
     if (self == NULL) {
         pep_log_error("hessian_map_dtor: NULL object pointer.");
         return HESSIAN_ERROR;
     }
-    /* free map pairs in one single list (references handling) */
-    keys_values= pep_llist_create();
-    if (keys_values == NULL) {
-        pep_log_error("hessian_map_dtor: can't create temp keys_values list.");
-        return HESSIAN_ERROR;
-    }
-    while( pep_llist_length(self->map) > 0 ) {
-        map_pair_t * kv= (map_pair_t *)pep_llist_remove(self->map,0);
-        if (kv != NULL) {
-            pep_llist_add(keys_values,kv->key);
-            pep_llist_add(keys_values,kv->value);
-            free(kv);
-        }
-    }
-    pep_llist_delete_elements(keys_values,(pep_llist_delete_elt_f)hessian_delete);
-    pep_llist_delete(keys_values);
-    /* should be empty */
-    pep_llist_delete(self->map);
+    /* the pairs array is an array of keys and values (references handling) */
+    hessian_delete_objects((hessian_object_t **)self->pairs,self->pairs_l * 2);
+    if (self->pairs != NULL) free(self->pairs);
+    if (self->index != NULL) free(self->index);
     if (self->type != NULL) free(self->type);
     return HESSIAN_OK;
 }
@@ -130,8 +116,8 @@ static int hessian_map_dtor (hessian_object_t * object) {
 static int hessian_map_serialize (const hessian_object_t * object, pep_buffer_t * output) {
     const hessian_map_t * self= object;
     const hessian_class_t * class;
-    size_t str_l, utf8_l, map_l;
-    int b16, b8, i;
+    size_t map_l;
+    int i;
     if (self == NULL) {
         pep_log_error("hessian_map_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -145,28 +131,14 @@ static int hessian_map_serialize (const hessian_object_t * object, pep_buffer_t
         pep_log_error("hessian_map_serialize: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    pep_buffer_putc(class->tag,output);
-    /* write type if any */
-    if (self->type != NULL) {
-        str_l= strlen(self->type);
-        utf8_l= hessian_utf8_strlen(self->type);
-        b16= utf8_l >> 8;
-        b8= utf8_l & 0x00FF;
-        pep_buffer_putc('t',output);
-        pep_buffer_putc(b16,output);
-        pep_buffer_putc(b8,output);
-        pep_buffer_write(self->type,1,str_l,output);
-    }
+    /* map tag and type if any */
+    hessian_map_write_start(self->type,output);
 
     /* write all <key,value> pair */
-    map_l= pep_llist_length(self->map);
+    map_l= self->pairs_l;
     for( i= 0; i < map_l; i++ ) {
-        map_pair_t * kv= (map_pair_t *)pep_llist_get(self->map,i);
+        const map_pair_t * kv= &(self->pairs[i]);
         hessian_object_t * key, * value;
-        if (kv==NULL) {
-            pep_log_error("hessian_map_serialize: NULL map pair<key,value> at %d.",i);
-            return HESSIAN_ERROR;
-        }
         key= kv->key;
         if (hessian_serialize(key, output) != HESSIAN_OK) {
             pep_log_error("hessian_map_serialize: failed to serialize pair<key> at %d.",i);
@@ -180,7 +152,40 @@ static int hessian_map_serialize (const hessian_object_t * object, pep_buffer_t
     }
 
     /* end of map */
-    pep_buffer_putc(class->chunk_tag,output);
+    return hessian_map_write_end(output);
+}
+
+int hessian_map_write_start(const char * type, pep_buffer_t * output) {
+    size_t str_l, utf8_l;
+    if (output == NULL) {
+        pep_log_error("hessian_map_write_start: NULL output pointer.");
+        return HESSIAN_ERROR;
+    }
+    pep_buffer_putc(_hessian_map_descr.tag,output);
+    /* write type if any */
+    if (type != NULL) {
+        str_l= strlen(type);
+        utf8_l= hessian_utf8_strlen(type);
+        pep_buffer_putc('t',output);
+        pep_buffer_put_u16((uint16_t)utf8_l,output);
+        if (pep_buffer_write(type,1,str_l,output) != str_l) {
+            pep_log_error("hessian_map_write_start: can't write type: %s.",type);
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+size_t hessian_map_write_start_size(const char * type) {
+    /* tag, and type tag, length and bytes */
+    return 1 + ((type != NULL) ? 3 + strlen(type) : 0);
+}
+
+int hessian_map_write_end(pep_buffer_t * output) {
+    if (output == NULL || pep_buffer_putc(_hessian_map_descr.chunk_tag,output) == BUFFER_ERROR) {
+        pep_log_error("hessian_map_write_end: can't write end of map.");
+        return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
@@ -190,8 +195,6 @@ static int hessian_map_serialize (const hessian_object_t * object, pep_buffer_t
 static int hessian_map_deserialize (hessian_object_t * object, int tag, pep_buffer_t * input) {
     hessian_map_t * self= object;
     const hessian_class_t * class;
-    pep_linkedlist_t * refs;
-    size_t refs_l;
     int next_tag, i;
     if (self == NULL) {
         pep_log_error("hessian_map_deserialize: NULL object pointer.");
@@ -211,12 +214,6 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, pep_buff
         pep_log_error("hessian_map_deserialize: invalid tag: %c (%d).",(char)tag,tag);
         return HESSIAN_ERROR;
     }
-    /* alloc the refs list for Hessian ref handling */
-    refs= pep_llist_create();
-    if (refs == NULL) {
-        pep_log_error("hessian_map_deserialize: can't create temp references list.");
-        return HESSIAN_ERROR;
-    }
     /* begin parsing */
     next_tag= pep_buffer_getc(input);
     /* map type is optional or not? */
@@ -227,10 +224,9 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, pep_buff
         int b8= pep_buffer_getc(input);
         size_t utf8_l= (b16 << 8) + b8;
         /* TODO: handle empty type (0 length) */
-        char * type= hessian_utf8_bgets(utf8_l,input);
+        char * type= hessian_utf8_bgets_arena(utf8_l,input,self->arena);
         if (type == NULL) {
             pep_log_error("hessian_map_deserialize: can't read map type: %d chars.", (int)utf8_l);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
         self->type= type;
@@ -238,89 +234,45 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, pep_buff
     }
     /* do until tag != 'z' */
     while( next_tag != class->chunk_tag && next_tag != BUFFER_EOF) {
-        /* standard Hessian object, add to the refs list. */
-        hessian_object_t * key= hessian_deserialize_tag(next_tag,input);
+        hessian_object_t * key= hessian_deserialize_tag_arena(next_tag,input,self->arena);
         hessian_object_t * value;
-        map_pair_t * kv;
         if (key == NULL) {
             pep_log_error("hessian_map_deserialize: can't deserialize map pair<key> with tag: %c.", next_tag);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
         next_tag= pep_buffer_getc(input);
-        value= hessian_deserialize_tag(next_tag,input);
+        value= hessian_deserialize_tag_arena(next_tag,input,self->arena);
         if (value == NULL) {
             pep_log_error("hessian_map_deserialize: can't deserialize map pair<value> with tag: %c.", next_tag);
             hessian_delete(key);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-            pep_llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
-        kv= map_pair_create(key,value);
-        if (kv == NULL) {
-            pep_log_error("hessian_map_deserialize: can't create map pair<key,value>.");
-            hessian_delete(key);
-            hessian_delete(value);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
-        if (pep_llist_add(refs,kv) != LLIST_OK) {
-            pep_log_error("hessian_map_deserialize: can't add map pair<key,value> to temp references list.");
+        if (hessian_map_addpair(self,key,value) != HESSIAN_OK) {
+            pep_log_error("hessian_map_deserialize: can't add map pair<key,value>.");
             hessian_delete(key);
             hessian_delete(value);
-            free(kv);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-            pep_llist_delete(refs);
             return HESSIAN_ERROR;
         }
-
         next_tag= pep_buffer_getc(input);
     }
-    /* alloc the objects list and fill with element from the refs lists. */
-    self->map= pep_llist_create();
-    if(self->map == NULL) {
-        pep_log_error("hessian_map_deserialize: can't create map pairs list.");
-        pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-        pep_llist_delete(refs);
-        return HESSIAN_ERROR;
-    }
     /* references handling, replace ref object by real referenced object. */
-    refs_l= pep_llist_length(refs);
-    for (i= 0; i < refs_l; i++) {
-        map_pair_t * pair= pep_llist_get(refs,i);
-        if(pair == NULL) {
-            pep_log_error("hessian_map_deserialize: NULL map pair in temp references list at: %d.",i);
-            pep_llist_delete_elements(refs,(pep_llist_delete_elt_f)map_pair_delete);
-            pep_llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
+    for (i= 0; i < self->pairs_l; i++) {
+        map_pair_t * pair= &(self->pairs[i]);
         /* handle the ref value */
         if (hessian_gettype(pair->value) == HESSIAN_REF) {
             hessian_object_t * ref= pair->value;
             /* get the ref index */
             int ref_index= hessian_ref_getvalue(ref);
             /* get the real value */
-            map_pair_t * real_pair= pep_llist_get(refs,ref_index);
-            if (real_pair != NULL) {
+            if (ref_index >= 0 && ref_index < self->pairs_l && hessian_gettype(self->pairs[ref_index].value) != HESSIAN_REF) {
                 hessian_delete(ref); /* ref object not needed anymore */
-                pair->value= real_pair->value;
+                pair->value= self->pairs[ref_index].value;
             }
             else {
                 pep_log_warn("hessian_map_deserialize: ref object at %d reference NULL pair at: %d.",i,ref_index);
             }
         }
-        if (pep_llist_add(self->map,pair) != LLIST_OK) {
-            pep_log_error("hessian_map_deserialize: can't add map pair<key,value> to pairs list.");
-            /* delete list content! see dtor... */
-            pep_llist_delete(refs);
-            pep_llist_delete(self->map);
-            return HESSIAN_ERROR;
-        }
     }
-
-    pep_llist_delete(refs);
     return HESSIAN_OK;
 }
 
@@ -330,7 +282,6 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, pep_buff
 int hessian_map_add(hessian_object_t * object, hessian_object_t * key, hessian_object_t * value) {
     hessian_map_t * self= object;
     const hessian_class_t * class;
-    map_pair_t * pair;
     if (self == NULL) {
         pep_log_error("hessian_map_add: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -344,14 +295,15 @@ int hessian_map_add(hessian_object_t * object, hessian_object_t * key, hessian_o
         pep_log_error("hessian_map_add: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    pair= map_pair_create(key,value);
-    if (pair == NULL) {
-        pep_log_error("hessian_map_add: can't create map pair<key,value>.");
+    if (key == NULL) {
+        pep_log_error("hessian_map_add: NULL key.");
         return HESSIAN_ERROR;
     }
-    if (pep_llist_add(self->map,pair) != LLIST_OK) {
-        pep_log_error("hessian_map_add: can't add map pair<key,value> to list.");
-        free(pair);
+    if (value == NULL) {
+        value= hessian_create(HESSIAN_NULL);
+    }
+    if (hessian_map_addpair(self,key,value) != HESSIAN_OK) {
+        pep_log_error("hessian_map_add: can't add map pair<key,value>.");
         return HESSIAN_ERROR;
     }
     return HESSIAN_OK;
@@ -378,12 +330,12 @@ int hessian_map_settype(hessian_object_t * object, const char * type) {
     }
     /* free if already set */
     if (self->type != NULL) {
-        free(self->type);
+        hessian_free(self->arena,self->type);
         self->type= NULL;
     }
     if (type != NULL) {
         size_t type_l= strlen(type);
-        self->type= calloc(type_l + 1, sizeof(char));
+        self->type= hessian_calloc(self->arena,type_l + 1);
         if (self->type == NULL) {
             pep_log_error("hessian_map_settype: can't allocate type (%d chars).",(int)type_l);
             return HESSIAN_ERROR;
@@ -433,13 +385,12 @@ size_t hessian_map_length(const hessian_object_t * object) {
         pep_log_error("hessian_map_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return pep_llist_length(self->map);
+    return self->pairs_l;
 }
 
 hessian_object_t * hessian_map_getkey(const hessian_object_t * object, int index) {
     const hessian_map_t * self= object;
     const hessian_class_t * class;
-    map_pair_t * pair;
     if (self == NULL) {
         pep_log_error("hessian_map_getkey: NULL object pointer.");
         return NULL;
@@ -453,18 +404,16 @@ hessian_object_t * hessian_map_getkey(const hessian_object_t * object, int index
         pep_log_error("hessian_map_getkey: wrong class type: %d.",class->type);
         return NULL;
     }
-    pair= pep_llist_get(self->map,index);
-    if (pair == NULL) {
+    if (index < 0 || index >= self->pairs_l) {
         pep_log_error("hessian_map_getkey: NULL map pair<key,value> at: %d.",index);
         return NULL;
     }
-    else return pair->key;
+    return self->pairs[index].key;
 }
 
 hessian_object_t * hessian_map_getvalue(const hessian_object_t * object, int index) {
     const hessian_map_t * self= object;
     const hessian_class_t * class;
-    map_pair_t * pair;
     if (self == NULL) {
         pep_log_error("hessian_map_getvalue: NULL object pointer.");
         return NULL;
@@ -478,47 +427,152 @@ hessian_object_t * hessian_map_getvalue(const hessian_object_t * object, int ind
         pep_log_error("hessian_map_getvalue: wrong class type: %d.",class->type);
         return NULL;
     }
-    pair= pep_llist_get(self->map,index);
-    if (pair == NULL) {
+    if (index < 0 || index >= self->pairs_l) {
         pep_log_error("hessian_map_getvalue: NULL map pair<key,value> at: %d.",index);
         return NULL;
     }
-    else return pair->value;
+    return self->pairs[index].value;
 }
 
 /**
- * Create a map pair<key,value>. If the value is NULL an Hessian null object is added.
- *
- * @param const hessian_object_t * key not NULL key object.
- * @param const hessian_object_t * value object, can be NULL.
- * @return map_pair_t * pointer to the map pair<key,value> or NULL if an error occurs.
+ * Grows the pairs array of the map to size pairs.
  */
-static map_pair_t * map_pair_create(hessian_object_t * key, hessian_object_t * value) {
-    map_pair_t * pair= calloc(1,sizeof(map_pair_t));
-    if (pair == NULL) {
-        pep_log_error("map_pair_create: can't allocate map pair.");
+static int hessian_map_grow(hessian_map_t * self, size_t size) {
+    map_pair_t * pairs;
+    if (size <= self->pairs_size) return HESSIAN_OK;
+    pairs= hessian_realloc(self->arena,self->pairs,self->pairs_size * sizeof(map_pair_t),size * sizeof(map_pair_t));
+    if (pairs == NULL) {
+        pep_log_error("hessian_map_grow: can't allocate pairs array (%d pairs).",(int)size);
+        return HESSIAN_ERROR;
+    }
+    self->pairs= pairs;
+    self->pairs_size= size;
+    return HESSIAN_OK;
+}
+
+/**
+ * Appends the pair<key,value> at the end of the pairs array.
+ */
+static int hessian_map_addpair(hessian_map_t * self, hessian_object_t * key, hessian_object_t * value) {
+    if (self->pairs_l == self->pairs_size) {
+        if (hessian_map_grow(self,(self->pairs_size > 0) ? self->pairs_size * 2 : 8) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+    }
+    self->pairs[self->pairs_l].key= key;
+    self->pairs[self->pairs_l].value= value;
+    self->pairs_l++;
+    /* keep the index, if built, at most half full */
+    if (self->index_size > 0) {
+        if (self->pairs_l * 2 > self->index_size) {
+            if (hessian_map_index_build(self,self->index_size * 2) != HESSIAN_OK) {
+                /* lookups fall back to linear search */
+                pep_log_warn("hessian_map_addpair: can't grow keys index, index dropped.");
+            }
+        }
+        else {
+            hessian_map_index_insert(self,self->pairs_l - 1);
+        }
+    }
+    return HESSIAN_OK;
+}
+
+/* FNV-1a hash */
+static size_t hessian_map_hash(const char * key, size_t key_l) {
+    uint32_t hash= 2166136261U;
+    size_t i;
+    for (i= 0; i < key_l; i++) {
+        hash^= (unsigned char)key[i];
+        hash*= 16777619U;
+    }
+    return hash;
+}
+
+/* returns 1 if the key object is the Hessian string key */
+static int hessian_map_keyequals(const hessian_object_t * object, const char * key, size_t key_l) {
+    const hessian_string_t * string= object;
+    if (hessian_gettype(object) != HESSIAN_STRING || string->string == NULL) return 0;
+    return string->length == key_l && memcmp(string->string,key,key_l) == 0;
+}
+
+/**
+ * Inserts the string key of pair i in the index, unless the same key is
+ * already indexed (the first pair with a key wins).
+ */
+static void hessian_map_index_insert(hessian_map_t * self, size_t i) {
+    const hessian_string_t * key= self->pairs[i].key;
+    size_t mask= self->index_size - 1, slot;
+    if (hessian_gettype(key) != HESSIAN_STRING || key->string == NULL) return;
+    slot= hessian_map_hash(key->string,key->length) & mask;
+    while (self->index[slot] != 0) {
+        if (hessian_map_keyequals(self->pairs[self->index[slot] - 1].key,key->string,key->length)) return;
+        slot= (slot + 1) & mask;
+    }
+    self->index[slot]= i + 1;
+}
+
+/**
+ * (Re)builds the keys index with size slots, size is a power of 2.
+ */
+static int hessian_map_index_build(hessian_map_t * self, size_t size) {
+    size_t i;
+    size_t * index= hessian_calloc(self->arena,size * sizeof(size_t));
+    if (index == NULL) {
+        pep_log_error("hessian_map_index_build: can't allocate index (%d slots).",(int)size);
+        hessian_free(self->arena,self->index);
+        self->index= NULL;
+        self->index_size= 0;
+        return HESSIAN_ERROR;
+    }
+    hessian_free(self->arena,self->index);
+    self->index= index;
+    self->index_size= size;
+    for (i= 0; i < self->pairs_l; i++) {
+        hessian_map_index_insert(self,i);
+    }
+    return HESSIAN_OK;
+}
+
+hessian_object_t * hessian_map_get(const hessian_object_t * object, const char * key) {
+    const hessian_map_t * self= object;
+    const hessian_class_t * class;
+    size_t key_l, i;
+    if (self == NULL) {
+        pep_log_error("hessian_map_get: NULL object pointer.");
+        return NULL;
+    }
+    class= hessian_getclass(object);
+    if (class == NULL) {
+        pep_log_error("hessian_map_get: NULL class descriptor.");
+        return NULL;
+    }
+    if (class->type != HESSIAN_MAP) {
+        pep_log_error("hessian_map_get: wrong class type: %d.",class->type);
         return NULL;
     }
     if (key == NULL) {
-        pep_log_error("map_pair_create: NULL key.");
-        free(pair);
+        pep_log_error("hessian_map_get: NULL key.");
         return NULL;
     }
-    pair->key= key;
-    if (value == NULL) {
-        pair->value= hessian_create(HESSIAN_NULL);
+    key_l= strlen(key);
+    if (self->pairs_l >= HESSIAN_MAP_INDEX_MIN && self->index_size == 0) {
+        /* index built on first lookup, the map content is not modified */
+        size_t size= HESSIAN_MAP_INDEX_MIN * 2;
+        while (size < self->pairs_l * 2) size*= 2;
+        hessian_map_index_build((hessian_map_t *)self,size);
+    }
+    if (self->index_size > 0) {
+        size_t mask= self->index_size - 1;
+        size_t slot= hessian_map_hash(key,key_l) & mask;
+        while (self->index[slot] != 0) {
+            const map_pair_t * pair= &(self->pairs[self->index[slot] - 1]);
+            if (hessian_map_keyequals(pair->key,key,key_l)) return pair->value;
+            slot= (slot + 1) & mask;
+        }
+        return NULL;
     }
-    else {
-        pair->value= value;
+    for (i= 0; i < self->pairs_l; i++) {
+        if (hessian_map_keyequals(self->pairs[i].key,key,key_l)) return self->pairs[i].value;
     }
-    return pair;
+    return NULL;
 }
-
-static void map_pair_delete(map_pair_t * pair) {
-    if (pair == NULL) return;
-    hessian_delete(pair->key);
-    hessian_delete(pair->value);
-    free(pair);
-    pair= NULL;
-}
-
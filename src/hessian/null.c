@@ -61,6 +61,14 @@ static int hessian_null_serialize (const hessian_object_t * object, pep_buffer_t
     return HESSIAN_OK;
 }
 
+int hessian_null_write(pep_buffer_t * output) {
+    if (output == NULL || pep_buffer_putc(_hessian_null_descr.tag,output) == BUFFER_ERROR) {
+        pep_log_error("hessian_null_write: can't write null.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
 /**
  * Hessian null deserialize method.
  */
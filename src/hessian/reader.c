@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hessian.h"
+#include "i_hessian.h"
+#include "log.h"
+
+/*******************************
+ * Hessian pull (token) reader *
+ *******************************/
+
+/*
+ * The reader works directly on the bytes of the input buffer. A single chunk
+ * string value is a view into the input, copied (and null terminated) only
+ * when hessian_reader_getstring() is called. The chunked strings, binaries
+ * and container types are copied into buffers owned by the reader and reused
+ * between the tokens, so reading a whole object graph doesn't allocate
+ * anything once the buffers are big enough.
+ *
+ * A partial input is read while it arrives: a token truncated by the end of
+ * the input is rewound and returned as HESSIAN_TOKEN_MORE, and read again
+ * once more bytes are appended (hessian_reader_refill).
+ */
+
+/* initial containers stack size */
+#ifndef HESSIAN_READER_STACK_SIZE
+#define HESSIAN_READER_STACK_SIZE 16
+#endif
+
+struct hessian_reader {
+    const unsigned char * data; /* input bytes */
+    size_t data_l;
+    size_t pos; /* next byte to read */
+    char * frames; /* containers stack: 'M' or 'V' */
+    size_t frames_size;
+    size_t frames_l;
+    hessian_token_t token; /* last token read */
+    int32_t integer; /* boolean, integer, ref or list length value */
+    int64_t value; /* long, date and double bits value */
+    const char * view; /* string, xml, binary or url value */
+    size_t view_l;
+    int view_copied; /* view is null terminated in the string buffer */
+    pep_buffer_t * string; /* copied value */
+    pep_buffer_t * type; /* container or remote type */
+    int has_type;
+    int partial; /* more input bytes will arrive */
+    int truncated; /* the token is truncated by the end of the input */
+};
+
+static int reader_utf8(hessian_reader_t * reader, int tag, pep_buffer_t * sb);
+static int reader_utf8_view(hessian_reader_t * reader, int tag);
+static int reader_copied(hessian_reader_t * reader);
+static int reader_bytes(hessian_reader_t * reader, int tag, pep_buffer_t * sb);
+static int reader_container(hessian_reader_t * reader, int tag);
+static int reader_truncated(hessian_reader_t * reader);
+
+hessian_reader_t * hessian_reader_create(void) {
+    hessian_reader_t * reader= calloc(1,sizeof(struct hessian_reader));
+    if (reader == NULL) {
+        pep_log_error("hessian_reader_create: can't allocate hessian_reader_t.");
+        return NULL;
+    }
+    reader->string= pep_buffer_create(256);
+    reader->type= pep_buffer_create(64);
+    reader->frames_size= HESSIAN_READER_STACK_SIZE;
+    reader->frames= calloc(reader->frames_size,sizeof(char));
+    if (reader->string == NULL || reader->type == NULL || reader->frames == NULL) {
+        pep_log_error("hessian_reader_create: can't allocate reader buffers.");
+        hessian_reader_delete(reader);
+        return NULL;
+    }
+    reader->token= HESSIAN_TOKEN_EOF;
+    return reader;
+}
+
+void hessian_reader_delete(hessian_reader_t * reader) {
+    if (reader == NULL) return;
+    pep_buffer_delete(reader->string);
+    pep_buffer_delete(reader->type);
+    free(reader->frames);
+    free(reader);
+}
+
+int hessian_reader_reset(hessian_reader_t * reader, pep_buffer_t * input) {
+    if (reader == NULL || input == NULL) {
+        pep_log_error("hessian_reader_reset: NULL reader or input buffer pointer.");
+        return HESSIAN_ERROR;
+    }
+    reader->data= pep_buffer_peek(input);
+    reader->data_l= pep_buffer_length(input);
+    reader->pos= 0;
+    reader->frames_l= 0;
+    reader->token= HESSIAN_TOKEN_EOF;
+    reader->has_type= FALSE;
+    reader->partial= FALSE;
+    return HESSIAN_OK;
+}
+
+int hessian_reader_refill(hessian_reader_t * reader, pep_buffer_t * input, int partial) {
+    if (reader == NULL || input == NULL) {
+        pep_log_error("hessian_reader_refill: NULL reader or input buffer pointer.");
+        return HESSIAN_ERROR;
+    }
+    if (pep_buffer_length(input) < reader->pos) {
+        pep_log_error("hessian_reader_refill: input buffer consumed (%d bytes) before offset: %d.",(int)pep_buffer_length(input),(int)reader->pos);
+        return HESSIAN_ERROR;
+    }
+    /* the buffer memory can move when it grows */
+    reader->data= pep_buffer_peek(input);
+    reader->data_l= pep_buffer_length(input);
+    reader->partial= partial;
+    return HESSIAN_OK;
+}
+
+size_t hessian_reader_offset(const hessian_reader_t * reader) {
+    if (reader == NULL) return 0;
+    return reader->pos;
+}
+
+size_t hessian_reader_depth(const hessian_reader_t * reader) {
+    if (reader == NULL) return 0;
+    return reader->frames_l;
+}
+
+int hessian_reader_rewind(hessian_reader_t * reader, size_t offset, size_t depth) {
+    if (reader == NULL || offset > reader->pos || depth > reader->frames_size) {
+        pep_log_error("hessian_reader_rewind: invalid position: %d (depth: %d).",(int)offset,(int)depth);
+        return HESSIAN_ERROR;
+    }
+    /* the containers below depth are still on the stack, an end token only
+       decrements the stack length */
+    reader->pos= offset;
+    reader->frames_l= depth;
+    reader->token= HESSIAN_TOKEN_EOF;
+    reader->has_type= FALSE;
+    return HESSIAN_OK;
+}
+
+/**
+ * The input ends within the token: an error, rewound by hessian_reader_next()
+ * if the input is partial.
+ */
+static int reader_truncated(hessian_reader_t * reader) {
+    reader->truncated= TRUE;
+    return HESSIAN_ERROR;
+}
+
+/**
+ * Reads n bytes as a big-endian unsigned integer.
+ */
+static int reader_uint(hessian_reader_t * reader, size_t n, uint64_t * value) {
+    uint64_t v= 0;
+    if (reader->data_l - reader->pos < n) {
+        if (!reader->partial) pep_log_error("hessian_reader_next: truncated input, %d bytes expected.",(int)n);
+        return reader_truncated(reader);
+    }
+    while (n-- > 0) {
+        v= (v << 8) | reader->data[reader->pos++];
+    }
+    *value= v;
+    return HESSIAN_OK;
+}
+
+hessian_token_t hessian_reader_next(hessian_reader_t * reader) {
+    uint64_t v;
+    int tag;
+    size_t start, start_frames_l;
+    if (reader == NULL) {
+        pep_log_error("hessian_reader_next: NULL reader pointer.");
+        return HESSIAN_TOKEN_ERROR;
+    }
+    if (reader->token == HESSIAN_TOKEN_ERROR) {
+        return HESSIAN_TOKEN_ERROR;
+    }
+    reader->has_type= FALSE;
+    reader->truncated= FALSE;
+    start= reader->pos;
+    start_frames_l= reader->frames_l;
+    if (reader->pos >= reader->data_l) {
+        if (reader->partial) {
+            return reader->token= HESSIAN_TOKEN_MORE;
+        }
+        if (reader->frames_l > 0) {
+            pep_log_error("hessian_reader_next: truncated input, %d containers not ended.",(int)reader->frames_l);
+            return reader->token= HESSIAN_TOKEN_ERROR;
+        }
+        return reader->token= HESSIAN_TOKEN_EOF;
+    }
+    tag= reader->data[reader->pos++];
+    switch (tag) {
+    case 'N':
+        return reader->token= HESSIAN_TOKEN_NULL;
+    case 'T':
+    case 'F':
+        reader->integer= (tag == 'T') ? TRUE : FALSE;
+        return reader->token= HESSIAN_TOKEN_BOOLEAN;
+    case 'I':
+    case 'R':
+        if (reader_uint(reader,4,&v) != HESSIAN_OK) break;
+        reader->integer= (int32_t)(uint32_t)v;
+        return reader->token= (tag == 'I') ? HESSIAN_TOKEN_INTEGER : HESSIAN_TOKEN_REF;
+    case 'L':
+    case 'd':
+    case 'D':
+        if (reader_uint(reader,8,&v) != HESSIAN_OK) break;
+        reader->value= (int64_t)v;
+        if (tag == 'D') return reader->token= HESSIAN_TOKEN_DOUBLE;
+        return reader->token= (tag == 'L') ? HESSIAN_TOKEN_LONG : HESSIAN_TOKEN_DATE;
+    case 'S':
+    case 's':
+    case 'X':
+    case 'x':
+        if (reader_utf8_view(reader,tag) != HESSIAN_OK) break;
+        return reader->token= (tag == 'S' || tag == 's') ? HESSIAN_TOKEN_STRING : HESSIAN_TOKEN_XML;
+    case 'B':
+    case 'b':
+        pep_buffer_reset(reader->string);
+        if (reader_bytes(reader,tag,reader->string) != HESSIAN_OK || reader_copied(reader) != HESSIAN_OK) break;
+        return reader->token= HESSIAN_TOKEN_BINARY;
+    case 'r':
+        /* remote: 't' type and 'S' url */
+        if (reader->pos >= reader->data_l) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated remote, type expected.");
+            reader_truncated(reader);
+            break;
+        }
+        if (reader->data[reader->pos] != 't') {
+            pep_log_error("hessian_reader_next: remote without type.");
+            break;
+        }
+        reader->pos++;
+        pep_buffer_reset(reader->type);
+        if (reader_utf8(reader,'t',reader->type) != HESSIAN_OK) break;
+        if (reader->pos >= reader->data_l) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated remote, url expected.");
+            reader_truncated(reader);
+            break;
+        }
+        if (reader->data[reader->pos] != 'S') {
+            pep_log_error("hessian_reader_next: remote without url.");
+            break;
+        }
+        reader->pos++;
+        pep_buffer_reset(reader->string);
+        if (reader_utf8(reader,'S',reader->string) != HESSIAN_OK || reader_copied(reader) != HESSIAN_OK) break;
+        reader->has_type= TRUE;
+        return reader->token= HESSIAN_TOKEN_REMOTE;
+    case 'M':
+    case 'V':
+        if (reader_container(reader,tag) != HESSIAN_OK) break;
+        return reader->token= (tag == 'M') ? HESSIAN_TOKEN_MAP_START : HESSIAN_TOKEN_LIST_START;
+    case 'z':
+        if (reader->frames_l == 0) {
+            pep_log_error("hessian_reader_next: end of container without container.");
+            break;
+        }
+        tag= reader->frames[--reader->frames_l];
+        return reader->token= (tag == 'M') ? HESSIAN_TOKEN_MAP_END : HESSIAN_TOKEN_LIST_END;
+    default:
+        pep_log_error("hessian_reader_next: unknown tag: %c (0x%0X) at: %d.",tag,tag,(int)(reader->pos - 1));
+        break;
+    }
+    if (reader->truncated && reader->partial) {
+        /* read the whole token again with the next bytes */
+        reader->pos= start;
+        reader->frames_l= start_frames_l;
+        return reader->token= HESSIAN_TOKEN_MORE;
+    }
+    return reader->token= HESSIAN_TOKEN_ERROR;
+}
+
+/**
+ * Opens a container: pushes it on the stack and reads the optional type and
+ * (list) length.
+ */
+static int reader_container(hessian_reader_t * reader, int tag) {
+    uint64_t v;
+    if (reader->frames_l >= reader->frames_size) {
+        size_t frames_size= reader->frames_size * 2;
+        char * frames= realloc(reader->frames,frames_size * sizeof(char));
+        if (frames == NULL) {
+            pep_log_error("hessian_reader_next: can't grow containers stack (%d frames).",(int)frames_size);
+            return HESSIAN_ERROR;
+        }
+        reader->frames= frames;
+        reader->frames_size= frames_size;
+    }
+    reader->frames[reader->frames_l++]= (char)tag;
+    reader->integer= -1;
+    /* the optional type and length can still arrive */
+    if (reader->partial && reader->pos >= reader->data_l) return reader_truncated(reader);
+    if (reader->pos < reader->data_l && reader->data[reader->pos] == 't') {
+        reader->pos++;
+        pep_buffer_reset(reader->type);
+        if (reader_utf8(reader,'t',reader->type) != HESSIAN_OK) return HESSIAN_ERROR;
+        reader->has_type= TRUE;
+    }
+    if (tag == 'V' && reader->partial && reader->pos >= reader->data_l) return reader_truncated(reader);
+    if (tag == 'V' && reader->pos < reader->data_l && reader->data[reader->pos] == 'l') {
+        reader->pos++;
+        if (reader_uint(reader,4,&v) != HESSIAN_OK) return HESSIAN_ERROR;
+        reader->integer= (int32_t)(uint32_t)v;
+    }
+    return HESSIAN_OK;
+}
+
+/**
+ * Null terminates the value read into the sb buffer, the terminator is not
+ * counted in the value length.
+ */
+static int reader_terminate(pep_buffer_t * sb) {
+    if (pep_buffer_putc('\0',sb) == BUFFER_ERROR) {
+        pep_log_error("hessian_reader_next: can't terminate the value.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+/**
+ * Reads the UTF-8 chunks of a string, xml or type into the sb buffer. The
+ * chunk lengths are in chars, the byte length is found with the lead bytes.
+ */
+static int reader_utf8(hessian_reader_t * reader, int tag, pep_buffer_t * sb) {
+    for (;;) {
+        uint64_t utf8_l;
+        size_t n;
+        int next_tag;
+        if (reader_uint(reader,2,&utf8_l) != HESSIAN_OK) return HESSIAN_ERROR;
+        n= hessian_utf8_bytes((const char *)reader->data + reader->pos,reader->data_l - reader->pos,utf8_l);
+        if (n == (size_t)-1) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated UTF-8 string, %d chars expected.",(int)utf8_l);
+            return reader_truncated(reader);
+        }
+        if (pep_buffer_write(reader->data + reader->pos,sizeof(char),n,sb) == BUFFER_ERROR) {
+            pep_log_error("hessian_reader_next: can't copy UTF-8 string chunk.");
+            return HESSIAN_ERROR;
+        }
+        reader->pos+= n;
+        /* 's' and 'x' chunks are followed by the next chunk */
+        if (tag != 's' && tag != 'x') break;
+        if (reader->pos >= reader->data_l) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated input, chunk tag expected.");
+            return reader_truncated(reader);
+        }
+        next_tag= reader->data[reader->pos++];
+        if (next_tag != tag && next_tag != tag - ('a' - 'A')) {
+            pep_log_error("hessian_reader_next: invalid chunk tag: %c (0x%0X) for tag: %c.",next_tag,next_tag,tag);
+            return HESSIAN_ERROR;
+        }
+        tag= next_tag;
+    }
+    return reader_terminate(sb);
+}
+
+/**
+ * Reads a string or xml value: a single chunk value is a view into the input,
+ * the chunks of a chunked value are copied into the string buffer.
+ */
+static int reader_utf8_view(hessian_reader_t * reader, int tag) {
+    uint64_t utf8_l;
+    size_t n;
+    if (tag == 's' || tag == 'x') {
+        pep_buffer_reset(reader->string);
+        if (reader_utf8(reader,tag,reader->string) != HESSIAN_OK) return HESSIAN_ERROR;
+        return reader_copied(reader);
+    }
+    if (reader_uint(reader,2,&utf8_l) != HESSIAN_OK) return HESSIAN_ERROR;
+    n= hessian_utf8_bytes((const char *)reader->data + reader->pos,reader->data_l - reader->pos,utf8_l);
+    if (n == (size_t)-1) {
+        if (!reader->partial) pep_log_error("hessian_reader_next: truncated UTF-8 string, %d chars expected.",(int)utf8_l);
+        return reader_truncated(reader);
+    }
+    reader->view= (const char *)reader->data + reader->pos;
+    reader->view_l= n;
+    reader->view_copied= FALSE;
+    reader->pos+= n;
+    return HESSIAN_OK;
+}
+
+/**
+ * Sets the view on the null terminated value copied into the string buffer.
+ */
+static int reader_copied(hessian_reader_t * reader) {
+    reader->view= (const char *)pep_buffer_peek(reader->string);
+    reader->view_l= pep_buffer_length(reader->string) - 1;
+    reader->view_copied= TRUE;
+    return HESSIAN_OK;
+}
+
+/**
+ * Reads the chunks of a binary into the sb buffer.
+ */
+static int reader_bytes(hessian_reader_t * reader, int tag, pep_buffer_t * sb) {
+    for (;;) {
+        uint64_t length;
+        if (reader_uint(reader,2,&length) != HESSIAN_OK) return HESSIAN_ERROR;
+        if (reader->data_l - reader->pos < length) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated binary, %d bytes expected.",(int)length);
+            return reader_truncated(reader);
+        }
+        if (pep_buffer_write(reader->data + reader->pos,sizeof(char),length,sb) == BUFFER_ERROR) {
+            pep_log_error("hessian_reader_next: can't copy binary chunk.");
+            return HESSIAN_ERROR;
+        }
+        reader->pos+= length;
+        if (tag != 'b') break;
+        if (reader->pos >= reader->data_l) {
+            if (!reader->partial) pep_log_error("hessian_reader_next: truncated input, chunk tag expected.");
+            return reader_truncated(reader);
+        }
+        tag= reader->data[reader->pos++];
+        if (tag != 'B' && tag != 'b') {
+            pep_log_error("hessian_reader_next: invalid binary chunk tag: %c (0x%0X).",tag,tag);
+            return HESSIAN_ERROR;
+        }
+    }
+    return reader_terminate(sb);
+}
+
+int hessian_reader_skip(hessian_reader_t * reader) {
+    size_t depth;
+    if (reader == NULL) {
+        pep_log_error("hessian_reader_skip: NULL reader pointer.");
+        return HESSIAN_ERROR;
+    }
+    switch (reader->token) {
+    case HESSIAN_TOKEN_ERROR:
+        return HESSIAN_ERROR;
+    case HESSIAN_TOKEN_MAP_START:
+    case HESSIAN_TOKEN_LIST_START:
+        break;
+    default:
+        /* leaf value already read */
+        return HESSIAN_OK;
+    }
+    depth= reader->frames_l - 1;
+    while (reader->frames_l > depth) {
+        if (hessian_reader_next(reader) <= HESSIAN_TOKEN_EOF) {
+            pep_log_error("hessian_reader_skip: can't skip the container.");
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+int32_t hessian_reader_getinteger(const hessian_reader_t * reader) {
+    if (reader == NULL) return 0;
+    return reader->integer;
+}
+
+int64_t hessian_reader_getlong(const hessian_reader_t * reader) {
+    if (reader == NULL) return 0;
+    return reader->value;
+}
+
+double hessian_reader_getdouble(const hessian_reader_t * reader) {
+    double value;
+    if (reader == NULL) return 0;
+    /* the 64-bit long bits of the double */
+    memcpy(&value,&(reader->value),sizeof(double));
+    return value;
+}
+
+const char * hessian_reader_getview(const hessian_reader_t * reader, size_t * length) {
+    if (reader == NULL) return NULL;
+    switch (reader->token) {
+    case HESSIAN_TOKEN_STRING:
+    case HESSIAN_TOKEN_XML:
+    case HESSIAN_TOKEN_BINARY:
+    case HESSIAN_TOKEN_REMOTE:
+        break;
+    default:
+        return NULL;
+    }
+    if (length != NULL) *length= reader->view_l;
+    return reader->view;
+}
+
+const char * hessian_reader_getstring(hessian_reader_t * reader, size_t * length) {
+    const char * view= hessian_reader_getview(reader,length);
+    if (view == NULL || reader->view_copied) return view;
+    /* copy the view to null terminate it */
+    pep_buffer_reset(reader->string);
+    if (pep_buffer_write(view,sizeof(char),reader->view_l,reader->string) == BUFFER_ERROR
+            || reader_terminate(reader->string) != HESSIAN_OK) {
+        pep_log_error("hessian_reader_getstring: can't copy the value.");
+        return NULL;
+    }
+    reader_copied(reader);
+    return reader->view;
+}
+
+const char * hessian_reader_gettype(const hessian_reader_t * reader) {
+    if (reader == NULL || !reader->has_type) return NULL;
+    return (const char *)pep_buffer_peek(reader->type);
+}
+
+int32_t hessian_reader_getlength(const hessian_reader_t * reader) {
+    if (reader == NULL || reader->token != HESSIAN_TOKEN_LIST_START) return -1;
+    return reader->integer;
+}
@@ -111,7 +111,6 @@ static int hessian_remote_serialize (const hessian_object_t * object, pep_buffer
     const hessian_remote_t * self= object;
     const hessian_class_t * class;
     size_t str_l, utf8_l;
-    int b8, b16;
     if (self == NULL) {
         pep_log_error("hessian_remote_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -129,20 +128,14 @@ static int hessian_remote_serialize (const hessian_object_t * object, pep_buffer
     /* write type */
     str_l= strlen(self->type);
     utf8_l= hessian_utf8_strlen(self->type);
-    b16= utf8_l >> 8;
-    b8= utf8_l & 0x00FF;
     pep_buffer_putc('t',output);
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
+    pep_buffer_put_u16((uint16_t)utf8_l,output);
     pep_buffer_write(self->type,1,str_l,output);
     /* write url (utf8) */
     str_l= strlen(self->url);
     utf8_l= hessian_utf8_strlen(self->url);
-    b16= utf8_l >> 8;
-    b8= utf8_l & 0x00FF;
     pep_buffer_putc('S',output);
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
+    pep_buffer_put_u16((uint16_t)utf8_l,output);
     pep_buffer_write(self->url,1,str_l,output);
 
     return HESSIAN_OK;
@@ -185,7 +178,7 @@ static int hessian_remote_deserialize (hessian_object_t * object, int tag, pep_b
     b16= pep_buffer_getc(input);
     b8= pep_buffer_getc(input);
     utf8_l= (b16 << 8) + b8;
-    type= hessian_utf8_bgets(utf8_l,input);
+    type= hessian_utf8_bgets_arena(utf8_l,input,self->arena);
     self->type= type;
     url_tag= pep_buffer_getc(input);
     if (url_tag != 'S') {
@@ -196,7 +189,7 @@ static int hessian_remote_deserialize (hessian_object_t * object, int tag, pep_b
     b16= pep_buffer_getc(input);
     b8= pep_buffer_getc(input);
     utf8_l= (b16 << 8) + b8;
-    url= hessian_utf8_bgets(utf8_l,input);
+    url= hessian_utf8_bgets_arena(utf8_l,input,self->arena);
     self->url= url;
     return HESSIAN_OK;
 }
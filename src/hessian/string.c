@@ -34,6 +34,8 @@ static OBJECT_CTOR(hessian_string);
 static OBJECT_DTOR(hessian_string);
 static OBJECT_SERIALIZE(hessian_string);
 static OBJECT_DESERIALIZE(hessian_string);
+static int hessian_string_write_tagged(int tag, int chunk_tag, const char * string, size_t str_l, size_t utf8_l, pep_buffer_t * output);
+static int hessian_utf8_chunks(int tag, int chunk_tag, const char * data, size_t data_l, char * dst, size_t * bytes_l, size_t * chars_l, size_t * data_used);
 
 
 /**
@@ -74,7 +76,33 @@ static hessian_object_t * hessian_string_ctor (hessian_object_t * object, va_lis
         pep_log_error("hessian_string_ctor: can't allocate string (%d chars).",(int)str_l);
         return NULL;
     }
-    strncpy(self->string,str,str_l);
+    memcpy(self->string,str,str_l);
+    self->length= str_l;
+    self->utf8_length= hessian_utf8_count(str,str_l);
+    return self;
+}
+
+hessian_object_t * hessian_string_create_n(const char * string, size_t length) {
+    hessian_string_t * self;
+    if (string == NULL) {
+        pep_log_error("hessian_string_create_n: NULL string.");
+        return NULL;
+    }
+    self= calloc(1,sizeof(hessian_string_t));
+    if (self == NULL) {
+        pep_log_error("hessian_string_create_n: can't allocate object descriptor (%d bytes).",(int)sizeof(hessian_string_t));
+        return NULL;
+    }
+    self->class= hessian_string_class;
+    self->string= calloc(length + 1,sizeof(char));
+    if (self->string == NULL) {
+        pep_log_error("hessian_string_create_n: can't allocate string (%d chars).",(int)length);
+        free(self);
+        return NULL;
+    }
+    memcpy(self->string,string,length);
+    self->length= length;
+    self->utf8_length= hessian_utf8_count(string,length);
     return self;
 }
 
@@ -100,9 +128,6 @@ static int hessian_string_dtor (hessian_object_t * object) {
 static int hessian_string_serialize (const hessian_object_t * object, pep_buffer_t * output) {
     const hessian_string_t * self= object;
     const hessian_class_t * class;
-    size_t str_l, utf8_l, pos;
-    const char * chunk, * rest;
-    int b8, b16;
     if (self == NULL) {
         pep_log_error("hessian_string_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -116,57 +141,84 @@ static int hessian_string_serialize (const hessian_object_t * object, pep_buffer
         pep_log_error("hessian_string_serialize: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    str_l= strlen(self->string); /* effective chars (bytes) */
-    utf8_l= hessian_utf8_strlen(self->string);
-    pos= 0;
+    return hessian_string_write_tagged(class->tag,class->chunk_tag,self->string,self->length,self->utf8_length,output);
+}
+
+/**
+ * Writes the UTF-8 string of str_l bytes and utf8_l chars, in HESSIAN_CHUNK_SIZE
+ * chunks if longer, with the given final and chunk tags.
+ */
+static int hessian_string_write_tagged(int tag, int chunk_tag, const char * string, size_t str_l, size_t utf8_l, pep_buffer_t * output) {
+    size_t pos= 0;
     /* WARN: number of chars != number of bytes (multi-byte utf8) */
     while (utf8_l > HESSIAN_CHUNK_SIZE) {
-        size_t start_pos;
-        int n_utf8s;
+        /* number of effective bytes of HESSIAN_CHUNK_SIZE utf8 chars */
+        size_t chunk_l= hessian_utf8_offset(&(string[pos]),str_l - pos,HESSIAN_CHUNK_SIZE);
         /* send utf8 chunks */
-        b16= (HESSIAN_CHUNK_SIZE >> 8) & 0x00FF;
-        b8= HESSIAN_CHUNK_SIZE & 0x00FF;
-        pep_buffer_putc(class->chunk_tag,output);
-        pep_buffer_putc(b16,output);
-        pep_buffer_putc(b8,output);
-        /* write HESSIAN_CHUNK_SIZE utf8 chars */
-        chunk= &(self->string[pos]);
-        /* number of effective bytes */
-        start_pos= pos;
-        n_utf8s= 0;
-        while( n_utf8s < HESSIAN_CHUNK_SIZE ) {
-            int byte= self->string[pos++];
-            if ((byte & 0xC0) != 0x80) {
-                n_utf8s++;
-                if ((byte & 0xE0) == 0xC0) pos++; /* start of the 2-byte seq. */
-                else if ((byte & 0xF0) == 0xE0) pos+= 2; /* start of the 3-byte seq. */
-                else if ((byte & 0xF0) == 0xF0) pos+= 3; /* start of the 4-byte seq. */
-            }
-        }
-        pep_buffer_write(chunk,1,(pos - start_pos),output);
+        pep_buffer_putc(chunk_tag,output);
+        pep_buffer_put_u16(HESSIAN_CHUNK_SIZE,output);
+        pep_buffer_write(&(string[pos]),1,chunk_l,output);
+        pos+= chunk_l;
         utf8_l= utf8_l - HESSIAN_CHUNK_SIZE;
     }
 
-    b16= utf8_l >> 8;
-    b8= utf8_l & 0x00FF;
-    pep_buffer_putc(class->tag,output);
-    pep_buffer_putc(b16,output);
-    pep_buffer_putc(b8,output);
-    rest= &(self->string[pos]);
-    pep_buffer_write(rest,1,(str_l - pos),output);
+    pep_buffer_putc(tag,output);
+    pep_buffer_put_u16((uint16_t)utf8_l,output);
+    pep_buffer_write(&(string[pos]),1,(str_l - pos),output);
 
     return HESSIAN_OK;
 }
 
+int hessian_string_write(const char * string, pep_buffer_t * output) {
+    size_t length;
+    if (string == NULL || output == NULL) {
+        pep_log_error("hessian_string_write: NULL string or output pointer.");
+        return HESSIAN_ERROR;
+    }
+    length= strlen(string);
+    return hessian_string_write_tagged(_hessian_string_descr.tag,_hessian_string_descr.chunk_tag,string,length,hessian_utf8_count(string,length),output);
+}
+
+int hessian_string_write_n(const char * string, size_t length, size_t utf8_length, pep_buffer_t * output) {
+    if (string == NULL || output == NULL) {
+        pep_log_error("hessian_string_write_n: NULL string or output pointer.");
+        return HESSIAN_ERROR;
+    }
+    return hessian_string_write_tagged(_hessian_string_descr.tag,_hessian_string_descr.chunk_tag,string,length,utf8_length,output);
+}
+
+size_t hessian_string_write_size(const char * string) {
+    size_t length;
+    if (string == NULL) return 0;
+    length= strlen(string);
+    return hessian_string_write_size_n(length,hessian_utf8_count(string,length));
+}
+
+size_t hessian_string_write_size_n(size_t length, size_t utf8_length) {
+    /* a 3 bytes header per HESSIAN_CHUNK_SIZE chars chunk, and for the final chunk */
+    return length + 3 + ((utf8_length > 0) ? 3 * ((utf8_length - 1) / HESSIAN_CHUNK_SIZE) : 0);
+}
+
+int hessian_encoded_write(const void * encoded, size_t size, pep_buffer_t * output) {
+    if (encoded == NULL || output == NULL) {
+        pep_log_error("hessian_encoded_write: NULL encoded or output pointer.");
+        return HESSIAN_ERROR;
+    }
+    if (pep_buffer_write(encoded,1,size,output) != size) {
+        pep_log_error("hessian_encoded_write: can't write %d bytes.",(int)size);
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
 /**
  * Hessian string deserialize method.
  */
 static int hessian_string_deserialize (hessian_object_t * object, int tag, pep_buffer_t * input) {
     hessian_string_t * self= object;
     const hessian_class_t * class;
-    pep_buffer_t * sb;
-    size_t sb_size, sb_l;
-    int fully_read;
+    const char * data;
+    size_t data_l, data_used, bytes_l, chars_l;
     if (self == NULL) {
         pep_log_error("hessian_string_deserialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -185,45 +237,80 @@ static int hessian_string_deserialize (hessian_object_t * object, int tag, pep_b
         pep_log_error("hessian_string_deserialize: invalid tag: %c (%d).",(char)tag,tag);
         return HESSIAN_ERROR;
     }
-    /* use a string buffer as tmp */
-    sb_size= 32;
-    if (tag == class->chunk_tag) sb_size= HESSIAN_CHUNK_SIZE;
-    sb= pep_buffer_create(sb_size);
-    if (sb == NULL) {
-        pep_log_error("hessian_string_deserialize: can't create temp buffer (%d bytes).",(int)sb_size);
+    /* the chunk headers give the total length, the string is copied once */
+    data= (const char *)pep_buffer_peek(input);
+    data_l= pep_buffer_length(input);
+    if (hessian_utf8_chunks(tag,class->chunk_tag,data,data_l,NULL,&bytes_l,&chars_l,&data_used) != HESSIAN_OK) {
+        pep_log_error("hessian_string_deserialize: can't read UTF-8 string chunks.");
         return HESSIAN_ERROR;
     }
-    fully_read= FALSE;
-    while (!fully_read) {
-        /* read the utf8 str length */
-        int b16= pep_buffer_getc(input);
-        int b8= pep_buffer_getc(input);
-        size_t utf8_l= (b16 << 8) + b8;
-        /* fully read UTF8 string (chunk) */
-        char * utf8= hessian_utf8_bgets(utf8_l,input);
-        /* FIXME: utf8 == NULL ?? */
-        pep_buffer_write(utf8,sizeof(char),strlen(utf8),sb);
-        free(utf8);
+    self->string= hessian_calloc(self->arena,bytes_l + 1);
+    if (self->string == NULL) {
+        pep_log_error("hessian_string_deserialize: can't allocate string (%d chars).", (int)bytes_l);
+        return HESSIAN_ERROR;
+    }
+    if (tag == class->tag) {
+        /* single chunk, after the length */
+        memcpy(self->string,data + 2,bytes_l);
+    }
+    else {
+        hessian_utf8_chunks(tag,class->chunk_tag,data,data_l,self->string,&bytes_l,&chars_l,&data_used);
+    }
+    self->length= bytes_l;
+    self->utf8_length= chars_l;
+    pep_buffer_skip(input,data_used);
+    return HESSIAN_OK;
+}
+
+/**
+ * Reads the UTF-8 string chunks following the tag. The chunk lengths are in
+ * chars, the byte lengths are found with the lead bytes.
+ *
+ * @param int tag the first (chunk or final) tag, already read.
+ * @param int chunk_tag the chunk tag, the final tag is the upper case chunk tag.
+ * @param const char * data the input bytes following the tag.
+ * @param size_t data_l the number of input bytes.
+ * @param char * dst the chunks bytes are copied into dst if not NULL.
+ * @param size_t * bytes_l the total bytes of the chunks (output).
+ * @param size_t * chars_l the total UTF-8 chars of the chunks (output).
+ * @param size_t * data_used the input bytes read (output).
+ * @return int HESSIAN_OK or HESSIAN_ERROR if the input is truncated or invalid.
+ *         Invalid UTF-8 sequences are logged and kept.
+ */
+static int hessian_utf8_chunks(int tag, int chunk_tag, const char * data, size_t data_l, char * dst, size_t * bytes_l, size_t * chars_l, size_t * data_used) {
+    size_t pos= 0, total= 0, chars= 0;
+    for (;;) {
+        size_t utf8_l, n;
+        if (data_l - pos < 2) {
+            pep_log_error("utf8_chunks: truncated input, chunk length expected.");
+            return HESSIAN_ERROR;
+        }
+        utf8_l= ((size_t)(unsigned char)data[pos] << 8) + (unsigned char)data[pos + 1];
+        pos+= 2;
+        n= hessian_utf8_bytes(data + pos,data_l - pos,utf8_l);
+        if (n == (size_t)-1) {
+            pep_log_error("utf8_chunks: truncated UTF-8 string, %d chars expected.",(int)utf8_l);
+            return HESSIAN_ERROR;
+        }
+        if (dst != NULL) memcpy(dst + total,data + pos,n);
+        total+= n;
+        chars+= utf8_l;
+        pos+= n;
         /* was it final chunk? */
-        if (tag == class->chunk_tag) {
-            tag= pep_buffer_getc(input);
+        if (tag != chunk_tag) break;
+        if (pos >= data_l) {
+            pep_log_error("utf8_chunks: truncated input, chunk tag expected.");
+            return HESSIAN_ERROR;
         }
-        else {
-            /* tag == class->tag (final) */
-            fully_read= TRUE;
+        tag= (unsigned char)data[pos++];
+        if (tag != chunk_tag && tag != chunk_tag - ('a' - 'A')) {
+            pep_log_error("utf8_chunks: invalid chunk tag: %c (0x%0X).",tag,tag);
+            return HESSIAN_ERROR;
         }
-    } /* while */
-
-    /* copy the string buffer into the hessian string */
-    sb_l= pep_buffer_length(sb);
-    self->string= calloc(sb_l + 1,sizeof(char));
-    if (self->string == NULL) {
-        pep_log_error("hessian_string_deserialize: can't allocate string (%d chars).", (int)sb_l);
-        pep_buffer_delete(sb);
-        return HESSIAN_ERROR;
     }
-    pep_buffer_read(self->string,sizeof(char),sb_l,sb);
-    pep_buffer_delete(sb);
+    *bytes_l= total;
+    *chars_l= chars;
+    *data_used= pos;
     return HESSIAN_OK;
 }
 
@@ -249,6 +336,16 @@ const char * hessian_string_getstring(const hessian_object_t * object) {
     return self->string;
 }
 
+/**
+ * Returns the UTF-8 string and its byte length.
+ */
+const char * hessian_string_getstring_n(const hessian_object_t * object, size_t * length) {
+    const hessian_string_t * self= object;
+    const char * string= hessian_string_getstring(object);
+    if (length != NULL) *length= (string != NULL) ? self->length : 0;
+    return string;
+}
+
 /**
  * Returns a char array ('\0' terminated) containing utf8_l UTF-8 chars, read from the input pep_buffer_t.
  * You are responsible to free the array.
@@ -256,64 +353,31 @@ const char * hessian_string_getstring(const hessian_object_t * object) {
  * @return a char array pointer or NULL on error.
  */
 char * hessian_utf8_bgets(size_t utf8_l, pep_buffer_t * input) {
-    size_t n_utf8, tmp_l;
+    return hessian_utf8_bgets_arena(utf8_l,input,NULL);
+}
+
+/**
+ * Same as hessian_utf8_bgets, but the char array is allocated in the arena.
+ */
+char * hessian_utf8_bgets_arena(size_t utf8_l, pep_buffer_t * input, hessian_arena_t * arena) {
+    const char * data= (const char *)pep_buffer_peek(input);
+    size_t n= hessian_utf8_bytes(data,pep_buffer_length(input),utf8_l);
     char * utf8;
-    /* use a tmp buffer */
-    pep_buffer_t * tmp= pep_buffer_create(utf8_l);
-    if (tmp == NULL) {
-        pep_log_error("utf8_bgets: can't create temp buffer (%d bytes).", (int)utf8_l);
+    if (n == (size_t)-1) {
+        pep_log_error("utf8_bgets: truncated UTF-8 string, %d chars expected.", (int)utf8_l);
         return NULL;
     }
-    n_utf8= 0;
-    while(n_utf8 < utf8_l) {
-        int byte= pep_buffer_getc(input);
-        pep_buffer_putc(byte,tmp);
-        if ((byte & 0xC0) == 0xC0) {
-            /* utf8 multi-byte char sequence */
-            int n_mbyte= 0;
-            if ((byte & 0xF0) == 0xC0) n_mbyte= 1; /* c is start of the 2-byte seq. */
-            else if ((byte & 0xF0) == 0xE0) n_mbyte= 2; /* c is start of the 3-byte seq. */
-            else if ((byte & 0xF0) == 0xF0) n_mbyte= 3; /* c is start of the 4-byte seq. */
-            else pep_log_error("utf8_bgets: unknown multi-bytes utf8 sequence: 0x%0X",byte);
-            /* read additional bytes */
-            while (n_mbyte-- > 0) {
-                int mbyte= pep_buffer_getc(input);
-                pep_buffer_putc(mbyte,tmp);
-            }
-        }
-        n_utf8++;
-    }
-    /* alloc the char array */
-    tmp_l= pep_buffer_length(tmp);
-    utf8= calloc(tmp_l + 1, sizeof(char));
+    /* copy the bytes once into the char array */
+    utf8= hessian_calloc(arena,n + 1);
     if (utf8 == NULL) {
-        pep_log_error("utf8_bgets: can't allocate string (%d chars).", (int)tmp_l);
-        pep_buffer_delete(tmp);
+        pep_log_error("utf8_bgets: can't allocate string (%d chars).", (int)n);
         return NULL;
     }
-    /* copy tmp buffer to char array */
-    pep_buffer_read(utf8,sizeof(char),tmp_l,tmp);
-    pep_buffer_delete(tmp);
+    memcpy(utf8,data,n);
+    pep_buffer_skip(input,n);
     return utf8;
 }
 
-/**
- * Returns the effective UTF8 string length
- */
-size_t hessian_utf8_strlen(const char *s) {
-    int i = 0;
-    size_t j = 0;
-    if (s == NULL) {
-        pep_log_error("utf8_strlen: NULL string pointer.");
-        return 0;
-    }
-    while (s[i]) {
-        if ((s[i] & 0xc0) != 0x80) j++; /* multi byte char */
-        i++;
-    }
-    return j;
-}
-
 /* return TRUE iff the byte is part of an UTF8 multi-byte sequence.
    2nd, 3rd and 4th byte of multi-byte seq. */
 /* NOT USED
@@ -347,7 +411,7 @@ size_t hessian_string_utf8_length(const hessian_object_t * object) {
         pep_log_error("hessian_string_utf8_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return hessian_utf8_strlen(self->string);
+    return self->utf8_length;
 }
 
 /**
@@ -369,7 +433,7 @@ size_t hessian_string_length(const hessian_object_t * object) {
         pep_log_error("hessian_string_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return strlen(self->string);
+    return self->length;
 }
 
 /**
@@ -378,7 +442,6 @@ size_t hessian_string_length(const hessian_object_t * object) {
 int hessian_string_equals(const hessian_object_t * object, const char *str) {
     const hessian_string_t * self= object;
     const hessian_class_t * class;
-    size_t string_l;
     if (self == NULL) {
         pep_log_error("hessian_string_equals: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -398,8 +461,7 @@ int hessian_string_equals(const hessian_object_t * object, const char *str) {
     if (str == NULL) {
         return FALSE;
     }
-    string_l= strlen(self->string);
-    return (strncmp(self->string, str, string_l) == 0) ? TRUE : FALSE;
+    return (strncmp(self->string, str, self->length) == 0) ? TRUE : FALSE;
 }
 
 /**
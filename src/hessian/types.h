@@ -25,7 +25,6 @@
 
 #include <stdint.h>
 #include "buffer.h"
-#include "linkedlist.h"
 
 /**
  * Hessian object types
@@ -53,6 +52,11 @@ typedef enum {
  */
 typedef void hessian_object_t;
 
+/**
+ * Hessian arena allocator type
+ */
+typedef struct hessian_arena hessian_arena_t;
+
 /**
  * Hessian internal class descriptor type.
  *
@@ -75,6 +79,7 @@ typedef struct hessian_class {
  */
 typedef struct hessian_binary {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     char * data;
     size_t length;
 } hessian_binary_t;
@@ -84,6 +89,7 @@ typedef struct hessian_binary {
  */
 typedef struct hessian_boolean {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     int value;
 } hessian_boolean_t;
 
@@ -92,6 +98,7 @@ typedef struct hessian_boolean {
  */
 typedef struct hessian_long {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     int64_t value;
 } hessian_long_t, hessian_date_t;
 
@@ -101,6 +108,7 @@ typedef struct hessian_long {
  */
 typedef struct hessian_integer {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     int32_t value;
 } hessian_integer_t, hessian_ref_t;
 
@@ -109,17 +117,33 @@ typedef struct hessian_integer {
  */
 typedef struct hessian_list {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     char * type;
-    pep_linkedlist_t * list;
+    hessian_object_t ** items;
+    size_t items_l;
+    size_t items_size;
 } hessian_list_t;
 
+/**
+ * Hessian internal map <key,value> pair type
+ */
+typedef struct map_pair {
+    hessian_object_t * key;
+    hessian_object_t * value;
+} map_pair_t;
+
 /**
  * Hessian map class type
  */
 typedef struct hessian_map {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     char * type;
-    pep_linkedlist_t * map; /* <object,object> pairs (key,value) */
+    map_pair_t * pairs; /* <object,object> pairs (key,value) */
+    size_t pairs_l;
+    size_t pairs_size;
+    size_t * index; /* string keys open addressing index: pair index + 1, 0 if free */
+    size_t index_size; /* power of 2, 0 if not built */
 } hessian_map_t;
 
 /**
@@ -127,6 +151,7 @@ typedef struct hessian_map {
  */
 typedef struct hessian_double {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     double value;
 } hessian_double_t;
 
@@ -135,7 +160,10 @@ typedef struct hessian_double {
  */
 typedef struct hessian_string {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     char * string;
+    size_t length; /* bytes */
+    size_t utf8_length; /* UTF-8 chars */
 } hessian_string_t, hessian_xml_t;
 
 /**
@@ -143,6 +171,7 @@ typedef struct hessian_string {
  */
 typedef struct hessian_null {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
 } hessian_null_t;
 
 /**
@@ -150,6 +179,7 @@ typedef struct hessian_null {
  */
 typedef struct hessian_remote {
     const void * class;
+    hessian_arena_t * arena; /* owning arena or NULL */
     char * type;
     char * url;
 } hessian_remote_t;
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hessian.h"
+#include "i_hessian.h"
+#include "log.h"
+
+/*************************
+ * UTF-8 strings kernels *
+ *************************/
+
+/*
+ * The Hessian string lengths are in chars, the kernels count the chars (the
+ * bytes which are not continuation bytes 10xxxxxx), find the byte offset of
+ * the N-th char and skip the ASCII runs when validating, 16 (SSE2) or 32
+ * (AVX2) bytes at a time. The SSE2 and AVX2 kernels are compiled with the
+ * gcc/clang target attribute and selected at runtime, define HESSIAN_NO_SIMD
+ * to disable them.
+ */
+#if !defined(HESSIAN_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define HESSIAN_SIMD 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Count kernel: returns the number of chars in the data_l bytes.
+ */
+typedef size_t utf8_count_kernel_t(const unsigned char * data, size_t data_l);
+
+/**
+ * Offset kernel: returns the byte offset of the char n (the number of bytes
+ * of the n first chars), data_l if the data contains exactly n chars, or
+ * (size_t)-1 if the data contains less than n chars.
+ */
+typedef size_t utf8_offset_kernel_t(const unsigned char * data, size_t data_l, size_t n);
+
+/**
+ * ASCII kernel: returns the length of the ASCII run at the start of the data.
+ */
+typedef size_t utf8_ascii_kernel_t(const unsigned char * data, size_t data_l);
+
+/* TRUE if the byte is not a continuation byte */
+#define UTF8_IS_LEAD(byte) (((byte) & 0xC0) != 0x80)
+
+static size_t count_scalar(const unsigned char * data, size_t data_l) {
+    size_t i, count= 0;
+    for (i= 0; i < data_l; i++) {
+        if (UTF8_IS_LEAD(data[i])) count++;
+    }
+    return count;
+}
+
+static size_t offset_scalar(const unsigned char * data, size_t data_l, size_t n) {
+    size_t i;
+    for (i= 0; i < data_l; i++) {
+        if (UTF8_IS_LEAD(data[i])) {
+            if (n == 0) return i;
+            n--;
+        }
+    }
+    return (n == 0) ? data_l : (size_t)-1;
+}
+
+static size_t ascii_scalar(const unsigned char * data, size_t data_l) {
+    size_t i= 0;
+    while (i < data_l && data[i] < 0x80) i++;
+    return i;
+}
+
+#ifdef HESSIAN_SIMD
+
+/* as signed bytes, the continuation bytes 0x80-0xBF are less than -64 */
+
+__attribute__((target("sse2")))
+static size_t count_sse2(const unsigned char * data, size_t data_l) {
+    const __m128i limit= _mm_set1_epi8(-65);
+    size_t i= 0, count= 0;
+    while (i + 16 <= data_l) {
+        __m128i v= _mm_loadu_si128((const __m128i *)&data[i]);
+        count+= __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v,limit)));
+        i+= 16;
+    }
+    return count + count_scalar(&data[i],data_l - i);
+}
+
+__attribute__((target("sse2")))
+static size_t offset_sse2(const unsigned char * data, size_t data_l, size_t n) {
+    const __m128i limit= _mm_set1_epi8(-65);
+    size_t i= 0;
+    while (i + 16 <= data_l) {
+        __m128i v= _mm_loadu_si128((const __m128i *)&data[i]);
+        size_t count= __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(v,limit)));
+        /* the char n is in this block */
+        if (count > n) break;
+        n-= count;
+        i+= 16;
+    }
+    n= offset_scalar(&data[i],data_l - i,n);
+    return (n == (size_t)-1) ? n : i + n;
+}
+
+__attribute__((target("sse2")))
+static size_t ascii_sse2(const unsigned char * data, size_t data_l) {
+    size_t i= 0;
+    while (i + 16 <= data_l) {
+        int mask= _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)&data[i]));
+        if (mask != 0) return i + __builtin_ctz(mask);
+        i+= 16;
+    }
+    return i + ascii_scalar(&data[i],data_l - i);
+}
+
+__attribute__((target("avx2")))
+static size_t count_avx2(const unsigned char * data, size_t data_l) {
+    const __m256i limit= _mm256_set1_epi8(-65);
+    size_t i= 0, count= 0;
+    while (i + 32 <= data_l) {
+        __m256i v= _mm256_loadu_si256((const __m256i *)&data[i]);
+        count+= __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v,limit)));
+        i+= 32;
+    }
+    return count + count_sse2(&data[i],data_l - i);
+}
+
+__attribute__((target("avx2")))
+static size_t offset_avx2(const unsigned char * data, size_t data_l, size_t n) {
+    const __m256i limit= _mm256_set1_epi8(-65);
+    size_t i= 0;
+    while (i + 32 <= data_l) {
+        __m256i v= _mm256_loadu_si256((const __m256i *)&data[i]);
+        size_t count= __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v,limit)));
+        /* the char n is in this block */
+        if (count > n) break;
+        n-= count;
+        i+= 32;
+    }
+    n= offset_sse2(&data[i],data_l - i,n);
+    return (n == (size_t)-1) ? n : i + n;
+}
+
+__attribute__((target("avx2")))
+static size_t ascii_avx2(const unsigned char * data, size_t data_l) {
+    size_t i= 0;
+    while (i + 32 <= data_l) {
+        unsigned int mask= (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)&data[i]));
+        if (mask != 0) return i + __builtin_ctz(mask);
+        i+= 32;
+    }
+    return i + ascii_sse2(&data[i],data_l - i);
+}
+
+#endif /* HESSIAN_SIMD */
+
+/* selected kernels, set by utf8_kernel_init() */
+static hessian_utf8_kernel_t utf8_kernel= HESSIAN_UTF8_KERNEL_AUTO;
+static utf8_count_kernel_t * utf8_count_kernel= count_scalar;
+static utf8_offset_kernel_t * utf8_offset_kernel= offset_scalar;
+static utf8_ascii_kernel_t * utf8_ascii_kernel= ascii_scalar;
+
+/**
+ * Returns the best kernel supported by the CPU.
+ */
+static hessian_utf8_kernel_t utf8_kernel_detect(void) {
+#ifdef HESSIAN_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return HESSIAN_UTF8_KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return HESSIAN_UTF8_KERNEL_SSE2;
+    }
+#endif
+    return HESSIAN_UTF8_KERNEL_SCALAR;
+}
+
+static pthread_once_t utf8_kernel_once= PTHREAD_ONCE_INIT;
+
+/* selects the best kernels, unless already set */
+static void utf8_kernel_select(void) {
+    if (utf8_kernel == HESSIAN_UTF8_KERNEL_AUTO) {
+        hessian_utf8_setkernel(HESSIAN_UTF8_KERNEL_AUTO);
+    }
+}
+
+/**
+ * Selects the kernels at first use, once for all the threads.
+ */
+static void utf8_kernel_init(void) {
+    pthread_once(&utf8_kernel_once,utf8_kernel_select);
+}
+
+int hessian_utf8_setkernel(hessian_utf8_kernel_t kernel) {
+    hessian_utf8_kernel_t supported= utf8_kernel_detect();
+    if (kernel == HESSIAN_UTF8_KERNEL_AUTO) {
+        kernel= supported;
+    }
+    switch (kernel) {
+    case HESSIAN_UTF8_KERNEL_SCALAR:
+        utf8_count_kernel= count_scalar;
+        utf8_offset_kernel= offset_scalar;
+        utf8_ascii_kernel= ascii_scalar;
+        break;
+#ifdef HESSIAN_SIMD
+    case HESSIAN_UTF8_KERNEL_SSE2:
+        if (supported < HESSIAN_UTF8_KERNEL_SSE2) {
+            pep_log_error("hessian_utf8_setkernel: SSE2 not supported by the CPU.");
+            return HESSIAN_ERROR;
+        }
+        utf8_count_kernel= count_sse2;
+        utf8_offset_kernel= offset_sse2;
+        utf8_ascii_kernel= ascii_sse2;
+        break;
+    case HESSIAN_UTF8_KERNEL_AVX2:
+        if (supported < HESSIAN_UTF8_KERNEL_AVX2) {
+            pep_log_error("hessian_utf8_setkernel: AVX2 not supported by the CPU.");
+            return HESSIAN_ERROR;
+        }
+        utf8_count_kernel= count_avx2;
+        utf8_offset_kernel= offset_avx2;
+        utf8_ascii_kernel= ascii_avx2;
+        break;
+#endif
+    default:
+        pep_log_error("hessian_utf8_setkernel: kernel %d not available.",(int)kernel);
+        return HESSIAN_ERROR;
+    }
+    utf8_kernel= kernel;
+    return HESSIAN_OK;
+}
+
+hessian_utf8_kernel_t hessian_utf8_getkernel(void) {
+    utf8_kernel_init();
+    return utf8_kernel;
+}
+
+size_t hessian_utf8_count(const char * data, size_t data_l) {
+    if (data == NULL) return 0;
+    utf8_kernel_init();
+    return utf8_count_kernel((const unsigned char *)data,data_l);
+}
+
+size_t hessian_utf8_offset(const char * data, size_t data_l, size_t n) {
+    if (data == NULL) return (n == 0) ? 0 : (size_t)-1;
+    utf8_kernel_init();
+    return utf8_offset_kernel((const unsigned char *)data,data_l,n);
+}
+
+/**
+ * Returns the length of the valid multi-bytes sequence at the start of the
+ * data, or 0 if the sequence is invalid (RFC 3629). The encoded surrogates
+ * (ED A0-BF xx) are valid: Java Hessian encodes the supplementary chars as
+ * two 3-bytes surrogates.
+ */
+static size_t utf8_sequence(const unsigned char * p, size_t l) {
+    unsigned char min= 0x80, max= 0xBF;
+    size_t n, i;
+    if (p[0] >= 0xC2 && p[0] <= 0xDF) n= 2;
+    else if (p[0] >= 0xE0 && p[0] <= 0xEF) {
+        n= 3;
+        if (p[0] == 0xE0) min= 0xA0; /* overlong */
+    }
+    else if (p[0] >= 0xF0 && p[0] <= 0xF4) {
+        n= 4;
+        if (p[0] == 0xF0) min= 0x90; /* overlong */
+        if (p[0] == 0xF4) max= 0x8F; /* > U+10FFFF */
+    }
+    else return 0;
+    if (l < n || p[1] < min || p[1] > max) return 0;
+    for (i= 2; i < n; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+    }
+    return n;
+}
+
+int hessian_utf8_validate(const char * data, size_t data_l) {
+    const unsigned char * p= (const unsigned char *)data;
+    size_t i= 0;
+    if (data == NULL) return FALSE;
+    utf8_kernel_init();
+    while (i < data_l) {
+        size_t n;
+        i+= utf8_ascii_kernel(&p[i],data_l - i);
+        if (i >= data_l) break;
+        n= utf8_sequence(&p[i],data_l - i);
+        if (n == 0) return FALSE;
+        i+= n;
+    }
+    return TRUE;
+}
+
+/**
+ * Returns the effective UTF8 string length
+ */
+size_t hessian_utf8_strlen(const char *s) {
+    if (s == NULL) {
+        pep_log_error("utf8_strlen: NULL string pointer.");
+        return 0;
+    }
+    return hessian_utf8_count(s,strlen(s));
+}
+
+/**
+ * Returns the number of bytes of the first utf8_l UTF-8 chars of data, or
+ * (size_t)-1 if data is truncated. Invalid sequences are logged and kept as
+ * is, the chars are delimited by their lead bytes.
+ */
+size_t hessian_utf8_bytes(const char * data, size_t data_l, size_t utf8_l) {
+    const unsigned char * p= (const unsigned char *)data;
+    size_t n= hessian_utf8_offset(data,data_l,utf8_l);
+    if (n == (size_t)-1) return n;
+    if (n == data_l && n > 0) {
+        /* the data ends with the last char: all its bytes must be there */
+        size_t lead= n - 1, lead_l;
+        while (lead > 0 && n - lead < 4 && !UTF8_IS_LEAD(p[lead])) lead--;
+        if (p[lead] >= 0xF0) lead_l= 4;
+        else if (p[lead] >= 0xE0) lead_l= 3;
+        else if (p[lead] >= 0xC0) lead_l= 2;
+        else lead_l= 1;
+        if (n - lead < lead_l) return (size_t)-1;
+    }
+    if (!hessian_utf8_validate(data,n)) {
+        pep_log_warn("utf8_bytes: invalid UTF-8 sequence in %d chars, kept as is.",(int)utf8_l);
+    }
+    return n;
+}
@@ -18,17 +18,19 @@
 #include "config.h"  /* PACKAGE_NAME and PACKAGE_VERSION const */
 
 #include <stdio.h> /* snprintf() */
+#include <pthread.h> /* pthread_once() */
 #include <curl/curl.h> /* curl_version() */
 
 /** buffer for version */
 #define VERSION_BUFFER_SIZE 1024
 static char VERSION_BUFFER[VERSION_BUFFER_SIZE];
-static int VERSION_BUFFER_initialized= 0;
+static pthread_once_t VERSION_BUFFER_once= PTHREAD_ONCE_INIT;
+
+static void version_buffer_init(void) {
+    snprintf(VERSION_BUFFER,VERSION_BUFFER_SIZE,"%s/%s (%s)",PACKAGE_NAME,PACKAGE_VERSION,curl_version());
+}
 
 const char * pep_version(void) {
-    if (!VERSION_BUFFER_initialized) {
-        snprintf(VERSION_BUFFER,VERSION_BUFFER_SIZE,"%s/%s (%s)",PACKAGE_NAME,PACKAGE_VERSION,curl_version());
-        VERSION_BUFFER_initialized= 1;
-    }
+    pthread_once(&VERSION_BUFFER_once,version_buffer_init);
     return VERSION_BUFFER;
 }
@@ -15,16 +15,59 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "base64.h"
+#include "log.h"
+
+/*
+ * SSE4.1 and AVX2 kernels are compiled with the gcc/clang target attribute
+ * and selected at runtime, define BASE64_NO_SIMD to disable them.
+ */
+#if !defined(BASE64_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BASE64_SIMD 1
+#include <immintrin.h>
+#endif
 
 #define NO_LINE_BREAK -1000
 
+/* decoded bytes batch size, multiple of 24 */
+#define DECODE_BATCH_SIZE 768
+/* extra room for the SIMD kernels 16 or 32 bytes stores */
+#define DECODE_BATCH_SLACK 32
+
 /**
  * Base64 codec table (RFC1113)
  */
 static const char base64_codec_table[]="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/**
+ * Base64 decode table: index of the char in the codec table or XX if the
+ * char is not in the codec table.
+ */
+#define XX 0xFF
+static const unsigned char base64_decode_table[256]= {
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+     52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, XX, XX, XX,
+     XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+     15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+     XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+     41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+     XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX
+};
+#undef XX
+
 /**
  * Encodes int_l 8-bit binary bytes as 4 '6-bit' characters (including '=' padding).
  */
@@ -36,6 +79,276 @@ static void encodeblock3to4( const unsigned char in[3], int in_l, unsigned char
     out[3] = (unsigned char) (in_l > 2 ? base64_codec_table[ in[2] & 0x3f ] : '=');
 }
 
+/**
+ * Decodes 4 '6-bit' characters into 3 8-bit binary bytes.
+ */
+static void decodeblock4to3( const unsigned char in[4], unsigned char out[3] ) {
+    out[0] = (in[0] << 2 | in[1] >> 4);
+    out[1] = (in[1] << 4 | in[2] >> 2);
+    out[2] = (((in[2] << 6) & 0xc0) | in[3]);
+}
+
+/**
+ * Encode kernel: encodes the in_l / 3 full blocks of in into out, reading at
+ * most readable bytes (readable >= in_l). Returns the number of bytes encoded,
+ * a multiple of 3, 4 chars are written for each 3 bytes.
+ */
+typedef size_t base64_encode_kernel_t(const unsigned char * in, size_t in_l, size_t readable, unsigned char * out);
+
+/**
+ * Decode kernel: decodes in chunks of 16 or 32 chars, as long as all the chars
+ * of the chunk are in the codec table. Returns the number of chars decoded,
+ * 3 bytes are written for each 4 chars, but the kernel stores up to 32 bytes
+ * past the decoded bytes.
+ */
+typedef size_t base64_decode_kernel_t(const unsigned char * in, size_t in_l, unsigned char * out);
+
+static size_t encode_scalar(const unsigned char * in, size_t in_l, size_t readable, unsigned char * out) {
+    size_t i;
+    for (i= 0; i + 3 <= in_l; i+= 3) {
+        encodeblock3to4(&in[i], 3, out);
+        out+= 4;
+    }
+    return i;
+}
+
+#ifdef BASE64_SIMD
+
+/**
+ * Maps 16 6-bit indexes to the codec table chars (W. Mula).
+ */
+__attribute__((target("sse4.1")))
+static __m128i encode_lookup_sse41(__m128i idx) {
+    const __m128i shift_lut= _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+    __m128i result= _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    __m128i less= _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+    result= _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    result= _mm_shuffle_epi8(shift_lut, result);
+    return _mm_add_epi8(result, idx);
+}
+
+/**
+ * Splits the 3 bytes blocks of 16 bytes (12 used) in 16 6-bit indexes.
+ */
+__attribute__((target("sse4.1")))
+static __m128i encode_split_sse41(__m128i in) {
+    __m128i t0, t1, t2, t3;
+    in= _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    t0= _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    t1= _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    t2= _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    t3= _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("sse4.1")))
+static size_t encode_sse41(const unsigned char * in, size_t in_l, size_t readable, unsigned char * out) {
+    size_t i= 0;
+    while (i + 12 <= in_l && i + 16 <= readable) {
+        __m128i v= _mm_loadu_si128((const __m128i *)&in[i]);
+        _mm_storeu_si128((__m128i *)out, encode_lookup_sse41(encode_split_sse41(v)));
+        i+= 12;
+        out+= 16;
+    }
+    return i + encode_scalar(&in[i], in_l - i, readable - i, out);
+}
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(const unsigned char * in, size_t in_l, size_t readable, unsigned char * out) {
+    const __m256i shuffle= _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                           10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shift_lut= _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0,
+                                              'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+    size_t i= 0;
+    while (i + 24 <= in_l && i + 28 <= readable) {
+        __m256i v, t0, t1, t2, t3, idx, result, less;
+        v= _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&in[i]));
+        v= _mm256_inserti128_si256(v, _mm_loadu_si128((const __m128i *)&in[i + 12]), 1);
+        v= _mm256_shuffle_epi8(v, shuffle);
+        t0= _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        t1= _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        t2= _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        t3= _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        idx= _mm256_or_si256(t1, t3);
+        result= _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        less= _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+        result= _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result= _mm256_shuffle_epi8(shift_lut, result);
+        _mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(result, idx));
+        i+= 24;
+        out+= 32;
+    }
+    return i + encode_sse41(&in[i], in_l - i, readable - i, out);
+}
+
+/**
+ * Maps 16 chars to their 6-bit indexes, the mask is set for the chars in
+ * the codec table.
+ */
+__attribute__((target("sse4.1")))
+static __m128i decode_lookup_sse41(__m128i v, int * mask) {
+    __m128i upper, lower, digit, plus, slash, shift, valid;
+    upper= _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    lower= _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+    digit= _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    plus= _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+    slash= _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+    valid= _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+    *mask= _mm_movemask_epi8(valid);
+    shift= _mm_and_si128(upper, _mm_set1_epi8(-65));
+    shift= _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+    shift= _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(4)));
+    shift= _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(19)));
+    shift= _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(16)));
+    return _mm_add_epi8(v, shift);
+}
+
+/**
+ * Packs 16 6-bit indexes in 12 bytes, followed by 4 zero bytes.
+ */
+__attribute__((target("sse4.1")))
+static __m128i decode_pack_sse41(__m128i idx) {
+    __m128i merged;
+    merged= _mm_maddubs_epi16(idx, _mm_set1_epi32(0x01400140));
+    merged= _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("sse4.1")))
+static size_t decode_sse41(const unsigned char * in, size_t in_l, unsigned char * out) {
+    size_t i= 0;
+    int mask;
+    while (i + 16 <= in_l) {
+        __m128i idx= decode_lookup_sse41(_mm_loadu_si128((const __m128i *)&in[i]), &mask);
+        if (mask != 0xFFFF) break;
+        _mm_storeu_si128((__m128i *)out, decode_pack_sse41(idx));
+        i+= 16;
+        out+= 12;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const unsigned char * in, size_t in_l, unsigned char * out) {
+    const __m256i pack= _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i= 0;
+    while (i + 32 <= in_l) {
+        __m256i v, upper, lower, digit, plus, slash, shift, valid;
+        v= _mm256_loadu_si256((const __m256i *)&in[i]);
+        upper= _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        lower= _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+        digit= _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        plus= _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+'));
+        slash= _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+        valid= _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, plus), slash));
+        if (_mm256_movemask_epi8(valid) != -1) {
+            /* the scalar decoder skips the invalid chars */
+            return i;
+        }
+        shift= _mm256_and_si256(upper, _mm256_set1_epi8(-65));
+        shift= _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(-71)));
+        shift= _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+        shift= _mm256_or_si256(shift, _mm256_and_si256(plus, _mm256_set1_epi8(19)));
+        shift= _mm256_or_si256(shift, _mm256_and_si256(slash, _mm256_set1_epi8(16)));
+        v= _mm256_add_epi8(v, shift);
+        v= _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v= _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v= _mm256_shuffle_epi8(v, pack);
+        v= _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256((__m256i *)out, v);
+        i+= 32;
+        out+= 24;
+    }
+    return i + decode_sse41(&in[i], in_l - i, out);
+}
+
+#endif /* BASE64_SIMD */
+
+/* selected kernels, set by base64_codec_init() */
+static pep_base64_codec_t base64_codec= PEP_BASE64_CODEC_AUTO;
+static base64_encode_kernel_t * base64_encode_kernel= encode_scalar;
+static base64_decode_kernel_t * base64_decode_kernel= NULL;
+
+/**
+ * Returns the best codec supported by the CPU.
+ */
+static pep_base64_codec_t base64_codec_detect(void) {
+#ifdef BASE64_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return PEP_BASE64_CODEC_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return PEP_BASE64_CODEC_SSE41;
+    }
+#endif
+    return PEP_BASE64_CODEC_SCALAR;
+}
+
+static pthread_once_t base64_codec_once= PTHREAD_ONCE_INIT;
+
+/* selects the best codec, unless already set */
+static void base64_codec_select(void) {
+    if (base64_codec == PEP_BASE64_CODEC_AUTO) {
+        pep_base64_setcodec(PEP_BASE64_CODEC_AUTO);
+    }
+}
+
+/**
+ * Selects the kernels at first use, once for all the threads.
+ */
+static void base64_codec_init(void) {
+    pthread_once(&base64_codec_once,base64_codec_select);
+}
+
+int pep_base64_setcodec(pep_base64_codec_t codec) {
+    pep_base64_codec_t supported= base64_codec_detect();
+    if (codec == PEP_BASE64_CODEC_AUTO) {
+        codec= supported;
+    }
+    switch (codec) {
+    case PEP_BASE64_CODEC_SCALAR:
+        base64_encode_kernel= encode_scalar;
+        base64_decode_kernel= NULL;
+        break;
+#ifdef BASE64_SIMD
+    case PEP_BASE64_CODEC_SSE41:
+        if (supported < PEP_BASE64_CODEC_SSE41) {
+            pep_log_error("pep_base64_setcodec: SSE4.1 not supported by the CPU.");
+            return BUFFER_ERROR;
+        }
+        base64_encode_kernel= encode_sse41;
+        base64_decode_kernel= decode_sse41;
+        break;
+    case PEP_BASE64_CODEC_AVX2:
+        if (supported < PEP_BASE64_CODEC_AVX2) {
+            pep_log_error("pep_base64_setcodec: AVX2 not supported by the CPU.");
+            return BUFFER_ERROR;
+        }
+        base64_encode_kernel= encode_avx2;
+        base64_decode_kernel= decode_avx2;
+        break;
+#endif
+    default:
+        pep_log_error("pep_base64_setcodec: codec %d not available.",(int)codec);
+        return BUFFER_ERROR;
+    }
+    base64_codec= codec;
+    return BUFFER_OK;
+}
+
+pep_base64_codec_t pep_base64_getcodec(void) {
+    base64_codec_init();
+    return base64_codec;
+}
+
 /**
  * Base64 encodes the in buffer into the out buffer (without line break).
  */
@@ -43,80 +356,304 @@ void pep_base64_encode_buffer( pep_buffer_t * inbuf, pep_buffer_t * outbuf ) {
     pep_base64_encode_buffer_l(inbuf,outbuf,NO_LINE_BREAK);
 }
 
+/* streaming base64 encoder structure */
+struct pep_base64_encoder {
+    pep_buffer_t * in; /* data to encode */
+    int linesize; /* line length */
+    size_t line_l; /* bytes written on the current line */
+    unsigned char out[6]; /* encoded partial block and line break */
+    int out_l; /* encoded block length */
+    int out_pos; /* encoded block read position */
+};
+
 /**
  * Base64 encodes the in buffer into the out buffer.
  */
 void pep_base64_encode_buffer_l( pep_buffer_t * inbuf, pep_buffer_t * outbuf, int linesize ) {
+    struct pep_base64_encoder encoder;
+    unsigned char chunk[4096];
+    size_t chunk_l;
 
-    unsigned char in[3], out[4];
-    int i= 0, in_l= 0;
-    size_t b_out = 0; /* byte written */
+    if (linesize != NO_LINE_BREAK && linesize < 4) {
+        linesize= BASE64_DEFAULT_LINE_SIZE;
+    }
+    encoder.linesize= linesize;
+    pep_base64_encoder_reset(&encoder, inbuf);
+    while ((chunk_l= pep_base64_encoder_read(chunk,1,sizeof(chunk),&encoder)) > 0) {
+        if (chunk_l == BUFFER_ERROR) break;
+        pep_buffer_write(chunk,1,chunk_l,outbuf);
+    }
+}
+
+/**
+ * Writes the decoded bytes into the out buffer.
+ */
+static size_t base64_buffer_write(const void * src, size_t size, size_t count, void * out) {
+    return pep_buffer_write(src,size,count,(pep_buffer_t *)out);
+}
 
+/* push base64 decoder structure */
+struct pep_base64_decoder {
+    pep_base64_write_func * write; /* decoded bytes writer */
+    void * out; /* writer argument */
+    unsigned char in[4]; /* pending 6-bit chars */
+    int in_l; /* number of pending chars */
+};
+
+/**
+ * Base64 decodes the in buffer into the out buffer.
+ */
+void pep_base64_decode_buffer( pep_buffer_t * inbuf, pep_buffer_t * outbuf ) {
+    struct pep_base64_decoder decoder;
+    size_t in_l= pep_buffer_length(inbuf);
+
+    decoder.write= base64_buffer_write;
+    decoder.out= outbuf;
+    decoder.in_l= 0;
+    if (in_l > 0 && in_l != BUFFER_ERROR) {
+        pep_base64_decoder_write(pep_buffer_peek(inbuf),1,in_l,&decoder);
+        pep_buffer_skip(inbuf,in_l);
+    }
+    pep_base64_decoder_flush(&decoder);
+}
+
+/**
+ * Length of the base64 encoded block, with the line breaks.
+ */
+size_t pep_base64_encoded_length(size_t in_l, int linesize) {
+    size_t blocks, line_blocks, lines;
+    blocks= (in_l + 2) / 3;
+    if (linesize == NO_LINE_BREAK) {
+        return blocks * 4;
+    }
+    if (linesize < 4) {
+        linesize= BASE64_DEFAULT_LINE_SIZE;
+    }
+    /* a line break is written after each full line and after the last block */
+    line_blocks= ((size_t)linesize + 3) / 4;
+    lines= (blocks + line_blocks - 1) / line_blocks;
+    return (blocks * 4) + (lines * 2);
+}
+
+pep_base64_encoder_t * pep_base64_encoder_create(int linesize) {
+    pep_base64_encoder_t * encoder= calloc(1,sizeof(struct pep_base64_encoder));
+    if (encoder == NULL) {
+        pep_log_error("pep_base64_encoder_create: calloc pep_base64_encoder_t failed.");
+        return NULL;
+    }
     if (linesize != NO_LINE_BREAK && linesize < 4) {
         linesize= BASE64_DEFAULT_LINE_SIZE;
     }
+    encoder->linesize= linesize;
+    encoder->in= NULL;
+    return encoder;
+}
 
-    while( !pep_buffer_eof( inbuf ) ) {
-        in_l = 0;
-        in[0] = in[1] = in[2] = 0;
-        for( i = 0; i < 3; i++ ) {
-            int c = pep_buffer_getc( inbuf );
-            if ( c != BUFFER_EOF ) {
-                in[i] = (unsigned char) c;
-                in_l++;
+void pep_base64_encoder_delete(pep_base64_encoder_t * encoder) {
+    if (encoder == NULL) return;
+    free(encoder);
+}
+
+int pep_base64_encoder_reset(pep_base64_encoder_t * encoder, pep_buffer_t * in) {
+    if (encoder == NULL) {
+        pep_log_error("pep_base64_encoder_reset: encoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    encoder->in= in;
+    encoder->line_l= 0;
+    encoder->out_l= 0;
+    encoder->out_pos= 0;
+    return BUFFER_OK;
+}
+
+/**
+ * Encodes on demand the in buffer, with the same line breaks as
+ * pep_base64_encode_buffer_l(in,out,linesize). The full blocks of the current
+ * line are encoded directly into dst, only a partial block or a block not
+ * fitting into dst, and the line break, are pending in the encoder.
+ */
+size_t pep_base64_encoder_read(void * dst, size_t size, size_t count, void * _encoder) {
+    pep_base64_encoder_t * encoder;
+    unsigned char * out;
+    const unsigned char * in;
+    size_t nbytes, n= 0, in_l, blocks, line_blocks;
+    if (dst == NULL || _encoder == NULL) {
+        pep_log_error("pep_base64_encoder_read: dst or encoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    encoder= (pep_base64_encoder_t *)_encoder;
+    if (encoder->in == NULL) {
+        pep_log_error("pep_base64_encoder_read: encoder in buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    base64_codec_init();
+    out= (unsigned char *)dst;
+    nbytes= size * count;
+    while (n < nbytes) {
+        if (encoder->out_pos < encoder->out_l) {
+            /* pending encoded bytes */
+            out[n++]= encoder->out[encoder->out_pos++];
+            continue;
+        }
+        in_l= pep_buffer_length(encoder->in);
+        if (in_l == 0 || in_l == BUFFER_ERROR) {
+            break;
+        }
+        in= pep_buffer_peek(encoder->in);
+        encoder->out_l= 0;
+        encoder->out_pos= 0;
+        /* full blocks fitting on the current line and into dst */
+        blocks= in_l / 3;
+        if (blocks > (nbytes - n) / 4) {
+            blocks= (nbytes - n) / 4;
+        }
+        if (encoder->linesize != NO_LINE_BREAK) {
+            line_blocks= ((size_t)encoder->linesize + 3) / 4 - encoder->line_l / 4;
+            if (blocks > line_blocks) {
+                blocks= line_blocks;
             }
         }
-        if( in_l > 0 ) {
-            encodeblock3to4( in, in_l, out );
-            b_out += pep_buffer_write(out,1,4,outbuf);
+        if (blocks > 0) {
+            base64_encode_kernel(in, blocks * 3, in_l, &out[n]);
+            pep_buffer_skip(encoder->in, blocks * 3);
+            n+= blocks * 4;
+            encoder->line_l+= blocks * 4;
+        }
+        else {
+            unsigned char block[3];
+            int block_l;
+            block[0] = block[1] = block[2] = 0;
+            block_l= (int)pep_buffer_read(block,1,3,encoder->in);
+            encodeblock3to4(block, block_l, encoder->out);
+            encoder->out_l= 4;
+            encoder->line_l+= 4;
         }
-        if (linesize != NO_LINE_BREAK) {
-            if( b_out >= linesize || pep_buffer_eof( inbuf )) {
-                pep_buffer_write("\r\n",1,2,outbuf);
-                b_out = 0;
+        if (encoder->linesize != NO_LINE_BREAK) {
+            if (encoder->line_l >= encoder->linesize || pep_buffer_eof(encoder->in)) {
+                encoder->out[encoder->out_l++]= '\r';
+                encoder->out[encoder->out_l++]= '\n';
+                encoder->line_l= 0;
             }
         }
     }
+    return n;
 }
 
-/**
- * Decodes 4 '6-bit' characters into 3 8-bit binary bytes.
- */
-static void decodeblock4to3( const unsigned char in[4], unsigned char out[3] ) {
-    out[0] = (in[0] << 2 | in[1] >> 4);
-    out[1] = (in[1] << 4 | in[2] >> 2);
-    out[2] = (((in[2] << 6) & 0xc0) | in[3]);
+pep_base64_decoder_t * pep_base64_decoder_create(pep_base64_write_func * write, void * out) {
+    pep_base64_decoder_t * decoder;
+    if (write == NULL) {
+        pep_log_error("pep_base64_decoder_create: write function is a NULL pointer.");
+        return NULL;
+    }
+    decoder= calloc(1,sizeof(struct pep_base64_decoder));
+    if (decoder == NULL) {
+        pep_log_error("pep_base64_decoder_create: calloc pep_base64_decoder_t failed.");
+        return NULL;
+    }
+    decoder->write= write;
+    decoder->out= out;
+    decoder->in_l= 0;
+    return decoder;
+}
+
+void pep_base64_decoder_delete(pep_base64_decoder_t * decoder) {
+    if (decoder == NULL) return;
+    free(decoder);
+}
+
+int pep_base64_decoder_reset(pep_base64_decoder_t * decoder) {
+    if (decoder == NULL) {
+        pep_log_error("pep_base64_decoder_reset: decoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    decoder->in_l= 0;
+    return BUFFER_OK;
 }
 
 /**
- * Base64 decodes the in buffer into the out buffer.
+ * Decodes the src chunk and writes the decoded bytes by batch. Runs of
+ * valid chars are decoded by the SIMD kernel when no char is pending, the
+ * others char by char. The chars of an incomplete block are kept for the
+ * next chunk.
  */
-void pep_base64_decode_buffer( pep_buffer_t * inbuf, pep_buffer_t * outbuf ) {
-    unsigned char in[4], out[3];
-    int c, i, in_l;
-    char * p;
-
-    while( !pep_buffer_eof( inbuf ) ) {
-        in_l= 0;
-        in[0] = in[1] = in[2] = in[3] = 0;
-        for( i = 0; i < 4;) {
-            c= pep_buffer_getc( inbuf );
-            if (c == BUFFER_EOF) break;
+size_t pep_base64_decoder_write(const void * src, size_t size, size_t count, void * _decoder) {
+    pep_base64_decoder_t * decoder;
+    const unsigned char * in;
+    unsigned char out[DECODE_BATCH_SIZE + DECODE_BATCH_SLACK];
+    size_t nbytes, i= 0, out_l= 0, n;
+    unsigned char c;
+    if (src == NULL || _decoder == NULL) {
+        pep_log_error("pep_base64_decoder_write: src or decoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    decoder= (pep_base64_decoder_t *)_decoder;
+    base64_codec_init();
+    in= (const unsigned char *)src;
+    nbytes= size * count;
+    while (i < nbytes) {
+        if (decoder->in_l == 0 && base64_decode_kernel != NULL && nbytes - i >= 16) {
+            n= nbytes - i;
+            if (n > (DECODE_BATCH_SIZE - out_l) / 3 * 4) {
+                n= (DECODE_BATCH_SIZE - out_l) / 3 * 4;
+            }
+            n= base64_decode_kernel(&in[i], n, &out[out_l]);
+            i+= n;
+            out_l+= n / 4 * 3;
+        }
+        else {
+            n= 0;
+        }
+        if (n == 0) {
             /* drop every char not in table */
-            p= strchr(base64_codec_table,c);
-            if (p != NULL) {
-                /* index of c in base64 table */
-                in[i] = p - base64_codec_table;
-                in_l++;
+            c= base64_decode_table[in[i++]];
+            if (c != 0xFF) {
+                decoder->in[decoder->in_l++]= c;
+                if (decoder->in_l == 4) {
+                    decodeblock4to3(decoder->in, &out[out_l]);
+                    out_l+= 3;
+                    decoder->in_l= 0;
+                }
+            }
+            /* skip the run of chars not in table, e.g. a line break */
+            while (i < nbytes && base64_decode_table[in[i]] == 0xFF) {
                 i++;
             }
         }
-        if( in_l > 0) {
-            decodeblock4to3( in, out );
-            for( i = 0; i < in_l - 1; i++ ) {
-                pep_buffer_putc( out[i], outbuf );
+        if (out_l == DECODE_BATCH_SIZE) {
+            if (decoder->write(out,1,out_l,decoder->out) != out_l) {
+                pep_log_error("pep_base64_decoder_write: failed to write %d decoded bytes.",(int)out_l);
+                return BUFFER_ERROR;
             }
+            out_l= 0;
         }
     }
+    if (out_l > 0 && decoder->write(out,1,out_l,decoder->out) != out_l) {
+        pep_log_error("pep_base64_decoder_write: failed to write %d decoded bytes.",(int)out_l);
+        return BUFFER_ERROR;
+    }
+    return nbytes;
 }
 
+int pep_base64_decoder_flush(pep_base64_decoder_t * decoder) {
+    unsigned char out[3];
+    size_t out_l;
+    int i;
+    if (decoder == NULL) {
+        pep_log_error("pep_base64_decoder_flush: decoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (decoder->in_l == 0) {
+        return BUFFER_OK;
+    }
+    for (i= decoder->in_l; i < 4; i++) {
+        decoder->in[i]= 0;
+    }
+    decodeblock4to3(decoder->in, out);
+    out_l= decoder->in_l - 1;
+    decoder->in_l= 0;
+    if (out_l > 0 && decoder->write(out,1,out_l,decoder->out) != out_l) {
+        pep_log_error("pep_base64_decoder_flush: failed to write %d decoded bytes.",(int)out_l);
+        return BUFFER_ERROR;
+    }
+    return BUFFER_OK;
+}
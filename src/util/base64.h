@@ -29,6 +29,35 @@ extern "C" {
 #define BASE64_DEFAULT_LINE_SIZE 64
 #endif
 
+/**
+ * Base64 codec kernels. The default {@link #PEP_BASE64_CODEC_AUTO} selects
+ * at runtime the fastest kernel supported by the CPU.
+ */
+typedef enum pep_base64_codec {
+    PEP_BASE64_CODEC_AUTO = 0, /**< Best kernel supported by the CPU (default) */
+    PEP_BASE64_CODEC_SCALAR, /**< Portable lookup table kernel */
+    PEP_BASE64_CODEC_SSE41, /**< x86 SSE4.1 kernel */
+    PEP_BASE64_CODEC_AVX2 /**< x86 AVX2 kernel */
+} pep_base64_codec_t;
+
+/**
+ * Sets the base64 codec kernel used by all the encoding and decoding functions.
+ * The encoded and decoded data are identical whatever the kernel.
+ *
+ * @param pep_base64_codec_t codec the kernel to use.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if the kernel is not supported by the CPU
+ *             or was not compiled in (BASE64_NO_SIMD).
+ */
+int pep_base64_setcodec(pep_base64_codec_t codec);
+
+/**
+ * Returns the base64 codec kernel effectively used, never {@link #PEP_BASE64_CODEC_AUTO}.
+ *
+ * @return pep_base64_codec_t the kernel used.
+ */
+pep_base64_codec_t pep_base64_getcodec(void);
+
 /**
  * Base64 encodes the in buffer into the out buffer (without line break).
  *
@@ -55,6 +84,127 @@ void pep_base64_encode_buffer_l(pep_buffer_t * in, pep_buffer_t * out, int lines
  */
 void pep_base64_decode_buffer(pep_buffer_t * in, pep_buffer_t * out);
 
+/**
+ * Returns the length of the base64 encoded block of in_l bytes, including the
+ * line breaks, as produced by pep_base64_encode_buffer_l(in,out,linesize).
+ *
+ * @param size_t in_l number of bytes to encode.
+ * @param int linesize length of the line (min 4)
+ *
+ * @return size_t length of the base64 encoded block.
+ */
+size_t pep_base64_encoded_length(size_t in_l, int linesize);
+
+/**
+ * The ADT streaming base64 encoder type.
+ */
+typedef struct pep_base64_encoder pep_base64_encoder_t;
+
+/**
+ * Creates a streaming base64 encoder. The encoded block have a line length of
+ * linesize [4..inf], like with pep_base64_encode_buffer_l(in,out,linesize).
+ *
+ * @param int linesize length of the line (min 4)
+ *
+ * @return pep_base64_encoder_t * pointer to the new encoder or NULL if an error occurs.
+ */
+pep_base64_encoder_t * pep_base64_encoder_create(int linesize);
+
+/**
+ * Deletes the streaming base64 encoder. The in buffer is not deleted.
+ *
+ * @param pep_base64_encoder_t * encoder pointer to the encoder.
+ */
+void pep_base64_encoder_delete(pep_base64_encoder_t * encoder);
+
+/**
+ * Resets the streaming base64 encoder to encode the unread data of the in buffer.
+ *
+ * @param pep_base64_encoder_t * encoder pointer to the encoder.
+ * @param pep_buffer_t * in pointer to the in buffer.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_base64_encoder_reset(pep_base64_encoder_t * encoder, pep_buffer_t * in);
+
+/**
+ * Reads at most count element, each size byte long, of base64 encoded data
+ * from the encoder and store them into the destination array. The data is
+ * encoded on demand from the in buffer. The function signature is compatible
+ * with the libcurl CURLOPT_READFUNCTION callback.
+ *
+ * @param void * dst pointer to the destination array.
+ * @param size_t size in byte of each element.
+ * @param size_t count number of element to read.
+ * @param pep_base64_encoder_t * encoder pointer to the encoder.
+ *
+ * @return size_t number of bytes effectively read, 0 when all the in buffer
+ *                is encoded, or BUFFER_ERROR if an error occurs.
+ */
+size_t pep_base64_encoder_read(void * dst, size_t size, size_t count, void * encoder);
+
+/**
+ * Write function type receiving the decoded bytes, compatible with pep_buffer_write.
+ */
+typedef size_t pep_base64_write_func(const void * src, size_t size, size_t count, void * out);
+
+/**
+ * The ADT push base64 decoder type.
+ */
+typedef struct pep_base64_decoder pep_base64_decoder_t;
+
+/**
+ * Creates a push base64 decoder. The decoded bytes are written to the out
+ * argument with the write function, like pep_buffer_write(src,1,count,out).
+ *
+ * @param pep_base64_write_func * write the function receiving the decoded bytes.
+ * @param void * out the argument passed to the write function.
+ *
+ * @return pep_base64_decoder_t * pointer to the new decoder or NULL if an error occurs.
+ */
+pep_base64_decoder_t * pep_base64_decoder_create(pep_base64_write_func * write, void * out);
+
+/**
+ * Deletes the push base64 decoder.
+ *
+ * @param pep_base64_decoder_t * decoder pointer to the decoder.
+ */
+void pep_base64_decoder_delete(pep_base64_decoder_t * decoder);
+
+/**
+ * Resets the push base64 decoder, the pending chars are dropped.
+ *
+ * @param pep_base64_decoder_t * decoder pointer to the decoder.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_base64_decoder_reset(pep_base64_decoder_t * decoder);
+
+/**
+ * Decodes count element, each size byte long, of base64 encoded data from the
+ * src array, and writes the decoded bytes. Chars not in the base64 table are
+ * dropped, as with pep_base64_decode_buffer(in,out). The function signature is
+ * compatible with the libcurl CURLOPT_WRITEFUNCTION callback.
+ *
+ * @param void * src pointer to the source array.
+ * @param size_t size size in byte of each element.
+ * @param size_t count number of element to decode.
+ * @param pep_base64_decoder_t * decoder pointer to the decoder.
+ *
+ * @return size_t number of bytes decoded from the src array or BUFFER_ERROR if
+ *                an error occurs (write function failed).
+ */
+size_t pep_base64_decoder_write(const void * src, size_t size, size_t count, void * decoder);
+
+/**
+ * Decodes and writes the pending chars of a final incomplete block.
+ *
+ * @param pep_base64_decoder_t * decoder pointer to the decoder.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_base64_decoder_flush(pep_base64_decoder_t * decoder);
+
 #ifdef  __cplusplus
 }
 #endif
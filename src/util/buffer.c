@@ -40,13 +40,12 @@
 #define BUFFER_INITIAL_SIZE 16
 #endif
 
-/* memory buffer structure */
-struct pep_buffer {
-    unsigned char * data; /* bytes */
-    size_t size; /* allocated size */
-    size_t wpos; /* write position */
-    size_t rpos; /* read position */
-};
+/*
+ * pep_buffer_fread block size
+ */
+#ifndef BUFFER_FREAD_SIZE
+#define BUFFER_FREAD_SIZE 4096
+#endif
 
 /* constructor */
 pep_buffer_t * pep_buffer_create(size_t size) {
@@ -147,16 +146,21 @@ size_t pep_buffer_write(const void * src, size_t size, size_t count, void * _buf
 }
 
 size_t pep_buffer_fread(pep_buffer_t * buffer, FILE * istream) {
-    size_t nbytes= 0;
-    int c;
+    size_t nbytes= 0, n;
     if (buffer == NULL || istream == NULL) {
         pep_log_error("pep_buffer_fread: buffer or istream is a NULL pointer.");
         return BUFFER_ERROR;
     }
-    while((c=fgetc(istream)) != EOF) {
-        pep_buffer_putc(c,buffer);
-        nbytes++;
-    }
+    /* read directly into the buffer, until a short read (end of stream or error) */
+    do {
+        if (pep_buffer_ensure_capacity(buffer, BUFFER_FREAD_SIZE) != BUFFER_OK) {
+            pep_log_error("pep_buffer_fread: can't increase buffer capacity by %d bytes.", (int)BUFFER_FREAD_SIZE);
+            return BUFFER_ERROR;
+        }
+        n= fread(&(buffer->data[buffer->wpos]),sizeof(char),BUFFER_FREAD_SIZE,istream);
+        buffer->wpos+= n;
+        nbytes+= n;
+    } while (n == BUFFER_FREAD_SIZE);
     return nbytes;
 }
 
@@ -180,40 +184,23 @@ size_t pep_buffer_read(void * dst, size_t size, size_t count, void * _buffer) {
     return nbytes;
 }
 
-int pep_buffer_eof(pep_buffer_t * buffer) {
-    if (buffer == NULL) {
-        pep_log_error("pep_buffer_eof: buffer is a NULL pointer.");
-        return TRUE;
-    }
-    return (buffer->wpos <= buffer->rpos) ? TRUE : FALSE;
-}
-
-int pep_buffer_getc(pep_buffer_t * buffer) {
-    unsigned char c;
-    if (buffer == NULL) {
-        pep_log_error("pep_buffer_getc: buffer is a NULL pointer.");
-        return BUFFER_EOF;
-    }
-    if (pep_buffer_eof(buffer))
-        return BUFFER_EOF;
-    else {
-        c= buffer->data[buffer->rpos];
-        buffer->rpos++;
-        return c;
+int pep_buffer_grow(pep_buffer_t * buffer, size_t size) {
+    if (pep_buffer_ensure_capacity(buffer, size) != BUFFER_OK) {
+        pep_log_error("pep_buffer_grow: can't increase buffer capacity by %d bytes.", (int)size);
+        return BUFFER_ERROR;
     }
+    return BUFFER_OK;
 }
 
-int pep_buffer_ungetc(int c, pep_buffer_t * buffer) {
-    unsigned char uc;
+int pep_buffer_unshift(int c, pep_buffer_t * buffer) {
     if (buffer == NULL) {
-        pep_log_error("pep_buffer_ungetc: buffer is a NULL pointer.");
+        pep_log_error("pep_buffer_unshift: buffer is a NULL pointer.");
         return BUFFER_ERROR;
     }
-    uc= (unsigned char)c;
     if (buffer->rpos == 0) {
         /* shift the whole data buffer by 1 */
         if (pep_buffer_ensure_capacity(buffer, 1) != BUFFER_OK) {
-            pep_log_error("pep_buffer_ungetc: can't increase buffer capacity by 1 byte.");
+            pep_log_error("pep_buffer_unshift: can't increase buffer capacity by 1 byte.");
             return BUFFER_ERROR;
         }
         memmove(&(buffer->data[1]),&(buffer->data[0]), buffer->wpos);
@@ -221,26 +208,10 @@ int pep_buffer_ungetc(int c, pep_buffer_t * buffer) {
         buffer->rpos++;
     }
     buffer->rpos--;
-    buffer->data[buffer->rpos]= uc;
+    buffer->data[buffer->rpos]= (unsigned char)c;
     return BUFFER_OK;
 }
 
-
-int pep_buffer_putc(int c, pep_buffer_t * buffer) {
-    unsigned char uc;
-    if (buffer == NULL) {
-        pep_log_error("pep_buffer_putc: buffer is a NULL pointer.");
-        return BUFFER_ERROR;
-    }
-    uc= (unsigned char)c;
-    if (pep_buffer_ensure_capacity(buffer, 1) != BUFFER_OK) {
-        pep_log_error("pep_buffer_putc: can't increase buffer capacity by 1 byte.");
-        return BUFFER_ERROR;
-    }
-    buffer->data[buffer->wpos++]= uc;
-    return c;
-}
-
 /**
  * Rewind the buffer read position.
  */
@@ -260,7 +231,6 @@ int pep_buffer_reset(pep_buffer_t * buffer) {
     }
     buffer->rpos= 0;
     buffer->wpos= 0;
-    memset(buffer->data,0,buffer->size);
     return BUFFER_OK;
 }
 
@@ -272,5 +242,81 @@ size_t pep_buffer_length(pep_buffer_t * buffer) {
     return buffer->wpos - buffer->rpos;
 }
 
+const unsigned char * pep_buffer_peek(pep_buffer_t * buffer) {
+    if (buffer == NULL || buffer->data == NULL) {
+        pep_log_error("pep_buffer_peek: buffer is a NULL pointer.");
+        return NULL;
+    }
+    return &(buffer->data[buffer->rpos]);
+}
 
+size_t pep_buffer_skip(pep_buffer_t * buffer, size_t count) {
+    size_t available;
+    if (buffer == NULL) {
+        pep_log_error("pep_buffer_skip: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    available= buffer->wpos - buffer->rpos;
+    if (count > available) {
+        count= available;
+    }
+    buffer->rpos += count;
+    return count;
+}
+
+size_t pep_buffer_capacity(pep_buffer_t * buffer) {
+    if (buffer == NULL) {
+        pep_log_error("pep_buffer_capacity: buffer is a NULL pointer.");
+        return 0;
+    }
+    return buffer->size;
+}
+
+int pep_buffer_shrink(pep_buffer_t * buffer, size_t size) {
+    unsigned char * tmp_data;
+    if (buffer == NULL) {
+        pep_log_error("pep_buffer_shrink: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (size < 2) {
+        size= (size_t)BUFFER_INITIAL_SIZE;
+    }
+    if (size < buffer->wpos) {
+        /* keep the written data */
+        size= buffer->wpos;
+    }
+    if (size >= buffer->size) {
+        /* nothing to release */
+        return BUFFER_OK;
+    }
+    tmp_data= realloc(buffer->data, size);
+    if (tmp_data == NULL) {
+        /* the original block is left untouched */
+        pep_log_warn("pep_buffer_shrink: realloc (%d bytes) failed.", (int)size);
+        return BUFFER_ERROR;
+    }
+    buffer->data= tmp_data;
+    buffer->size= size;
+    return BUFFER_OK;
+}
 
+int pep_buffer_reserve(pep_buffer_t * buffer, size_t size) {
+    unsigned char * tmp_data;
+    if (buffer == NULL) {
+        pep_log_error("pep_buffer_reserve: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (size <= buffer->size - buffer->wpos) {
+        /* already available */
+        return BUFFER_OK;
+    }
+    tmp_data= realloc(buffer->data, buffer->wpos + size);
+    if (tmp_data == NULL) {
+        /* the original block is left untouched */
+        pep_log_error("pep_buffer_reserve: realloc (%d bytes) failed.", (int)(buffer->wpos + size));
+        return BUFFER_ERROR;
+    }
+    buffer->data= tmp_data;
+    buffer->size= buffer->wpos + size;
+    return BUFFER_OK;
+}
@@ -24,6 +24,7 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <limits.h>
 
 /** buffer EOF and ERROR */
@@ -45,6 +46,38 @@ extern "C" {
  */
 typedef struct pep_buffer pep_buffer_t;
 
+/*
+ * The buffer structure is only visible for the inline fast paths below, use
+ * the functions. The NULL buffer checks of the inline functions are only done
+ * if BUFFER_DEBUG is defined.
+ */
+struct pep_buffer {
+    unsigned char * data; /* bytes */
+    size_t size; /* allocated size */
+    size_t wpos; /* write position */
+    size_t rpos; /* read position */
+};
+
+#ifdef BUFFER_DEBUG
+#include "log.h"
+#define BUFFER_CHECK(buffer,func,rc) \
+    if ((buffer) == NULL) { \
+        pep_log_error(func ": buffer is a NULL pointer."); \
+        return (rc); \
+    }
+#else
+#define BUFFER_CHECK(buffer,func,rc)
+#endif
+
+/**
+ * Slow paths of the inline functions: grows the buffer to write size more
+ * bytes, and pushes back a character when nothing was read.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_buffer_grow(pep_buffer_t * buffer, size_t size);
+int pep_buffer_unshift(int c, pep_buffer_t * buffer);
+
 /**
  * Creates a buffer with the given initial size.
  * If size < 2, then at least 16 bytes of memory are allocated.
@@ -88,7 +121,7 @@ size_t pep_buffer_fwrite(pep_buffer_t * buffer, FILE * ostream);
 size_t pep_buffer_write(const void * src, size_t size, size_t count, void * buffer);
 
 /**
- * Fully read an input stream in to the buffer.
+ * Fully read an input stream in to the buffer, by blocks.
  *
  * @param pep_buffer_t * buffer pointer to the buffer.
  * @param FILE * istream pointer to the input stream.
@@ -119,7 +152,10 @@ size_t pep_buffer_read(void * dst, size_t size, size_t count, void * buffer);
  *
  * @return int FALSE if there is some unread data in the buffer, TRUE otherwise.
  */
-int pep_buffer_eof(pep_buffer_t * buffer);
+static inline int pep_buffer_eof(pep_buffer_t * buffer) {
+    BUFFER_CHECK(buffer,"pep_buffer_eof",TRUE)
+    return (buffer->wpos <= buffer->rpos) ? TRUE : FALSE;
+}
 
 /**
  * Returns the next available character or BUFFER_EOF
@@ -128,17 +164,27 @@ int pep_buffer_eof(pep_buffer_t * buffer);
  *
  * @return int the next character or BUFFER_EOF.
  */
-int pep_buffer_getc(pep_buffer_t * buffer);
+static inline int pep_buffer_getc(pep_buffer_t * buffer) {
+    BUFFER_CHECK(buffer,"pep_buffer_getc",BUFFER_EOF)
+    if (buffer->wpos <= buffer->rpos) return BUFFER_EOF;
+    return buffer->data[buffer->rpos++];
+}
 
 /**
- * Push back the character c, cast as a unsigned char, into the buffer.
+ * Push back the character c, cast as a unsigned char, into the buffer. The
+ * whole buffer is shifted if nothing was read.
  *
  * @param int c the character to push back at the begin of the buffer.
  * @param pep_buffer_t * buffer pointer to the buffer.
  *
  * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
  */
-int pep_buffer_ungetc(int c, pep_buffer_t * buffer);
+static inline int pep_buffer_ungetc(int c, pep_buffer_t * buffer) {
+    BUFFER_CHECK(buffer,"pep_buffer_ungetc",BUFFER_ERROR)
+    if (buffer->rpos == 0) return pep_buffer_unshift(c,buffer);
+    buffer->data[--buffer->rpos]= (unsigned char)c;
+    return BUFFER_OK;
+}
 
 /**
  * Adds the character c, cast as a unsigned char, at the end of the buffer.
@@ -146,9 +192,61 @@ int pep_buffer_ungetc(int c, pep_buffer_t * buffer);
  * @param int c the character to add at the end of the buffer.
  * @param pep_buffer_t * buffer pointer to the buffer.
  *
+ * @return int the character c or BUFFER_ERROR if an error occurs.
+ */
+static inline int pep_buffer_putc(int c, pep_buffer_t * buffer) {
+    BUFFER_CHECK(buffer,"pep_buffer_putc",BUFFER_ERROR)
+    if (buffer->wpos >= buffer->size && pep_buffer_grow(buffer,1) != BUFFER_OK) return BUFFER_ERROR;
+    buffer->data[buffer->wpos++]= (unsigned char)c;
+    return c;
+}
+
+/**
+ * Adds the 16, 32 or 64 bits unsigned value, in big-endian (network) byte
+ * order, at the end of the buffer.
+ *
+ * @param uint16_t, uint32_t or uint64_t value the value to add.
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ *
  * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
  */
-int pep_buffer_putc(int c, pep_buffer_t * buffer);
+static inline int pep_buffer_put_u16(uint16_t value, pep_buffer_t * buffer) {
+    unsigned char * p;
+    BUFFER_CHECK(buffer,"pep_buffer_put_u16",BUFFER_ERROR)
+    if (buffer->size - buffer->wpos < 2 && pep_buffer_grow(buffer,2) != BUFFER_OK) return BUFFER_ERROR;
+    p= &(buffer->data[buffer->wpos]);
+    p[0]= (unsigned char)(value >> 8);
+    p[1]= (unsigned char)value;
+    buffer->wpos+= 2;
+    return BUFFER_OK;
+}
+
+static inline int pep_buffer_put_u32(uint32_t value, pep_buffer_t * buffer) {
+    unsigned char * p;
+    BUFFER_CHECK(buffer,"pep_buffer_put_u32",BUFFER_ERROR)
+    if (buffer->size - buffer->wpos < 4 && pep_buffer_grow(buffer,4) != BUFFER_OK) return BUFFER_ERROR;
+    p= &(buffer->data[buffer->wpos]);
+    p[0]= (unsigned char)(value >> 24);
+    p[1]= (unsigned char)(value >> 16);
+    p[2]= (unsigned char)(value >> 8);
+    p[3]= (unsigned char)value;
+    buffer->wpos+= 4;
+    return BUFFER_OK;
+}
+
+static inline int pep_buffer_put_u64(uint64_t value, pep_buffer_t * buffer) {
+    unsigned char * p;
+    int i;
+    BUFFER_CHECK(buffer,"pep_buffer_put_u64",BUFFER_ERROR)
+    if (buffer->size - buffer->wpos < 8 && pep_buffer_grow(buffer,8) != BUFFER_OK) return BUFFER_ERROR;
+    p= &(buffer->data[buffer->wpos]);
+    for (i= 7; i >= 0; i--) {
+        p[i]= (unsigned char)value;
+        value>>= 8;
+    }
+    buffer->wpos+= 8;
+    return BUFFER_OK;
+}
 
 /**
  * Rewind the buffer read position.
@@ -160,7 +258,8 @@ int pep_buffer_putc(int c, pep_buffer_t * buffer);
 int pep_buffer_rewind(pep_buffer_t * buffer);
 
 /**
- * Reset the buffer write and read position pointer, and zero the buffer content.
+ * Reset the buffer write and read position pointer. The allocated memory is kept
+ * and its content is not zeroed, so resetting a buffer is a constant time operation.
  *
  * @param pep_buffer_t * buffer pointer to the buffer.
  *
@@ -177,6 +276,60 @@ int pep_buffer_reset(pep_buffer_t * buffer);
  */
 size_t pep_buffer_length(pep_buffer_t * buffer);
 
+/**
+ * Returns a pointer to the unread data of the buffer. The pointer is valid
+ * until the next write into the buffer. The number of bytes available is
+ * given by pep_buffer_length(buffer).
+ *
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ *
+ * @return const unsigned char * pointer to the unread data or NULL if an error occurs.
+ */
+const unsigned char * pep_buffer_peek(pep_buffer_t * buffer);
+
+/**
+ * Skips count bytes of unread data, as if they were read.
+ *
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ * @param size_t count number of bytes to skip.
+ *
+ * @return size_t number of bytes effectively skipped or BUFFER_ERROR if an error occurs.
+ */
+size_t pep_buffer_skip(pep_buffer_t * buffer, size_t count);
+
+/**
+ * Returns the number of bytes currently allocated by the buffer.
+ *
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ *
+ * @return size_t allocated size of the buffer or 0 if an error occurs.
+ */
+size_t pep_buffer_capacity(pep_buffer_t * buffer);
+
+/**
+ * Releases the memory allocated above the given size. The buffer never shrinks
+ * below its write position, so no data is lost. If size < 2, then the buffer
+ * shrinks to at most 16 bytes.
+ *
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ * @param size_t size the new allocated size.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_buffer_shrink(pep_buffer_t * buffer, size_t size);
+
+/**
+ * Ensures that size more bytes can be written without reallocation. The
+ * buffer grows, at once, to exactly its write position plus size bytes if
+ * it is too small. The content is kept if the reallocation fails.
+ *
+ * @param pep_buffer_t * buffer pointer to the buffer.
+ * @param size_t size the number of bytes to be written.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int pep_buffer_reserve(pep_buffer_t * buffer, size_t size);
+
 #ifdef  __cplusplus
 }
 #endif
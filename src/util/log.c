@@ -26,119 +26,122 @@
 /* tmp buffer for logging */
 #define LOG_BUFFER_SIZE 1024
 
-/* output file handler */
-static FILE * log_out= NULL;
-
-/* log level */
-static pep_log_level_t log_level= LOG_LEVEL_NONE;
-
 /* internal prototypes: */
 static int _log_vfprintf(FILE * out, time_t * epoch, const char * level, const char * fmt, va_list args);
+static int default_log_handler(pep_log_level_t level,const char *fmt, va_list args);
+static int _log_vlog(pep_log_level_t level, const char * fmt, va_list args);
 
 /* level prio strings */
 static const char * LEVEL_EVENTS[]= {"ERROR"," WARN"," INFO","DEBUG","TRACE"};
 
+/* process-wide log context */
+static pep_log_context_t log_default= { LOG_LEVEL_NONE, NULL, (pep_log_handler_func*)default_log_handler };
+
+/* log context of the thread, the process-wide one if NULL */
+static __thread const pep_log_context_t * log_context= NULL;
+
+/* returns the log context of the calling thread */
+static const pep_log_context_t * log_current(void) {
+    return (log_context != NULL) ? log_context : &log_default;
+}
+
 /* internal log handler function */
 static int default_log_handler(pep_log_level_t level,const char *fmt, va_list args) {
     time_t epoch;
     time(&epoch);
-    return _log_vfprintf(log_out, &epoch, LEVEL_EVENTS[level], fmt, args);
+    return _log_vfprintf(log_current()->out, &epoch, LEVEL_EVENTS[level], fmt, args);
 }
 
-/* log handler function pointer */
-static pep_log_handler_func * log_handler= (pep_log_handler_func*)default_log_handler;
-
-
 int pep_log_sethandler(pep_log_handler_func * handler) {
-    log_handler= handler;
+    log_default.handler= handler;
     return LOG_OK;
 }
 
 int pep_log_setlevel(pep_log_level_t level) {
-    log_level= level;
+    log_default.level= level;
     return LOG_OK;
 }
 
 pep_log_level_t pep_log_getlevel(void) {
-    return log_level;
+    return log_current()->level;
 }
 
 int pep_log_setout(FILE * file) {
-    log_out= file;
+    log_default.out= file;
     return LOG_OK;
 }
 
 FILE * pep_log_getout(void) {
-    return log_out;
+    return log_current()->out;
 }
 
+void pep_log_initcontext(pep_log_context_t * context) {
+    if (context == NULL) return;
+    context->level= LOG_LEVEL_NONE;
+    context->out= NULL;
+    context->handler= (pep_log_handler_func*)default_log_handler;
+}
 
+const pep_log_context_t * pep_log_setcontext(const pep_log_context_t * context) {
+    const pep_log_context_t * previous= log_context;
+    log_context= context;
+    return previous;
+}
 
 int pep_log_info(const char *fmt, ...) {
-    int rc= LOG_OK;
+    int rc;
     va_list args;
-    if (log_level >= LOG_LEVEL_INFO) {
-        va_start(args,fmt);
-        if (log_handler != NULL) {
-            rc= log_handler(LOG_LEVEL_INFO,fmt,args);
-        }
-        va_end(args);
-    }
+    va_start(args,fmt);
+    rc= _log_vlog(LOG_LEVEL_INFO,fmt,args);
+    va_end(args);
     return rc;
 }
 
 int pep_log_warn(const char *fmt, ...) {
-    int rc= LOG_OK;
+    int rc;
     va_list args;
-    if (log_level >= LOG_LEVEL_WARN) {
-        va_start(args,fmt);
-        if (log_handler != NULL) {
-            rc= log_handler(LOG_LEVEL_WARN,fmt,args);
-        }
-        va_end(args);
-    }
+    va_start(args,fmt);
+    rc= _log_vlog(LOG_LEVEL_WARN,fmt,args);
+    va_end(args);
     return rc;
 }
 
 int pep_log_error(const char *fmt, ...) {
-    int rc= LOG_OK;
+    int rc;
     va_list args;
-    if (log_level >= LOG_LEVEL_ERROR) {
-        va_start(args,fmt);
-        if (log_handler != NULL) {
-            rc= log_handler(LOG_LEVEL_ERROR,fmt,args);
-        }
-        va_end(args);
-    }
+    va_start(args,fmt);
+    rc= _log_vlog(LOG_LEVEL_ERROR,fmt,args);
+    va_end(args);
     return rc;
 }
 
 int pep_log_debug(const char *fmt, ...) {
-    int rc= LOG_OK;
+    int rc;
     va_list args;
-    if (log_level >= LOG_LEVEL_DEBUG) {
-        va_start(args,fmt);
-        if (log_handler != NULL) {
-            rc= log_handler(LOG_LEVEL_DEBUG,fmt,args);
-        }
-        va_end(args);
-    }
+    va_start(args,fmt);
+    rc= _log_vlog(LOG_LEVEL_DEBUG,fmt,args);
+    va_end(args);
     return rc;
 }
 
 int pep_log_trace(const char *fmt, ...) {
-    int rc= LOG_OK;
+    int rc;
     va_list args;
-    if (log_level >= LOG_LEVEL_TRACE) {
-        va_start(args,fmt);
-        if (log_handler != NULL) {
-            rc= log_handler(LOG_LEVEL_TRACE,fmt,args);
-        }
-        va_end(args);
-    }
+    va_start(args,fmt);
+    rc= _log_vlog(LOG_LEVEL_TRACE,fmt,args);
+    va_end(args);
     return rc;
 }
 
+/* logs with the handler of the thread context, if the level is enabled */
+static int _log_vlog(pep_log_level_t level, const char * fmt, va_list args) {
+    const pep_log_context_t * context= log_current();
+    if (context->level >= level && context->handler != NULL) {
+        return context->handler(level,fmt,args);
+    }
+    return LOG_OK;
+}
+
 
 /* 
  * logs into file out
@@ -50,6 +50,17 @@ typedef enum {
  */
 typedef int pep_log_handler_func(int level,const char * fmt, va_list args);
 
+/**
+ * Log context: level, output and handler. The process-wide context is set with
+ * pep_log_setlevel(), pep_log_setout() and pep_log_sethandler(). A thread can
+ * log in its own context with pep_log_setcontext().
+ */
+typedef struct pep_log_context {
+    pep_log_level_t level;
+    FILE * out;
+    pep_log_handler_func * handler;
+} pep_log_context_t;
+
 /**
  * Sets the optional log handler function.
  *
@@ -85,6 +96,19 @@ int pep_log_setout(FILE * fd);
  */
 FILE * pep_log_getout(void);
 
+/**
+ * Initializes the log context with the defaults: no logging, no output and
+ * the default log handler.
+ */
+void pep_log_initcontext(pep_log_context_t * context);
+
+/**
+ * Sets the log context of the calling thread, NULL to log in the process-wide
+ * context again. The context must remain valid until it is unset.
+ * @return the previous context of the thread, to restore it.
+ */
+const pep_log_context_t * pep_log_setcontext(const pep_log_context_t * context);
+
 /**
  * Logs message at LOG_LEVEL_INFO level.
  * @return {@link #LOG_OK} or {@link #LOG_ERROR} on error
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "vector.h"
+#include "log.h"
+
+/* capacity allocated by the first add */
+#ifndef PEP_VECTOR_MIN_SIZE
+#define PEP_VECTOR_MIN_SIZE 4
+#endif
+
+/**
+ * ADT Vector type
+ */
+struct pep_vector {
+    void ** elements;
+    size_t length;
+    size_t size; /* capacity */
+    pep_vector_realloc_f reallocf; /* NULL: heap */
+    void * allocator;
+};
+
+static int vector_grow(pep_vector_t * vector, size_t size);
+static int vector_ptrcmp(const void * a, const void * b);
+
+pep_vector_t * pep_vector_create(size_t size) {
+    pep_vector_t * vector= calloc(1,sizeof(struct pep_vector));
+    if (vector == NULL) {
+        pep_log_error("pep_vector_create: can't allocate pep_vector_t.");
+        return NULL;
+    }
+    vector->elements= NULL;
+    vector->length= 0;
+    vector->size= 0;
+    if (size > 0 && vector_grow(vector,size) != VECTOR_OK) {
+        pep_log_error("pep_vector_create: can't allocate %d elements.",(int)size);
+        free(vector);
+        return NULL;
+    }
+    return vector;
+}
+
+pep_vector_t * pep_vector_create_in(size_t size, pep_vector_realloc_f reallocf, void * allocator) {
+    pep_vector_t * vector;
+    if (reallocf == NULL) {
+        return pep_vector_create(size);
+    }
+    vector= reallocf(allocator,NULL,0,sizeof(struct pep_vector));
+    if (vector == NULL) {
+        pep_log_error("pep_vector_create_in: can't allocate pep_vector_t.");
+        return NULL;
+    }
+    vector->elements= NULL;
+    vector->length= 0;
+    vector->size= 0;
+    vector->reallocf= reallocf;
+    vector->allocator= allocator;
+    if (size > 0 && vector_grow(vector,size) != VECTOR_OK) {
+        pep_log_error("pep_vector_create_in: can't allocate %d elements.",(int)size);
+        return NULL;
+    }
+    return vector;
+}
+
+size_t pep_vector_length(const pep_vector_t * vector) {
+    if (vector == NULL) {
+        pep_log_error("pep_vector_length: NULL pointer vector.");
+        return 0;
+    }
+    return vector->length;
+}
+
+int pep_vector_add(pep_vector_t * vector, void * element) {
+    if (vector == NULL) {
+        pep_log_error("pep_vector_add: NULL pointer vector.");
+        return VECTOR_ERROR;
+    }
+    if (vector->length == vector->size) {
+        size_t size= (vector->size > 0) ? vector->size * 2 : PEP_VECTOR_MIN_SIZE;
+        if (vector_grow(vector,size) != VECTOR_OK) {
+            pep_log_error("pep_vector_add: can't grow vector to %d elements.",(int)size);
+            return VECTOR_ERROR;
+        }
+    }
+    vector->elements[vector->length++]= element;
+    return VECTOR_OK;
+}
+
+void * pep_vector_get(const pep_vector_t * vector, size_t i) {
+    if (vector == NULL) {
+        pep_log_error("pep_vector_get: NULL pointer vector.");
+        return NULL;
+    }
+    if (i >= vector->length) {
+        pep_log_error("pep_vector_get: index %d out of range.",(int)i);
+        return NULL;
+    }
+    return vector->elements[i];
+}
+
+void * pep_vector_remove(pep_vector_t * vector, size_t i) {
+    void * element;
+    if (vector == NULL) {
+        pep_log_error("pep_vector_remove: NULL pointer vector.");
+        return NULL;
+    }
+    if (i >= vector->length) {
+        pep_log_error("pep_vector_remove: index %d out of range.",(int)i);
+        return NULL; /* empty vector case included */
+    }
+    element= vector->elements[i];
+    memmove(&vector->elements[i],&vector->elements[i + 1],(vector->length - i - 1) * sizeof(void *));
+    vector->length--;
+    return element;
+}
+
+int pep_vector_delete_elements(pep_vector_t * vector, pep_vector_delete_elt_f deletef) {
+    void ** elements;
+    size_t i;
+    if (vector == NULL) {
+        pep_log_error("pep_vector_delete_elements: NULL pointer vector.");
+        return VECTOR_ERROR;
+    }
+    if (deletef == NULL || vector->length == 0) return VECTOR_OK;
+    if (vector->length == 1) {
+        deletef(vector->elements[0]);
+        return VECTOR_OK;
+    }
+    /* WARN: the vector can contain many times the same element (same memory address) */
+    elements= malloc(vector->length * sizeof(void *));
+    if (elements == NULL) {
+        pep_log_error("pep_vector_delete_elements: can't allocate %d elements.",(int)vector->length);
+        return VECTOR_ERROR;
+    }
+    memcpy(elements,vector->elements,vector->length * sizeof(void *));
+    qsort(elements,vector->length,sizeof(void *),vector_ptrcmp);
+    for (i= 0; i < vector->length; i++) {
+        if (i == 0 || elements[i] != elements[i - 1]) {
+            deletef(elements[i]);
+        }
+    }
+    free(elements);
+    return VECTOR_OK;
+}
+
+int pep_vector_delete(pep_vector_t * vector) {
+    if (vector == NULL) {
+        pep_log_error("pep_vector_delete: NULL pointer vector.");
+        return VECTOR_ERROR;
+    }
+    /* released with the allocator */
+    if (vector->reallocf != NULL) return VECTOR_OK;
+    free(vector->elements);
+    free(vector);
+    return VECTOR_OK;
+}
+
+static int vector_grow(pep_vector_t * vector, size_t size) {
+    void ** elements;
+    if (size > SIZE_MAX / sizeof(void *)) return VECTOR_ERROR;
+    if (vector->reallocf != NULL) {
+        elements= vector->reallocf(vector->allocator,vector->elements,vector->size * sizeof(void *),size * sizeof(void *));
+    }
+    else {
+        elements= realloc(vector->elements,size * sizeof(void *));
+    }
+    if (elements == NULL) return VECTOR_ERROR;
+    vector->elements= elements;
+    vector->size= size;
+    return VECTOR_OK;
+}
+
+static int vector_ptrcmp(const void * a, const void * b) {
+    uintptr_t pa= (uintptr_t)*(void * const *)a;
+    uintptr_t pb= (uintptr_t)*(void * const *)b;
+    return (pa > pb) - (pa < pb);
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PEP_VECTOR_H_
+#define _PEP_VECTOR_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h> /* size_t */
+
+/* Return code OK */
+#define VECTOR_OK 0
+/* Return code ERROR */
+#define VECTOR_ERROR -1
+
+/**
+ * ADT Vector type: growable array of element pointers.
+ */
+typedef struct pep_vector pep_vector_t;
+
+/**
+ * Creates an empty vector. The elements array is allocated on the first
+ * add if size is @c 0.
+ *
+ * @param size_t size initial capacity (number of elements).
+ *
+ * @return a pointer to the new vector or NULL if an error occurs.
+ */
+pep_vector_t * pep_vector_create(size_t size);
+
+/**
+ * Allocator of the vectors created by pep_vector_create_in(): reallocates the
+ * block ptr (NULL for a new block) of size bytes to new_size bytes. The memory
+ * belongs to the allocator, typically an arena, and is never freed by the vector.
+ */
+typedef void * (*pep_vector_realloc_f) (void * allocator, void * ptr, size_t size, size_t new_size);
+
+/**
+ * Creates an empty vector, the vector and its elements array are allocated
+ * with the given allocator. pep_vector_delete() releases nothing.
+ *
+ * @param size_t size initial capacity (number of elements).
+ * @param pep_vector_realloc_f reallocf the allocator function.
+ * @param void * allocator the allocator passed to reallocf.
+ *
+ * @return a pointer to the new vector or NULL if an error occurs.
+ */
+pep_vector_t * pep_vector_create_in(size_t size, pep_vector_realloc_f reallocf, void * allocator);
+
+/**
+ * Returns the vector length.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ *
+ * @return size_t number of element in the vector, @c 0 if empty or an error occurs.
+ */
+size_t pep_vector_length(const pep_vector_t * vector);
+
+/**
+ * Adds an element at the end of the vector. The capacity is doubled when
+ * the vector is full.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ * @param void * element pointer to the element to add.
+ *
+ * @return VECTOR_OK or VECTOR_ERROR if an error occurs.
+ */
+int pep_vector_add(pep_vector_t * vector, void * element);
+
+/**
+ * Returns the element at position i [0..n-1] or NULL if index i is out of range.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ * @param size_t index of the element to return.
+ *
+ * @return void * element pointer to the element
+ *         or NULL if an error occurs (index out of range, ...)
+ */
+void * pep_vector_get(const pep_vector_t * vector, size_t i);
+
+/**
+ * Removes the element at position i [0..n-1], the following elements are
+ * shifted down.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ * @param size_t index of the element to remove.
+ *
+ * @return void * element pointer to the removed element
+ *         or NULL if an error occurs (index out of range, ...)
+ */
+void * pep_vector_remove(pep_vector_t * vector, size_t i);
+
+/**
+ * Deletes the vector.
+ * The element contained in the vector are NOT released.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ *
+ * @return VECTOR_OK or VECTOR_ERROR if an error occurs.
+ */
+int pep_vector_delete(pep_vector_t * vector);
+
+/**
+ * Applies the delete function on each distinct element contained in the
+ * vector, an element added several times is deleted only once. The vector
+ * is not released.
+ *
+ * @param pep_vector_t * vector pointer to the vector.
+ * @param pep_vector_delete_elt_f delete function to apply to each element.
+ *
+ * @return VECTOR_OK or VECTOR_ERROR if an error occurs.
+ */
+typedef void (*pep_vector_delete_elt_f) (void *);
+int pep_vector_delete_elements(pep_vector_t * vector, pep_vector_delete_elt_f deletef);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
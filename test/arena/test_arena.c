@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Deserializes random Hessian object graphs from the heap and from an arena:
+ * both graphs must serialize back to the original bytes. The lists and maps
+ * with Hessian refs must share the referenced objects. The allocations done
+ * by each deserialization are counted by interposing the glibc allocator.
+ * The keyed map lookups must find the first pair with the key, in small
+ * (searched) and large (indexed) maps.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/buffer.h"
+#include "hessian/hessian.h"
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static int n_allocs= 0;
+
+void * malloc(size_t size) {
+    n_allocs++;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t nmemb, size_t size) {
+    n_allocs++;
+    return __libc_calloc(nmemb,size);
+}
+
+void * realloc(void * ptr, size_t size) {
+    n_allocs++;
+    return __libc_realloc(ptr,size);
+}
+
+static const char * words[]= {
+    "", "a", "urn:oasis:names:tc:xacml:1.0:subject:subject-id",
+    "caf\303\251 \320\237\321\200\320\270\320\262\320\265\321\202", "\342\202\254 \360\237\230\200 euro",
+};
+
+#define N_WORDS (int)(sizeof(words) / sizeof(char *))
+
+/* returns a random Hessian object graph */
+static hessian_object_t * random_object(int depth) {
+    int i, n;
+    hessian_object_t * o;
+    switch (rand() % ((depth > 0) ? 9 : 7)) {
+    case 0:
+        return hessian_create(HESSIAN_STRING,words[rand() % N_WORDS]);
+    case 1:
+        return hessian_create(HESSIAN_INTEGER,(int32_t)rand());
+    case 2:
+        return hessian_create(HESSIAN_LONG,(int64_t)rand() << 20);
+    case 3:
+        return hessian_create(HESSIAN_BOOLEAN,rand() % 2);
+    case 4:
+        return hessian_create(HESSIAN_NULL);
+    case 5:
+        return hessian_create(HESSIAN_BINARY,(size_t)4,"\0\1\2\3");
+    case 6:
+        return hessian_create(HESSIAN_REMOTE,"org.glite.Service","http://example.org/service");
+    case 7:
+        o= hessian_create(HESSIAN_LIST);
+        n= rand() % 6;
+        for (i= 0; i < n; i++) {
+            hessian_list_add(o,random_object(depth - 1));
+        }
+        return o;
+    default:
+        o= hessian_create(HESSIAN_MAP,"org.glite.authz.Map");
+        n= rand() % 6;
+        for (i= 0; i < n; i++) {
+            hessian_map_add(o,hessian_create(HESSIAN_STRING,words[rand() % N_WORDS]),random_object(depth - 1));
+        }
+        return o;
+    }
+}
+
+/* serializes the object, returns the output length or -1 */
+static int serialize(const hessian_object_t * object, pep_buffer_t * output) {
+    pep_buffer_reset(output);
+    if (hessian_serialize(object,output) != HESSIAN_OK) return -1;
+    return (int)pep_buffer_length(output);
+}
+
+/* reads all the bytes of the buffer, returns the allocated array */
+static char * read_all(pep_buffer_t * buffer, size_t * length) {
+    size_t l= pep_buffer_length(buffer);
+    char * bytes= malloc(l + 1);
+    pep_buffer_read(bytes,1,l,buffer);
+    *length= l;
+    return bytes;
+}
+
+/* compares the serialized object with the expected bytes */
+static int compare(const hessian_object_t * object, const char * expected, size_t expected_l, pep_buffer_t * output) {
+    char * actual;
+    size_t actual_l;
+    int rc;
+    if (serialize(object,output) < 0) return -1;
+    actual= read_all(output,&actual_l);
+    rc= (actual_l == expected_l) ? memcmp(expected,actual,actual_l) : -1;
+    free(actual);
+    return rc;
+}
+
+/* list [ "x", "y", ref 0 ] and map { "k0"=>"x", "k1"=>ref 0 } */
+static int test_refs(hessian_arena_t * arena) {
+    const char list[]= "Vl\0\0\0\3S\0\1xS\0\1yR\0\0\0\0z";
+    const char map[]= "Mt\0\1TS\0\2k0S\0\1xS\0\2k1R\0\0\0\0z";
+    pep_buffer_t * input= pep_buffer_create(64);
+    hessian_object_t * o;
+    int ok= 1;
+    pep_buffer_write(list,1,sizeof(list) - 1,input);
+    pep_buffer_write(map,1,sizeof(map) - 1,input);
+    o= hessian_deserialize_arena(input,arena);
+    if (o == NULL || hessian_list_length(o) != 3 || hessian_list_get(o,2) != hessian_list_get(o,0)) {
+        printf("list ref not shared\n");
+        ok= 0;
+    }
+    /* no-op for an object in the arena */
+    hessian_delete(o);
+    o= hessian_deserialize_arena(input,arena);
+    if (o == NULL || hessian_map_length(o) != 2 || hessian_map_getvalue(o,1) != hessian_map_getvalue(o,0)) {
+        printf("map ref not shared\n");
+        ok= 0;
+    }
+    /* same from the heap, the shared object is deleted once */
+    pep_buffer_reset(input);
+    pep_buffer_write(map,1,sizeof(map) - 1,input);
+    o= hessian_deserialize(input);
+    if (o == NULL || hessian_map_getvalue(o,1) != hessian_map_getvalue(o,0)) {
+        printf("heap map ref not shared\n");
+        ok= 0;
+    }
+    hessian_delete(o);
+    pep_buffer_delete(input);
+    return ok;
+}
+
+/* map of n pairs "k<i>" => i, an integer key and a duplicated "k0" key */
+static int test_map_get(int n, hessian_arena_t * arena) {
+    pep_buffer_t * output= pep_buffer_create(1024);
+    hessian_object_t * map= hessian_create(HESSIAN_MAP,"org.glite.authz.Map");
+    hessian_object_t * read;
+    char key[16];
+    int i, ok= 1;
+    hessian_map_add(map,hessian_create(HESSIAN_INTEGER,(int32_t)7),hessian_create(HESSIAN_INTEGER,(int32_t)-7));
+    for (i= 0; i < n; i++) {
+        sprintf(key,"k%d",i);
+        hessian_map_add(map,hessian_create(HESSIAN_STRING,key),hessian_create(HESSIAN_INTEGER,(int32_t)i));
+    }
+    hessian_map_add(map,hessian_create(HESSIAN_STRING,"k0"),hessian_create(HESSIAN_INTEGER,(int32_t)-1));
+    hessian_serialize(map,output);
+    read= (arena != NULL) ? hessian_deserialize_arena(output,arena) : hessian_deserialize(output);
+    for (i= 0; i < n && ok; i++) {
+        hessian_object_t * value;
+        sprintf(key,"k%d",i);
+        value= hessian_map_get(read,key);
+        if (value == NULL || hessian_integer_getvalue(value) != i || hessian_map_get(map,key) == NULL) {
+            printf("map(%d) key %s not found\n",n,key);
+            ok= 0;
+        }
+    }
+    if (hessian_map_get(read,"k") != NULL || hessian_map_get(read,"7") != NULL || hessian_map_get(read,"") != NULL) {
+        printf("map(%d) unknown key found\n",n);
+        ok= 0;
+    }
+    /* pairs added after the first lookup */
+    hessian_map_add(map,hessian_create(HESSIAN_STRING,""),hessian_create(HESSIAN_INTEGER,(int32_t)n));
+    for (i= n; i < 2 * n; i++) {
+        sprintf(key,"k%d",i);
+        hessian_map_add(map,hessian_create(HESSIAN_STRING,key),hessian_create(HESSIAN_INTEGER,(int32_t)i));
+    }
+    for (i= 0; i < 2 * n && ok; i++) {
+        hessian_object_t * value;
+        sprintf(key,"k%d",i);
+        value= hessian_map_get(map,key);
+        if (value == NULL || hessian_integer_getvalue(value) != i) {
+            printf("map(%d) added key %s not found\n",n,key);
+            ok= 0;
+        }
+    }
+    if (hessian_map_get(map,"") == NULL) {
+        printf("map(%d) empty key not found\n",n);
+        ok= 0;
+    }
+    hessian_delete(map);
+    if (arena == NULL) hessian_delete(read);
+    pep_buffer_delete(output);
+    return ok;
+}
+
+int main(void) {
+    pep_buffer_t * input= pep_buffer_create(1024);
+    pep_buffer_t * output= pep_buffer_create(1024);
+    hessian_arena_t * arena= hessian_arena_create(0);
+    int i, n= 2000, ok= 1, heap_allocs= 0, arena_allocs= 0;
+
+    srand(42);
+    for (i= 0; i < n && ok; i++) {
+        hessian_object_t * o= random_object(4);
+        hessian_object_t * h, * a;
+        char * bytes;
+        size_t bytes_l;
+        serialize(o,output);
+        hessian_delete(o);
+        bytes= read_all(output,&bytes_l);
+
+        pep_buffer_reset(input);
+        pep_buffer_write(bytes,1,bytes_l,input);
+        n_allocs= 0;
+        h= hessian_deserialize(input);
+        heap_allocs+= n_allocs;
+
+        pep_buffer_reset(input);
+        pep_buffer_write(bytes,1,bytes_l,input);
+        hessian_arena_reset(arena);
+        n_allocs= 0;
+        a= hessian_deserialize_arena(input,arena);
+        arena_allocs+= n_allocs;
+
+        if (h == NULL || a == NULL) {
+            printf("object %d: deserialization failed\n",i);
+            ok= 0;
+        }
+        else if (compare(h,bytes,bytes_l,output) != 0) {
+            printf("object %d: heap graph differs\n",i);
+            ok= 0;
+        }
+        else if (compare(a,bytes,bytes_l,output) != 0) {
+            printf("object %d: arena graph differs\n",i);
+            ok= 0;
+        }
+        hessian_delete(h);
+        free(bytes);
+    }
+    printf("%d objects: %d allocations (heap), %d allocations (arena)\n",n,heap_allocs,arena_allocs);
+    if (arena_allocs >= n) {
+        printf("arena allocates more than once per graph\n");
+        ok= 0;
+    }
+
+    hessian_arena_reset(arena);
+    if (!test_refs(arena)) ok= 0;
+    for (i= 1; i < 300; i+= 1 + i / 4) {
+        if (!test_map_get(i,arena) || !test_map_get(i,NULL)) ok= 0;
+    }
+
+    hessian_arena_delete(arena);
+    pep_buffer_delete(input);
+    pep_buffer_delete(output);
+    printf(ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
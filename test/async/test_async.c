@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pep_authorize_async() test against the local stand-in PEP daemon:
+ * - many authorizations in flight, driven by pep_async_perform() and
+ *   pep_async_wait() from one thread, over a bounded number of connections,
+ * - the PIPs run at submission, the OHs and the callback at completion,
+ * - binary body fallback to base64, failed submissions and aborted
+ *   authorizations are completed through the callback.
+ */
+#include <stdio.h>
+
+#include "argus/pep.h"
+#include "../pepd/pepd.h"
+
+#define N_AUTHORIZATIONS 1000
+#define MAX_CONNECTIONS 4
+
+static int n_pips= 0;
+static int n_ohs= 0;
+
+static int pip_init(void) { return 0; }
+static int pip_process(xacml_request_t ** request) { n_pips++; return 0; }
+static int pip_fail(xacml_request_t ** request) { return 1; }
+static int pip_destroy(void) { return 0; }
+static int oh_init(void) { return 0; }
+static int oh_process(xacml_request_t ** request, xacml_response_t ** response) { n_ohs++; return 0; }
+static int oh_destroy(void) { return 0; }
+
+struct completions {
+    int n; /* callbacks called */
+    int permits; /* Permit decisions */
+    pep_error_t rc; /* last error */
+};
+
+static void completed(PEP * pep, xacml_request_t * request, xacml_response_t * response, pep_error_t rc, void * userdata) {
+    struct completions * c= userdata;
+    c->n++;
+    if (rc != PEP_OK) {
+        c->rc= rc;
+    }
+    else if (xacml_result_getdecision(xacml_response_getresult(response,0)) == XACML_DECISION_PERMIT) {
+        c->permits++;
+    }
+    xacml_request_delete(request);
+    xacml_response_delete(response);
+}
+
+static xacml_request_t * create_request(int i) {
+    char id[32];
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    sprintf(id,"CN=User %d",i);
+    xacml_attribute_addvalue(attr,id);
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    return request;
+}
+
+/* submits n authorizations, returns the number of failed submissions */
+static int submit_all(PEP * pep, int n, struct completions * c) {
+    int i, failed= 0;
+    for (i= 0; i < n; i++) {
+        xacml_request_t * request= create_request(i);
+        if (pep_authorize_async(pep,request,completed,c) != PEP_OK) {
+            xacml_request_delete(request);
+            failed++;
+        }
+    }
+    if (c->n != 0) {
+        printf("callback called before pep_async_perform\n");
+        failed++;
+    }
+    return failed;
+}
+
+/* drives the authorizations until all are completed */
+static int perform_all(PEP * pep) {
+    int running= 0;
+    do {
+        if (pep_async_perform(pep,&running) != PEP_OK || pep_async_wait(pep,1000) != PEP_OK) {
+            printf("pep_async_perform or pep_async_wait failed\n");
+            return 1;
+        }
+    } while (running > 0);
+    return 0;
+}
+
+int main(void) {
+    pep_pip_t pip= { "test-pip", pip_init, pip_process, pip_destroy };
+    pep_pip_t failing_pip= { "failing-pip", pip_init, pip_fail, pip_destroy };
+    pep_obligationhandler_t oh= { "test-oh", oh_init, oh_process, oh_destroy };
+    struct completions c= { 0, 0, PEP_OK };
+    pepd_t * pepd, * pepd_base64;
+    PEP * pep;
+    int failed= 0, requests, connections;
+
+    pep_global_init();
+    pepd= pepd_start(PEPD_BINARY);
+    pepd_base64= pepd_start(PEPD_BASE64);
+    pep= pep_initialize();
+    if (pepd == NULL || pepd_base64 == NULL || pep == NULL) {
+        printf("can't start\nFAILED\n");
+        return 1;
+    }
+
+    /* many in flight, bounded connections */
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_MAX_CONNECTIONS,MAX_CONNECTIONS);
+    pep_addpip(pep,&pip);
+    pep_addobligationhandler(pep,&oh);
+    failed+= submit_all(pep,N_AUTHORIZATIONS,&c);
+    if (n_pips != N_AUTHORIZATIONS || n_ohs != 0 || c.n != 0) {
+        printf("at submission: %d PIPs, %d OHs, %d callbacks\n",n_pips,n_ohs,c.n);
+        failed++;
+    }
+    if (pep_setoption(pep,PEP_OPTION_ENDPOINT_TIMEOUT,10) != PEP_ERR_HANDLE_FROZEN) {
+        printf("handle not frozen by pep_authorize_async\n");
+        failed++;
+    }
+    failed+= perform_all(pep);
+    requests= pepd_requests(pepd,NULL);
+    connections= pepd_connections(pepd);
+    printf("%d asynchronous authorizations: %d callbacks, %d permits, %d OHs, %d requests, %d connections\n",N_AUTHORIZATIONS,c.n,c.permits,n_ohs,requests,connections);
+    if (c.n != N_AUTHORIZATIONS || c.permits != N_AUTHORIZATIONS || n_ohs != N_AUTHORIZATIONS || connections > MAX_CONNECTIONS) {
+        printf("expected %d permits with at most %d connections, last error: %s\n",N_AUTHORIZATIONS,MAX_CONNECTIONS,pep_strerror(c.rc));
+        failed++;
+    }
+
+    /* in flight authorizations aborted */
+    c.n= 0;
+    failed+= submit_all(pep,10,&c);
+    pep_destroy(pep);
+    if (c.n != 10 || c.rc != PEP_ERR_ASYNC_ABORTED) {
+        printf("pep_destroy: %d callbacks, last error: %s\n",c.n,pep_strerror(c.rc));
+        failed++;
+    }
+
+    /* binary body rejected, resent base64 encoded */
+    pep= pep_initialize();
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd_base64));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    c.n= c.permits= 0;
+    c.rc= PEP_OK;
+    failed+= submit_all(pep,20,&c) + perform_all(pep);
+    if (c.n != 20 || c.permits != 20) {
+        printf("base64 fallback: %d callbacks, %d permits, last error: %s\n",c.n,c.permits,pep_strerror(c.rc));
+        failed++;
+    }
+    pep_destroy(pep);
+
+    /* failed submission completed by pep_async_perform */
+    pep= pep_initialize();
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_addpip(pep,&failing_pip);
+    c.n= c.permits= 0;
+    c.rc= PEP_OK;
+    failed+= submit_all(pep,3,&c) + perform_all(pep);
+    if (c.n != 3 || c.rc != PEP_ERR_PIP_PROCESS) {
+        printf("failing PIP: %d callbacks, last error: %s\n",c.n,pep_strerror(c.rc));
+        failed++;
+    }
+    pep_destroy(pep);
+
+    pepd_stop(pepd);
+    pepd_stop(pepd_base64);
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
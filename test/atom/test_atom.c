@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * XACML atom table test: every identifier of xacml.h and profiles.h must map
+ * to its predefined atom, user identifiers are interned once, also by
+ * concurrent threads. The model objects must carry the atom of their id and
+ * share the interned identifier.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "argus/xacml.h"
+#include "argus/profiles.h"
+
+#define N_THREADS 8
+#define N_IDS 500
+
+static int n_errors= 0;
+
+#define CHECK_ATOM(id,atom) check_atom(#id,id,atom)
+
+static void check_atom(const char * name, const char * id, xacml_atom_t atom) {
+    const char * interned= xacml_atom_tostring(atom);
+    if (atom == XACML_ATOM_NONE || xacml_atom_lookup(id) != atom || interned == NULL || strcmp(interned,id) != 0) {
+        printf("%s: atom %d not predefined\n",name,atom);
+        n_errors++;
+    }
+}
+
+static xacml_atom_t user_atoms[N_THREADS][N_IDS];
+
+static void * intern_ids(void * arg) {
+    xacml_atom_t * atoms= arg;
+    char id[64];
+    int i;
+    for (i= 0; i < N_IDS; i++) {
+        sprintf(id,"urn:example:attribute:%d",i);
+        atoms[i]= xacml_atom_intern(id);
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t threads[N_THREADS];
+    xacml_attribute_t * attr;
+    xacml_obligation_t * obligation;
+    xacml_attributeassignment_t * assignment;
+    xacml_atom_t atom;
+    int i, j;
+
+    CHECK_ATOM(XACML_DATATYPE_X500NAME,XACML_ATOM_DATATYPE_X500NAME);
+    CHECK_ATOM(XACML_DATATYPE_RFC822NAME,XACML_ATOM_DATATYPE_RFC822NAME);
+    CHECK_ATOM(XACML_DATATYPE_IPADDRESS,XACML_ATOM_DATATYPE_IPADDRESS);
+    CHECK_ATOM(XACML_DATATYPE_DNSNAME,XACML_ATOM_DATATYPE_DNSNAME);
+    CHECK_ATOM(XACML_DATATYPE_STRING,XACML_ATOM_DATATYPE_STRING);
+    CHECK_ATOM(XACML_DATATYPE_BOOLEAN,XACML_ATOM_DATATYPE_BOOLEAN);
+    CHECK_ATOM(XACML_DATATYPE_INTEGER,XACML_ATOM_DATATYPE_INTEGER);
+    CHECK_ATOM(XACML_DATATYPE_DOUBLE,XACML_ATOM_DATATYPE_DOUBLE);
+    CHECK_ATOM(XACML_DATATYPE_TIME,XACML_ATOM_DATATYPE_TIME);
+    CHECK_ATOM(XACML_DATATYPE_DATE,XACML_ATOM_DATATYPE_DATE);
+    CHECK_ATOM(XACML_DATATYPE_DATETIME,XACML_ATOM_DATATYPE_DATETIME);
+    CHECK_ATOM(XACML_DATATYPE_ANYURI,XACML_ATOM_DATATYPE_ANYURI);
+    CHECK_ATOM(XACML_DATATYPE_HEXBINARY,XACML_ATOM_DATATYPE_HEXBINARY);
+    CHECK_ATOM(XACML_DATATYPE_BASE64BINARY,XACML_ATOM_DATATYPE_BASE64BINARY);
+    CHECK_ATOM(XACML_DATATYPE_DAY_TIME_DURATION,XACML_ATOM_DATATYPE_DAY_TIME_DURATION);
+    CHECK_ATOM(XACML_DATATYPE_YEAR_MONTH_DURATION,XACML_ATOM_DATATYPE_YEAR_MONTH_DURATION);
+    CHECK_ATOM(XACML_SUBJECT_ID,XACML_ATOM_SUBJECT_ID);
+    CHECK_ATOM(XACML_SUBJECT_ID_QUALIFIER,XACML_ATOM_SUBJECT_ID_QUALIFIER);
+    CHECK_ATOM(XACML_SUBJECT_KEY_INFO,XACML_ATOM_SUBJECT_KEY_INFO);
+    CHECK_ATOM(XACML_SUBJECT_CATEGORY_ACCESS,XACML_ATOM_SUBJECT_CATEGORY_ACCESS);
+    CHECK_ATOM(XACML_SUBJECT_CATEGORY_INTERMEDIARY,XACML_ATOM_SUBJECT_CATEGORY_INTERMEDIARY);
+    CHECK_ATOM(XACML_SUBJECT_CATEGORY_RECIPIENT,XACML_ATOM_SUBJECT_CATEGORY_RECIPIENT);
+    CHECK_ATOM(XACML_SUBJECT_CATEGORY_CODEBASE,XACML_ATOM_SUBJECT_CATEGORY_CODEBASE);
+    CHECK_ATOM(XACML_SUBJECT_CATEGORY_REQUESTING_MACHINE,XACML_ATOM_SUBJECT_CATEGORY_REQUESTING_MACHINE);
+    CHECK_ATOM(XACML_RESOURCE_ID,XACML_ATOM_RESOURCE_ID);
+    CHECK_ATOM(XACML_ACTION_ID,XACML_ATOM_ACTION_ID);
+    CHECK_ATOM(XACML_ENVIRONMENT_CURRENT_TIME,XACML_ATOM_ENVIRONMENT_CURRENT_TIME);
+    CHECK_ATOM(XACML_ENVIRONMENT_CURRENT_DATE,XACML_ATOM_ENVIRONMENT_CURRENT_DATE);
+    CHECK_ATOM(XACML_ENVIRONMENT_CURRENT_DATETIME,XACML_ATOM_ENVIRONMENT_CURRENT_DATETIME);
+    CHECK_ATOM(XACML_STATUSCODE_OK,XACML_ATOM_STATUSCODE_OK);
+    CHECK_ATOM(XACML_STATUSCODE_MISSINGATTRIBUTE,XACML_ATOM_STATUSCODE_MISSINGATTRIBUTE);
+    CHECK_ATOM(XACML_STATUSCODE_SYNTAXERROR,XACML_ATOM_STATUSCODE_SYNTAXERROR);
+    CHECK_ATOM(XACML_STATUSCODE_PROCESSINGERROR,XACML_ATOM_STATUSCODE_PROCESSINGERROR);
+    CHECK_ATOM(XACML_COMMONAUTHZ_PROFILE_1_1,XACML_ATOM_COMMONAUTHZ_PROFILE_1_1);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_PROFILE_ID,XACML_ATOM_DCISEC_ATTRIBUTE_PROFILE_ID);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_SUBJECT_ISSUER,XACML_ATOM_DCISEC_ATTRIBUTE_SUBJECT_ISSUER);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION,XACML_ATOM_DCISEC_ATTRIBUTE_VIRTUAL_ORGANIZATION);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_GROUP,XACML_ATOM_DCISEC_ATTRIBUTE_GROUP);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_GROUP_PRIMARY,XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_PRIMARY);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_ROLE,XACML_ATOM_DCISEC_ATTRIBUTE_ROLE);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_ROLE_PRIMARY,XACML_ATOM_DCISEC_ATTRIBUTE_ROLE_PRIMARY);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_RESOURCE_OWNER,XACML_ATOM_DCISEC_ATTRIBUTE_RESOURCE_OWNER);
+    CHECK_ATOM(XACML_DCISEC_ACTION_NAMESPACE,XACML_ATOM_DCISEC_ACTION_NAMESPACE);
+    CHECK_ATOM(XACML_DCISEC_ACTION_ANY,XACML_ATOM_DCISEC_ACTION_ANY);
+    CHECK_ATOM(XACML_DCISEC_OBLIGATION_MAP_LOCAL_USER,XACML_ATOM_DCISEC_OBLIGATION_MAP_LOCAL_USER);
+    CHECK_ATOM(XACML_DCISEC_OBLIGATION_MAP_POSIX_USER,XACML_ATOM_DCISEC_OBLIGATION_MAP_POSIX_USER);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_USER_ID,XACML_ATOM_DCISEC_ATTRIBUTE_USER_ID);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_GROUP_ID,XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID);
+    CHECK_ATOM(XACML_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY,XACML_ATOM_DCISEC_ATTRIBUTE_GROUP_ID_PRIMARY);
+    CHECK_ATOM(XACML_GRIDWN_PROFILE_VERSION,XACML_ATOM_GRIDWN_PROFILE_VERSION);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID,XACML_ATOM_GRIDWN_ATTRIBUTE_PROFILE_ID);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_PROFILE_ID,XACML_ATOM_GLITE_ATTRIBUTE_PROFILE_ID);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_SUBJECT_ISSUER,XACML_ATOM_GLITE_ATTRIBUTE_SUBJECT_ISSUER);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_VOMS_ISSUER,XACML_ATOM_GLITE_ATTRIBUTE_VOMS_ISSUER);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION,XACML_ATOM_GLITE_ATTRIBUTE_VIRTUAL_ORGANIZATION);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_FQAN,XACML_ATOM_GLITE_ATTRIBUTE_FQAN);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_FQAN_PRIMARY,XACML_ATOM_GLITE_ATTRIBUTE_FQAN_PRIMARY);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER,XACML_ATOM_GLITE_ATTRIBUTE_PILOT_JOB_CLASSIFIER);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_USER_ID,XACML_ATOM_GLITE_ATTRIBUTE_USER_ID);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_GROUP_ID,XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID);
+    CHECK_ATOM(XACML_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY,XACML_ATOM_GLITE_ATTRIBUTE_GROUP_ID_PRIMARY);
+    CHECK_ATOM(XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP,XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP);
+    CHECK_ATOM(XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX,XACML_ATOM_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX);
+    CHECK_ATOM(XACML_GLITE_DATATYPE_FQAN,XACML_ATOM_GLITE_DATATYPE_FQAN);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER,XACML_ATOM_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION,XACML_ATOM_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_FQAN,XACML_ATOM_GRIDWN_ATTRIBUTE_FQAN);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_FQAN_PRIMARY,XACML_ATOM_GRIDWN_ATTRIBUTE_FQAN_PRIMARY);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_PILOT_JOB_CLASSIFIER,XACML_ATOM_GRIDWN_ATTRIBUTE_PILOT_JOB_CLASSIFIER);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_VOMS_ISSUER,XACML_ATOM_GRIDWN_ATTRIBUTE_VOMS_ISSUER);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_USER_ID,XACML_ATOM_GRIDWN_ATTRIBUTE_USER_ID);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_GROUP_ID,XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID);
+    CHECK_ATOM(XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY,XACML_ATOM_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY);
+    CHECK_ATOM(XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP,XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP);
+    CHECK_ATOM(XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX,XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX);
+    CHECK_ATOM(XACML_GRIDWN_DATATYPE_FQAN,XACML_ATOM_GRIDWN_DATATYPE_FQAN);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_X509_ID,XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ID);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_X509_ISSUER,XACML_ATOM_AUTHZINTEROP_SUBJECT_X509_ISSUER);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_VO,XACML_ATOM_AUTHZINTEROP_SUBJECT_VO);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN,XACML_ATOM_AUTHZINTEROP_SUBJECT_CERTCHAIN);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN,XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_FQAN);
+    CHECK_ATOM(XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN,XACML_ATOM_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_UIDGID,XACML_ATOM_AUTHZINTEROP_OBLIGATION_UIDGID);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS,XACML_ATOM_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_USERNAME,XACML_ATOM_AUTHZINTEROP_OBLIGATION_USERNAME);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_AFS_TOKEN,XACML_ATOM_AUTHZINTEROP_OBLIGATION_AFS_TOKEN);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID,XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID,XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME,XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME);
+    CHECK_ATOM(XACML_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN,XACML_ATOM_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN);
+
+    /* unknown identifiers */
+    if (xacml_atom_lookup("urn:example:unknown") != XACML_ATOM_NONE || xacml_atom_lookup(NULL) != XACML_ATOM_NONE
+        || xacml_atom_tostring(XACML_ATOM_NONE) != NULL || xacml_atom_tostring(-1) != NULL) {
+        printf("unknown identifier interned\n");
+        n_errors++;
+    }
+
+    /* concurrent interning */
+    for (i= 0; i < N_THREADS; i++) pthread_create(&threads[i],NULL,intern_ids,user_atoms[i]);
+    for (i= 0; i < N_THREADS; i++) pthread_join(threads[i],NULL);
+    for (j= 0; j < N_IDS; j++) {
+        char id[64];
+        sprintf(id,"urn:example:attribute:%d",j);
+        atom= user_atoms[0][j];
+        if (atom < XACML_ATOM_PROFILES_LAST || xacml_atom_lookup(id) != atom || strcmp(xacml_atom_tostring(atom),id) != 0) {
+            printf("%s: atom %d not interned\n",id,atom);
+            n_errors++;
+        }
+        for (i= 1; i < N_THREADS; i++) {
+            if (user_atoms[i][j] != atom) {
+                printf("%s: interned twice (%d and %d)\n",id,atom,user_atoms[i][j]);
+                n_errors++;
+            }
+        }
+    }
+
+    /* model objects share the interned identifiers */
+    attr= xacml_attribute_create(XACML_SUBJECT_ID);
+    if (xacml_attribute_getatom(attr) != XACML_ATOM_SUBJECT_ID || xacml_attribute_getid(attr) != xacml_atom_tostring(XACML_ATOM_SUBJECT_ID)) {
+        printf("attribute id not interned\n");
+        n_errors++;
+    }
+    xacml_attribute_setid(attr,"urn:example:attribute:7");
+    if (xacml_attribute_getatom(attr) != user_atoms[0][7]) {
+        printf("attribute user id not interned\n");
+        n_errors++;
+    }
+    xacml_attribute_setid(attr,"urn:example:unknown");
+    if (xacml_attribute_getatom(attr) != XACML_ATOM_NONE || strcmp(xacml_attribute_getid(attr),"urn:example:unknown") != 0) {
+        printf("attribute unknown id\n");
+        n_errors++;
+    }
+    xacml_attribute_delete(attr);
+    obligation= xacml_obligation_create(XACML_GLITE_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX);
+    assignment= xacml_attributeassignment_create(XACML_GRIDWN_ATTRIBUTE_USER_ID);
+    if (xacml_obligation_getatom(obligation) != XACML_ATOM_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX
+        || xacml_attributeassignment_getatom(assignment) != XACML_ATOM_GLITE_ATTRIBUTE_USER_ID) {
+        printf("obligation or assignment id not interned\n");
+        n_errors++;
+    }
+    xacml_obligation_delete(obligation);
+    xacml_attributeassignment_delete(assignment);
+
+    printf(n_errors == 0 ? "OK\n" : "FAILED\n");
+    return n_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Base64 codec kernels test: every kernel supported by the CPU must encode
+ * and decode exactly like the reference byte by byte codec, for all the
+ * lengths, line sizes, chunk sizes and with chars not in the codec table.
+ * The throughput of each kernel is printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/buffer.h"
+#include "util/base64.h"
+
+static const char table[]="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* reference encoder, as in the original pep_base64_encode_buffer_l */
+static size_t reference_encode(const unsigned char * in, size_t in_l, int linesize, unsigned char * out) {
+    size_t i, n= 0, b_out= 0;
+    for (i= 0; i < in_l; i+= 3) {
+        unsigned char b[3]= { 0, 0, 0 };
+        size_t l= in_l - i < 3 ? in_l - i : 3;
+        memcpy(b,&in[i],l);
+        out[n++]= table[b[0] >> 2];
+        out[n++]= table[((b[0] & 0x03) << 4) | (b[1] >> 4)];
+        out[n++]= l > 1 ? table[((b[1] & 0x0f) << 2) | (b[2] >> 6)] : '=';
+        out[n++]= l > 2 ? table[b[2] & 0x3f] : '=';
+        b_out+= 4;
+        if (linesize > 0 && (b_out >= (size_t)linesize || i + 3 >= in_l)) {
+            out[n++]= '\r';
+            out[n++]= '\n';
+            b_out= 0;
+        }
+    }
+    return n;
+}
+
+/* reference decoder, as in the original pep_base64_decode_buffer */
+static size_t reference_decode(const unsigned char * in, size_t in_l, unsigned char * out) {
+    size_t i, n= 0;
+    unsigned char b[4];
+    int b_l= 0;
+    char * p;
+    for (i= 0; i <= in_l; i++) {
+        if (i < in_l) {
+            if (in[i] == '\0' || (p= strchr(table,in[i])) == NULL) continue;
+            b[b_l++]= p - table;
+        }
+        if (b_l == 4 || (i == in_l && b_l > 0)) {
+            int j;
+            for (j= b_l; j < 4; j++) b[j]= 0;
+            out[n++]= b[0] << 2 | b[1] >> 4;
+            if (b_l > 2) out[n++]= b[1] << 4 | b[2] >> 2;
+            if (b_l > 3) out[n++]= ((b[2] << 6) & 0xc0) | b[3];
+            b_l= 0;
+        }
+    }
+    return n;
+}
+
+static int check_codec(pep_base64_codec_t codec) {
+    static unsigned char data[1200], expected[2500], noisy[2500], decoded[2000];
+    static const char noise[]= "\r\n =\t-.\0\200\377*";
+    static const int linesizes[]= { 0, 4, 7, 64, 76, 1000 };
+    size_t len, i, n, expected_l, noisy_l;
+    unsigned int l, chunk;
+    pep_buffer_t * in= pep_buffer_create(64);
+    pep_buffer_t * out= pep_buffer_create(64);
+    pep_base64_encoder_t * encoder;
+    pep_base64_decoder_t * decoder;
+    unsigned char buf[97];
+
+    for (i= 0; i < sizeof(data); i++) data[i]= (unsigned char)rand();
+    for (len= 0; len < sizeof(data); len+= (len < 200 ? 1 : 37)) {
+        for (l= 0; l < sizeof(linesizes) / sizeof(int); l++) {
+            /* buffer encoder */
+            expected_l= reference_encode(data,len,linesizes[l],expected);
+            pep_buffer_reset(in);
+            pep_buffer_reset(out);
+            pep_buffer_write(data,1,len,in);
+            if (linesizes[l] == 0) pep_base64_encode_buffer(in,out);
+            else pep_base64_encode_buffer_l(in,out,linesizes[l]);
+            if (pep_buffer_length(out) != expected_l || memcmp(pep_buffer_peek(out),expected,expected_l) != 0) {
+                printf("codec %d: encode len=%d linesize=%d differs\n",codec,(int)len,linesizes[l]);
+                return 1;
+            }
+            if (linesizes[l] == 0) continue;
+            /* streaming encoder, odd dst sizes */
+            for (chunk= 1; chunk < sizeof(buf); chunk+= 6) {
+                encoder= pep_base64_encoder_create(linesizes[l]);
+                pep_buffer_rewind(in);
+                pep_buffer_reset(out);
+                pep_base64_encoder_reset(encoder,in);
+                while ((n= pep_base64_encoder_read(buf,1,chunk,encoder)) > 0) {
+                    pep_buffer_write(buf,1,n,out);
+                }
+                pep_base64_encoder_delete(encoder);
+                if (pep_buffer_length(out) != expected_l || memcmp(pep_buffer_peek(out),expected,expected_l) != 0) {
+                    printf("codec %d: streaming encode len=%d linesize=%d chunk=%d differs\n",codec,(int)len,linesizes[l],chunk);
+                    return 1;
+                }
+            }
+        }
+        /* decoder with chars not in table at random positions */
+        expected_l= reference_encode(data,len,0,expected);
+        noisy_l= 0;
+        for (i= 0; i < expected_l; i++) {
+            if (rand() % 23 == 0) noisy[noisy_l++]= noise[rand() % (sizeof(noise) - 1)];
+            noisy[noisy_l++]= expected[i];
+        }
+        for (chunk= 1; chunk < 200; chunk+= 11) {
+            pep_buffer_reset(out);
+            decoder= pep_base64_decoder_create((pep_base64_write_func *)pep_buffer_write,out);
+            for (i= 0; i < noisy_l; i+= chunk) {
+                n= noisy_l - i < chunk ? noisy_l - i : chunk;
+                pep_base64_decoder_write(&noisy[i],1,n,decoder);
+            }
+            pep_base64_decoder_flush(decoder);
+            pep_base64_decoder_delete(decoder);
+            n= reference_decode(noisy,noisy_l,decoded);
+            if (n != len || memcmp(decoded,data,len) != 0) {
+                printf("reference decode len=%d differs\n",(int)len);
+                return 1;
+            }
+            if (pep_buffer_length(out) != len || memcmp(pep_buffer_peek(out),data,len) != 0) {
+                printf("codec %d: decode len=%d chunk=%d differs\n",codec,(int)len,chunk);
+                return 1;
+            }
+        }
+        /* buffer decoder */
+        pep_buffer_reset(in);
+        pep_buffer_reset(out);
+        pep_buffer_write(noisy,1,noisy_l,in);
+        pep_base64_decode_buffer(in,out);
+        if (pep_buffer_length(out) != len || memcmp(pep_buffer_peek(out),data,len) != 0) {
+            printf("codec %d: buffer decode len=%d differs\n",codec,(int)len);
+            return 1;
+        }
+    }
+    pep_buffer_delete(in);
+    pep_buffer_delete(out);
+    return 0;
+}
+
+static void throughput(pep_base64_codec_t codec) {
+    size_t size= 4 * 1024 * 1024, i;
+    pep_buffer_t * data= pep_buffer_create(size);
+    pep_buffer_t * encoded= pep_buffer_create(size * 2);
+    pep_buffer_t * decoded= pep_buffer_create(size);
+    clock_t start, encode, decode;
+    for (i= 0; i < size; i++) pep_buffer_putc(rand(),data);
+    start= clock();
+    pep_base64_encode_buffer_l(data,encoded,BASE64_DEFAULT_LINE_SIZE);
+    encode= clock();
+    pep_base64_decode_buffer(encoded,decoded);
+    decode= clock();
+    printf("codec %d: encode %.0f MB/s, decode %.0f MB/s\n",codec,
+           4.0 / ((double)(encode - start + 1) / CLOCKS_PER_SEC),
+           4.0 / ((double)(decode - encode + 1) / CLOCKS_PER_SEC));
+    pep_buffer_delete(data);
+    pep_buffer_delete(encoded);
+    pep_buffer_delete(decoded);
+}
+
+int main(void) {
+    pep_base64_codec_t codec;
+    srand(1);
+    for (codec= PEP_BASE64_CODEC_SCALAR; codec <= PEP_BASE64_CODEC_AVX2; codec++) {
+        if (pep_base64_setcodec(codec) != BUFFER_OK) {
+            printf("codec %d: not supported, skipped\n",codec);
+            continue;
+        }
+        if (check_codec(codec) != 0) {
+            printf("FAILED\n");
+            return 1;
+        }
+        throughput(codec);
+    }
+    pep_base64_setcodec(PEP_BASE64_CODEC_AUTO);
+    printf("OK (codec %d)\n",pep_base64_getcodec());
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pep_authorize_batch() test against the local stand-in PEP daemon:
+ * - the requests of a batch are sent over a bounded number of connections,
+ *   kept for the next batch with the curl handles of the transfers,
+ * - the PIPs and OHs are applied to each request, a NULL request or a failing
+ *   PIP only fails its own request,
+ * - binary body fallback to base64,
+ * - threads send batches simultaneously with one frozen PEP handle.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <curl/curl.h>
+
+#include "argus/pep.h"
+#include "../pepd/pepd.h"
+
+#define N_REQUESTS 100
+#define MAX_CONNECTIONS 4
+#define N_THREADS 4
+
+static int n_pips= 0;
+static int n_ohs= 0;
+static int n_curls= 0;
+
+/* counts the curl handles created */
+CURL * curl_easy_init(void) {
+    static CURL * (*libcurl_easy_init)(void)= NULL;
+    if (libcurl_easy_init == NULL) libcurl_easy_init= (CURL * (*)(void))dlsym(RTLD_NEXT,"curl_easy_init");
+    __sync_fetch_and_add(&n_curls,1);
+    return libcurl_easy_init();
+}
+
+static int pip_init(void) { return 0; }
+static int pip_destroy(void) { return 0; }
+static int oh_init(void) { return 0; }
+static int oh_destroy(void) { return 0; }
+
+/* fails for the subject "CN=User 5" */
+static int pip_process(xacml_request_t ** request) {
+    xacml_subject_t * subject= xacml_request_getsubject(*request,0);
+    xacml_attribute_t * attr= xacml_subject_getattribute(subject,0);
+    __sync_fetch_and_add(&n_pips,1);
+    return (strcmp(xacml_attribute_getvalue(attr,0),"CN=User 5") == 0) ? 1 : 0;
+}
+
+static int oh_process(xacml_request_t ** request, xacml_response_t ** response) {
+    __sync_fetch_and_add(&n_ohs,1);
+    return 0;
+}
+
+static xacml_request_t * create_request(int i) {
+    char id[32];
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    sprintf(id,"CN=User %d",i);
+    xacml_attribute_addvalue(attr,id);
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    return request;
+}
+
+/*
+ * sends a batch of n requests, the request skip (if >= 0) is NULL, returns
+ * the number of permits and the last error in rc
+ */
+static int batch(PEP * pep, int n, int skip, pep_error_t * errors, pep_error_t * rc) {
+    xacml_request_t * requests[N_REQUESTS];
+    xacml_response_t * responses[N_REQUESTS];
+    int i, permits= 0;
+    for (i= 0; i < n; i++) {
+        requests[i]= (i == skip) ? NULL : create_request(i);
+    }
+    *rc= pep_authorize_batch(pep,requests,n,responses,errors);
+    for (i= 0; i < n; i++) {
+        if (errors[i] == PEP_OK && xacml_result_getdecision(xacml_response_getresult(responses[i],0)) == XACML_DECISION_PERMIT) {
+            permits++;
+        }
+        xacml_request_delete(requests[i]);
+        xacml_response_delete(responses[i]);
+    }
+    return permits;
+}
+
+struct worker {
+    pthread_t thread;
+    PEP * pep;
+    int permits;
+};
+
+static void * worker_run(void * arg) {
+    struct worker * w= arg;
+    pep_error_t errors[N_REQUESTS];
+    pep_error_t rc;
+    int i;
+    for (i= 0; i < 5; i++) w->permits+= batch(w->pep,20,-1,errors,&rc);
+    return NULL;
+}
+
+int main(void) {
+    pep_pip_t pip= { "test-pip", pip_init, pip_process, pip_destroy };
+    pep_obligationhandler_t oh= { "test-oh", oh_init, oh_process, oh_destroy };
+    struct worker workers[N_THREADS];
+    pep_error_t errors[N_REQUESTS];
+    pep_error_t rc;
+    pepd_t * pepd, * pepd_base64;
+    PEP * pep;
+    int i, failed= 0, permits, errors_ok, connections;
+
+    pep_global_init();
+    pepd= pepd_start(PEPD_BINARY);
+    pepd_base64= pepd_start(PEPD_BASE64);
+    pep= pep_initialize();
+    if (pepd == NULL || pepd_base64 == NULL || pep == NULL) {
+        printf("can't start\nFAILED\n");
+        return 1;
+    }
+
+    /* per request errors don't fail the batch */
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_MAX_CONNECTIONS,MAX_CONNECTIONS);
+    pep_addpip(pep,&pip);
+    pep_addobligationhandler(pep,&oh);
+    permits= batch(pep,N_REQUESTS,3,errors,&rc);
+    for (i= 0, errors_ok= 0; i < N_REQUESTS; i++) if (errors[i] == PEP_OK) errors_ok++;
+    connections= pepd_connections(pepd);
+    printf("batch of %d: %d permits, %d PIPs, %d OHs, %d connections\n",N_REQUESTS,permits,n_pips,n_ohs,connections);
+    if (rc != PEP_OK || permits != N_REQUESTS - 2 || errors_ok != N_REQUESTS - 2
+        || errors[3] != PEP_ERR_NULL_POINTER || errors[5] != PEP_ERR_PIP_PROCESS
+        || n_pips != N_REQUESTS - 1 || n_ohs != N_REQUESTS - 2 || connections > MAX_CONNECTIONS) {
+        printf("expected %d permits, NULL request and PIP errors, at most %d connections: %s, %s, %s\n",N_REQUESTS - 2,MAX_CONNECTIONS,
+               pep_strerror(rc),pep_strerror(errors[3]),pep_strerror(errors[5]));
+        failed++;
+    }
+
+    /* the connections and the transports are kept for the next batch */
+    n_curls= 0;
+    permits= batch(pep,N_REQUESTS,-1,errors,&rc);
+    if (rc != PEP_OK || permits != N_REQUESTS - 1 || pepd_connections(pepd) != connections || n_curls != 0) {
+        printf("second batch: %d permits, %d connections, %d curl handles created\n",permits,pepd_connections(pepd),n_curls);
+        failed++;
+    }
+
+    /* simultaneous batches with a frozen handle */
+    pep_freeze(pep);
+    for (i= 0; i < N_THREADS; i++) {
+        workers[i].pep= pep;
+        workers[i].permits= 0;
+        pthread_create(&workers[i].thread,NULL,worker_run,&workers[i]);
+    }
+    for (permits= 0, i= 0; i < N_THREADS; i++) {
+        pthread_join(workers[i].thread,NULL);
+        permits+= workers[i].permits;
+    }
+    printf("%d threads, one frozen handle: %d permits, %d connections\n",N_THREADS,permits,pepd_connections(pepd));
+    if (permits != N_THREADS * 5 * 19) {
+        printf("expected %d permits\n",N_THREADS * 5 * 19);
+        failed++;
+    }
+    pep_destroy(pep);
+
+    /* binary body rejected, resent base64 encoded */
+    pep= pep_initialize();
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd_base64));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    permits= batch(pep,20,-1,errors,&rc);
+    if (rc != PEP_OK || permits != 20) {
+        printf("base64 fallback: %d permits, %s\n",permits,pep_strerror(errors[0]));
+        failed++;
+    }
+    pep_destroy(pep);
+
+    pepd_stop(pepd);
+    pepd_stop(pepd_base64);
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * PEP_OPTION_ENDPOINT_BINARY_BODY test against the local stand-in PEP daemon:
+ * - binary body sent and received raw by a server supporting it,
+ * - fallback to base64 with a server rejecting it, remembered by the handle,
+ * - binary body kept after a transient server error,
+ * - base64 body by default.
+ */
+#include <stdio.h>
+
+#include "argus/pep.h"
+#include "../pepd/pepd.h"
+
+/* authorizes n requests, returns the number of failures */
+static int authorize(PEP * pep, int n) {
+    int i, failed= 0;
+    for (i= 0; i < n; i++) {
+        pep_error_t rc;
+        xacml_request_t * request= xacml_request_create();
+        xacml_subject_t * subject= xacml_subject_create();
+        xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+        xacml_response_t * response= NULL;
+        xacml_attribute_addvalue(attr,"CN=John Doe \320\237\321\200");
+        xacml_subject_addattribute(subject,attr);
+        xacml_request_addsubject(request,subject);
+        rc= pep_authorize(pep,&request,&response);
+        if (rc != PEP_OK) {
+            printf("pep_authorize failed: %s\n",pep_strerror(rc));
+            failed++;
+        }
+        else {
+            xacml_result_t * result= xacml_response_getresult(response,0);
+            if (xacml_result_getdecision(result) != XACML_DECISION_PERMIT
+                || xacml_request_subjects_length(request) != 1) {
+                printf("unexpected response\n");
+                failed++;
+            }
+            xacml_response_delete(response);
+        }
+        xacml_request_delete(request);
+    }
+    return failed;
+}
+
+/* runs n authorizations, checks the requests and binary requests received */
+static int check(const char * name, int mode, int binary_body, int n, int expected, int expected_binary) {
+    int requests, binary, failed;
+    pepd_t * pepd= pepd_start(mode);
+    PEP * pep= pep_initialize();
+    if (pepd == NULL || pep == NULL) {
+        printf("%s: can't start\n",name);
+        return 1;
+    }
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,binary_body);
+    failed= authorize(pep,n);
+    pep_destroy(pep);
+    requests= pepd_requests(pepd,&binary);
+    pepd_stop(pepd);
+    printf("%s: %d authorizations, %d requests (%d binary)\n",name,n,requests,binary);
+    if (failed > 0 || requests != expected || binary != expected_binary) {
+        printf("%s: expected %d requests (%d binary)\n",name,expected,expected_binary);
+        return 1;
+    }
+    return 0;
+}
+
+/* one 503 reply: the authorization fails, the binary body is still used */
+static int check_transient(void) {
+    int requests, binary, failed;
+    pepd_t * pepd= pepd_start(PEPD_BINARY);
+    PEP * pep= pep_initialize();
+    if (pepd == NULL || pep == NULL) {
+        printf("transient error: can't start\n");
+        return 1;
+    }
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    pepd_fail(pepd,503,1);
+    failed= authorize(pep,10);
+    pep_destroy(pep);
+    requests= pepd_requests(pepd,&binary);
+    pepd_stop(pepd);
+    printf("transient error: 10 authorizations, %d failed, %d requests (%d binary)\n",failed,requests,binary);
+    if (failed != 1 || requests != 10 || binary != 10) {
+        printf("transient error: expected 1 failed, 10 requests (10 binary)\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed= 0;
+    pep_global_init();
+    /* binary body accepted, never base64 */
+    failed+= check("binary server",PEPD_BINARY,1,10,10,10);
+    /* binary body rejected once, then base64 only */
+    failed+= check("base64 server",PEPD_BASE64,1,10,11,1);
+    /* 503 is not a binary body rejection */
+    failed+= check_transient();
+    /* option disabled */
+    failed+= check("default",PEPD_BINARY,0,10,10,0);
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Transport buffers reuse test: once the buffers have reached their high-water
+ * mark, a marshal/encode/send/receive/decode cycle must not allocate any memory.
+ * The allocations are counted by interposing the glibc allocator.
+ * The streaming base64 encoder is checked against pep_base64_encode_buffer_l().
+ * The big-endian puts, the push back, the reserve and the block fread are
+ * checked byte by byte.
+ * Repeated pep_authorize() calls against the local stand-in PEP daemon must not
+ * allocate any buffer memory after the first call: the allocations made from the
+ * buffer.c code of the library are told apart by their return address.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <dlfcn.h>
+#include <link.h>
+
+#include "argus/pep.h"
+#include "util/buffer.h"
+#include "util/base64.h"
+#include "../pepd/pepd.h"
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static int n_allocs= 0;
+static int n_buffer_allocs= 0;
+
+/* text range of the buffer.c code in the library, see buffer_text_init() */
+static uintptr_t buffer_text_start= 0;
+static uintptr_t buffer_text_end= 0;
+
+#define BUFFER_ALLOC(caller) \
+    if ((uintptr_t)(caller) >= buffer_text_start && (uintptr_t)(caller) < buffer_text_end) n_buffer_allocs++
+
+void * malloc(size_t size) {
+    n_allocs++;
+    BUFFER_ALLOC(__builtin_return_address(0));
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t nmemb, size_t size) {
+    n_allocs++;
+    BUFFER_ALLOC(__builtin_return_address(0));
+    return __libc_calloc(nmemb,size);
+}
+
+void * realloc(void * ptr, size_t size) {
+    n_allocs++;
+    BUFFER_ALLOC(__builtin_return_address(0));
+    return __libc_realloc(ptr,size);
+}
+
+/*
+ * The buffer.c functions are contiguous in the library text, the static ones
+ * (pep_buffer_ensure_capacity) lie between the first and the last exported one.
+ */
+static int buffer_text_init(void) {
+    const char * names[]= { "pep_buffer_create", "pep_buffer_delete", "pep_buffer_fwrite", "pep_buffer_write", "pep_buffer_fread",
+                            "pep_buffer_read", "pep_buffer_grow", "pep_buffer_unshift", "pep_buffer_rewind", "pep_buffer_reset",
+                            "pep_buffer_length", "pep_buffer_peek", "pep_buffer_skip", "pep_buffer_capacity", "pep_buffer_shrink",
+                            "pep_buffer_reserve" };
+    size_t i;
+    for (i= 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        Dl_info info;
+        const ElfW(Sym) * sym= NULL;
+        void * function= dlsym(RTLD_DEFAULT,names[i]);
+        uintptr_t start;
+        if (function == NULL || dladdr1(function,&info,(void **)&sym,RTLD_DL_SYMENT) == 0 || sym == NULL) {
+            /* statically linked without exported symbols */
+            printf("no symbol %s, buffer allocations not counted\n",names[i]);
+            buffer_text_start= buffer_text_end= 0;
+            return 0;
+        }
+        start= (uintptr_t)function;
+        if (buffer_text_start == 0 || start < buffer_text_start) buffer_text_start= start;
+        if (start + sym->st_size > buffer_text_end) buffer_text_end= start + sym->st_size;
+    }
+    return 0;
+}
+
+/* one transport cycle, as done by pep_authorize with the handle buffers */
+static int transport_cycle(pep_buffer_t * request, pep_buffer_t * output, pep_base64_encoder_t * b64encoder, pep_buffer_t * b64input, pep_buffer_t * input) {
+    unsigned char chunk[256];
+    size_t n, b64output_l;
+    pep_buffer_reset(output);
+    pep_buffer_reset(b64input);
+    pep_buffer_reset(input);
+    pep_buffer_rewind(request);
+    /* marshal */
+    while ((n= pep_buffer_read(chunk,1,sizeof(chunk),request)) > 0) {
+        pep_buffer_write(chunk,1,n,output);
+    }
+    /* curl read callback encodes on demand, write callback receives */
+    b64output_l= pep_base64_encoded_length(pep_buffer_length(output),BASE64_DEFAULT_LINE_SIZE);
+    pep_base64_encoder_reset(b64encoder,output);
+    while ((n= pep_base64_encoder_read(chunk,1,sizeof(chunk),b64encoder)) > 0) {
+        pep_buffer_write(chunk,1,n,b64input);
+    }
+    if (pep_buffer_length(b64input) != b64output_l) {
+        printf("encoded length %d != expected length %d\n",(int)pep_buffer_length(b64input),(int)b64output_l);
+        return 1;
+    }
+    /* decode */
+    pep_base64_decode_buffer(b64input,input);
+    pep_buffer_rewind(request);
+    if (pep_buffer_length(input) != pep_buffer_length(request)) {
+        printf("decoded length %d != request length %d\n",(int)pep_buffer_length(input),(int)pep_buffer_length(request));
+        return 1;
+    }
+    return 0;
+}
+
+/* the streaming encoder must produce the same block as pep_base64_encode_buffer_l */
+static int streaming_encoder_check(void) {
+    pep_buffer_t * in, * out, * stream;
+    pep_base64_encoder_t * encoder;
+    unsigned char chunk[7];
+    size_t n, chunk_l;
+    int i, in_l, rc= 0;
+    in= pep_buffer_create(256);
+    out= pep_buffer_create(512);
+    stream= pep_buffer_create(512);
+    encoder= pep_base64_encoder_create(BASE64_DEFAULT_LINE_SIZE);
+    for (in_l= 0; in_l < 200 && rc == 0; in_l++) {
+        pep_buffer_reset(in);
+        pep_buffer_reset(out);
+        pep_buffer_reset(stream);
+        for (i= 0; i < in_l; i++) {
+            pep_buffer_putc(i * 7,in);
+        }
+        pep_base64_encode_buffer_l(in,out,BASE64_DEFAULT_LINE_SIZE);
+        pep_buffer_rewind(in);
+        pep_base64_encoder_reset(encoder,in);
+        /* odd read sizes split the encoded blocks and the line breaks */
+        chunk_l= 1 + (in_l % sizeof(chunk));
+        while ((n= pep_base64_encoder_read(chunk,1,chunk_l,encoder)) > 0) {
+            pep_buffer_write(chunk,1,n,stream);
+        }
+        if (pep_buffer_length(out) != pep_buffer_length(stream)
+            || pep_buffer_length(out) != pep_base64_encoded_length(in_l,BASE64_DEFAULT_LINE_SIZE)) {
+            printf("%d bytes: encoded length %d, streamed length %d\n",in_l,(int)pep_buffer_length(out),(int)pep_buffer_length(stream));
+            rc= 1;
+        }
+        while (rc == 0 && !pep_buffer_eof(out)) {
+            if (pep_buffer_getc(out) != pep_buffer_getc(stream)) {
+                printf("%d bytes: streamed block differs\n",in_l);
+                rc= 1;
+            }
+        }
+    }
+    pep_base64_encoder_delete(encoder);
+    pep_buffer_delete(in);
+    pep_buffer_delete(out);
+    pep_buffer_delete(stream);
+    return rc;
+}
+
+static int span_check(void) {
+    const unsigned char expected[]= { 'I', 0x12, 0x34, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xFF, 0xFE };
+    pep_buffer_t * buffer= pep_buffer_create(0);
+    FILE * file= tmpfile();
+    int i, rc= 0, allocs;
+    pep_buffer_putc('I',buffer);
+    pep_buffer_put_u16(0x1234,buffer);
+    pep_buffer_put_u32(0x89ABCDEF,buffer);
+    pep_buffer_put_u64(0x0123456789ABCDEFULL,buffer);
+    pep_buffer_put_u16(0xFFFE,buffer);
+    if (pep_buffer_length(buffer) != sizeof(expected) || memcmp(pep_buffer_peek(buffer),expected,sizeof(expected)) != 0) {
+        printf("big-endian puts differ\n");
+        rc= 1;
+    }
+    /* push back before the first byte, then after a read */
+    pep_buffer_ungetc('x',buffer);
+    if (pep_buffer_getc(buffer) != 'x' || pep_buffer_getc(buffer) != 'I' || pep_buffer_ungetc('y',buffer) != BUFFER_OK || pep_buffer_getc(buffer) != 'y') {
+        printf("push back differs\n");
+        rc= 1;
+    }
+    /* reserved bytes are written without allocation */
+    pep_buffer_reserve(buffer,1000);
+    allocs= n_allocs;
+    for (i= 0; i < 1000; i++) pep_buffer_putc(i,buffer);
+    if (n_allocs != allocs) {
+        printf("%d allocations after reserve\n",n_allocs - allocs);
+        rc= 1;
+    }
+    /* block fread */
+    pep_buffer_reset(buffer);
+    for (i= 0; i < 10000; i++) fputc(i % 253,file);
+    rewind(file);
+    if (pep_buffer_fread(buffer,file) != 10000 || pep_buffer_length(buffer) != 10000) {
+        printf("fread length %d != 10000\n",(int)pep_buffer_length(buffer));
+        rc= 1;
+    }
+    for (i= 0; i < 10000 && rc == 0; i++) {
+        if (pep_buffer_getc(buffer) != i % 253) {
+            printf("fread byte %d differs\n",i);
+            rc= 1;
+        }
+    }
+    fclose(file);
+    pep_buffer_delete(buffer);
+    return rc;
+}
+
+static xacml_request_t * create_request(void) {
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    xacml_attribute_addvalue(attr,"CN=John Doe,O=Example");
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    return request;
+}
+
+/* the transport buffers of the handle are reused by the next pep_authorize() calls */
+static int authorize_check(int mode, int binary) {
+    pepd_t * pepd= pepd_start(mode);
+    PEP * pep= pep_initialize();
+    xacml_request_t * request= create_request();
+    xacml_response_t * response= NULL;
+    int i, first_allocs, allocs, rc= 0;
+    if (pepd == NULL || pep == NULL) {
+        printf("can not start the PEP daemon or the PEP client\n");
+        return 1;
+    }
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,binary);
+    n_buffer_allocs= 0;
+    if (pep_authorize(pep,&request,&response) != PEP_OK) {
+        printf("first pep_authorize failed\n");
+        rc= 1;
+    }
+    first_allocs= n_buffer_allocs;
+    xacml_response_delete(response);
+    n_buffer_allocs= 0;
+    for (i= 0; i < 100 && rc == 0; i++) {
+        response= NULL;
+        if (pep_authorize(pep,&request,&response) != PEP_OK) {
+            printf("pep_authorize %d failed\n",i);
+            rc= 1;
+        }
+        xacml_response_delete(response);
+    }
+    allocs= n_buffer_allocs;
+    printf("%s body: %d buffer allocations in the first call, %d in the next 100 calls\n",binary ? "binary" : "base64",first_allocs,allocs);
+    /* the first call creates the transport buffers, unless the allocations are not counted */
+    if (n_allocs > 0 && buffer_text_end != 0 && first_allocs == 0) {
+        printf("buffer allocations not attributed\n");
+        rc= 1;
+    }
+    if (allocs != 0) {
+        printf("pep_authorize must not allocate buffer memory after the first call\n");
+        rc= 1;
+    }
+    xacml_request_delete(request);
+    pep_destroy(pep);
+    pepd_stop(pepd);
+    return rc;
+}
+
+int main(void) {
+    pep_buffer_t * request, * output, * b64input, * input;
+    pep_base64_encoder_t * b64encoder;
+    int i, allocs;
+
+    printf("streaming base64 encoder...\n");
+    if (streaming_encoder_check() != 0) {
+        return 4;
+    }
+
+    printf("span primitives...\n");
+    if (span_check() != 0) {
+        return 5;
+    }
+
+    printf("repeated pep_authorize...\n");
+    if (buffer_text_init() != 0 || authorize_check(PEPD_BASE64,0) != 0 || authorize_check(PEPD_BINARY,1) != 0) {
+        return 6;
+    }
+
+    /* a 8KB request, as big as one with a cert-chain attribute */
+    request= pep_buffer_create(8192);
+    for (i= 0; i < 8192; i++) {
+        pep_buffer_putc(i % 251,request);
+    }
+
+    output= pep_buffer_create(512);
+    b64encoder= pep_base64_encoder_create(BASE64_DEFAULT_LINE_SIZE);
+    b64input= pep_buffer_create(1024);
+    input= pep_buffer_create(1024);
+
+    printf("warming up transport buffers...\n");
+    if (transport_cycle(request,output,b64encoder,b64input,input) != 0) {
+        return 1;
+    }
+
+    printf("steady-state transport cycles...\n");
+    n_allocs= 0;
+    for (i= 0; i < 1000; i++) {
+        if (transport_cycle(request,output,b64encoder,b64input,input) != 0) {
+            return 1;
+        }
+    }
+    allocs= n_allocs;
+    printf("%d allocations in 1000 cycles\n",allocs);
+    if (allocs != 0) {
+        printf("steady-state transport cycles must not allocate memory\n");
+        return 2;
+    }
+
+    printf("shrink policy...\n");
+    pep_buffer_reset(b64input);
+    pep_buffer_shrink(b64input,1024);
+    if (pep_buffer_capacity(b64input) != 1024) {
+        printf("b64input capacity %d != 1024\n",(int)pep_buffer_capacity(b64input));
+        return 3;
+    }
+    /* written data is never released */
+    pep_buffer_shrink(request,16);
+    if (pep_buffer_capacity(request) != 8192 || pep_buffer_length(request) != 8192) {
+        printf("request capacity %d, length %d != 8192\n",(int)pep_buffer_capacity(request),(int)pep_buffer_length(request));
+        return 3;
+    }
+
+    pep_buffer_delete(request);
+    pep_buffer_delete(output);
+    pep_base64_encoder_delete(b64encoder);
+    pep_buffer_delete(b64input);
+    pep_buffer_delete(input);
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pep_freeze() test against the local stand-in PEP daemon:
+ * - threads authorize simultaneously with one frozen PEP handle, each call
+ *   with a pooled transport (connection),
+ * - the configuration of a frozen handle can't be changed,
+ * - the log options only apply to their own PEP handle during its calls, and
+ *   to the process-wide logging as before.
+ */
+#include <stdio.h>
+#include <pthread.h>
+
+#include "argus/pep.h"
+#include "util/log.h"
+#include "../pepd/pepd.h"
+
+#define N_THREADS 8
+#define N_THREAD_AUTHORIZATIONS 50
+
+/* authorizes one request, returns 0 on success */
+static int authorize(PEP * pep) {
+    pep_error_t rc;
+    int failed= 0;
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    xacml_response_t * response= NULL;
+    xacml_attribute_addvalue(attr,"CN=John Doe");
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    rc= pep_authorize(pep,&request,&response);
+    if (rc != PEP_OK) {
+        printf("pep_authorize failed: %s\n",pep_strerror(rc));
+        failed= 1;
+    }
+    else {
+        if (xacml_result_getdecision(xacml_response_getresult(response,0)) != XACML_DECISION_PERMIT) {
+            printf("unexpected response\n");
+            failed= 1;
+        }
+        xacml_response_delete(response);
+    }
+    xacml_request_delete(request);
+    return failed;
+}
+
+struct worker {
+    pthread_t thread;
+    PEP * pep;
+    int failed;
+};
+
+static void * worker_run(void * arg) {
+    struct worker * w= arg;
+    int i;
+    for (i= 0; i < N_THREAD_AUTHORIZATIONS; i++) w->failed+= authorize(w->pep);
+    return NULL;
+}
+
+/* counts the log messages of the handle */
+static int n_logs= 0;
+
+static int count_log(int level, const char * format, va_list args) {
+    __sync_fetch_and_add(&n_logs,1);
+    return 0;
+}
+
+static int pip_init(void) { return 0; }
+static int pip_process(xacml_request_t ** request) { return 0; }
+static int pip_destroy(void) { return 0; }
+
+int main(void) {
+    struct worker workers[N_THREADS];
+    pep_pip_t pip= { "test-pip", pip_init, pip_process, pip_destroy };
+    pepd_t * pepd;
+    PEP * pep, * quiet;
+    int i, failed= 0, requests, connections, logs;
+
+    pep_global_init();
+    pepd= pepd_start(PEPD_BINARY);
+    pep= pep_initialize();
+    quiet= pep_initialize();
+    if (pepd == NULL || pep == NULL || quiet == NULL) {
+        printf("can't start\nFAILED\n");
+        return 1;
+    }
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    pep_setoption(pep,PEP_OPTION_LOG_LEVEL,PEP_LOGLEVEL_INFO);
+    pep_setoption(pep,PEP_OPTION_LOG_HANDLER,count_log);
+    pep_addpip(pep,&pip);
+    pep_setoption(quiet,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    if (pep_log_getlevel() != LOG_LEVEL_INFO) {
+        printf("log level of the handle not set process-wide\n");
+        failed++;
+    }
+
+    if (pep_freeze(pep) != PEP_OK
+        || pep_setoption(pep,PEP_OPTION_ENDPOINT_TIMEOUT,10) != PEP_ERR_HANDLE_FROZEN
+        || pep_addpip(pep,&pip) != PEP_ERR_HANDLE_FROZEN) {
+        printf("frozen handle configuration changed\n");
+        failed++;
+    }
+
+    for (i= 0; i < N_THREADS; i++) {
+        workers[i].pep= pep;
+        workers[i].failed= 0;
+        pthread_create(&workers[i].thread,NULL,worker_run,&workers[i]);
+    }
+    for (i= 0; i < N_THREADS; i++) {
+        pthread_join(workers[i].thread,NULL);
+        failed+= workers[i].failed;
+    }
+    requests= pepd_requests(pepd,NULL);
+    connections= pepd_connections(pepd);
+    printf("%d threads, one frozen handle: %d requests, %d connections\n",N_THREADS,requests,connections);
+    if (requests != N_THREADS * N_THREAD_AUTHORIZATIONS || connections > N_THREADS) {
+        printf("expected %d requests with at most %d connections\n",N_THREADS * N_THREAD_AUTHORIZATIONS,N_THREADS);
+        failed++;
+    }
+
+    /* the other handle doesn't log with the log options of the first one */
+    logs= n_logs;
+    failed+= authorize(quiet);
+    if (logs == 0 || n_logs != logs) {
+        printf("log handler: %d messages, then %d with the other handle\n",logs,n_logs);
+        failed++;
+    }
+
+    /* the xacml-functions called directly log with the last log options */
+    xacml_request_addsubject(NULL,NULL);
+    if (n_logs != logs + 1) {
+        printf("log handler: xacml-function called directly not logged\n");
+        failed++;
+    }
+
+    pep_destroy(pep);
+    pep_destroy(quiet);
+    pepd_stop(pepd);
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
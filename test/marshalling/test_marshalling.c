@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Differential test of the two request marshalling engines: the direct
+ * xacml_request_marshalling() must write exactly the same bytes as the
+ * Hessian tree xacml_request_marshalling_tree(), for random requests with
+ * optional fields, empty lists, UTF-8 and chunked (> 32767 chars) strings.
+ * The allocations done by each engine are counted by interposing the glibc
+ * allocator. The precomputed serialized size must be exact, and the direct
+ * engine must grow an empty output buffer at most once. The same requests
+ * built in an arena must marshal to the same bytes, with few allocations.
+ * The attribute strings set with their lengths keep their embedded NULs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/buffer.h"
+#include "argus/xacml.h"
+#include "argus/io.h"
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static int n_allocs= 0;
+
+void * malloc(size_t size) {
+    n_allocs++;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t nmemb, size_t size) {
+    n_allocs++;
+    return __libc_calloc(nmemb,size);
+}
+
+void * realloc(void * ptr, size_t size) {
+    n_allocs++;
+    return __libc_realloc(ptr,size);
+}
+
+static const char * words[]= {
+    "", "a", "urn:oasis:names:tc:xacml:1.0:subject:subject-id",
+    "CN=John Doe,O=Example", "http://www.w3.org/2001/XMLSchema#string",
+    "caf\303\251 \320\237\321\200\320\270\320\262\320\265\321\202", "\342\202\254 \360\237\230\200 euro",
+};
+
+/* returns a random string, sometimes a long (chunked) one */
+static const char * random_string(void) {
+    static char big[100000];
+    if (rand() % 40 == 0) {
+        size_t l= 0, n= 30000 + rand() % 40000;
+        while (l < n) {
+            /* mix of 1, 2 and 3 bytes UTF-8 chars */
+            const char * w= words[5 + rand() % 2];
+            size_t w_l= strlen(w);
+            if (l + w_l >= sizeof(big)) break;
+            memcpy(&big[l],w,w_l);
+            l+= w_l;
+        }
+        big[l]= '\0';
+        return big;
+    }
+    return words[rand() % (sizeof(words) / sizeof(char *))];
+}
+
+/* the request objects are allocated from the arena, or from the heap if NULL */
+static xacml_attribute_t * random_attribute(xacml_arena_t * arena) {
+    int i, n= rand() % 4;
+    xacml_attribute_t * attr= xacml_attribute_create_in(random_string(),arena);
+    if (rand() % 2) xacml_attribute_setdatatype(attr,random_string());
+    if (rand() % 3 == 0) xacml_attribute_setissuer(attr,random_string());
+    for (i= 0; i < n; i++) xacml_attribute_addvalue(attr,random_string());
+    return attr;
+}
+
+static xacml_request_t * random_request(xacml_arena_t * arena) {
+    int i, j, n;
+    xacml_request_t * request= xacml_request_create_in(arena);
+    n= rand() % 3;
+    for (i= 0; i < n; i++) {
+        xacml_subject_t * subject= xacml_subject_create_in(arena);
+        int m= rand() % 4;
+        if (rand() % 2) xacml_subject_setcategory(subject,random_string());
+        for (j= 0; j < m; j++) xacml_subject_addattribute(subject,random_attribute(arena));
+        xacml_request_addsubject(request,subject);
+    }
+    n= rand() % 3;
+    for (i= 0; i < n; i++) {
+        xacml_resource_t * resource= xacml_resource_create_in(arena);
+        int m= rand() % 3;
+        if (rand() % 3 == 0) xacml_resource_setcontent(resource,random_string());
+        for (j= 0; j < m; j++) xacml_resource_addattribute(resource,random_attribute(arena));
+        xacml_request_addresource(request,resource);
+    }
+    if (rand() % 4) {
+        xacml_action_t * action= xacml_action_create_in(arena);
+        n= rand() % 3;
+        for (i= 0; i < n; i++) xacml_action_addattribute(action,random_attribute(arena));
+        xacml_request_setaction(request,action);
+    }
+    if (rand() % 2) {
+        xacml_environment_t * env= xacml_environment_create_in(arena);
+        n= rand() % 3;
+        for (i= 0; i < n; i++) xacml_environment_addattribute(env,random_attribute(arena));
+        xacml_request_setenvironment(request,env);
+    }
+    return request;
+}
+
+/* returns true if the buffer contains the bytes */
+static int contains(pep_buffer_t * buffer, const char * bytes, size_t bytes_l) {
+    const unsigned char * p= pep_buffer_peek(buffer);
+    size_t i, l= pep_buffer_length(buffer);
+    for (i= 0; i + bytes_l <= l; i++) {
+        if (memcmp(&p[i],bytes,bytes_l) == 0) return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int i, tree_allocs= 0, direct_allocs= 0, heap_allocs= 0, arena_allocs= 0;
+    pep_buffer_t * tree= pep_buffer_create(1024);
+    pep_buffer_t * direct= pep_buffer_create(1024);
+    pep_buffer_t * empty;
+    xacml_arena_t * arena= xacml_arena_create(0);
+    xacml_request_t * request;
+    xacml_subject_t * subject;
+    xacml_attribute_t * attribute;
+    size_t length;
+    for (i= 0; i < 2000; i++) {
+        int allocs= n_allocs;
+        srand(6 + i);
+        request= random_request(NULL);
+        heap_allocs+= n_allocs - allocs;
+        pep_buffer_reset(tree);
+        pep_buffer_reset(direct);
+        allocs= n_allocs;
+        if (xacml_request_marshalling_tree(request,tree) != PEP_OK) {
+            printf("request %d: tree marshalling failed\n",i);
+            return 1;
+        }
+        tree_allocs+= n_allocs - allocs;
+        allocs= n_allocs;
+        if (xacml_request_marshalling(request,direct) != PEP_OK) {
+            printf("request %d: direct marshalling failed\n",i);
+            return 1;
+        }
+        direct_allocs+= n_allocs - allocs;
+        if (xacml_request_serialized_size(request) != pep_buffer_length(direct)) {
+            printf("request %d: serialized size %d != %d bytes\n",i,(int)xacml_request_serialized_size(request),(int)pep_buffer_length(direct));
+            printf("FAILED\n");
+            return 1;
+        }
+        empty= pep_buffer_create(0);
+        allocs= n_allocs;
+        xacml_request_marshalling(request,empty);
+        if (n_allocs - allocs > 1) {
+            printf("request %d: %d allocations to marshal in an empty buffer\n",i,n_allocs - allocs);
+            printf("FAILED\n");
+            return 1;
+        }
+        pep_buffer_delete(empty);
+        if (pep_buffer_length(tree) != pep_buffer_length(direct)
+            || memcmp(pep_buffer_peek(tree),pep_buffer_peek(direct),pep_buffer_length(tree)) != 0) {
+            printf("request %d: %d bytes (tree) != %d bytes (direct)\n",i,(int)pep_buffer_length(tree),(int)pep_buffer_length(direct));
+            printf("FAILED\n");
+            return 1;
+        }
+        xacml_request_delete(request);
+        /* same request in the arena */
+        xacml_arena_reset(arena);
+        allocs= n_allocs;
+        srand(6 + i);
+        request= random_request(arena);
+        arena_allocs+= n_allocs - allocs;
+        pep_buffer_reset(tree);
+        if (xacml_request_marshalling(request,tree) != PEP_OK
+            || pep_buffer_length(tree) != pep_buffer_length(direct)
+            || memcmp(pep_buffer_peek(tree),pep_buffer_peek(direct),pep_buffer_length(tree)) != 0) {
+            printf("request %d: arena request differs\n",i);
+            printf("FAILED\n");
+            return 1;
+        }
+        /* no-op for an object in the arena */
+        xacml_request_delete(request);
+    }
+    printf("2000 requests: %d allocations (tree), %d allocations (direct)\n",tree_allocs,direct_allocs);
+    printf("2000 requests built: %d allocations (heap), %d allocations (arena)\n",heap_allocs,arena_allocs);
+    if (arena_allocs * 10 > heap_allocs) {
+        printf("arena requests allocate too much\nFAILED\n");
+        return 1;
+    }
+    xacml_arena_delete(arena);
+
+    /* lengths given by the caller: a prefix id and a value with a NUL byte */
+    request= xacml_request_create();
+    subject= xacml_subject_create();
+    attribute= xacml_attribute_create(NULL);
+    xacml_attribute_setid_n(attribute,"subject-id-and-more",10);
+    xacml_attribute_addvalue_n(attribute,"a\0b",3);
+    xacml_subject_addattribute(subject,attribute);
+    xacml_request_addsubject(request,subject);
+    pep_buffer_reset(tree);
+    pep_buffer_reset(direct);
+    if (strcmp(xacml_attribute_getid_n(attribute,&length),"subject-id") != 0 || length != 10
+        || xacml_attribute_getvalue_n(attribute,0,&length) == NULL || length != 3
+        || xacml_request_marshalling_tree(request,tree) != PEP_OK
+        || xacml_request_marshalling(request,direct) != PEP_OK
+        || pep_buffer_length(tree) != pep_buffer_length(direct)
+        || memcmp(pep_buffer_peek(tree),pep_buffer_peek(direct),pep_buffer_length(tree)) != 0
+        || !contains(direct,"S\0\3a\0b",6)) {
+        printf("attribute with lengths: differs\nFAILED\n");
+        return 1;
+    }
+    xacml_request_delete(request);
+
+    /* both engines reject a NULL attribute id */
+    request= xacml_request_create();
+    subject= xacml_subject_create();
+    xacml_subject_addattribute(subject,xacml_attribute_create(NULL));
+    xacml_request_addsubject(request,subject);
+    if (xacml_request_marshalling_tree(request,tree) != PEP_ERR_MARSHALLING_HESSIAN
+        || xacml_request_marshalling(request,direct) != PEP_ERR_MARSHALLING_HESSIAN
+        || xacml_request_serialized_size(request) != 0) {
+        printf("NULL attribute id: not rejected by both engines\nFAILED\n");
+        return 1;
+    }
+    xacml_request_delete(request);
+    pep_buffer_delete(tree);
+    pep_buffer_delete(direct);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Local stand-in PEP daemon, see pepd.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+
+#include "util/buffer.h"
+#include "util/base64.h"
+#include "pepd.h"
+
+#define BINARY_CONTENT_TYPE "application/x-hessian"
+
+struct pepd {
+    int mode;
+    int fd;
+    char url[64];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int requests;
+    int binary_requests;
+    int connections;
+    int fail_status;
+    int fail_count;
+    SSL_CTX * ssl_ctx; /* PEPD_TLS */
+    int handshakes;
+    int resumed_handshakes;
+};
+
+struct connection {
+    pepd_t * pepd;
+    int fd;
+    SSL * ssl;
+};
+
+/* Hessian string (or type tag) */
+static void h_string(pep_buffer_t * b, char tag, const char * str) {
+    size_t l= strlen(str);
+    pep_buffer_putc(tag,b);
+    pep_buffer_putc((l >> 8) & 0xFF,b);
+    pep_buffer_putc(l & 0xFF,b);
+    pep_buffer_write(str,1,l,b);
+}
+
+/* Hessian typed map header */
+static void h_map(pep_buffer_t * b, const char * type) {
+    pep_buffer_putc('M',b);
+    h_string(b,'t',type);
+}
+
+/* Response with the echoed request and one Permit Result */
+static void response(pep_buffer_t * b, const unsigned char * request, size_t request_l) {
+    h_map(b,"org.glite.authz.common.model.Response");
+    h_string(b,'S',"request");
+    pep_buffer_write(request,1,request_l,b);
+    h_string(b,'S',"results");
+    pep_buffer_write("Vl\0\0\0\1",1,6,b);
+    h_map(b,"org.glite.authz.common.model.Result");
+    h_string(b,'S',"decision");
+    pep_buffer_write("I\0\0\0\1",1,5,b);
+    h_string(b,'S',"resourceId");
+    h_string(b,'S',"res-1");
+    h_string(b,'S',"status");
+    h_map(b,"org.glite.authz.common.model.Status");
+    h_string(b,'S',"message");
+    h_string(b,'S',"OK");
+    h_string(b,'S',"statusCode");
+    h_map(b,"org.glite.authz.common.model.StatusCode");
+    h_string(b,'S',"code");
+    h_string(b,'S',"urn:oasis:names:tc:xacml:1.0:status:ok");
+    h_string(b,'S',"subCode");
+    pep_buffer_putc('N',b);
+    pep_buffer_putc('z',b); /* StatusCode */
+    pep_buffer_putc('z',b); /* Status */
+    h_string(b,'S',"obligations");
+    pep_buffer_write("Vz",1,2,b);
+    pep_buffer_putc('z',b); /* Result */
+    pep_buffer_putc('z',b); /* results */
+    pep_buffer_putc('z',b); /* Response */
+}
+
+/* value of the header name, or NULL */
+static const char * header(const char * headers, const char * name, char * value, size_t value_l) {
+    const char * p= headers;
+    size_t name_l= strlen(name);
+    while ((p= strstr(p,"\r\n")) != NULL) {
+        p+= 2;
+        if (strncasecmp(p,name,name_l) == 0 && p[name_l] == ':') {
+            size_t l;
+            p+= name_l + 1;
+            while (*p == ' ') p++;
+            l= strcspn(p,"\r\n");
+            if (l >= value_l) l= value_l - 1;
+            memcpy(value,p,l);
+            value[l]= '\0';
+            return value;
+        }
+    }
+    return NULL;
+}
+
+static ssize_t conn_recv(struct connection * c, void * data, size_t l) {
+    if (c->ssl != NULL) return SSL_read(c->ssl,data,(int)l);
+    return recv(c->fd,data,l,0);
+}
+
+static int send_all(struct connection * c, const void * data, size_t l) {
+    const char * p= data;
+    while (l > 0) {
+        ssize_t n= (c->ssl != NULL) ? SSL_write(c->ssl,p,(int)l) : send(c->fd,p,l,MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+        p+= n;
+        l-= n;
+    }
+    return 0;
+}
+
+static int reply(struct connection * c, int status, const char * content_type, pep_buffer_t * body) {
+    char head[256];
+    size_t body_l= body ? pep_buffer_length(body) : 0;
+    snprintf(head,sizeof(head),"HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n\r\n",
+             status, status == 200 ? "OK" : "Error", content_type, (int)body_l);
+    if (send_all(c,head,strlen(head)) != 0) return -1;
+    if (body_l > 0) return send_all(c,pep_buffer_peek(body),body_l);
+    return 0;
+}
+
+/* handles the requests of one keep-alive connection */
+static void * connection_run(void * arg) {
+    struct connection * c= arg;
+    pepd_t * pepd= c->pepd;
+    size_t cap= 64 * 1024, l= 0;
+    char * data= malloc(cap + 1);
+    pep_buffer_t * body= pep_buffer_create(1024);
+    pep_buffer_t * request= pep_buffer_create(1024);
+    pep_buffer_t * out= pep_buffer_create(1024);
+    pep_buffer_t * encoded= pep_buffer_create(1024);
+    if (pepd->ssl_ctx != NULL) {
+        c->ssl= SSL_new(pepd->ssl_ctx);
+        SSL_set_fd(c->ssl,c->fd);
+        if (SSL_accept(c->ssl) != 1) goto close;
+        pthread_mutex_lock(&pepd->lock);
+        pepd->handshakes++;
+        if (SSL_session_reused(c->ssl)) pepd->resumed_handshakes++;
+        pthread_mutex_unlock(&pepd->lock);
+    }
+    for (;;) {
+        char * end;
+        char value[128];
+        size_t head_l, body_l;
+        ssize_t n;
+        int binary, fail;
+        data[l]= '\0';
+        while ((end= strstr(data,"\r\n\r\n")) == NULL) {
+            if (l == cap) goto close;
+            n= conn_recv(c,&data[l],cap - l);
+            if (n <= 0) goto close;
+            l+= n;
+            data[l]= '\0';
+        }
+        head_l= end - data + 4;
+        body_l= header(data,"Content-Length",value,sizeof(value)) ? (size_t)atoi(value) : 0;
+        binary= header(data,"Content-Type",value,sizeof(value)) && strncasecmp(value,BINARY_CONTENT_TYPE,strlen(BINARY_CONTENT_TYPE)) == 0;
+        while (l < head_l + body_l) {
+            if (l == cap) goto close;
+            n= conn_recv(c,&data[l],cap - l);
+            if (n <= 0) goto close;
+            l+= n;
+        }
+        pthread_mutex_lock(&pepd->lock);
+        pepd->requests++;
+        if (binary) pepd->binary_requests++;
+        fail= 0;
+        if (pepd->fail_count > 0) {
+            pepd->fail_count--;
+            fail= pepd->fail_status;
+        }
+        pthread_mutex_unlock(&pepd->lock);
+
+        pep_buffer_reset(body);
+        pep_buffer_reset(request);
+        pep_buffer_reset(out);
+        pep_buffer_reset(encoded);
+        pep_buffer_write(&data[head_l],1,body_l,body);
+        if (binary && (pepd->mode & PEPD_BINARY)) {
+            pep_buffer_write(&data[head_l],1,body_l,request);
+        }
+        else {
+            pep_base64_decode_buffer(body,request);
+        }
+        if (fail != 0) {
+            /* transient server error */
+            if (reply(c,fail,"text/plain",NULL) != 0) goto close;
+        }
+        else if (binary && !(pepd->mode & PEPD_BINARY)) {
+            /* unknown body type */
+            if (reply(c,415,"text/plain",NULL) != 0) goto close;
+        }
+        else if (pep_buffer_length(request) < 2 || memcmp(pep_buffer_peek(request),"Mt",2) != 0) {
+            /* not a Hessian Request */
+            if (reply(c,500,"text/plain",NULL) != 0) goto close;
+        }
+        else {
+            response(out,pep_buffer_peek(request),pep_buffer_length(request));
+            if (binary && (pepd->mode & PEPD_BINARY)) {
+                if (reply(c,200,BINARY_CONTENT_TYPE,out) != 0) goto close;
+            }
+            else {
+                pep_base64_encode_buffer_l(out,encoded,BASE64_DEFAULT_LINE_SIZE);
+                if (reply(c,200,"text/plain",encoded) != 0) goto close;
+            }
+        }
+        /* keep the pipelined bytes */
+        memmove(data,&data[head_l + body_l],l - head_l - body_l);
+        l-= head_l + body_l;
+    }
+close:
+    if (c->ssl != NULL) {
+        SSL_shutdown(c->ssl);
+        SSL_free(c->ssl);
+    }
+    close(c->fd);
+    free(data);
+    pep_buffer_delete(body);
+    pep_buffer_delete(request);
+    pep_buffer_delete(out);
+    pep_buffer_delete(encoded);
+    free(c);
+    return NULL;
+}
+
+static void * pepd_run(void * arg) {
+    pepd_t * pepd= arg;
+    int fd;
+    while ((fd= accept(pepd->fd,NULL,NULL)) >= 0) {
+        pthread_t thread;
+        struct connection * c= malloc(sizeof(struct connection));
+        pthread_mutex_lock(&pepd->lock);
+        pepd->connections++;
+        pthread_mutex_unlock(&pepd->lock);
+        c->pepd= pepd;
+        c->fd= fd;
+        c->ssl= NULL;
+        if (pthread_create(&thread,NULL,connection_run,c) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+/* TLS context with a self-signed EC certificate, generated in memory */
+static SSL_CTX * tls_context(void) {
+    SSL_CTX * ctx= SSL_CTX_new(TLS_server_method());
+    EVP_PKEY * key= EVP_EC_gen("P-256");
+    X509 * cert= X509_new();
+    X509_NAME * name;
+    if (ctx == NULL || key == NULL || cert == NULL) goto error;
+    ASN1_INTEGER_set(X509_get_serialNumber(cert),1);
+    X509_gmtime_adj(X509_getm_notBefore(cert),0);
+    X509_gmtime_adj(X509_getm_notAfter(cert),3600);
+    X509_set_pubkey(cert,key);
+    name= X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name,"CN",MBSTRING_ASC,(const unsigned char *)"127.0.0.1",-1,-1,0);
+    X509_set_issuer_name(cert,name);
+    if (X509_sign(cert,key,EVP_sha256()) == 0
+        || SSL_CTX_use_certificate(ctx,cert) != 1 || SSL_CTX_use_PrivateKey(ctx,key) != 1) goto error;
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ctx;
+error:
+    fprintf(stderr,"pepd_start: can't create the TLS context\n");
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    SSL_CTX_free(ctx);
+    return NULL;
+}
+
+pepd_t * pepd_start(int mode) {
+    struct sockaddr_in addr;
+    socklen_t addr_l= sizeof(addr);
+    pepd_t * pepd= calloc(1,sizeof(struct pepd));
+    pepd->mode= mode;
+    pthread_mutex_init(&pepd->lock,NULL);
+    pepd->fd= socket(AF_INET,SOCK_STREAM,0);
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family= AF_INET;
+    addr.sin_addr.s_addr= htonl(INADDR_LOOPBACK);
+    addr.sin_port= 0;
+    if (pepd->fd < 0 || bind(pepd->fd,(struct sockaddr *)&addr,sizeof(addr)) != 0
+        || listen(pepd->fd,64) != 0 || getsockname(pepd->fd,(struct sockaddr *)&addr,&addr_l) != 0) {
+        perror("pepd_start");
+        if (pepd->fd >= 0) close(pepd->fd);
+        free(pepd);
+        return NULL;
+    }
+    if (mode & PEPD_TLS) {
+        /* SSL_write() to a closed connection */
+        signal(SIGPIPE,SIG_IGN);
+        pepd->ssl_ctx= tls_context();
+        if (pepd->ssl_ctx == NULL) {
+            close(pepd->fd);
+            free(pepd);
+            return NULL;
+        }
+    }
+    snprintf(pepd->url,sizeof(pepd->url),"%s://127.0.0.1:%d/authz",(mode & PEPD_TLS) ? "https" : "http",ntohs(addr.sin_port));
+    if (pthread_create(&pepd->thread,NULL,pepd_run,pepd) != 0) {
+        SSL_CTX_free(pepd->ssl_ctx);
+        close(pepd->fd);
+        free(pepd);
+        return NULL;
+    }
+    return pepd;
+}
+
+const char * pepd_url(pepd_t * pepd) {
+    return pepd->url;
+}
+
+int pepd_requests(pepd_t * pepd, int * binary) {
+    int requests;
+    pthread_mutex_lock(&pepd->lock);
+    requests= pepd->requests;
+    if (binary != NULL) *binary= pepd->binary_requests;
+    pthread_mutex_unlock(&pepd->lock);
+    return requests;
+}
+
+void pepd_fail(pepd_t * pepd, int status, int count) {
+    pthread_mutex_lock(&pepd->lock);
+    pepd->fail_status= status;
+    pepd->fail_count= count;
+    pthread_mutex_unlock(&pepd->lock);
+}
+
+int pepd_handshakes(pepd_t * pepd, int * resumed) {
+    int handshakes;
+    pthread_mutex_lock(&pepd->lock);
+    handshakes= pepd->handshakes;
+    if (resumed != NULL) *resumed= pepd->resumed_handshakes;
+    pthread_mutex_unlock(&pepd->lock);
+    return handshakes;
+}
+
+int pepd_connections(pepd_t * pepd) {
+    int connections;
+    pthread_mutex_lock(&pepd->lock);
+    connections= pepd->connections;
+    pthread_mutex_unlock(&pepd->lock);
+    return connections;
+}
+
+void pepd_stop(pepd_t * pepd) {
+    shutdown(pepd->fd,SHUT_RDWR);
+    pthread_join(pepd->thread,NULL);
+    close(pepd->fd);
+    /* connections are closed by their clients */
+    SSL_CTX_free(pepd->ssl_ctx);
+    pthread_mutex_destroy(&pepd->lock);
+    free(pepd);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Local stand-in PEP daemon for the tests: a minimal HTTP/1.1 server on the
+ * loopback interface, optionally over TLS, running in its own threads. Every POSTed Request is
+ * answered with a Response echoing the request, with one Permit Result for
+ * the resource "res-1".
+ */
+#ifndef _PEPD_STANDIN_H_
+#define _PEPD_STANDIN_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* server accepts and answers the raw application/x-hessian body */
+#define PEPD_BINARY 1
+/* server only knows the base64 body, like PEPd <= 1.x (415 on binary body) */
+#define PEPD_BASE64 0
+/* server speaks HTTPS, with a self-signed certificate (or-ed with the mode) */
+#define PEPD_TLS 2
+
+typedef struct pepd pepd_t;
+
+/**
+ * Starts the stand-in PEP daemon on an ephemeral loopback port.
+ *
+ * @param int mode PEPD_BINARY or PEPD_BASE64, with PEPD_TLS
+ * @return pepd_t * the running server or NULL on error.
+ */
+pepd_t * pepd_start(int mode);
+
+/**
+ * Returns the endpoint URL of the server, e.g. "http://127.0.0.1:34567/authz"
+ * or "https://..." with PEPD_TLS.
+ */
+const char * pepd_url(pepd_t * pepd);
+
+/**
+ * Returns the number of requests received, and in binary the number of raw
+ * application/x-hessian bodies among them.
+ */
+int pepd_requests(pepd_t * pepd, int * binary);
+
+/**
+ * Answers the next count requests with the HTTP error status, e.g. 503.
+ */
+void pepd_fail(pepd_t * pepd, int status, int count);
+
+/**
+ * Returns the number of TLS handshakes, and in resumed the number of them
+ * resuming a previous TLS session.
+ */
+int pepd_handshakes(pepd_t * pepd, int * resumed);
+
+/**
+ * Returns the number of TCP connections accepted.
+ */
+int pepd_connections(pepd_t * pepd);
+
+/**
+ * Stops the server.
+ */
+void pepd_stop(pepd_t * pepd);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
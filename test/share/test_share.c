@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * PEP_OPTION_SHARE test against the local stand-in PEP daemon:
+ * - PEP handles of concurrent threads authorize through the same share, and
+ *   each keeps its own connection alive,
+ * - over TLS, the handles resume the session of the first one instead of
+ *   doing a full handshake, and don't without the share,
+ * - a share still used by a PEP handle is not released, a handle can stop
+ *   sharing.
+ */
+#include <stdio.h>
+#include <pthread.h>
+
+#include "argus/pep.h"
+#include "../pepd/pepd.h"
+
+#define N_THREADS 8
+#define N_THREAD_AUTHORIZATIONS 20
+
+/* authorizes one request, returns 0 on success */
+static int authorize(PEP * pep) {
+    pep_error_t rc;
+    int failed= 0;
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    xacml_response_t * response= NULL;
+    xacml_attribute_addvalue(attr,"CN=John Doe");
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    rc= pep_authorize(pep,&request,&response);
+    if (rc != PEP_OK) {
+        printf("pep_authorize failed: %s\n",pep_strerror(rc));
+        failed= 1;
+    }
+    else {
+        if (xacml_result_getdecision(xacml_response_getresult(response,0)) != XACML_DECISION_PERMIT) {
+            printf("unexpected response\n");
+            failed= 1;
+        }
+        xacml_response_delete(response);
+    }
+    xacml_request_delete(request);
+    return failed;
+}
+
+struct worker {
+    pthread_t thread;
+    const char * url;
+    pep_share_t * share;
+    int authorizations;
+    int failed;
+};
+
+static void * worker_run(void * arg) {
+    struct worker * w= arg;
+    int i;
+    PEP * pep= pep_initialize();
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,w->url);
+    /* self-signed stand-in certificate */
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_SSL_VALIDATION,0);
+    if (w->share != NULL && pep_setoption(pep,PEP_OPTION_SHARE,w->share) != PEP_OK) w->failed++;
+    for (i= 0; i < w->authorizations; i++) w->failed+= authorize(pep);
+    pep_destroy(pep);
+    return NULL;
+}
+
+/* N_THREADS threads with their own handle and the same share */
+static int concurrent(void) {
+    struct worker workers[N_THREADS];
+    pep_share_t * share= pep_share_create();
+    pepd_t * pepd= pepd_start(PEPD_BINARY);
+    int i, failed= 0, requests, connections;
+    if (share == NULL || pepd == NULL) return 1;
+    for (i= 0; i < N_THREADS; i++) {
+        workers[i].url= pepd_url(pepd);
+        workers[i].share= share;
+        workers[i].authorizations= N_THREAD_AUTHORIZATIONS;
+        workers[i].failed= 0;
+        pthread_create(&workers[i].thread,NULL,worker_run,&workers[i]);
+    }
+    for (i= 0; i < N_THREADS; i++) {
+        pthread_join(workers[i].thread,NULL);
+        failed+= workers[i].failed;
+    }
+    requests= pepd_requests(pepd,NULL);
+    connections= pepd_connections(pepd);
+    if (pep_share_delete(share) != PEP_OK) failed++;
+    pepd_stop(pepd);
+    printf("%d threads: %d requests, %d connections\n",N_THREADS,requests,connections);
+    if (failed > 0 || requests != N_THREADS * N_THREAD_AUTHORIZATIONS || connections != N_THREADS) {
+        printf("concurrent share: %d failures, expected %d connections\n",failed,N_THREADS);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * TLS: a first handle does the full handshake, then N_THREADS handles of
+ * concurrent threads resume its session if shared, or do a full handshake.
+ */
+static int resumption(int shared) {
+    struct worker workers[N_THREADS + 1];
+    pep_share_t * share= shared ? pep_share_create() : NULL;
+    pepd_t * pepd= pepd_start(PEPD_BINARY|PEPD_TLS);
+    int i, failed= 0, handshakes, resumed, expected;
+    if ((shared && share == NULL) || pepd == NULL) return 1;
+    for (i= 0; i <= N_THREADS; i++) {
+        workers[i].url= pepd_url(pepd);
+        workers[i].share= share;
+        workers[i].authorizations= 1;
+        workers[i].failed= 0;
+    }
+    worker_run(&workers[0]);
+    for (i= 1; i <= N_THREADS; i++) {
+        pthread_create(&workers[i].thread,NULL,worker_run,&workers[i]);
+    }
+    for (i= 0; i <= N_THREADS; i++) {
+        if (i > 0) pthread_join(workers[i].thread,NULL);
+        failed+= workers[i].failed;
+    }
+    handshakes= pepd_handshakes(pepd,&resumed);
+    if (share != NULL && pep_share_delete(share) != PEP_OK) failed++;
+    pepd_stop(pepd);
+    expected= shared ? N_THREADS : 0;
+    printf("TLS %s: %d handshakes, %d resumed\n",shared ? "shared" : "not shared",handshakes,resumed);
+    if (failed > 0 || handshakes != N_THREADS + 1 || resumed != expected) {
+        printf("TLS %s: %d failures, expected %d handshakes, %d resumed\n",shared ? "shared" : "not shared",failed,N_THREADS + 1,expected);
+        return 1;
+    }
+    return 0;
+}
+
+/* the share outlives its handles, a handle can stop sharing */
+static int lifecycle(void) {
+    pep_share_t * share= pep_share_create();
+    pepd_t * pepd= pepd_start(PEPD_BASE64);
+    PEP * pep= pep_initialize();
+    int failed= 0;
+    if (share == NULL || pepd == NULL || pep == NULL) return 1;
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,pepd_url(pepd));
+    if (pep_setoption(pep,PEP_OPTION_SHARE,share) != PEP_OK) failed++;
+    failed+= authorize(pep);
+    /* still used: not released */
+    if (pep_share_delete(share) != PEP_ERR_SHARE_IN_USE) failed++;
+    failed+= authorize(pep);
+    if (pep_setoption(pep,PEP_OPTION_SHARE,(pep_share_t *)NULL) != PEP_OK) failed++;
+    failed+= authorize(pep);
+    if (pep_share_delete(share) != PEP_OK) failed++;
+    pep_destroy(pep);
+    pepd_stop(pepd);
+    if (failed > 0) {
+        printf("share lifecycle: %d failures\n",failed);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed= 0;
+    pep_global_init();
+    failed+= concurrent();
+    failed+= resumption(1);
+    failed+= resumption(0);
+    failed+= lifecycle();
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
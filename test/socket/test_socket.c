@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pep_socket_action() test against the local stand-in PEP daemon: a poll()
+ * event loop watches the sockets and the timer given by the socket and timer
+ * callbacks of the PEP handle, and drives the asynchronous authorizations
+ * with pep_socket_action(). The completion callbacks are called inline, the
+ * socket data assigned with pep_socket_assign() is given back, and a failed
+ * submission is completed when the timer expires.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <time.h>
+
+#include "argus/pep.h"
+#include "../pepd/pepd.h"
+
+#define N_AUTHORIZATIONS 200
+#define MAX_SOCKETS 64
+
+/* poll() event loop */
+struct loop {
+    struct pollfd fds[MAX_SOCKETS];
+    int n_fds;
+    long deadline_ms; /* timer expiration, -1 if none */
+    int bad_socketdata;
+};
+
+static int in_action= 0;
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static int socket_callback(PEP * pep, int fd, int what, void * userdata, void * socketdata) {
+    struct loop * loop= userdata;
+    int i;
+    for (i= 0; i < loop->n_fds && loop->fds[i].fd != fd; i++);
+    if (socketdata != NULL && *(int *)socketdata != fd) loop->bad_socketdata++;
+    if (what == PEP_POLL_REMOVE) {
+        if (i < loop->n_fds) loop->fds[i]= loop->fds[--loop->n_fds];
+        free(socketdata);
+        return 0;
+    }
+    if (i == loop->n_fds) {
+        int * data= malloc(sizeof(int));
+        if (loop->n_fds == MAX_SOCKETS) return -1;
+        loop->n_fds++;
+        loop->fds[i].fd= fd;
+        *data= fd;
+        pep_socket_assign(pep,fd,data);
+    }
+    else if (socketdata == NULL) {
+        loop->bad_socketdata++;
+    }
+    loop->fds[i].events= ((what & PEP_POLL_IN) ? POLLIN : 0) | ((what & PEP_POLL_OUT) ? POLLOUT : 0);
+    return 0;
+}
+
+static int timer_callback(PEP * pep, long timeout_ms, void * userdata) {
+    struct loop * loop= userdata;
+    loop->deadline_ms= (timeout_ms < 0) ? -1 : now_ms() + timeout_ms;
+    return 0;
+}
+
+/* runs the event loop until all the authorizations are completed */
+static int run(PEP * pep, struct loop * loop) {
+    int running= 1, rounds= 0;
+    while (running > 0) {
+        struct pollfd ready[MAX_SOCKETS];
+        int i, n_ready= 0, timeout= 1000;
+        if (loop->deadline_ms >= 0) {
+            timeout= (int)(loop->deadline_ms - now_ms());
+            if (timeout < 0) timeout= 0;
+        }
+        if (poll(loop->fds,loop->n_fds,timeout) < 0 || ++rounds > 100000) {
+            printf("event loop failed\n");
+            return 1;
+        }
+        /* the socket callback changes the watched sockets */
+        for (i= 0; i < loop->n_fds; i++) {
+            if (loop->fds[i].revents != 0) ready[n_ready++]= loop->fds[i];
+        }
+        for (i= 0; i < n_ready; i++) {
+            int events= ((ready[i].revents & POLLIN) ? PEP_EVENT_IN : 0) | ((ready[i].revents & POLLOUT) ? PEP_EVENT_OUT : 0)
+                        | ((ready[i].revents & (POLLERR | POLLHUP)) ? PEP_EVENT_ERR : 0);
+            in_action= 1;
+            pep_socket_action(pep,ready[i].fd,events,&running);
+            in_action= 0;
+        }
+        if (loop->deadline_ms >= 0 && now_ms() >= loop->deadline_ms) {
+            loop->deadline_ms= -1;
+            in_action= 1;
+            pep_socket_action(pep,PEP_SOCKET_TIMEOUT,0,&running);
+            in_action= 0;
+        }
+    }
+    return 0;
+}
+
+struct completions {
+    int n; /* callbacks called */
+    int permits; /* Permit decisions */
+    int outside; /* callbacks called outside pep_socket_action */
+    pep_error_t rc; /* last error */
+};
+
+static void completed(PEP * pep, xacml_request_t * request, xacml_response_t * response, pep_error_t rc, void * userdata) {
+    struct completions * c= userdata;
+    c->n++;
+    if (!in_action) c->outside++;
+    if (rc != PEP_OK) {
+        c->rc= rc;
+    }
+    else if (xacml_result_getdecision(xacml_response_getresult(response,0)) == XACML_DECISION_PERMIT) {
+        c->permits++;
+    }
+    xacml_request_delete(request);
+    xacml_response_delete(response);
+}
+
+static xacml_request_t * create_request(int i) {
+    char id[32];
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_attribute_t * attr= xacml_attribute_create("urn:oasis:names:tc:xacml:1.0:subject:subject-id");
+    sprintf(id,"CN=User %d",i);
+    xacml_attribute_addvalue(attr,id);
+    xacml_subject_addattribute(subject,attr);
+    xacml_request_addsubject(request,subject);
+    return request;
+}
+
+/* creates a PEP handle driven by the event loop */
+static PEP * create_pep(const char * url, struct loop * loop) {
+    PEP * pep= pep_initialize();
+    loop->n_fds= 0;
+    loop->deadline_ms= -1;
+    loop->bad_socketdata= 0;
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,url);
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_BINARY_BODY,1);
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_MAX_CONNECTIONS,4);
+    pep_setoption(pep,PEP_OPTION_ASYNC_SOCKET_FUNCTION,socket_callback);
+    pep_setoption(pep,PEP_OPTION_ASYNC_TIMER_FUNCTION,timer_callback);
+    pep_setoption(pep,PEP_OPTION_ASYNC_USERDATA,loop);
+    return pep;
+}
+
+static int pip_init(void) { return 0; }
+static int pip_fail(xacml_request_t ** request) { return 1; }
+static int pip_destroy(void) { return 0; }
+
+int main(void) {
+    pep_pip_t failing_pip= { "failing-pip", pip_init, pip_fail, pip_destroy };
+    struct completions c= { 0, 0, 0, PEP_OK };
+    struct loop loop;
+    pepd_t * pepd;
+    PEP * pep;
+    int i, failed= 0;
+
+    pep_global_init();
+    pepd= pepd_start(PEPD_BINARY);
+    if (pepd == NULL) {
+        printf("can't start\nFAILED\n");
+        return 1;
+    }
+
+    /* authorizations driven by the event loop */
+    pep= create_pep(pepd_url(pepd),&loop);
+    for (i= 0; i < N_AUTHORIZATIONS; i++) {
+        xacml_request_t * request= create_request(i);
+        if (pep_authorize_async(pep,request,completed,&c) != PEP_OK) {
+            xacml_request_delete(request);
+            failed++;
+        }
+    }
+    failed+= run(pep,&loop);
+    printf("%d authorizations: %d callbacks (%d outside pep_socket_action), %d permits, %d connections\n",N_AUTHORIZATIONS,c.n,c.outside,c.permits,pepd_connections(pepd));
+    if (c.n != N_AUTHORIZATIONS || c.permits != N_AUTHORIZATIONS || c.outside != 0 || loop.bad_socketdata != 0) {
+        printf("expected %d permits in pep_socket_action, socket data errors: %d, last error: %s\n",N_AUTHORIZATIONS,loop.bad_socketdata,pep_strerror(c.rc));
+        failed++;
+    }
+    pep_destroy(pep);
+    if (loop.n_fds != 0) {
+        printf("%d sockets still watched after pep_destroy\n",loop.n_fds);
+        failed++;
+    }
+
+    /* failed submission completed when the timer expires */
+    pep= create_pep(pepd_url(pepd),&loop);
+    pep_addpip(pep,&failing_pip);
+    c.n= c.permits= c.outside= 0;
+    c.rc= PEP_OK;
+    pep_authorize_async(pep,create_request(0),completed,&c);
+    if (c.n != 0 || loop.deadline_ms < 0) {
+        printf("failed submission: callback called or timer not set\n");
+        failed++;
+    }
+    failed+= run(pep,&loop);
+    if (c.n != 1 || c.outside != 0 || c.rc != PEP_ERR_PIP_PROCESS) {
+        printf("failed submission: %d callbacks, last error: %s\n",c.n,pep_strerror(c.rc));
+        failed++;
+    }
+    pep_destroy(pep);
+
+    pepd_stop(pepd);
+    pep_global_cleanup();
+    if (failed > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
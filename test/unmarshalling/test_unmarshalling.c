@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Differential test of the two response unmarshalling engines: the one-pass
+ * xacml_response_unmarshalling() pull reader must build exactly the same
+ * XACML response as xacml_response_unmarshalling_tree(), for random responses
+ * echoing random requests, with null and unknown fields, deprecated values
+ * lists and chunked strings. A response with a Hessian ref must fall back to
+ * the tree engine. The allocations done by each engine are counted by
+ * interposing the glibc allocator. The reader must build the same response
+ * in an arena, and the incremental parser fed chunk by chunk. By default the
+ * response has its own arena and needs ten times fewer allocations than the
+ * tree engine.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/buffer.h"
+#include "argus/xacml.h"
+#include "argus/io.h"
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static int n_allocs= 0;
+
+void * malloc(size_t size) {
+    n_allocs++;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t nmemb, size_t size) {
+    n_allocs++;
+    return __libc_calloc(nmemb,size);
+}
+
+void * realloc(void * ptr, size_t size) {
+    n_allocs++;
+    return __libc_realloc(ptr,size);
+}
+
+static const char * words[]= {
+    "", "a", "urn:oasis:names:tc:xacml:1.0:subject:subject-id",
+    "CN=John Doe,O=Example", "http://www.w3.org/2001/XMLSchema#string",
+    "caf\303\251 \320\237\321\200\320\270\320\262\320\265\321\202", "\342\202\254 \360\237\230\200 euro",
+};
+
+/* returns a random string, sometimes a long (chunked) one */
+static const char * random_string(void) {
+    static char big[100000];
+    if (rand() % 60 == 0) {
+        size_t l= 0, n= 30000 + rand() % 40000;
+        while (l < n) {
+            const char * w= words[5 + rand() % 2];
+            size_t w_l= strlen(w);
+            if (l + w_l >= sizeof(big)) break;
+            memcpy(&big[l],w,w_l);
+            l+= w_l;
+        }
+        big[l]= '\0';
+        return big;
+    }
+    return words[rand() % (sizeof(words) / sizeof(char *))];
+}
+
+static void write_integer(int32_t value, pep_buffer_t * output) {
+    pep_buffer_putc('I',output);
+    pep_buffer_putc((value >> 24) & 0xFF,output);
+    pep_buffer_putc((value >> 16) & 0xFF,output);
+    pep_buffer_putc((value >> 8) & 0xFF,output);
+    pep_buffer_putc(value & 0xFF,output);
+}
+
+/* random string or null value */
+static void write_nullable(pep_buffer_t * output) {
+    if (rand() % 4 == 0) hessian_null_write(output);
+    else hessian_string_write(random_string(),output);
+}
+
+/* unknown map<key,value>, skipped by both engines */
+static void write_unknown(pep_buffer_t * output) {
+    hessian_string_write("unknownKey",output);
+    hessian_list_write_start(NULL,2,output);
+    hessian_map_write_start("some.Class",output);
+    hessian_string_write("k",output);
+    write_integer(rand(),output);
+    hessian_map_write_end(output);
+    hessian_string_write(random_string(),output);
+    hessian_list_write_end(output);
+}
+
+static void write_statuscode(int depth, pep_buffer_t * output) {
+    hessian_map_write_start(XACML_HESSIAN_STATUSCODE_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_STATUSCODE_VALUE,output);
+    hessian_string_write(random_string(),output);
+    hessian_string_write(XACML_HESSIAN_STATUSCODE_SUBCODE,output);
+    if (depth > 0 && rand() % 2) write_statuscode(depth - 1,output);
+    else hessian_null_write(output);
+    hessian_map_write_end(output);
+}
+
+static void write_status(pep_buffer_t * output) {
+    hessian_map_write_start(XACML_HESSIAN_STATUS_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_STATUS_MESSAGE,output);
+    write_nullable(output);
+    hessian_string_write(XACML_HESSIAN_STATUS_CODE,output);
+    if (rand() % 4) write_statuscode(2,output);
+    else hessian_null_write(output);
+    hessian_map_write_end(output);
+}
+
+static void write_assignment(pep_buffer_t * output) {
+    hessian_map_write_start(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,output);
+    hessian_string_write(random_string(),output);
+    hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,output);
+    write_nullable(output);
+    if (rand() % 5 == 0) {
+        /* PEPd <= 1.0 */
+        hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES,output);
+        hessian_list_write_start(NULL,1,output);
+        hessian_string_write(random_string(),output);
+        hessian_list_write_end(output);
+    }
+    else {
+        hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,output);
+        write_nullable(output);
+    }
+    hessian_map_write_end(output);
+}
+
+static void write_obligation(pep_buffer_t * output) {
+    int i, n= rand() % 4;
+    hessian_map_write_start(XACML_HESSIAN_OBLIGATION_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_OBLIGATION_ID,output);
+    hessian_string_write(random_string(),output);
+    hessian_string_write(XACML_HESSIAN_OBLIGATION_FULFILLON,output);
+    write_integer(rand() % 2,output);
+    hessian_string_write(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,output);
+    hessian_list_write_start(NULL,n,output);
+    for (i= 0; i < n; i++) write_assignment(output);
+    hessian_list_write_end(output);
+    hessian_map_write_end(output);
+}
+
+static void write_result(pep_buffer_t * output) {
+    int i, n= rand() % 3;
+    hessian_map_write_start(XACML_HESSIAN_RESULT_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_RESULT_DECISION,output);
+    write_integer(rand() % 4,output);
+    hessian_string_write(XACML_HESSIAN_RESULT_RESOURCEID,output);
+    write_nullable(output);
+    if (rand() % 5 == 0) write_unknown(output);
+    hessian_string_write(XACML_HESSIAN_RESULT_STATUS,output);
+    if (rand() % 4) write_status(output);
+    else hessian_null_write(output);
+    hessian_string_write(XACML_HESSIAN_RESULT_OBLIGATIONS,output);
+    hessian_list_write_start(NULL,n,output);
+    for (i= 0; i < n; i++) write_obligation(output);
+    hessian_list_write_end(output);
+    hessian_map_write_end(output);
+}
+
+static xacml_attribute_t * random_attribute(void) {
+    int i, n= rand() % 4;
+    xacml_attribute_t * attr= xacml_attribute_create(random_string());
+    if (rand() % 2) xacml_attribute_setdatatype(attr,random_string());
+    if (rand() % 3 == 0) xacml_attribute_setissuer(attr,random_string());
+    for (i= 0; i < n; i++) xacml_attribute_addvalue(attr,random_string());
+    return attr;
+}
+
+static xacml_request_t * random_request(void) {
+    int i, j, n;
+    xacml_request_t * request= xacml_request_create();
+    n= rand() % 3;
+    for (i= 0; i < n; i++) {
+        xacml_subject_t * subject= xacml_subject_create();
+        int m= rand() % 4;
+        if (rand() % 2) xacml_subject_setcategory(subject,random_string());
+        for (j= 0; j < m; j++) xacml_subject_addattribute(subject,random_attribute());
+        xacml_request_addsubject(request,subject);
+    }
+    n= rand() % 3;
+    for (i= 0; i < n; i++) {
+        xacml_resource_t * resource= xacml_resource_create();
+        int m= rand() % 3;
+        if (rand() % 3 == 0) xacml_resource_setcontent(resource,random_string());
+        for (j= 0; j < m; j++) xacml_resource_addattribute(resource,random_attribute());
+        xacml_request_addresource(request,resource);
+    }
+    if (rand() % 4) {
+        xacml_action_t * action= xacml_action_create();
+        n= rand() % 3;
+        for (i= 0; i < n; i++) xacml_action_addattribute(action,random_attribute());
+        xacml_request_setaction(request,action);
+    }
+    if (rand() % 2) {
+        xacml_environment_t * env= xacml_environment_create();
+        n= rand() % 3;
+        for (i= 0; i < n; i++) xacml_environment_addattribute(env,random_attribute());
+        xacml_request_setenvironment(request,env);
+    }
+    return request;
+}
+
+static void write_response(pep_buffer_t * output) {
+    int i, n= rand() % 4;
+    hessian_map_write_start(XACML_HESSIAN_RESPONSE_CLASSNAME,output);
+    hessian_string_write(XACML_HESSIAN_RESPONSE_REQUEST,output);
+    if (rand() % 5) {
+        xacml_request_t * request= random_request();
+        xacml_request_marshalling(request,output);
+        xacml_request_delete(request);
+    }
+    else {
+        hessian_null_write(output);
+    }
+    hessian_string_write(XACML_HESSIAN_RESPONSE_RESULTS,output);
+    hessian_list_write_start(NULL,n,output);
+    for (i= 0; i < n; i++) write_result(output);
+    hessian_list_write_end(output);
+    hessian_map_write_end(output);
+}
+
+static int same_string(const char * a, const char * b) {
+    if (a == NULL || b == NULL) return a == b;
+    return strcmp(a,b) == 0;
+}
+
+static int same_statuscode(const xacml_statuscode_t * a, const xacml_statuscode_t * b) {
+    if (a == NULL || b == NULL) return a == b;
+    return same_string(xacml_statuscode_getvalue(a),xacml_statuscode_getvalue(b))
+        && same_statuscode(xacml_statuscode_getsubcode(a),xacml_statuscode_getsubcode(b));
+}
+
+static int same_request(const xacml_request_t * a, const xacml_request_t * b, pep_buffer_t * a_b, pep_buffer_t * b_b) {
+    if (a == NULL || b == NULL) return a == b;
+    pep_buffer_reset(a_b);
+    pep_buffer_reset(b_b);
+    xacml_request_marshalling(a,a_b);
+    xacml_request_marshalling(b,b_b);
+    return pep_buffer_length(a_b) == pep_buffer_length(b_b)
+        && memcmp(pep_buffer_peek(a_b),pep_buffer_peek(b_b),pep_buffer_length(a_b)) == 0;
+}
+
+static int same_response(const xacml_response_t * a, const xacml_response_t * b, pep_buffer_t * a_b, pep_buffer_t * b_b) {
+    size_t i, j, k;
+    if (!same_request(xacml_response_getrequest(a),xacml_response_getrequest(b),a_b,b_b)) return 0;
+    if (xacml_response_results_length(a) != xacml_response_results_length(b)) return 0;
+    for (i= 0; i < xacml_response_results_length(a); i++) {
+        xacml_result_t * ra= xacml_response_getresult(a,i);
+        xacml_result_t * rb= xacml_response_getresult(b,i);
+        xacml_status_t * sa= xacml_result_getstatus(ra);
+        xacml_status_t * sb= xacml_result_getstatus(rb);
+        if (xacml_result_getdecision(ra) != xacml_result_getdecision(rb)) return 0;
+        if (!same_string(xacml_result_getresourceid(ra),xacml_result_getresourceid(rb))) return 0;
+        if ((sa == NULL) != (sb == NULL)) return 0;
+        if (sa != NULL && (!same_string(xacml_status_getmessage(sa),xacml_status_getmessage(sb))
+                           || !same_statuscode(xacml_status_getcode(sa),xacml_status_getcode(sb)))) return 0;
+        if (xacml_result_obligations_length(ra) != xacml_result_obligations_length(rb)) return 0;
+        for (j= 0; j < xacml_result_obligations_length(ra); j++) {
+            xacml_obligation_t * oa= xacml_result_getobligation(ra,j);
+            xacml_obligation_t * ob= xacml_result_getobligation(rb,j);
+            if (!same_string(xacml_obligation_getid(oa),xacml_obligation_getid(ob))) return 0;
+            if (xacml_obligation_getfulfillon(oa) != xacml_obligation_getfulfillon(ob)) return 0;
+            if (xacml_obligation_attributeassignments_length(oa) != xacml_obligation_attributeassignments_length(ob)) return 0;
+            for (k= 0; k < xacml_obligation_attributeassignments_length(oa); k++) {
+                xacml_attributeassignment_t * aa= xacml_obligation_getattributeassignment(oa,k);
+                xacml_attributeassignment_t * ab= xacml_obligation_getattributeassignment(ob,k);
+                if (!same_string(xacml_attributeassignment_getid(aa),xacml_attributeassignment_getid(ab))
+                    || !same_string(xacml_attributeassignment_getdatatype(aa),xacml_attributeassignment_getdatatype(ab))
+                    || !same_string(xacml_attributeassignment_getvalue(aa),xacml_attributeassignment_getvalue(ab))) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    int i, tree_allocs= 0, reader_allocs= 0, arena_allocs= 0, owned_allocs= 0;
+    pep_buffer_t * input= pep_buffer_create(1024);
+    pep_buffer_t * a_b= pep_buffer_create(1024);
+    pep_buffer_t * b_b= pep_buffer_create(1024);
+    hessian_reader_t * reader= hessian_reader_create();
+    xacml_response_parser_t * parser= xacml_response_parser_create();
+    pep_buffer_t * chunked= pep_buffer_create(64);
+    xacml_arena_t * arena= xacml_arena_create(0);
+    xacml_response_t * tree, * pulled, * in_arena;
+    size_t input_l;
+    srand(7);
+    for (i= 0; i < 2000; i++) {
+        int allocs;
+        pep_buffer_reset(input);
+        write_response(input);
+        input_l= pep_buffer_length(input);
+        tree= NULL;
+        pulled= NULL;
+        allocs= n_allocs;
+        if (xacml_response_unmarshalling_reader(&pulled,reader,input) != PEP_OK) {
+            printf("response %d: reader unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        reader_allocs+= n_allocs - allocs;
+        if (pep_buffer_length(input) != 0) {
+            printf("response %d: %d bytes not consumed by the reader\nFAILED\n",i,(int)pep_buffer_length(input));
+            return 1;
+        }
+        pep_buffer_rewind(input);
+        allocs= n_allocs;
+        if (xacml_response_unmarshalling_tree(&tree,input) != PEP_OK) {
+            printf("response %d: tree unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        tree_allocs+= n_allocs - allocs;
+        if (!same_response(tree,pulled,a_b,b_b)) {
+            printf("response %d (%d bytes): tree and reader responses differ\nFAILED\n",i,(int)input_l);
+            return 1;
+        }
+        pep_buffer_rewind(input);
+        xacml_arena_reset(arena);
+        in_arena= NULL;
+        allocs= n_allocs;
+        if (xacml_response_unmarshalling_reader_in(&in_arena,reader,input,arena) != PEP_OK) {
+            printf("response %d: arena reader unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        arena_allocs+= n_allocs - allocs;
+        if (!same_response(pulled,in_arena,a_b,b_b)) {
+            printf("response %d (%d bytes): reader and arena responses differ\nFAILED\n",i,(int)input_l);
+            return 1;
+        }
+        /* the transport default: the response has its own arena */
+        pep_buffer_rewind(input);
+        xacml_response_delete(tree);
+        tree= NULL;
+        allocs= n_allocs;
+        xacml_response_parser_reset(parser,input,NULL);
+        if (xacml_response_parser_finish(parser,input,&tree) != PEP_OK) {
+            printf("response %d: own arena unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        owned_allocs+= n_allocs - allocs;
+        if (!same_response(pulled,tree,a_b,b_b)) {
+            printf("response %d (%d bytes): reader and own arena responses differ\nFAILED\n",i,(int)input_l);
+            return 1;
+        }
+        xacml_response_delete(tree);
+        xacml_response_delete(pulled);
+        xacml_response_delete(in_arena);
+    }
+    printf("2000 responses: %d allocations (tree), %d allocations (reader)\n",tree_allocs,reader_allocs);
+    printf("2000 responses: %d allocations (arena reader), %d allocations (own arena)\n",arena_allocs,owned_allocs);
+    /* the objects and strings are not allocated one by one anymore */
+    if (reader_allocs > tree_allocs || arena_allocs * 10 > reader_allocs || owned_allocs * 10 > tree_allocs) {
+        printf("FAILED\n");
+        return 1;
+    }
+    xacml_arena_delete(arena);
+
+    /* the parser unmarshals the response while it arrives, chunk by chunk */
+    for (i= 0; i < 300; i++) {
+        static const size_t chunk_sizes[]= { 1, 7, 64, 1000 };
+        size_t chunk_l= chunk_sizes[i % 4], sent;
+        pep_buffer_reset(input);
+        write_response(input);
+        input_l= pep_buffer_length(input);
+        pulled= NULL;
+        if (xacml_response_unmarshalling_reader(&pulled,reader,input) != PEP_OK) {
+            printf("response %d: reader unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        pep_buffer_rewind(input);
+        pep_buffer_reset(chunked);
+        xacml_response_parser_reset(parser,chunked,NULL);
+        for (sent= 0; sent < input_l; sent+= chunk_l) {
+            size_t l= (input_l - sent < chunk_l) ? input_l - sent : chunk_l;
+            pep_buffer_write(pep_buffer_peek(input) + sent,1,l,chunked);
+            if (xacml_response_parser_feed(parser,chunked) != PEP_OK) {
+                printf("response %d: chunk at %d/%d rejected\nFAILED\n",i,(int)sent,(int)input_l);
+                return 1;
+            }
+        }
+        /* all unmarshalled before the end of the transfer */
+        if (xacml_response_parser_offset(parser) != input_l) {
+            printf("response %d: %d/%d bytes unmarshalled before the end\nFAILED\n",i,(int)xacml_response_parser_offset(parser),(int)input_l);
+            return 1;
+        }
+        tree= NULL;
+        if (xacml_response_parser_finish(parser,chunked,&tree) != PEP_OK || pep_buffer_length(chunked) != 0) {
+            printf("response %d: parser unmarshalling failed\nFAILED\n",i);
+            return 1;
+        }
+        if (!same_response(pulled,tree,a_b,b_b)) {
+            printf("response %d (%d bytes, %d bytes chunks): reader and parser responses differ\nFAILED\n",i,(int)input_l,(int)chunk_l);
+            return 1;
+        }
+        xacml_response_delete(tree);
+        xacml_response_delete(pulled);
+    }
+
+    /* own arena: heap objects added to the response are deleted with it, the
+       relinquished effective request outlives it */
+    for (pulled= NULL; pulled == NULL; ) {
+        pep_buffer_reset(input);
+        write_response(input);
+        xacml_response_parser_reset(parser,input,NULL);
+        if (xacml_response_parser_finish(parser,input,&pulled) != PEP_OK) {
+            printf("own arena: unmarshalling failed\nFAILED\n");
+            return 1;
+        }
+        if (xacml_response_getrequest(pulled) == NULL) {
+            xacml_response_delete(pulled);
+            pulled= NULL;
+        }
+    }
+    {
+        xacml_result_t * result= xacml_result_create();
+        xacml_request_t * request;
+        size_t subjects_l;
+        xacml_result_addobligation(result,xacml_obligation_create("heap-obligation"));
+        xacml_response_addresult(pulled,result);
+        request= xacml_response_relinquishrequest(pulled);
+        subjects_l= xacml_request_subjects_length(request);
+        xacml_request_addsubject(request,xacml_subject_create());
+        xacml_response_delete(pulled);
+        if (xacml_request_subjects_length(request) != subjects_l + 1) {
+            printf("own arena: relinquished request released with the response\nFAILED\n");
+            return 1;
+        }
+        xacml_request_delete(request);
+    }
+
+    /* a Hessian ref falls back to the tree engine: dataType is a ref to the id value */
+    pep_buffer_reset(input);
+    hessian_map_write_start(XACML_HESSIAN_RESPONSE_CLASSNAME,input);
+    hessian_string_write(XACML_HESSIAN_RESPONSE_RESULTS,input);
+    hessian_list_write_start(NULL,1,input);
+    hessian_map_write_start(XACML_HESSIAN_RESULT_CLASSNAME,input);
+    hessian_string_write(XACML_HESSIAN_RESULT_DECISION,input);
+    write_integer(XACML_DECISION_PERMIT,input);
+    hessian_string_write(XACML_HESSIAN_RESULT_OBLIGATIONS,input);
+    hessian_list_write_start(NULL,1,input);
+    hessian_map_write_start(XACML_HESSIAN_OBLIGATION_CLASSNAME,input);
+    hessian_string_write(XACML_HESSIAN_OBLIGATION_ID,input);
+    hessian_string_write("obligation-1",input);
+    hessian_string_write(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,input);
+    hessian_list_write_start(NULL,1,input);
+    hessian_map_write_start(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,input);
+    hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,input);
+    hessian_string_write("attr-1",input);
+    hessian_string_write(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,input);
+    pep_buffer_write("R\000\000\000\000",1,5,input);
+    hessian_map_write_end(input);
+    hessian_list_write_end(input);
+    hessian_map_write_end(input);
+    hessian_list_write_end(input);
+    hessian_map_write_end(input);
+    hessian_list_write_end(input);
+    hessian_map_write_end(input);
+    pulled= NULL;
+    if (xacml_response_unmarshalling_reader(&pulled,reader,input) != PEP_OK
+        || !same_string(xacml_attributeassignment_getvalue(xacml_obligation_getattributeassignment(xacml_result_getobligation(xacml_response_getresult(pulled,0),0),0)),"attr-1")) {
+        printf("Hessian ref: not resolved by the tree engine\nFAILED\n");
+        return 1;
+    }
+    xacml_response_delete(pulled);
+    pep_buffer_rewind(input);
+    pulled= NULL;
+    xacml_response_parser_reset(parser,input,NULL);
+    xacml_response_parser_feed(parser,input);
+    if (xacml_response_parser_finish(parser,input,&pulled) != PEP_OK
+        || !same_string(xacml_attributeassignment_getvalue(xacml_obligation_getattributeassignment(xacml_result_getobligation(xacml_response_getresult(pulled,0),0),0)),"attr-1")) {
+        printf("Hessian ref: not resolved by the tree engine after the parser\nFAILED\n");
+        return 1;
+    }
+    xacml_response_delete(pulled);
+
+    /* truncated and invalid content */
+    pep_buffer_reset(input);
+    write_response(input);
+    input_l= pep_buffer_length(input);
+    for (i= 0; i < (int)input_l; i+= 1 + input_l / 50) {
+        pep_buffer_t * truncated= pep_buffer_create(i + 1);
+        pep_buffer_write(pep_buffer_peek(input),1,i,truncated);
+        pulled= NULL;
+        if (xacml_response_unmarshalling_reader(&pulled,reader,truncated) == PEP_OK) {
+            printf("truncated at %d/%d: not rejected\nFAILED\n",i,(int)input_l);
+            return 1;
+        }
+        xacml_response_parser_reset(parser,truncated,NULL);
+        xacml_response_parser_feed(parser,truncated);
+        if (xacml_response_parser_finish(parser,truncated,&pulled) == PEP_OK) {
+            printf("truncated at %d/%d: not rejected by the parser\nFAILED\n",i,(int)input_l);
+            return 1;
+        }
+        pep_buffer_delete(truncated);
+    }
+    pep_buffer_reset(input);
+    pep_buffer_write("Mt\000\001AQ",1,6,input);
+    if (xacml_response_unmarshalling_reader(&pulled,reader,input) == PEP_OK) {
+        printf("invalid content: not rejected\nFAILED\n");
+        return 1;
+    }
+
+    hessian_reader_delete(reader);
+    xacml_response_parser_delete(parser);
+    pep_buffer_delete(chunked);
+    pep_buffer_delete(input);
+    pep_buffer_delete(a_b);
+    pep_buffer_delete(b_b);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * UTF-8 kernels test: every kernel supported by the CPU must count, split
+ * and validate exactly like the reference byte by byte functions, for all
+ * the lengths, for valid and corrupted UTF-8. Long strings must be written
+ * in chunks and read back. Invalid strings are read as is, truncated ones
+ * are rejected. The throughput of each kernel is printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/buffer.h"
+#include "hessian/hessian.h"
+
+/* valid chars: ASCII, 2, 3 bytes, encoded surrogate (Java) and 4 bytes */
+static const char * chars[]= {
+    "a", "Z", "=", "\303\251", "\320\237", "\342\202\254", "\355\240\275", "\360\237\230\200", "\364\217\277\277"
+};
+
+/* invalid sequences */
+static const char * invalids[]= {
+    "\200", "\277", "\300\200", "\301\277", "\340\200\200", "\360\200\200\200",
+    "\364\220\200\200", "\370\210\200\200", "\377", "\303", "\342\202", "\303a"
+};
+
+#define N_CHARS (int)(sizeof(chars) / sizeof(char *))
+#define N_INVALIDS (int)(sizeof(invalids) / sizeof(char *))
+
+static size_t reference_count(const unsigned char * p, size_t l) {
+    size_t i, n= 0;
+    for (i= 0; i < l; i++) if ((p[i] & 0xC0) != 0x80) n++;
+    return n;
+}
+
+static size_t reference_offset(const unsigned char * p, size_t l, size_t n) {
+    size_t i;
+    for (i= 0; i < l; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            if (n == 0) return i;
+            n--;
+        }
+    }
+    return (n == 0) ? l : (size_t)-1;
+}
+
+/* appends random chars, mostly ASCII, returns the number of chars */
+static size_t random_utf8(char * s, size_t * s_l, size_t max_l) {
+    size_t n= 0;
+    *s_l= 0;
+    for (;;) {
+        const char * c= (rand() % 4 == 0) ? chars[rand() % N_CHARS] : chars[rand() % 3];
+        size_t c_l= strlen(c);
+        if (*s_l + c_l > max_l) break;
+        memcpy(&s[*s_l],c,c_l);
+        *s_l+= c_l;
+        n++;
+        if (rand() % (max_l + 1) == 0) break;
+    }
+    return n;
+}
+
+static int check_kernel(hessian_utf8_kernel_t kernel) {
+    static char s[600];
+    int round;
+    for (round= 0; round < 20000; round++) {
+        size_t s_l, n, i;
+        n= random_utf8(s,&s_l,rand() % 512);
+        if (hessian_utf8_count(s,s_l) != n || reference_count((unsigned char *)s,s_l) != n) {
+            printf("kernel %d: count len=%d differs\n",kernel,(int)s_l);
+            return 1;
+        }
+        for (i= 0; i <= n + 1; i+= 1 + rand() % 7) {
+            if (hessian_utf8_offset(s,s_l,i) != reference_offset((unsigned char *)s,s_l,i)) {
+                printf("kernel %d: offset %d len=%d differs\n",kernel,(int)i,(int)s_l);
+                return 1;
+            }
+        }
+        if (!hessian_utf8_validate(s,s_l)) {
+            printf("kernel %d: valid len=%d rejected\n",kernel,(int)s_l);
+            return 1;
+        }
+        /* corrupted at a random position */
+        if (s_l > 0) {
+            const char * bad= invalids[rand() % N_INVALIDS];
+            size_t bad_l= strlen(bad), pos= rand() % s_l;
+            /* at a char boundary */
+            while (pos > 0 && (s[pos] & 0xC0) == 0x80) pos--;
+            memmove(&s[pos + bad_l],&s[pos],s_l - pos);
+            memcpy(&s[pos],bad,bad_l);
+            /* a truncated sequence followed by a continuation byte can be valid */
+            if ((s[pos + bad_l] & 0xC0) != 0x80 && hessian_utf8_validate(s,s_l + bad_l)) {
+                printf("kernel %d: invalid len=%d accepted at %d\n",kernel,(int)(s_l + bad_l),(int)pos);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* long strings are written in HESSIAN_CHUNK_SIZE chars chunks */
+static int check_chunks(void) {
+    size_t size= 200000, s_l= 0, n= 0;
+    char * s= malloc(size + 1);
+    pep_buffer_t * output= pep_buffer_create(size);
+    hessian_object_t * string, * read;
+    int rc= 0;
+    while (s_l + 4 < size) {
+        const char * c= chars[rand() % N_CHARS];
+        memcpy(&s[s_l],c,strlen(c));
+        s_l+= strlen(c);
+        n++;
+    }
+    s[s_l]= '\0';
+    string= hessian_create(HESSIAN_STRING,s);
+    hessian_serialize(string,output);
+    read= hessian_deserialize(output);
+    if (read == NULL || strcmp(hessian_string_getstring(read),s) != 0 || hessian_string_utf8_length(read) != n) {
+        printf("chunked string (%d chars) differs\n",(int)n);
+        rc= 1;
+    }
+    hessian_delete(string);
+    hessian_delete(read);
+    pep_buffer_delete(output);
+    free(s);
+    return rc;
+}
+
+/* invalid UTF-8 is kept by the deserializer and the reader, truncated is rejected */
+static int check_tolerant(void) {
+    static const char invalid[]= "S\000\003\377\300a";
+    static const char truncated[]= "S\000\002a\303";
+    pep_buffer_t * input= pep_buffer_create(16);
+    hessian_reader_t * reader= hessian_reader_create();
+    hessian_object_t * read;
+    const char * view;
+    size_t view_l= 0;
+    int rc= 0;
+    pep_buffer_write(invalid,1,sizeof(invalid) - 1,input);
+    hessian_reader_reset(reader,input);
+    if (hessian_reader_next(reader) != HESSIAN_TOKEN_STRING || (view= hessian_reader_getview(reader,&view_l)) == NULL
+            || view_l != 3 || memcmp(view,"\377\300a",3) != 0) {
+        printf("invalid string: not read as is by the reader\n");
+        rc= 1;
+    }
+    read= hessian_deserialize(input);
+    if (read == NULL || strcmp(hessian_string_getstring(read),"\377\300a") != 0) {
+        printf("invalid string: not deserialized as is\n");
+        rc= 1;
+    }
+    hessian_delete(read);
+    pep_buffer_reset(input);
+    pep_buffer_write(truncated,1,sizeof(truncated) - 1,input);
+    hessian_reader_reset(reader,input);
+    if (hessian_reader_next(reader) != HESSIAN_TOKEN_ERROR) {
+        printf("truncated string: not rejected by the reader\n");
+        rc= 1;
+    }
+    read= hessian_deserialize(input);
+    if (read != NULL) {
+        printf("truncated string: not rejected by the deserializer\n");
+        hessian_delete(read);
+        rc= 1;
+    }
+    hessian_reader_delete(reader);
+    pep_buffer_delete(input);
+    return rc;
+}
+
+static void throughput(hessian_utf8_kernel_t kernel) {
+    size_t size= 16 * 1024 * 1024, i, n= 0;
+    char * data= malloc(size);
+    clock_t start, count, validate;
+    int valid;
+    /* PEM like ASCII */
+    for (i= 0; i < size; i++) data[i]= (i % 65 == 64) ? '\n' : 'A' + rand() % 26;
+    start= clock();
+    for (i= 0; i < 4; i++) n+= hessian_utf8_count(data,size);
+    count= clock();
+    for (i= 0; i < 4; i++) valid= hessian_utf8_validate(data,size);
+    validate= clock();
+    printf("kernel %d: count %.0f MB/s, validate %.0f MB/s%s\n",kernel,
+           64.0 / ((double)(count - start + 1) / CLOCKS_PER_SEC),
+           64.0 / ((double)(validate - count + 1) / CLOCKS_PER_SEC),
+           (n == 4 * size && valid) ? "" : " (wrong result)");
+    free(data);
+}
+
+int main(void) {
+    hessian_utf8_kernel_t kernel;
+    srand(1);
+    for (kernel= HESSIAN_UTF8_KERNEL_SCALAR; kernel <= HESSIAN_UTF8_KERNEL_AVX2; kernel++) {
+        if (hessian_utf8_setkernel(kernel) != HESSIAN_OK) {
+            printf("kernel %d: not supported, skipped\n",kernel);
+            continue;
+        }
+        if (check_kernel(kernel) != 0 || check_chunks() != 0 || check_tolerant() != 0) {
+            printf("FAILED\n");
+            return 1;
+        }
+        throughput(kernel);
+    }
+    hessian_utf8_setkernel(HESSIAN_UTF8_KERNEL_AUTO);
+    printf("OK (kernel %d)\n",hessian_utf8_getkernel());
+    return 0;
+}
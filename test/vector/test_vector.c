@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Vector test: elements are appended, indexed and removed in order, the
+ * elements added several times are deleted once. The growth must be
+ * amortized: appending n elements reallocates O(log n) times. An XACML
+ * attribute with many values must be indexed in constant time.
+ * The allocations are counted by interposing the glibc allocator.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/vector.h"
+#include "argus/xacml.h"
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t nmemb, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static int n_allocs= 0;
+
+void * malloc(size_t size) {
+    n_allocs++;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t nmemb, size_t size) {
+    n_allocs++;
+    return __libc_calloc(nmemb,size);
+}
+
+void * realloc(void * ptr, size_t size) {
+    n_allocs++;
+    return __libc_realloc(ptr,size);
+}
+
+static int n_deleted= 0;
+
+static void count_delete(void * element) {
+    n_deleted++;
+}
+
+static int test_vector(void) {
+    static int elements[100000];
+    size_t n= sizeof(elements) / sizeof(int), i;
+    pep_vector_t * vector= pep_vector_create(0);
+    int ok= 1;
+    n_allocs= 0;
+    for (i= 0; i < n; i++) {
+        pep_vector_add(vector,&elements[i]);
+    }
+    printf("%d elements added: %d allocations\n",(int)n,n_allocs);
+    if (n_allocs > 20) {
+        printf("vector growth is not amortized\n");
+        ok= 0;
+    }
+    for (i= 0; i < n; i++) {
+        if (pep_vector_get(vector,i) != &elements[i]) {
+            printf("element %d differs\n",(int)i);
+            ok= 0;
+            break;
+        }
+    }
+    if (pep_vector_get(vector,n) != NULL || pep_vector_remove(vector,n) != NULL) {
+        printf("index %d not out of range\n",(int)n);
+        ok= 0;
+    }
+    if (pep_vector_remove(vector,0) != &elements[0] || pep_vector_get(vector,0) != &elements[1]
+        || pep_vector_remove(vector,n - 2) != &elements[n - 1] || pep_vector_length(vector) != n - 2) {
+        printf("remove failed\n");
+        ok= 0;
+    }
+    /* same element added many times */
+    pep_vector_add(vector,&elements[1]);
+    pep_vector_add(vector,&elements[2]);
+    pep_vector_delete_elements(vector,count_delete);
+    if (n_deleted != (int)n - 2) {
+        printf("%d elements deleted, expected %d\n",n_deleted,(int)n - 2);
+        ok= 0;
+    }
+    pep_vector_delete(vector);
+    return ok;
+}
+
+static int test_attribute(void) {
+    xacml_attribute_t * attr= xacml_attribute_create("http://authz-interop.org/xacml/subject/voms-fqan");
+    size_t n= 50000, i;
+    char value[32];
+    clock_t start;
+    int ok= 1;
+    for (i= 0; i < n; i++) {
+        sprintf(value,"/vo/group%d/Role=NULL",(int)i);
+        xacml_attribute_addvalue(attr,value);
+    }
+    start= clock();
+    for (i= 0; i < n; i++) {
+        sprintf(value,"/vo/group%d/Role=NULL",(int)i);
+        if (strcmp(xacml_attribute_getvalue(attr,(int)i),value) != 0) {
+            printf("attribute value %d differs\n",(int)i);
+            ok= 0;
+            break;
+        }
+    }
+    printf("%d attribute values indexed in %.3f s\n",(int)n,(double)(clock() - start) / CLOCKS_PER_SEC);
+    if (xacml_attribute_values_length(attr) != n || xacml_attribute_getvalue(attr,-1) != NULL) {
+        printf("attribute values length or range differs\n");
+        ok= 0;
+    }
+    xacml_attribute_delete(attr);
+    return ok;
+}
+
+int main(void) {
+    int ok= test_vector() && test_attribute();
+    printf(ok ? "OK\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}